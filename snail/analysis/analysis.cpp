@@ -1,13 +1,26 @@
 
 #include <snail/analysis/analysis.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <format>
+#include <future>
+#include <limits>
+#include <memory>
 #include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <snail/analysis/data_provider.hpp>
 
 #include <snail/common/hash_combine.hpp>
+#include <snail/common/string_interner.hpp>
+#include <snail/common/thread_pool.hpp>
 
 using namespace snail;
 using namespace snail::analysis;
@@ -31,16 +44,19 @@ private:
 
 namespace {
 
-source_hit_counts init_hits(const sample_source_info::id_t max_source_id)
+// The id for a new entry that is appended to a list of `current_size` entries.
+// The largest id is not available since it is reserved for the roots.
+template<typename Id>
+Id make_next_id(std::size_t current_size)
 {
-    return source_hit_counts{
-        .counts_per_source = std::vector<hit_counts>(max_source_id + 1)};
+    if(current_size >= std::numeric_limits<Id>::max()) throw std::runtime_error("Too many entries for a stacks analysis");
+    return static_cast<Id>(current_size);
 }
 
 module_info& get_or_create_module(std::vector<module_info>&                           modules,
                                   std::unordered_map<std::string, module_info::id_t>& modules_by_name,
                                   std::string_view                                    module_name,
-                                  const sample_source_info::id_t                      max_source_id)
+                                  hit_counts_matrix&                                  module_hits)
 {
     const auto key = std::string(module_name);
 
@@ -48,10 +64,10 @@ module_info& get_or_create_module(std::vector<module_info>&
     if(iter == modules_by_name.end())
     {
         modules.push_back(module_info{
-            .id   = modules.size(),
+            .id   = make_next_id<module_info::id_t>(modules.size()),
             .name = std::string(module_name),
-            .hits = init_hits(max_source_id),
         });
+        module_hits.append_row();
         modules_by_name[key] = modules.back().id;
         return modules.back();
     }
@@ -63,7 +79,7 @@ function_info& get_or_create_function(std::vector<function_info>&
                                       std::unordered_map<std::pair<module_info::id_t, std::string>, module_info::id_t>& functions_by_name,
                                       const module_info&                                                                module,
                                       std::string_view                                                                  function_name,
-                                      const sample_source_info::id_t                                                    max_source_id)
+                                      hit_counts_matrix&                                                                function_hits)
 {
     const auto key = std::make_pair(module.id, std::string(function_name));
 
@@ -71,16 +87,13 @@ function_info& get_or_create_function(std::vector<function_info>&
     if(iter == functions_by_name.end())
     {
         functions.push_back(function_info{
-            .id           = functions.size(),
-            .module_id    = module.id,
-            .name         = std::string(function_name),
-            .hits         = init_hits(max_source_id),
-            .callers      = {},
-            .callees      = {},
-            .file_id      = {},
-            .line_number  = {},
-            .hits_by_line = {},
+            .id          = make_next_id<function_info::id_t>(functions.size()),
+            .module_id   = module.id,
+            .name        = std::string(function_name),
+            .file_id     = {},
+            .line_number = {},
         });
+        function_hits.append_row();
         functions_by_name[key] = functions.back().id;
         return functions.back();
     }
@@ -91,7 +104,7 @@ function_info& get_or_create_function(std::vector<function_info>&
 file_info& get_or_create_file(std::vector<file_info>&                             files,
                               std::unordered_map<std::string, module_info::id_t>& files_by_path,
                               std::string_view                                    file_path,
-                              const sample_source_info::id_t                      max_source_id)
+                              hit_counts_matrix&                                  file_hits)
 {
     const auto key = std::string(file_path);
 
@@ -99,10 +112,10 @@ file_info& get_or_create_file(std::vector<file_info>&
     if(iter == files_by_path.end())
     {
         files.push_back(file_info{
-            .id   = files.size(),
+            .id   = make_next_id<file_info::id_t>(files.size()),
             .path = std::string(file_path),
-            .hits = init_hits(max_source_id),
         });
+        file_hits.append_row();
         files_by_path[key] = files.back().id;
         return files.back();
     }
@@ -110,33 +123,163 @@ file_info& get_or_create_file(std::vector<file_info>&
     return files[iter->second];
 }
 
-call_tree_node& get_or_append_call_tree_child(std::vector<call_tree_node>&   call_tree_nodes,
-                                              call_tree_node&                current_node,
-                                              const function_info&           function,
-                                              const sample_source_info::id_t max_source_id)
+// Some nodes (e.g. thread entry points or event loop dispatchers) can have thousands of children,
+// hence we do not search the children of a node linearly but look them up by their function.
+using call_tree_children_map = std::unordered_map<std::pair<call_tree_node::id_t, function_info::id_t>, call_tree_node::id_t>;
+
+call_tree_node& get_or_append_call_tree_child(std::vector<call_tree_node>& call_tree_nodes,
+                                              call_tree_children_map&      children_by_function,
+                                              call_tree_node&              current_node,
+                                              const function_info&         function,
+                                              hit_counts_matrix&           call_tree_node_hits)
 {
-    for(const auto child_id : current_node.children)
-    {
-        auto& child_node = call_tree_nodes[child_id];
-        if(child_node.function_id == function.id)
-        {
-            return child_node;
-        }
-    }
+    const auto key = std::make_pair(current_node.id, function.id);
+
+    const auto iter = children_by_function.find(key);
+    if(iter != children_by_function.end()) return call_tree_nodes[iter->second];
+
+    const auto new_node_id = make_next_id<call_tree_node::id_t>(call_tree_nodes.size());
+    children_by_function.emplace(key, new_node_id);
 
-    const auto new_node_id = call_tree_nodes.size();
     current_node.children.push_back(new_node_id);
 
     // ATTENTION: changing `call_tree_nodes` might invalidate `current_node`.
     call_tree_nodes.push_back(call_tree_node{
         .id          = new_node_id,
         .function_id = function.id,
-        .hits        = init_hits(max_source_id),
         .children    = {},
     });
+    call_tree_node_hits.append_row();
     return call_tree_nodes.back();
 }
 
+// A matrix with the same rows and sources as `matrix`, but without any hits.
+hit_counts_matrix make_empty_hit_counts_matrix(const hit_counts_matrix& matrix)
+{
+    return hit_counts_matrix{
+        .source_count = matrix.source_count,
+        .counts       = std::vector<hit_counts>(matrix.counts.size())};
+}
+
+// Adds all the hits from `hits` to the respective entries in `target`.
+void add_hit_counts(hit_counts_matrix& target, const hit_counts_matrix& hits)
+{
+    assert(target.counts.size() == hits.counts.size());
+    for(std::size_t index = 0; index < hits.counts.size(); ++index)
+    {
+        target.counts[index].total += hits.counts[index].total;
+        target.counts[index].self += hits.counts[index].self;
+    }
+}
+
+// Collects hits per (row, key) pair while counting. Since the entries are only appended, this
+// needs just a few allocations. It is compacted into a `hits_table` when counting has finished.
+struct hits_table_builder
+{
+    hit_counts& get(std::size_t row, std::size_t key, sample_source_info::id_t source_id, std::size_t source_count)
+    {
+        const auto [iter, inserted] = entry_indices.try_emplace(std::make_pair(row, key), entries.size());
+        if(inserted)
+        {
+            entries.push_back(std::make_pair(row, key));
+            counts.resize(counts.size() + source_count);
+        }
+        return counts[iter->second * source_count + source_id];
+    }
+
+    std::unordered_map<std::pair<std::size_t, std::size_t>, std::size_t> entry_indices;
+    std::vector<std::pair<std::size_t, std::size_t>>                      entries; // (row, key)
+    std::vector<hit_counts>                                               counts;  // indexed by `entry_index * source_count + source_id`
+};
+
+// Merges the entries of all the builders into a single table. Entries for the same (row, key)
+// pair in different builders are summed up.
+hits_table make_hits_table(std::span<const hits_table_builder* const> builders,
+                           std::size_t                                row_count,
+                           std::size_t                                source_count)
+{
+    struct entry_ref
+    {
+        std::size_t key;
+        std::size_t builder_index;
+        std::size_t entry_index;
+    };
+
+    // Sort the entries by row (counting sort) first and by key within each row afterwards.
+    std::vector<std::size_t> row_offsets(row_count + 1, 0);
+    for(const auto* builder : builders)
+    {
+        for(const auto& [row, key] : builder->entries) ++row_offsets[row + 1];
+    }
+    for(std::size_t row = 0; row < row_count; ++row) row_offsets[row + 1] += row_offsets[row];
+
+    std::vector<entry_ref> sorted_entries(row_offsets.back());
+    {
+        auto insert_positions = row_offsets;
+        for(std::size_t builder_index = 0; builder_index < builders.size(); ++builder_index)
+        {
+            const auto& entries = builders[builder_index]->entries;
+            for(std::size_t entry_index = 0; entry_index < entries.size(); ++entry_index)
+            {
+                const auto& [row, key] = entries[entry_index];
+
+                sorted_entries[insert_positions[row]++] = entry_ref{.key = key, .builder_index = builder_index, .entry_index = entry_index};
+            }
+        }
+    }
+
+    hits_table result;
+    result.source_count = source_count;
+    result.offsets.reserve(row_count + 1);
+    result.keys.reserve(sorted_entries.size());
+    result.counts.reserve(sorted_entries.size() * source_count);
+
+    result.offsets.push_back(0);
+    for(std::size_t row = 0; row < row_count; ++row)
+    {
+        const auto row_entries = std::span(sorted_entries).subspan(row_offsets[row], row_offsets[row + 1] - row_offsets[row]);
+        std::ranges::sort(row_entries, {}, &entry_ref::key);
+
+        for(const auto& entry : row_entries)
+        {
+            const auto* const counts = builders[entry.builder_index]->counts.data() + entry.entry_index * source_count;
+
+            if(result.keys.size() == result.offsets.back() || result.keys.back() != entry.key)
+            {
+                result.keys.push_back(entry.key);
+                result.counts.insert(result.counts.end(), counts, counts + source_count);
+                continue;
+            }
+
+            auto* const merged_counts = result.counts.data() + result.counts.size() - source_count;
+            for(std::size_t source_id = 0; source_id < source_count; ++source_id)
+            {
+                merged_counts[source_id].total += counts[source_id].total;
+                merged_counts[source_id].self += counts[source_id].self;
+            }
+        }
+
+        result.offsets.push_back(result.keys.size());
+    }
+
+    return result;
+}
+
+std::size_t count_total_work(const samples_provider&          provider,
+                             unique_process_id                process_id,
+                             const sample_filter&             filter,
+                             const common::progress_listener* progress_listener)
+{
+    if(!progress_listener) return std::numeric_limits<std::size_t>::max();
+
+    std::size_t total_work = 0;
+    for(const auto& source_info : provider.sample_sources())
+    {
+        total_work += provider.count_samples(source_info.id, process_id, filter);
+    }
+    return total_work;
+}
+
 } // namespace
 
 const module_info& stacks_analysis::get_module(module_info::id_t id) const
@@ -184,184 +327,986 @@ const call_tree_node& stacks_analysis::get_call_tree_node(call_tree_node::id_t i
     return id == call_tree_root.id ? call_tree_root : call_tree_nodes.at(id);
 }
 
-stacks_analysis snail::analysis::analyze_stacks(const samples_provider&           provider,
-                                                unique_process_id                 process_id,
-                                                const sample_filter&              filter,
-                                                const common::progress_listener*  progress_listener,
-                                                const common::cancellation_token* cancellation_token)
+source_hit_counts_view stacks_analysis::get_hits(const module_info& module) const
+{
+    return module_hits.row(module.id);
+}
+
+source_hit_counts_view stacks_analysis::get_hits(const function_info& function) const
+{
+    return function_hits.row(get_function_row(function.id));
+}
+
+source_hit_counts_view stacks_analysis::get_hits(const call_tree_node& node) const
+{
+    return call_tree_node_hits.row(get_call_tree_node_row(node.id));
+}
+
+source_hit_counts_view stacks_analysis::get_hits(const file_info& file) const
+{
+    return file_hits.row(file.id);
+}
+
+hits_by_key_view stacks_analysis::get_callers(const function_info& function) const
+{
+    return function_callers.row(get_function_row(function.id));
+}
+
+hits_by_key_view stacks_analysis::get_callees(const function_info& function) const
+{
+    return function_callees.row(get_function_row(function.id));
+}
+
+hits_by_key_view stacks_analysis::get_hits_by_line(const function_info& function) const
+{
+    return function_hits_by_line.row(get_function_row(function.id));
+}
+
+std::size_t stacks_analysis::get_function_row(function_info::id_t id) const
+{
+    return id == function_root.id ? 0 : std::size_t(id) + 1;
+}
+
+std::size_t stacks_analysis::get_call_tree_node_row(call_tree_node::id_t id) const
 {
+    return id == call_tree_root.id ? 0 : std::size_t(id) + 1;
+}
+
+
+namespace snail::analysis::detail {
+
+// Creates the analysis of the stacks of a process in two steps:
+//  1. Collecting: All samples are read and every distinct stack is resolved (once) to the modules,
+//     functions, files and call tree nodes of the analysis. The caller gets notified about every
+//     sample and decides how to record the hits of the stacks.
+//  2. Counting: The recorded hits of all stacks are added to the entities of the analysis.
+class stacks_analysis_builder
+{
+public:
+    // A stack frame with all its information already mapped to ids in the analysis.
+    struct resolved_frame
+    {
+        module_info::id_t              module_id;
+        function_info::id_t            function_id;
+        call_tree_node::id_t           node_id;
+        std::optional<file_info::id_t> file_id;
+        std::size_t                    instruction_line_number;
+    };
+
+    // The frames of a collected stack. Samples without a stack but with a frame are collected as
+    // single frames with `has_stack == false`: they count for the entities of their frame only,
+    // but not for the roots, the call tree or any callers or callees.
+    struct resolved_frames_range
+    {
+        std::size_t offset;
+        std::size_t size;
+        bool        has_stack;
+    };
+
+    // Distinct stacks, resolved to the entities of `analysis`. No hits have been counted yet.
+    struct collected_stacks
+    {
+        stacks_analysis                    analysis;
+        std::vector<resolved_frames_range> stacks;
+        std::vector<resolved_frame>        frames;
+    };
+
+    // Hits of the collected stacks, indexed by `stack_index * source_count + source_id`.
+    using stack_hits_t = std::vector<std::size_t>;
+
+    static collected_stacks make_empty_collection(unique_process_id process_id, std::size_t source_count);
+
+    // Resolves the stacks of all samples of the given process that pass the filter.
+    // For every sample, `on_sample(record, source_id, stack_index)` is called.
+    // Returns `false` if the operation has been canceled.
+    template<typename OnSample>
+    static bool collect(collected_stacks&                 collected,
+                        const samples_provider&           provider,
+                        const sample_filter&              filter,
+                        common::progress_reporter&        progress,
+                        const common::cancellation_token* cancellation_token,
+                        OnSample&&                        on_sample);
+
+    // Copies all stacks that have any hits into a new collection, together with the entities they
+    // refer to. Hence, the new collection does not contain any entities without hits.
+    static collected_stacks extract_hit_stacks(const collected_stacks& collected,
+                                               const stack_hits_t&     stack_hits,
+                                               stack_hits_t&           extracted_stack_hits);
+
+    // Counts the given hits of all collected stacks into the entities of the collection's analysis.
+    static void count(collected_stacks&   collected,
+                      const stack_hits_t& stack_hits,
+                      std::size_t         max_worker_threads);
+};
+
+} // namespace snail::analysis::detail
+
+using detail::stacks_analysis_builder;
+
+stacks_analysis_builder::collected_stacks stacks_analysis_builder::make_empty_collection(unique_process_id process_id, std::size_t source_count)
+{
+    collected_stacks result;
+
+    auto& analysis      = result.analysis;
+    analysis.process_id = process_id;
+
+    analysis.function_root = function_info{
+        .id          = stacks_analysis::root_function_id,
+        .module_id   = module_info::id_t(-1),
+        .name        = "root",
+        .file_id     = {},
+        .line_number = {},
+    };
+
+    analysis.call_tree_root = call_tree_node{
+        .id          = stacks_analysis::root_call_tree_node_id,
+        .function_id = analysis.function_root.id,
+        .children    = {},
+    };
+
+    // The hits of the roots are stored in the first row.
+    for(auto* const hits : {&analysis.module_hits, &analysis.function_hits, &analysis.call_tree_node_hits, &analysis.file_hits})
+    {
+        hits->source_count = source_count;
+    }
+    analysis.function_hits.append_row();
+    analysis.call_tree_node_hits.append_row();
+
+    return result;
+}
+
+template<typename OnSample>
+bool stacks_analysis_builder::collect(collected_stacks&                 collected,
+                                      const samples_provider&           provider,
+                                      const sample_filter&              filter,
+                                      common::progress_reporter&        progress,
+                                      const common::cancellation_token* cancellation_token,
+                                      OnSample&&                        on_sample)
+{
+    auto& result = collected.analysis;
+
     std::unordered_map<std::string, module_info::id_t>                               modules_by_name;
     std::unordered_map<std::pair<module_info::id_t, std::string>, module_info::id_t> functions_by_name;
     std::unordered_map<std::string, file_info::id_t>                                 files_by_path;
+    call_tree_children_map                                                           call_tree_children;
 
-    stacks_analysis result;
-    result.process_id = process_id;
-
-    const auto sources       = provider.sample_sources();
-    const auto max_source_id = sources.back().id;
-
-    result.function_root = function_info{
-        .id           = stacks_analysis::root_function_id,
-        .module_id    = std::size_t(-1),
-        .name         = "root",
-        .hits         = init_hits(max_source_id),
-        .callers      = {},
-        .callees      = {},
-        .file_id      = {},
-        .line_number  = {},
-        .hits_by_line = {},
+    // If the provider interned the strings of the frames, we look up the modules, functions and files
+    // by those ids and only need to fall back to the strings once per distinct id.
+    std::unordered_map<common::string_interner::id_t, module_info::id_t>                                 modules_by_name_id;
+    std::unordered_map<std::pair<module_info::id_t, common::string_interner::id_t>, function_info::id_t> functions_by_name_id;
+    std::unordered_map<common::string_interner::id_t, file_info::id_t>                                   files_by_path_id;
+
+    const auto get_frame_module = [&](const stack_frame& frame) -> module_info&
+    {
+        if(frame.ids == std::nullopt) return get_or_create_module(result.modules, modules_by_name, frame.module_name, result.module_hits);
+
+        const auto iter = modules_by_name_id.find(frame.ids->module_name);
+        if(iter != modules_by_name_id.end()) return result.modules[iter->second];
+
+        auto& module = get_or_create_module(result.modules, modules_by_name, frame.module_name, result.module_hits);
+        modules_by_name_id.emplace(frame.ids->module_name, module.id);
+        return module;
     };
 
-    result.call_tree_root = call_tree_node{
-        .id          = stacks_analysis::root_call_tree_node_id,
-        .function_id = result.function_root.id,
-        .hits        = init_hits(max_source_id),
-        .children    = {},
+    const auto get_frame_function = [&](const stack_frame& frame, const module_info& module) -> function_info&
+    {
+        if(frame.ids == std::nullopt) return get_or_create_function(result.functions, functions_by_name, module, frame.symbol_name, result.function_hits);
+
+        const auto key  = std::make_pair(module.id, frame.ids->symbol_name);
+        const auto iter = functions_by_name_id.find(key);
+        if(iter != functions_by_name_id.end()) return result.functions[iter->second];
+
+        auto& function = get_or_create_function(result.functions, functions_by_name, module, frame.symbol_name, result.function_hits);
+        functions_by_name_id.emplace(key, function.id);
+        return function;
     };
 
-    std::size_t total_work = 0;
-    if(progress_listener)
+    const auto get_frame_file = [&](const stack_frame& frame) -> file_info*
+    {
+        if(frame.file_path.empty()) return nullptr;
+        if(frame.ids == std::nullopt) return &get_or_create_file(result.files, files_by_path, frame.file_path, result.file_hits);
+
+        const auto iter = files_by_path_id.find(frame.ids->file_path);
+        if(iter != files_by_path_id.end()) return &result.files[iter->second];
+
+        auto& file = get_or_create_file(result.files, files_by_path, frame.file_path, result.file_hits);
+        files_by_path_id.emplace(frame.ids->file_path, file.id);
+        return &file;
+    };
+
+    // Maps all frames of a stack to the ids of their modules, functions, files and call tree nodes.
+    // This creates the respective entries in the result, if they do not exist yet.
+    const auto resolve_stack = [&](const sample_data& sample)
     {
-        for(const auto& source_info : provider.sample_sources())
+        std::optional<call_tree_node::id_t> previous_node_id;
+
+        for(const auto& stack_frame : sample.reversed_stack())
         {
-            total_work += provider.count_samples(source_info.id, process_id, filter);
+            auto&       module   = get_frame_module(stack_frame);
+            auto&       function = get_frame_function(stack_frame, module);
+            auto&       node     = get_or_append_call_tree_child(result.call_tree_nodes, call_tree_children, previous_node_id ? result.call_tree_nodes[*previous_node_id] : result.call_tree_root, function, result.call_tree_node_hits);
+            auto* const file     = get_frame_file(stack_frame);
+
+            if(file != nullptr)
+            {
+                assert(function.file_id == std::nullopt || *function.file_id == file->id);
+                if(function.file_id == std::nullopt)
+                {
+                    function.file_id = file->id;
+                }
+                // assert(function.line_number == std::nullopt || *function.line_number == stack_frame.function_line_number);
+                if(function.line_number == std::nullopt)
+                {
+                    function.line_number = stack_frame.function_line_number;
+                }
+            }
+
+            collected.frames.push_back(resolved_frame{
+                .module_id               = module.id,
+                .function_id             = function.id,
+                .node_id                 = node.id,
+                .file_id                 = file == nullptr ? std::nullopt : std::optional(file->id),
+                .instruction_line_number = stack_frame.instruction_line_number});
+
+            previous_node_id = node.id;
         }
-    }
-    else
+    };
+
+    const auto resolve_frame = [&](const stack_frame& stack_frame) -> resolved_frame
     {
-        total_work = std::numeric_limits<std::size_t>::max();
-    }
+        auto&       module   = get_frame_module(stack_frame);
+        auto&       function = get_frame_function(stack_frame, module);
+        auto* const file     = get_frame_file(stack_frame);
 
-    common::progress_reporter progress(progress_listener, total_work, "Analyzing samples");
+        if(file != nullptr)
+        {
+            assert(function.file_id == std::nullopt || *function.file_id == file->id);
+            if(function.file_id == std::nullopt)
+            {
+                function.file_id = file->id;
+            }
+            assert(function.line_number == std::nullopt || *function.line_number == stack_frame.function_line_number);
+            if(function.line_number == std::nullopt)
+            {
+                function.line_number = stack_frame.function_line_number;
+            }
+        }
 
-    bool cancel = false;
+        return resolved_frame{
+            .module_id               = module.id,
+            .function_id             = function.id,
+            .node_id                 = result.call_tree_root.id, // not used
+            .file_id                 = file == nullptr ? std::nullopt : std::optional(file->id),
+            .instruction_line_number = stack_frame.instruction_line_number};
+    };
 
-    for(const auto& source_info : provider.sample_sources())
+    // Every distinct stack is resolved only once. Samples without a stack key are recorded as a
+    // distinct stack each. Samples without a stack are still resolved individually, but are
+    // recorded only once per distinct function and line.
+    std::unordered_map<std::uint64_t, std::size_t> stack_indices_by_key;
+
+    using frame_key_t = std::pair<std::pair<function_info::id_t, file_info::id_t>, std::size_t>;
+    std::unordered_map<frame_key_t, std::size_t> frame_stack_indices;
+
+    const auto get_stack_index = [&](const sample_batch& batch, std::size_t sample_index) -> std::size_t
     {
-        if(cancel) break;
+        const auto& stack_key = batch.records()[sample_index].stack_key;
+        if(stack_key != std::nullopt)
+        {
+            const auto iter = stack_indices_by_key.find(*stack_key);
+            if(iter != stack_indices_by_key.end()) return iter->second;
+        }
+
+        const auto offset = collected.frames.size();
+        resolve_stack(batch.sample(sample_index));
 
-        for(const auto& sample : provider.samples(source_info.id, process_id, filter))
+        const auto stack_index = collected.stacks.size();
+        collected.stacks.push_back(resolved_frames_range{.offset = offset, .size = collected.frames.size() - offset, .has_stack = true});
+
+        if(stack_key != std::nullopt) stack_indices_by_key.emplace(*stack_key, stack_index);
+
+        return stack_index;
+    };
+
+    const auto get_frame_stack_index = [&](const sample_batch& batch, std::size_t sample_index) -> std::size_t
+    {
+        const auto frame = resolve_frame(batch.sample(sample_index).frame());
+
+        const auto key = std::make_pair(std::make_pair(frame.function_id, frame.file_id.value_or(file_info::id_t(-1))),
+                                        frame.instruction_line_number);
+
+        const auto [iter, inserted] = frame_stack_indices.try_emplace(key, collected.stacks.size());
+        if(inserted)
         {
-            if(cancellation_token && cancellation_token->is_canceled())
+            collected.stacks.push_back(resolved_frames_range{.offset = collected.frames.size(), .size = 1, .has_stack = false});
+            collected.frames.push_back(frame);
+        }
+        return iter->second;
+    };
+
+    for(const auto& source_info : provider.sample_sources())
+    {
+        for(const auto& batch : provider.sample_batches(source_info.id, result.process_id, filter))
+        {
+            if(cancellation_token && cancellation_token->is_canceled()) return false;
+
+            const auto records = batch.records();
+            progress.progress(records.size());
+
+            for(std::size_t sample_index = 0; sample_index < records.size(); ++sample_index)
             {
-                cancel = true;
-                break;
+                const auto& record = records[sample_index];
+
+                if(record.has_stack)
+                {
+                    on_sample(record, source_info.id, get_stack_index(batch, sample_index));
+                }
+                else if(record.instruction_pointer)
+                {
+                    on_sample(record, source_info.id, get_frame_stack_index(batch, sample_index));
+                }
             }
-            progress.progress(1);
+        }
+    }
 
-            if(sample.has_stack())
-            {
-                ++result.call_tree_root.hits.get(source_info.id).total;
-                ++result.function_root.hits.get(source_info.id).total;
+    return true;
+}
+
+stacks_analysis_builder::collected_stacks stacks_analysis_builder::extract_hit_stacks(const collected_stacks& collected,
+                                                                                      const stack_hits_t&     stack_hits,
+                                                                                      stack_hits_t&           extracted_stack_hits)
+{
+    const auto& source = collected.analysis;
+
+    const auto source_count = source.function_hits.source_count;
+
+    auto  extracted = make_empty_collection(source.process_id, source_count);
+    auto& result    = extracted.analysis;
+
+    extracted_stack_hits.clear();
+
+    // Map from the ids in the source analysis to the ids in the new one.
+    constexpr auto           no_id = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> module_ids(source.modules.size(), no_id);
+    std::vector<std::uint32_t> function_ids(source.functions.size(), no_id);
+    std::vector<std::uint32_t> file_ids(source.files.size(), no_id);
+    std::vector<std::uint32_t> node_ids(source.call_tree_nodes.size(), no_id);
+
+    const auto map_module = [&](module_info::id_t id) -> module_info::id_t
+    {
+        auto& new_id = module_ids[id];
+        if(new_id != no_id) return new_id;
+
+        new_id = make_next_id<module_info::id_t>(result.modules.size());
+        result.modules.push_back(module_info{
+            .id   = new_id,
+            .name = source.modules[id].name,
+        });
+        result.module_hits.append_row();
+        return new_id;
+    };
+
+    const auto map_file = [&](file_info::id_t id) -> file_info::id_t
+    {
+        auto& new_id = file_ids[id];
+        if(new_id != no_id) return new_id;
+
+        new_id = make_next_id<file_info::id_t>(result.files.size());
+        result.files.push_back(file_info{
+            .id   = new_id,
+            .path = source.files[id].path,
+        });
+        result.file_hits.append_row();
+        return new_id;
+    };
+
+    const auto map_function = [&](const resolved_frame& frame) -> function_info::id_t
+    {
+        auto& new_id = function_ids[frame.function_id];
+        if(new_id == no_id)
+        {
+            new_id = make_next_id<function_info::id_t>(result.functions.size());
+            result.functions.push_back(function_info{
+                .id          = new_id,
+                .module_id   = map_module(frame.module_id),
+                .name        = source.functions[frame.function_id].name,
+                .file_id     = {},
+                .line_number = {},
+            });
+            result.function_hits.append_row();
+        }
+
+        // Like when collecting, functions only get a file once they appear in a frame with a file.
+        auto& function = result.functions[new_id];
+        if(frame.file_id && function.file_id == std::nullopt)
+        {
+            function.file_id     = map_file(*frame.file_id);
+            function.line_number = source.functions[frame.function_id].line_number;
+        }
+        return new_id;
+    };
+
+    const auto map_node = [&](call_tree_node::id_t id, call_tree_node& new_parent, function_info::id_t new_function_id) -> call_tree_node::id_t
+    {
+        auto& new_id = node_ids[id];
+        if(new_id != no_id) return new_id;
+
+        new_id = make_next_id<call_tree_node::id_t>(result.call_tree_nodes.size());
+        new_parent.children.push_back(new_id);
+
+        // ATTENTION: changing `call_tree_nodes` might invalidate `new_parent`.
+        result.call_tree_nodes.push_back(call_tree_node{
+            .id          = new_id,
+            .function_id = new_function_id,
+            .children    = {},
+        });
+        result.call_tree_node_hits.append_row();
+        return new_id;
+    };
+
+    for(std::size_t stack_index = 0; stack_index < collected.stacks.size(); ++stack_index)
+    {
+        const auto hits = std::span(stack_hits).subspan(stack_index * source_count, source_count);
+        if(std::ranges::all_of(hits, [](std::size_t count)
+                               { return count == 0; })) continue;
+
+        const auto& stack = collected.stacks[stack_index];
+
+        const auto offset = extracted.frames.size();
+
+        std::optional<call_tree_node::id_t> previous_node_id;
+        for(const auto& frame : std::span(collected.frames).subspan(stack.offset, stack.size))
+        {
+            const auto function_id = map_function(frame);
+            const auto node_id     = stack.has_stack ?
+                                         map_node(frame.node_id, previous_node_id ? result.call_tree_nodes[*previous_node_id] : result.call_tree_root, function_id) :
+                                         result.call_tree_root.id;
 
-                std::optional<module_info::id_t>   previous_node_id;
-                std::optional<module_info::id_t>   previous_module_id;
-                std::optional<function_info::id_t> previous_function_id;
-                std::optional<file_info::id_t>     previous_file_id;
-                std::optional<std::size_t>         previous_line_number;
+            extracted.frames.push_back(resolved_frame{
+                .module_id               = module_ids[frame.module_id],
+                .function_id             = function_id,
+                .node_id                 = node_id,
+                .file_id                 = frame.file_id ? std::optional(map_file(*frame.file_id)) : std::nullopt,
+                .instruction_line_number = frame.instruction_line_number});
 
-                for(const auto stack_frame : sample.reversed_stack())
+            previous_node_id = node_id;
+        }
+
+        extracted.stacks.push_back(resolved_frames_range{.offset = offset, .size = stack.size, .has_stack = stack.has_stack});
+        extracted_stack_hits.insert(extracted_stack_hits.end(), hits.begin(), hits.end());
+    }
+
+    return extracted;
+}
+
+void stacks_analysis_builder::count(collected_stacks&   collected,
+                                    const stack_hits_t& stack_hits,
+                                    std::size_t         max_worker_threads)
+{
+    auto& result = collected.analysis;
+
+    const auto source_count = result.function_hits.source_count;
+
+    const auto& resolved_stacks       = collected.stacks;
+    const auto& resolved_stack_frames = collected.frames;
+
+    assert(stack_hits.size() == resolved_stacks.size() * source_count);
+
+    // Each worker counts a contiguous range of the stacks into its own hit matrices and builders.
+    // Afterwards, the results of all workers are summed up in the order of the workers, so that the
+    // result does not depend on the number of workers.
+    struct worker_hits
+    {
+        hit_counts_matrix module_hits;
+        hit_counts_matrix function_hits;
+        hit_counts_matrix call_tree_node_hits;
+        hit_counts_matrix file_hits;
+
+        hits_table_builder callers;
+        hits_table_builder callees;
+        hits_table_builder hits_by_line;
+    };
+
+    const auto count_stack_hits = [&](worker_hits& worker, const std::size_t first_stack_index, const std::size_t last_stack_index)
+    {
+        for(std::size_t stack_index = first_stack_index; stack_index < last_stack_index; ++stack_index)
+        {
+            const auto& stack  = resolved_stacks[stack_index];
+            const auto  frames = std::span(resolved_stack_frames).subspan(stack.offset, stack.size);
+
+            for(sample_source_info::id_t source_id = 0; source_id < source_count; ++source_id)
+            {
+                const auto hits = stack_hits[stack_index * source_count + source_id];
+                if(hits == 0) continue;
+
+                // samples without a stack only have hits for their own frame
+                if(!stack.has_stack)
                 {
-                    auto&       module   = get_or_create_module(result.modules, modules_by_name, stack_frame.module_name, max_source_id);
-                    auto&       function = get_or_create_function(result.functions, functions_by_name, module, stack_frame.symbol_name, max_source_id);
-                    auto&       node     = get_or_append_call_tree_child(result.call_tree_nodes, previous_node_id ? result.call_tree_nodes[*previous_node_id] : result.call_tree_root, function, max_source_id);
-                    auto* const file     = stack_frame.file_path.empty() ? nullptr : &get_or_create_file(result.files, files_by_path, stack_frame.file_path, max_source_id);
+                    assert(frames.size() == 1);
+                    const auto& frame = frames.front();
 
-                    ++module.hits.get(source_info.id).total;
-                    ++function.hits.get(source_info.id).total;
-                    ++node.hits.get(source_info.id).total;
-                    if(file != nullptr) ++file->hits.get(source_info.id).total;
+                    auto& module_hits = worker.module_hits.get(frame.module_id, source_id);
+                    module_hits.total += hits;
+                    module_hits.self += hits;
 
-                    if(previous_function_id)
+                    if(frame.file_id)
                     {
-                        auto& previous_function = result.functions[*previous_function_id];
-                        ++previous_function.callees[function.id].get(source_info.id).total;
-                        ++function.callers[previous_function.id].get(source_info.id).total;
-                    }
-                    else
-                    {
-                        auto& previous_function = result.function_root;
-                        ++previous_function.callees[function.id].get(source_info.id).total;
-                        ++function.callers[previous_function.id].get(source_info.id).total;
+                        auto& file_hits = worker.file_hits.get(*frame.file_id, source_id);
+                        file_hits.total += hits;
+                        file_hits.self += hits;
                     }
 
-                    if(file != nullptr)
+                    auto& function_hits = worker.function_hits.get(result.get_function_row(frame.function_id), source_id);
+                    function_hits.total += hits;
+                    function_hits.self += hits;
+                    if(frame.file_id)
                     {
-                        assert(function.file_id == std::nullopt || *function.file_id == file->id);
-                        if(function.file_id == std::nullopt)
-                        {
-                            function.file_id = file->id;
-                        }
-                        // assert(function.line_number == std::nullopt || *function.line_number == stack_frame.function_line_number);
-                        if(function.line_number == std::nullopt)
-                        {
-                            function.line_number = stack_frame.function_line_number;
-                        }
-                        ++function.hits_by_line[stack_frame.instruction_line_number].get(source_info.id).total;
+                        auto& line_hits = worker.hits_by_line.get(result.get_function_row(frame.function_id), frame.instruction_line_number, source_id, source_count);
+                        line_hits.total += hits;
+                        line_hits.self += hits;
                     }
+                    continue;
+                }
+
+                worker.call_tree_node_hits.get(0, source_id).total += hits;
+                worker.function_hits.get(0, source_id).total += hits;
+
+                auto previous_function_id = result.function_root.id;
+
+                for(const auto& frame : frames)
+                {
+                    worker.module_hits.get(frame.module_id, source_id).total += hits;
+                    worker.call_tree_node_hits.get(result.get_call_tree_node_row(frame.node_id), source_id).total += hits;
+                    if(frame.file_id) worker.file_hits.get(*frame.file_id, source_id).total += hits;
+
+                    worker.callees.get(result.get_function_row(previous_function_id), frame.function_id, source_id, source_count).total += hits;
 
-                    previous_module_id   = module.id;
-                    previous_function_id = function.id;
-                    previous_node_id     = node.id;
-                    previous_file_id     = file == nullptr ? std::nullopt : std::optional(file->id);
-                    previous_line_number = stack_frame.instruction_line_number;
+                    worker.function_hits.get(result.get_function_row(frame.function_id), source_id).total += hits;
+                    worker.callers.get(result.get_function_row(frame.function_id), previous_function_id, source_id, source_count).total += hits;
+                    if(frame.file_id) worker.hits_by_line.get(result.get_function_row(frame.function_id), frame.instruction_line_number, source_id, source_count).total += hits;
+
+                    previous_function_id = frame.function_id;
                 }
 
                 // final elements at the top of the stack have self hits
-                if(previous_module_id) ++result.modules[*previous_module_id].hits.get(source_info.id).self;
-                if(previous_node_id) ++result.call_tree_nodes[*previous_node_id].hits.get(source_info.id).self;
-                else ++result.call_tree_root.hits.get(source_info.id).self;
-                if(previous_file_id) ++result.files[*previous_file_id].hits.get(source_info.id).self;
-                if(previous_function_id)
+                if(frames.empty())
                 {
-                    ++result.functions[*previous_function_id].hits.get(source_info.id).self;
-                    if(previous_file_id && previous_line_number)
-                    {
-                        assert(*previous_file_id == result.functions[*previous_function_id].file_id);
-                        ++result.functions[*previous_function_id].hits_by_line[*previous_line_number].get(source_info.id).self;
-                    }
+                    worker.call_tree_node_hits.get(0, source_id).self += hits;
+                    worker.function_hits.get(0, source_id).self += hits;
+                    continue;
                 }
-                else
+
+                const auto& top_frame = frames.back();
+                worker.module_hits.get(top_frame.module_id, source_id).self += hits;
+                worker.call_tree_node_hits.get(result.get_call_tree_node_row(top_frame.node_id), source_id).self += hits;
+                if(top_frame.file_id) worker.file_hits.get(*top_frame.file_id, source_id).self += hits;
+                worker.function_hits.get(result.get_function_row(top_frame.function_id), source_id).self += hits;
+                if(top_frame.file_id)
                 {
-                    ++result.function_root.hits.get(source_info.id).self;
+                    assert(*top_frame.file_id == result.functions[top_frame.function_id].file_id);
+                    worker.hits_by_line.get(result.get_function_row(top_frame.function_id), top_frame.instruction_line_number, source_id, source_count).self += hits;
                 }
             }
-            else if(sample.has_frame())
-            {
-                const auto stack_frame = sample.frame();
+        }
+    };
+
+    // When choosing the number of workers automatically, only use multiple workers if there
+    // is enough work to amortize starting the threads. Additionally, every worker but the first
+    // needs its own copy of the hit matrices, hence limit the number of workers so that those
+    // copies stay within a fixed memory budget.
+    constexpr std::size_t min_frames_per_worker        = 16 * 1024;
+    constexpr std::size_t max_worker_matrices_in_bytes = 256 * 1024 * 1024;
+
+    const auto matrices_in_bytes = (result.module_hits.counts.size() +
+                                    result.function_hits.counts.size() +
+                                    result.call_tree_node_hits.counts.size() +
+                                    result.file_hits.counts.size()) *
+                                   sizeof(hit_counts);
+
+    const auto max_automatic_worker_count = std::min(std::max(std::size_t(std::thread::hardware_concurrency()), std::size_t(1)),
+                                                     1 + max_worker_matrices_in_bytes / std::max(matrices_in_bytes, std::size_t(1)));
+
+    const auto worker_count = max_worker_threads == 0 ?
+                                  std::clamp(resolved_stack_frames.size() / min_frames_per_worker, std::size_t(1), max_automatic_worker_count) :
+                                  max_worker_threads;
 
-                auto&       module   = get_or_create_module(result.modules, modules_by_name, stack_frame.module_name, max_source_id);
-                auto&       function = get_or_create_function(result.functions, functions_by_name, module, stack_frame.symbol_name, max_source_id);
-                auto* const file     = stack_frame.file_path.empty() ? nullptr : &get_or_create_file(result.files, files_by_path, stack_frame.file_path, max_source_id);
+    std::vector<worker_hits> workers_hits(worker_count);
+
+    // The first worker counts directly into the analysis, all others start with empty matrices of the same shape.
+    workers_hits[0].module_hits         = std::move(result.module_hits);
+    workers_hits[0].function_hits       = std::move(result.function_hits);
+    workers_hits[0].call_tree_node_hits = std::move(result.call_tree_node_hits);
+    workers_hits[0].file_hits           = std::move(result.file_hits);
+    for(std::size_t worker_index = 1; worker_index < worker_count; ++worker_index)
+    {
+        auto& worker               = workers_hits[worker_index];
+        worker.module_hits         = make_empty_hit_counts_matrix(workers_hits[0].module_hits);
+        worker.function_hits       = make_empty_hit_counts_matrix(workers_hits[0].function_hits);
+        worker.call_tree_node_hits = make_empty_hit_counts_matrix(workers_hits[0].call_tree_node_hits);
+        worker.file_hits           = make_empty_hit_counts_matrix(workers_hits[0].file_hits);
+    }
+
+    if(worker_count == 1)
+    {
+        count_stack_hits(workers_hits[0], 0, resolved_stacks.size());
+    }
+    else
+    {
+        // Split the stacks into ranges with roughly the same number of frames each.
+        std::vector<std::size_t> worker_first_stack_indices(worker_count + 1, resolved_stacks.size());
+        worker_first_stack_indices[0] = 0;
+        {
+            std::size_t worker_index = 1;
+            std::size_t frame_count  = 0;
+            for(std::size_t stack_index = 0; stack_index < resolved_stacks.size() && worker_index < worker_count; ++stack_index)
+            {
+                while(worker_index < worker_count && frame_count >= resolved_stack_frames.size() * worker_index / worker_count)
+                {
+                    worker_first_stack_indices[worker_index++] = stack_index;
+                }
+                frame_count += resolved_stacks[stack_index].size;
+            }
+        }
 
-                ++module.hits.get(source_info.id).total;
-                ++function.hits.get(source_info.id).total;
-                if(file != nullptr) ++file->hits.get(source_info.id).total;
+        common::thread_pool workers(worker_count - 1);
 
-                ++module.hits.get(source_info.id).self;
-                ++function.hits.get(source_info.id).self;
-                if(file != nullptr) ++file->hits.get(source_info.id).self;
+        std::vector<std::future<void>> finished;
+        for(std::size_t worker_index = 1; worker_index < worker_count; ++worker_index)
+        {
+            auto finished_promise = std::make_shared<std::promise<void>>();
+            finished.push_back(finished_promise->get_future());
 
-                if(file != nullptr)
+            workers.submit(
+                [&count_stack_hits, &workers_hits, &worker_first_stack_indices, finished_promise, worker_index]()
                 {
-                    assert(function.file_id == std::nullopt || *function.file_id == file->id);
-                    if(function.file_id == std::nullopt)
+                    try
                     {
-                        function.file_id = file->id;
+                        count_stack_hits(workers_hits[worker_index], worker_first_stack_indices[worker_index], worker_first_stack_indices[worker_index + 1]);
+                        finished_promise->set_value();
                     }
-                    assert(function.line_number == std::nullopt || *function.line_number == stack_frame.function_line_number);
-                    if(function.line_number == std::nullopt)
+                    catch(...)
                     {
-                        function.line_number = stack_frame.function_line_number;
+                        finished_promise->set_exception(std::current_exception());
                     }
-                    ++function.hits_by_line[stack_frame.instruction_line_number].get(source_info.id).total;
-                    ++function.hits_by_line[stack_frame.instruction_line_number].get(source_info.id).self;
+                });
+        }
+
+        count_stack_hits(workers_hits[0], worker_first_stack_indices[0], worker_first_stack_indices[1]);
+
+        for(auto& worker_finished : finished)
+        {
+            worker_finished.get(); // will rethrow any exceptions from the workers
+        }
+    }
+
+    // Finally, merge the counts of all workers and compact the collected callers, callees and line hits.
+    result.module_hits         = std::move(workers_hits[0].module_hits);
+    result.function_hits       = std::move(workers_hits[0].function_hits);
+    result.call_tree_node_hits = std::move(workers_hits[0].call_tree_node_hits);
+    result.file_hits           = std::move(workers_hits[0].file_hits);
+    for(std::size_t worker_index = 1; worker_index < worker_count; ++worker_index)
+    {
+        const auto& worker = workers_hits[worker_index];
+        add_hit_counts(result.module_hits, worker.module_hits);
+        add_hit_counts(result.function_hits, worker.function_hits);
+        add_hit_counts(result.call_tree_node_hits, worker.call_tree_node_hits);
+        add_hit_counts(result.file_hits, worker.file_hits);
+    }
+
+    const auto function_row_count = result.functions.size() + 1;
+
+    std::vector<const hits_table_builder*> callers_builders;
+    std::vector<const hits_table_builder*> callees_builders;
+    std::vector<const hits_table_builder*> hits_by_line_builders;
+    for(const auto& worker : workers_hits)
+    {
+        callers_builders.push_back(&worker.callers);
+        callees_builders.push_back(&worker.callees);
+        hits_by_line_builders.push_back(&worker.hits_by_line);
+    }
+
+    result.function_callers      = make_hits_table(callers_builders, function_row_count, source_count);
+    result.function_callees      = make_hits_table(callees_builders, function_row_count, source_count);
+    result.function_hits_by_line = make_hits_table(hits_by_line_builders, function_row_count, source_count);
+}
+
+stacks_analysis snail::analysis::analyze_stacks(const samples_provider&           provider,
+                                                unique_process_id                 process_id,
+                                                const sample_filter&              filter,
+                                                const common::progress_listener*  progress_listener,
+                                                const common::cancellation_token* cancellation_token,
+                                                std::size_t                       max_worker_threads)
+{
+    const auto source_count = provider.sample_sources().back().id + 1;
+
+    auto collected = stacks_analysis_builder::make_empty_collection(process_id, source_count);
+
+    common::progress_reporter progress(progress_listener, count_total_work(provider, process_id, filter, progress_listener), "Analyzing samples");
+
+    stacks_analysis_builder::stack_hits_t stack_hits;
+
+    const auto completed = stacks_analysis_builder::collect(
+        collected, provider, filter, progress, cancellation_token,
+        [&stack_hits, source_count](const sample_record& /*record*/, sample_source_info::id_t source_id, std::size_t stack_index)
+        {
+            if(stack_hits.size() <= stack_index * source_count) stack_hits.resize((stack_index + 1) * source_count, 0);
+            ++stack_hits[stack_index * source_count + source_id];
+        });
+
+    stack_hits.resize(collected.stacks.size() * source_count, 0);
+
+    stacks_analysis_builder::count(collected, stack_hits, max_worker_threads);
+
+    if(completed) progress.finish();
+
+    return std::move(collected.analysis);
+}
+
+struct stacks_time_index::impl
+{
+    // A single sample, referring to the stack it hit.
+    struct sample_entry
+    {
+        std::chrono::nanoseconds timestamp;
+        std::uint32_t            stack_index;
+        std::uint32_t            source_id;
+        std::uint32_t            thread_index;
+    };
+
+    // Sparse hits of stacks. Each entry is a pair of `stack_index * source_count + source_id` and the
+    // number of hits.
+    using stack_hits_entry = std::pair<std::size_t, std::size_t>;
+
+    // The samples are grouped into buckets of this many consecutive samples (in time).
+    static constexpr std::size_t samples_per_bucket = 4096;
+
+    stacks_analysis_builder::collected_stacks stacks;
+
+    std::size_t source_count;
+
+    // All samples of the process, sorted by time.
+    std::vector<sample_entry> samples;
+
+    // The number of hits per stack and source in each bucket: The entries of bucket `i` are the
+    // ones at the positions `bucket_offsets[i]` up to `bucket_offsets[i + 1]` in `bucket_hits`.
+    std::vector<std::size_t>      bucket_offsets;
+    std::vector<stack_hits_entry> bucket_hits;
+
+    // All threads that have samples, referred to by their index in this list.
+    std::vector<unique_thread_id>                        threads;
+    std::unordered_map<unique_thread_id, std::uint32_t> thread_indices;
+
+    // The positions in `samples` of the samples of each thread, in ascending order: The samples of
+    // thread `i` are the ones listed at `thread_sample_offsets[i]` up to `thread_sample_offsets[i + 1]`
+    // in `thread_samples`. The number of hits of all samples of each thread are stored the same way.
+    // This allows to subtract the hits of excluded threads without looking at any other thread.
+    std::vector<std::size_t>      thread_sample_offsets;
+    std::vector<std::uint32_t>    thread_samples;
+    std::vector<std::size_t>      thread_hits_offsets;
+    std::vector<stack_hits_entry> thread_hits;
+};
+
+stacks_time_index::stacks_time_index(std::unique_ptr<impl> impl) :
+    impl_(std::move(impl))
+{}
+
+stacks_time_index::stacks_time_index(stacks_time_index&&) noexcept            = default;
+stacks_time_index& stacks_time_index::operator=(stacks_time_index&&) noexcept = default;
+
+stacks_time_index::~stacks_time_index() = default;
+
+unique_process_id stacks_time_index::process_id() const
+{
+    return impl_->stacks.analysis.process_id;
+}
+
+std::optional<stacks_time_index> snail::analysis::make_stacks_time_index(const samples_provider&           provider,
+                                                                         unique_process_id                 process_id,
+                                                                         const common::progress_listener*  progress_listener,
+                                                                         const common::cancellation_token* cancellation_token)
+{
+    using sample_entry     = stacks_time_index::impl::sample_entry;
+    using stack_hits_entry = stacks_time_index::impl::stack_hits_entry;
+
+    const auto source_count = provider.sample_sources().back().id + 1;
+
+    auto index          = std::make_unique<stacks_time_index::impl>();
+    index->stacks       = stacks_analysis_builder::make_empty_collection(process_id, source_count);
+    index->source_count = source_count;
+
+    const sample_filter no_filter = {};
+
+    common::progress_reporter progress(progress_listener, count_total_work(provider, process_id, no_filter, progress_listener), "Indexing samples");
+
+    const auto completed = stacks_analysis_builder::collect(
+        index->stacks, provider, no_filter, progress, cancellation_token,
+        [&index](const sample_record& record, sample_source_info::id_t source_id, std::size_t stack_index)
+        {
+            if(stack_index >= std::numeric_limits<std::uint32_t>::max()) throw std::runtime_error("Too many stacks for a time index");
+
+            const auto [thread_iter, inserted] = index->thread_indices.try_emplace(record.thread_id, static_cast<std::uint32_t>(index->threads.size()));
+            if(inserted) index->threads.push_back(record.thread_id);
+
+            index->samples.push_back(sample_entry{
+                .timestamp    = record.timestamp,
+                .stack_index  = static_cast<std::uint32_t>(stack_index),
+                .source_id    = static_cast<std::uint32_t>(source_id),
+                .thread_index = thread_iter->second});
+        });
+    if(!completed) return std::nullopt;
+
+    if(index->samples.size() >= std::numeric_limits<std::uint32_t>::max()) throw std::runtime_error("Too many samples for a time index");
+
+    // The samples have been collected per source and thread, hence they need to be sorted by time.
+    std::ranges::stable_sort(index->samples, {}, &sample_entry::timestamp);
+
+    std::unordered_map<std::size_t, std::size_t> current_hits;
+
+    const auto append_hits = [&current_hits, &index, source_count](std::vector<stack_hits_entry>& hits, auto&& sample_indices)
+    {
+        current_hits.clear();
+        for(const auto sample_index : sample_indices)
+        {
+            const auto& sample = index->samples[sample_index];
+            ++current_hits[sample.stack_index * source_count + sample.source_id];
+        }
+        hits.insert(hits.end(), current_hits.begin(), current_hits.end());
+    };
+
+    index->bucket_offsets.push_back(0);
+    for(std::size_t bucket_start = 0; bucket_start < index->samples.size(); bucket_start += stacks_time_index::impl::samples_per_bucket)
+    {
+        const auto bucket_end = std::min(bucket_start + stacks_time_index::impl::samples_per_bucket, index->samples.size());
+
+        append_hits(index->bucket_hits, std::views::iota(bucket_start, bucket_end));
+        index->bucket_offsets.push_back(index->bucket_hits.size());
+    }
+
+    // Group the samples by thread (counting sort), keeping them sorted by time within each thread.
+    index->thread_sample_offsets.resize(index->threads.size() + 1, 0);
+    for(const auto& sample : index->samples) ++index->thread_sample_offsets[sample.thread_index + 1];
+    for(std::size_t thread_index = 0; thread_index < index->threads.size(); ++thread_index)
+    {
+        index->thread_sample_offsets[thread_index + 1] += index->thread_sample_offsets[thread_index];
+    }
+
+    index->thread_samples.resize(index->samples.size());
+    {
+        auto insert_positions = index->thread_sample_offsets;
+        for(std::size_t sample_index = 0; sample_index < index->samples.size(); ++sample_index)
+        {
+            index->thread_samples[insert_positions[index->samples[sample_index].thread_index]++] = static_cast<std::uint32_t>(sample_index);
+        }
+    }
+
+    index->thread_hits_offsets.push_back(0);
+    for(std::size_t thread_index = 0; thread_index < index->threads.size(); ++thread_index)
+    {
+        append_hits(index->thread_hits, std::span(index->thread_samples).subspan(index->thread_sample_offsets[thread_index], index->thread_sample_offsets[thread_index + 1] - index->thread_sample_offsets[thread_index]));
+        index->thread_hits_offsets.push_back(index->thread_hits.size());
+    }
+
+    progress.finish();
+
+    return stacks_time_index(std::move(index));
+}
+
+stacks_analysis snail::analysis::analyze_stacks(const stacks_time_index& index,
+                                                const sample_filter&     filter,
+                                                std::size_t              max_worker_threads)
+{
+    const auto& data = *index.impl_;
+
+    constexpr auto samples_per_bucket = stacks_time_index::impl::samples_per_bucket;
+
+    const auto process_excluded = filter.excluded_processes.contains(data.stacks.analysis.process_id);
+
+    // Find the samples within the time range
+    const auto first_sample = filter.min_time ?
+                                  static_cast<std::size_t>(std::ranges::lower_bound(data.samples, *filter.min_time, {}, &stacks_time_index::impl::sample_entry::timestamp) - data.samples.begin()) :
+                                  std::size_t(0);
+    const auto end_sample   = filter.max_time ?
+                                  static_cast<std::size_t>(std::ranges::upper_bound(data.samples, *filter.max_time, {}, &stacks_time_index::impl::sample_entry::timestamp) - data.samples.begin()) :
+                                  data.samples.size();
+
+    stacks_analysis_builder::stack_hits_t stack_hits(data.stacks.stacks.size() * data.source_count, 0);
+
+    const auto add_samples = [&](std::size_t begin, std::size_t end)
+    {
+        for(std::size_t sample_index = begin; sample_index < end; ++sample_index)
+        {
+            const auto& sample = data.samples[sample_index];
+            ++stack_hits[sample.stack_index * data.source_count + sample.source_id];
+        }
+    };
+
+    // Add the aggregated hits of all buckets that are completely within the range
+    // and only look at the individual samples in the partially covered buckets at the edges.
+    const auto first_full_bucket = (first_sample + samples_per_bucket - 1) / samples_per_bucket;
+    const auto end_full_bucket   = end_sample == data.samples.size() ? data.bucket_offsets.size() - 1 : end_sample / samples_per_bucket;
+
+    if(process_excluded || first_sample >= end_sample)
+    {
+        // empty range
+    }
+    else if(first_full_bucket >= end_full_bucket)
+    {
+        add_samples(first_sample, end_sample);
+    }
+    else
+    {
+        add_samples(first_sample, first_full_bucket * samples_per_bucket);
+
+        for(auto iter = data.bucket_hits.begin() + data.bucket_offsets[first_full_bucket];
+            iter != data.bucket_hits.begin() + data.bucket_offsets[end_full_bucket];
+            ++iter)
+        {
+            stack_hits[iter->first] += iter->second;
+        }
+
+        add_samples(std::min(end_full_bucket * samples_per_bucket, end_sample), end_sample);
+    }
+
+    // Subtract the hits of the excluded threads within the range again.
+    if(!process_excluded && first_sample < end_sample)
+    {
+        const auto covers_all_samples = first_sample == 0 && end_sample == data.samples.size();
+
+        for(const auto thread_id : filter.excluded_threads)
+        {
+            const auto thread_iter = data.thread_indices.find(thread_id);
+            if(thread_iter == data.thread_indices.end()) continue;
+
+            const std::size_t thread_index = thread_iter->second;
+
+            if(covers_all_samples)
+            {
+                for(auto iter = data.thread_hits.begin() + data.thread_hits_offsets[thread_index];
+                    iter != data.thread_hits.begin() + data.thread_hits_offsets[thread_index + 1];
+                    ++iter)
+                {
+                    stack_hits[iter->first] -= iter->second;
                 }
+                continue;
+            }
+
+            const auto thread_samples = std::span(data.thread_samples).subspan(data.thread_sample_offsets[thread_index], data.thread_sample_offsets[thread_index + 1] - data.thread_sample_offsets[thread_index]);
+
+            const auto first = std::ranges::lower_bound(thread_samples, first_sample);
+            const auto end   = std::ranges::lower_bound(thread_samples, end_sample);
+            for(auto iter = first; iter < end; ++iter)
+            {
+                const auto& sample = data.samples[*iter];
+                --stack_hits[sample.stack_index * data.source_count + sample.source_id];
             }
         }
     }
 
-    if(!cancel) progress.finish();
+    stacks_analysis_builder::stack_hits_t extracted_stack_hits;
 
-    return result;
+    auto extracted = stacks_analysis_builder::extract_hit_stacks(data.stacks, stack_hits, extracted_stack_hits);
+
+    stacks_analysis_builder::count(extracted, extracted_stack_hits, max_worker_threads);
+
+    return std::move(extracted.analysis);
 }
@@ -1,12 +1,16 @@
 #pragma once
 
+#include <cstdint>
 #include <limits>
+#include <memory>
+#include <optional>
 
 #include <snail/common/progress.hpp>
 
 #include <snail/analysis/data/call_tree.hpp>
 #include <snail/analysis/data/file.hpp>
 #include <snail/analysis/data/functions.hpp>
+#include <snail/analysis/data/hits_table.hpp>
 #include <snail/analysis/data/ids.hpp>
 #include <snail/analysis/data/modules.hpp>
 #include <snail/analysis/data/process.hpp>
@@ -20,11 +24,74 @@ class samples_provider;
 
 struct stacks_analysis;
 
+namespace detail {
+
+class stacks_analysis_builder;
+
+} // namespace detail
+
+// Collects the hits of all samples of the given process.
+//
+// The samples are read (and symbolized) sequentially, but the hits of the collected stacks are
+// counted on `max_worker_threads` threads. If `max_worker_threads` is zero, the number of threads
+// is chosen based on the number of hardware threads and the number of collected stack frames, and
+// limited so that the per-thread copies of the hit counts stay within a fixed memory budget.
+// The result does not depend on the number of threads.
 stacks_analysis analyze_stacks(const samples_provider&           provider,
                                unique_process_id                 process_id,
                                const sample_filter&              filter             = {},
                                const common::progress_listener*  progress_listener  = nullptr,
-                               const common::cancellation_token* cancellation_token = nullptr);
+                               const common::cancellation_token* cancellation_token = nullptr,
+                               std::size_t                       max_worker_threads = 0);
+
+// The resolved stacks of all samples of a single process, indexed by the time of the samples.
+//
+// This allows to analyze the stacks for arbitrary time ranges without reading and resolving
+// the samples again: The samples are grouped into buckets of consecutive samples that store the
+// aggregated hits of each stack. Hence, an analysis only needs to sum up the buckets that are
+// fully within the time range and to look at the individual samples of the buckets at its edges.
+// Excluded threads are handled by subtracting the hits of their samples again, which requires
+// to look at the samples of those threads only.
+class stacks_time_index
+{
+public:
+    stacks_time_index(stacks_time_index&&) noexcept;
+    stacks_time_index& operator=(stacks_time_index&&) noexcept;
+
+    ~stacks_time_index();
+
+    unique_process_id process_id() const;
+
+private:
+    struct impl;
+
+    explicit stacks_time_index(std::unique_ptr<impl> impl);
+
+    friend std::optional<stacks_time_index> make_stacks_time_index(const samples_provider&           provider,
+                                                                   unique_process_id                 process_id,
+                                                                   const common::progress_listener*  progress_listener,
+                                                                   const common::cancellation_token* cancellation_token);
+
+    friend stacks_analysis analyze_stacks(const stacks_time_index& index,
+                                          const sample_filter&     filter,
+                                          std::size_t              max_worker_threads);
+
+    std::unique_ptr<impl> impl_;
+};
+
+// Reads and resolves all samples of the given process into a time index.
+// Returns `std::nullopt` if the operation has been canceled.
+std::optional<stacks_time_index> make_stacks_time_index(const samples_provider&           provider,
+                                                        unique_process_id                 process_id,
+                                                        const common::progress_listener*  progress_listener  = nullptr,
+                                                        const common::cancellation_token* cancellation_token = nullptr);
+
+// Collects the hits of all samples in the index that are within the time range of the filter.
+// The result is equivalent to the one of analyzing the samples of the same process directly, except
+// that the ids of the entries might differ.
+stacks_analysis analyze_stacks(const stacks_time_index& index,
+                               const sample_filter&     filter             = {},
+                               std::size_t              max_worker_threads = 0);
 
 struct stacks_analysis
 {
@@ -40,24 +107,37 @@ struct stacks_analysis
 
     const file_info& get_file(file_info::id_t id) const;
 
+    source_hit_counts_view get_hits(const module_info& module) const;
+    source_hit_counts_view get_hits(const function_info& function) const;
+    source_hit_counts_view get_hits(const call_tree_node& node) const;
+    source_hit_counts_view get_hits(const file_info& file) const;
+
+    // The functions that called the given function, keyed by their ids.
+    hits_by_key_view get_callers(const function_info& function) const;
+    // The functions called by the given function, keyed by their ids.
+    hits_by_key_view get_callees(const function_info& function) const;
+    // The hits in the source lines of the given function, keyed by line number.
+    hits_by_key_view get_hits_by_line(const function_info& function) const;
+
     const std::vector<module_info>&   all_modules() const;
     const std::vector<function_info>& all_functions() const;
     const std::vector<file_info>&     all_files() const;
 
 private:
-    friend stacks_analysis analyze_stacks(const samples_provider&           provider,
-                                          unique_process_id                 process_id,
-                                          const sample_filter&              filter,
-                                          const common::progress_listener*  progress_listener,
-                                          const common::cancellation_token* cancellation_token);
-
-    // FIXME: This is a workaround: we would like to use the max of std::size_t, but since we will
-    //        serialize those values to JSON and eventually handle them in JavaScript which cannot
-    //        deal with integers larger than 53bits in its `number` type, we restrict ourselves
-    //        to 32bits here.
-    static_assert(sizeof(std::size_t) >= sizeof(std::uint32_t)); // just for sanity. Otherwise this would not be a "restriction".
-    constexpr static inline auto root_function_id       = std::numeric_limits<std::uint32_t>::max();
-    constexpr static inline auto root_call_tree_node_id = std::numeric_limits<std::uint32_t>::max();
+    friend class detail::stacks_analysis_builder;
+
+    // The roots use the largest possible ids, which are never assigned to any other entry.
+    // NOTE: All ids are 32bit integers. Besides saving memory, this guarantees that they can be
+    //       serialized to JSON and handled in JavaScript, which cannot deal with integers larger
+    //       than 53bits in its `number` type.
+    constexpr static inline auto root_function_id       = std::numeric_limits<function_info::id_t>::max();
+    constexpr static inline auto root_call_tree_node_id = std::numeric_limits<call_tree_node::id_t>::max();
+
+    // The rows of functions and call tree nodes in the hit counts and tables. The roots are
+    // stored in the first row, followed by all other entries in the order of their ids.
+    // Modules and files are stored in the order of their ids only.
+    std::size_t get_function_row(function_info::id_t id) const;
+    std::size_t get_call_tree_node_row(call_tree_node::id_t id) const;
 
     std::vector<module_info>    modules;
     std::vector<function_info>  functions;
@@ -66,6 +146,15 @@ private:
 
     call_tree_node call_tree_root;
     function_info  function_root;
+
+    hit_counts_matrix module_hits;
+    hit_counts_matrix function_hits;
+    hit_counts_matrix call_tree_node_hits;
+    hit_counts_matrix file_hits;
+
+    hits_table function_callers;
+    hits_table function_callees;
+    hits_table function_hits_by_line;
 };
 
 } // namespace snail::analysis
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -13,13 +14,13 @@ namespace snail::analysis {
 
 struct call_tree_node
 {
-    using id_t = std::size_t;
+    using id_t = std::uint32_t;
 
     id_t id;
 
     function_info::id_t function_id;
 
-    source_hit_counts hits;
+    // The hits are stored in the analysis, see `stacks_analysis::get_hits`.
 
     std::vector<id_t> children;
 };
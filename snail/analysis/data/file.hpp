@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #include <snail/analysis/data/hit_counts.hpp>
@@ -8,13 +9,13 @@ namespace snail::analysis {
 
 struct file_info
 {
-    using id_t = std::size_t;
+    using id_t = std::uint32_t;
 
     id_t id;
 
     std::string path;
 
-    source_hit_counts hits;
+    // The hits are stored in the analysis, see `stacks_analysis::get_hits`.
 };
 
 } // namespace snail::analysis
@@ -1,8 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <string>
-#include <unordered_map>
 
 #include <snail/analysis/data/file.hpp>
 #include <snail/analysis/data/hit_counts.hpp>
@@ -12,7 +12,7 @@ namespace snail::analysis {
 
 struct function_info
 {
-    using id_t = std::size_t;
+    using id_t = std::uint32_t;
 
     id_t id;
 
@@ -20,14 +20,11 @@ struct function_info
 
     std::string name;
 
-    source_hit_counts hits;
+    // The hits, callers, callees and hits per line are stored in the analysis, see
+    // `stacks_analysis::get_hits`, `stacks_analysis::get_callers` and friends.
 
-    std::unordered_map<function_info::id_t, source_hit_counts> callers;
-    std::unordered_map<function_info::id_t, source_hit_counts> callees;
-
-    std::optional<file_info::id_t>                     file_id;
-    std::optional<std::size_t>                         line_number;
-    std::unordered_map<std::size_t, source_hit_counts> hits_by_line;
+    std::optional<file_info::id_t> file_id;
+    std::optional<std::size_t>     line_number;
 };
 
 } // namespace snail::analysis
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <span>
 #include <type_traits>
 #include <vector>
 
@@ -35,4 +37,61 @@ struct source_hit_counts
     std::vector<hit_counts> counts_per_source;
 };
 
+// Non-owning counterpart of `source_hit_counts`, used to refer to counts stored in flat arrays.
+struct source_hit_counts_view
+{
+    const hit_counts& get(sample_source_info::id_t source_id) const
+    {
+        static constexpr hit_counts empty_hits = {};
+        if(source_id >= counts_per_source.size()) return empty_hits;
+        return counts_per_source[source_id];
+    }
+
+    std::span<const hit_counts> counts_per_source;
+
+    friend bool operator==(const source_hit_counts_view& lhs, const source_hit_counts_view& rhs)
+    {
+        return std::ranges::equal(lhs.counts_per_source, rhs.counts_per_source);
+    }
+    friend bool operator==(const source_hit_counts_view& lhs, const source_hit_counts& rhs)
+    {
+        return std::ranges::equal(lhs.counts_per_source, rhs.counts_per_source);
+    }
+};
+
+// The hit counts per source of all entities of one kind (e.g. all functions), stored in a
+// single dense array.
+//
+// The counts of the entity in the row `row` for the source `source_id` are stored at
+// `counts[row * source_count + source_id]`.
+struct hit_counts_matrix
+{
+    std::size_t row_count() const
+    {
+        return source_count == 0 ? 0 : counts.size() / source_count;
+    }
+
+    std::size_t append_row()
+    {
+        counts.resize(counts.size() + source_count);
+        return row_count() - 1;
+    }
+
+    hit_counts& get(std::size_t row, sample_source_info::id_t source_id)
+    {
+        assert(source_id < source_count);
+        return counts[row * source_count + source_id];
+    }
+
+    source_hit_counts_view row(std::size_t row) const
+    {
+        assert(row < row_count());
+        return source_hit_counts_view{
+            .counts_per_source = std::span(counts).subspan(row * source_count, source_count)};
+    }
+
+    std::size_t             source_count = 0;
+    std::vector<hit_counts> counts;
+};
+
 } // namespace snail::analysis
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <snail/analysis/data/hit_counts.hpp>
+
+namespace snail::analysis {
+
+// The hit counts per source for a list of keys (e.g. the callers of a single function), sorted
+// ascending by key.
+struct hits_by_key_view
+{
+    std::size_t size() const
+    {
+        return keys.size();
+    }
+    bool empty() const
+    {
+        return keys.empty();
+    }
+
+    std::size_t key(std::size_t index) const
+    {
+        assert(index < keys.size());
+        return keys[index];
+    }
+    source_hit_counts_view hits(std::size_t index) const
+    {
+        assert(index < keys.size());
+        return source_hit_counts_view{
+            .counts_per_source = counts.subspan(index * source_count, source_count)};
+    }
+
+    std::optional<source_hit_counts_view> find(std::size_t search_key) const
+    {
+        const auto iter = std::ranges::lower_bound(keys, search_key);
+        if(iter == keys.end() || *iter != search_key) return std::nullopt;
+        return hits(static_cast<std::size_t>(iter - keys.begin()));
+    }
+
+    std::span<const std::size_t> keys;
+    std::span<const hit_counts>  counts;
+    std::size_t                  source_count;
+};
+
+// Hit counts per source for a list of keys for each of many rows (e.g. the callers of all
+// functions), stored in a few flat arrays instead of one map per row.
+//
+// The entries of the row `row` are the ones at the positions `offsets[row]` up to (excluding)
+// `offsets[row + 1]` in `keys`, sorted ascending by key. The counts of the entry at position `i`
+// for the source `source_id` are at `counts[i * source_count + source_id]`.
+struct hits_table
+{
+    std::size_t row_count() const
+    {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    hits_by_key_view row(std::size_t row_index) const
+    {
+        if(row_index >= row_count()) return hits_by_key_view{.keys = {}, .counts = {}, .source_count = source_count};
+
+        const auto begin = offsets[row_index];
+        const auto end   = offsets[row_index + 1];
+        return hits_by_key_view{
+            .keys         = std::span(keys).subspan(begin, end - begin),
+            .counts       = std::span(counts).subspan(begin * source_count, (end - begin) * source_count),
+            .source_count = source_count};
+    }
+
+    std::size_t              source_count = 0;
+    std::vector<std::size_t> offsets;
+    std::vector<std::size_t> keys;
+    std::vector<hit_counts>  counts;
+};
+
+} // namespace snail::analysis
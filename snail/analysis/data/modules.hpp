@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -9,13 +10,13 @@ namespace snail::analysis {
 
 struct module_info
 {
-    using id_t = std::size_t;
+    using id_t = std::uint32_t;
 
     id_t id;
 
     std::string name;
 
-    source_hit_counts hits;
+    // The hits are stored in the analysis, see `stacks_analysis::get_hits`.
 };
 
 } // namespace snail::analysis
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <optional>
 #include <string_view>
 
+#include <snail/common/string_interner.hpp>
+
 namespace snail::analysis {
 
 struct stack_frame
@@ -13,6 +16,16 @@ struct stack_frame
 
     std::size_t function_line_number;
     std::size_t instruction_line_number;
+
+    // Ids of the strings above, that identify them among all frames of the same data provider.
+    // Frames with equal ids have equal strings. Not set by providers that do not intern their strings.
+    struct string_ids
+    {
+        common::string_interner::id_t symbol_name;
+        common::string_interner::id_t module_name;
+        common::string_interner::id_t file_path;
+    };
+    std::optional<string_ids> ids = std::nullopt;
 };
 
 } // namespace snail::analysis
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
 
 #include <snail/common/generator.hpp>
@@ -32,10 +35,49 @@ struct sample_data
 
     virtual common::generator<stack_frame> reversed_stack() const = 0;
 
+    // Identifies the stack of this sample: all samples (of the same process) with equal
+    // keys yield the same frames from `reversed_stack()`. This allows to resolve every
+    // distinct stack only once.
+    // Returns `std::nullopt` if the stack can not be identified.
+    virtual std::optional<std::uint64_t> stack_key() const
+    {
+        return std::nullopt;
+    }
+
     // Time since session start
     virtual std::chrono::nanoseconds timestamp() const = 0;
 };
 
+// Compact description of a sample, that can be processed without any virtual calls.
+struct sample_record
+{
+    unique_thread_id thread_id;
+
+    // Time since session start
+    std::chrono::nanoseconds timestamp;
+
+    // Only set if the sample has a frame (see `sample_data::has_frame()`).
+    std::optional<std::uint64_t> instruction_pointer;
+
+    // Same as `sample_data::stack_key()`
+    std::optional<std::uint64_t> stack_key;
+
+    bool has_stack;
+};
+
+// A number of consecutive samples of a single thread.
+class sample_batch
+{
+public:
+    virtual ~sample_batch() = default;
+
+    virtual std::span<const sample_record> records() const = 0;
+
+    // Full access to the sample that corresponds to `records()[index]`, e.g. to resolve its stack.
+    // The returned reference is valid until the next call to this function.
+    virtual const sample_data& sample(std::size_t index) const = 0;
+};
+
 class samples_provider
 {
 public:
@@ -47,6 +89,12 @@ public:
                                                           unique_process_id        process_id,
                                                           const sample_filter&     filter = {}) const = 0;
 
+    // Yields the same samples as `samples()`, but in batches. The samples of each batch are
+    // ordered by time, but there is no order between the samples of different batches.
+    virtual common::generator<const sample_batch&> sample_batches(sample_source_info::id_t source_id,
+                                                                  unique_process_id        process_id,
+                                                                  const sample_filter&     filter = {}) const = 0;
+
     virtual std::size_t count_samples(sample_source_info::id_t source_id,
                                       unique_process_id        process_id,
                                       const sample_filter&     filter = {}) const = 0;
@@ -54,6 +102,15 @@ public:
     virtual std::size_t count_samples(sample_source_info::id_t source_id,
                                       unique_thread_id         thread_id,
                                       const sample_filter&     filter = {}) const = 0;
+
+    // Counts the samples of a thread in `bucket_count` consecutive time buckets. The bucket `i` covers
+    // the time from `start_time + i * bucket_duration` up to (but excluding) `start_time + (i + 1) * bucket_duration`.
+    // This does not apply any filter, since it is meant to show where samples are in the first place.
+    virtual std::vector<std::size_t> count_samples_per_time_bucket(sample_source_info::id_t source_id,
+                                                                   unique_thread_id         thread_id,
+                                                                   std::chrono::nanoseconds start_time,
+                                                                   std::chrono::nanoseconds bucket_duration,
+                                                                   std::size_t              bucket_count) const = 0;
 };
 
 class info_provider
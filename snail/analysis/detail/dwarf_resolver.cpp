@@ -100,6 +100,16 @@ dwarf_resolver::dwarf_resolver(dwarf_symbol_find_options find_options,
 
 dwarf_resolver::~dwarf_resolver() = default;
 
+const dwarf_resolver::symbol_info& dwarf_resolver::insert_symbol(const symbol_key& key, symbol_info symbol)
+{
+    symbol.name_id      = strings_.intern(symbol.name);
+    symbol.file_path_id = strings_.intern(symbol.file_path);
+
+    const auto [new_iter, inserted] = symbol_cache_.emplace(key, std::move(symbol));
+    assert(inserted);
+    return new_iter->second;
+}
+
 const dwarf_resolver::symbol_info& dwarf_resolver::make_generic_symbol(instruction_pointer_t address)
 {
     const auto key = symbol_key{
@@ -119,8 +129,7 @@ const dwarf_resolver::symbol_info& dwarf_resolver::make_generic_symbol(instructi
         .instruction_line_number = {},
     };
 
-    const auto [new_iter, _] = symbol_cache_.emplace(key, new_symbol);
-    return new_iter->second;
+    return insert_symbol(key, new_symbol);
 }
 
 const dwarf_resolver::symbol_info& dwarf_resolver::make_generic_symbol(const module_info& module, instruction_pointer_t address)
@@ -147,9 +156,7 @@ const dwarf_resolver::symbol_info& dwarf_resolver::make_generic_symbol(const mod
         .instruction_line_number = {},
     };
 
-    const auto [new_iter, inserted] = symbol_cache_.emplace(key, new_symbol);
-    assert(inserted);
-    return new_iter->second;
+    return insert_symbol(key, new_symbol);
 }
 
 #ifdef SNAIL_HAS_LLVM
@@ -231,9 +238,7 @@ const dwarf_resolver::symbol_info& dwarf_resolver::resolve_symbol(const module_i
         new_symbol.name = line_info.FunctionName;
     }
 
-    const auto [new_iter, inserted] = symbol_cache_.emplace(key, std::move(new_symbol));
-    assert(inserted);
-    return new_iter->second;
+    return insert_symbol(key, std::move(new_symbol));
 #else  // SNAIL_HAS_LLVM
     return make_generic_symbol(module, address);
 #endif // SNAIL_HAS_LLVM
@@ -9,6 +9,8 @@
 
 #include <snail/perf_data/build_id.hpp>
 
+#include <snail/common/string_interner.hpp>
+
 #include <snail/analysis/options.hpp>
 #include <snail/analysis/path_map.hpp>
 
@@ -82,7 +84,12 @@ private:
     std::unordered_map<module_key, std::unique_ptr<context_storage>, module_key_hasher> dwarf_context_cache_;
 #endif // SNAIL_HAS_LLVM
 
+    const symbol_info& insert_symbol(const symbol_key& key, symbol_info symbol);
+
     std::unordered_map<symbol_key, symbol_info, symbol_key_hasher> symbol_cache_;
+
+    // All symbol names and file paths of the resolved symbols.
+    common::string_interner strings_;
 };
 
 struct dwarf_resolver::symbol_info
@@ -94,6 +101,10 @@ struct dwarf_resolver::symbol_info
 
     std::size_t function_line_number;
     std::size_t instruction_line_number;
+
+    // Ids of `name` and `file_path` in `dwarf_resolver::strings_`.
+    common::string_interner::id_t name_id      = 0;
+    common::string_interner::id_t file_path_id = 0;
 };
 
 struct dwarf_resolver::module_info
@@ -680,13 +680,17 @@ void etl_file_process_context::handle_event(const etl::etl_file::header_data& /*
         }
     }
 
+    auto filename = utf8::utf16to8(event.file_name());
+    auto name_id  = module_names_.intern(filename);
+
     modules.insert(module_info<module_data>{
                        .base    = image_base,
                        .size    = event.image_size(),
                        .payload = {
-                                   .filename = utf8::utf16to8(event.file_name()),
+                                   .filename = std::move(filename),
                                    .checksum = event.image_checksum(),
-                                   .pdb_info = std::move(pdb_info)}
+                                   .pdb_info = std::move(pdb_info),
+                                   .name_id  = name_id}
     },
                    header.timestamp);
 }
@@ -717,11 +721,11 @@ void etl_file_process_context::handle_event(const etl::etl_file::header_data& /*
 
     thread_samples->push_back(sample_info{
         .thread_id           = thread_id,
+        .user_mode_stack     = stack_cache::no_stack,
+        .kernel_mode_stack   = stack_cache::no_stack,
         .timestamp           = header.timestamp,
         .instruction_pointer = event.instruction_pointer(),
-        .user_mode_stack     = {},
         .user_timestamp      = {},
-        .kernel_mode_stack   = {},
         .kernel_timestamp    = {},
     });
 }
@@ -752,11 +756,11 @@ void etl_file_process_context::handle_event(const etl::etl_file::header_data& /*
 
     samples.push_back(sample_info{
         .thread_id           = thread_id,
+        .user_mode_stack     = stack_cache::no_stack,
+        .kernel_mode_stack   = stack_cache::no_stack,
         .timestamp           = header.timestamp,
         .instruction_pointer = event.instruction_pointer(),
-        .user_mode_stack     = {},
         .user_timestamp      = {},
-        .kernel_mode_stack   = {},
         .kernel_timestamp    = {},
     });
 }
@@ -821,7 +825,7 @@ void etl_file_process_context::handle_event(const etl::etl_file::header_data&
             // In this case we just replace the first kernel mode stack. Maybe the right thing to do would
             // be to concatenate the stacks, but the kernel mode stacks are kind of useless anyways?! So,
             // for know, we just replace the old stack.
-            assert(sample_stack_index == std::nullopt || starts_in_kernel);
+            assert(sample_stack_index == stack_cache::no_stack || starts_in_kernel);
 
             sample_stack_index     = stacks.insert(event.stack());
             sample_stack_timestamp = header.timestamp;
@@ -941,7 +945,7 @@ void etl_file_process_context::handle_event(const etl::etl_file::header_data&
         else
         {
             assert(!starts_in_kernel);
-            assert(sample.user_mode_stack == std::nullopt);
+            assert(sample.user_mode_stack == stack_cache::no_stack);
             sample.user_mode_stack = new_stack_index;
             sample.user_timestamp  = sample_ref.stack_event_timestamp;
         }
@@ -1039,7 +1043,7 @@ std::span<const etl_file_process_context::sample_info> etl_file_process_context:
     return samples.subspan(range_first_iter - samples.begin(), range_end_iter - range_first_iter);
 }
 
-const std::vector<etl_file_process_context::instruction_pointer_t>& etl_file_process_context::stack(std::size_t stack_index) const
+stack_cache::stack_view etl_file_process_context::stack(stack_cache::stack_index_t stack_index) const
 {
     return stacks.get(stack_index);
 }
@@ -12,6 +12,8 @@
 
 #include <snail/etl/dispatching_event_observer.hpp>
 
+#include <snail/common/string_interner.hpp>
+
 #include <snail/analysis/data/ids.hpp>
 
 #include <snail/analysis/detail/id_at.hpp>
@@ -107,6 +109,9 @@ public:
         std::uint32_t                   checksum;
         std::optional<detail::pdb_info> pdb_info;
 
+        // Id of `filename` among the names of all modules of the context.
+        common::string_interner::id_t name_id = 0;
+
         [[nodiscard]] friend bool operator==(const module_data& lhs, const module_data& rhs)
         {
             return lhs.filename == rhs.filename &&
@@ -151,7 +156,7 @@ public:
                                                 std::optional<timestamp_t> end_time,
                                                 sample_source_id_t         pmc_source) const;
 
-    const std::vector<instruction_pointer_t>& stack(std::size_t stack_index) const;
+    stack_cache::stack_view stack(stack_cache::stack_index_t stack_index) const;
 
     std::optional<std::u16string_view> computer_name() const;
     std::optional<std::uint16_t>       processor_architecture() const;
@@ -212,6 +217,7 @@ private:
 
     std::unordered_map<os_pid_t, std::vector<pdb_info_storage>>        modules_pdb_info_per_process_id_;
     std::unordered_map<os_pid_t, module_map<module_data, timestamp_t>> modules_per_process_id_;
+    common::string_interner                                            module_names_;
 
     std::unordered_map<os_tid_t, std::unique_ptr<std::vector<sample_info>>> samples_per_thread_id_; // store as unique_ptr to allow stable references
 
@@ -279,19 +285,23 @@ struct etl_file_process_context::profiler_process_info
     timestamp_t start_timestamp;
 };
 
+// We store one of these for every sample in the trace, hence it is packed tightly: missing
+// stacks are marked by `stack_cache::no_stack` instead of using `std::optional`.
 struct etl_file_process_context::sample_info
 {
     os_tid_t thread_id;
 
+    stack_cache::stack_index_t user_mode_stack;
+    stack_cache::stack_index_t kernel_mode_stack;
+
     timestamp_t timestamp;
 
     instruction_pointer_t instruction_pointer;
 
-    std::optional<std::size_t> user_mode_stack;
-    timestamp_t                user_timestamp;
-
-    std::optional<std::size_t> kernel_mode_stack;
-    timestamp_t                kernel_timestamp;
+    timestamp_t user_timestamp;
+    timestamp_t kernel_timestamp;
 };
 
+static_assert(sizeof(etl_file_process_context::sample_info) <= 48);
+
 } // namespace snail::analysis::detail
@@ -303,6 +303,16 @@ pdb_resolver::pdb_resolver(pdb_symbol_find_options find_options,
 
 pdb_resolver::~pdb_resolver() = default;
 
+const pdb_resolver::symbol_info& pdb_resolver::insert_symbol(const symbol_key& key, symbol_info symbol)
+{
+    symbol.name_id      = strings_.intern(symbol.name);
+    symbol.file_path_id = strings_.intern(symbol.file_path);
+
+    const auto [new_iter, inserted] = symbol_cache_.emplace(key, std::move(symbol));
+    assert(inserted);
+    return new_iter->second;
+}
+
 const pdb_resolver::symbol_info& pdb_resolver::make_generic_symbol(instruction_pointer_t address)
 {
     const auto key = symbol_key{
@@ -322,8 +332,7 @@ const pdb_resolver::symbol_info& pdb_resolver::make_generic_symbol(instruction_p
         .instruction_line_number = {},
     };
 
-    const auto [new_iter, _] = symbol_cache_.emplace(key, new_symbol);
-    return new_iter->second;
+    return insert_symbol(key, new_symbol);
 }
 
 const pdb_resolver::symbol_info& pdb_resolver::make_generic_symbol(const module_info& module, instruction_pointer_t address)
@@ -350,9 +359,7 @@ const pdb_resolver::symbol_info& pdb_resolver::make_generic_symbol(const module_
         .instruction_line_number = {},
     };
 
-    const auto [new_iter, inserted] = symbol_cache_.emplace(key, new_symbol);
-    assert(inserted);
-    return new_iter->second;
+    return insert_symbol(key, new_symbol);
 }
 
 const pdb_resolver::symbol_info& pdb_resolver::resolve_symbol(const module_info& module, instruction_pointer_t address)
@@ -420,9 +427,7 @@ const pdb_resolver::symbol_info& pdb_resolver::resolve_symbol(const module_info&
         }
     }
 
-    const auto [new_iter, inserted] = symbol_cache_.emplace(key, std::move(new_symbol));
-    assert(inserted);
-    return new_iter->second;
+    return insert_symbol(key, std::move(new_symbol));
 #else  // SNAIL_HAS_LLVM
     return make_generic_symbol(module, address);
 #endif // SNAIL_HAS_LLVM
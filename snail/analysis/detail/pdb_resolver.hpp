@@ -7,6 +7,8 @@
 #include <string>
 #include <unordered_map>
 
+#include <snail/common/string_interner.hpp>
+
 #include <snail/analysis/options.hpp>
 #include <snail/analysis/path_map.hpp>
 
@@ -104,7 +106,12 @@ private:
     std::unordered_map<module_key, std::unique_ptr<llvm::pdb::IPDBSession>, module_key_hasher> pdb_session_cache_;
 #endif // SNAIL_HAS_LLVM
 
+    const symbol_info& insert_symbol(const symbol_key& key, symbol_info symbol);
+
     std::unordered_map<symbol_key, symbol_info, symbol_key_hasher> symbol_cache_;
+
+    // All symbol names and file paths of the resolved symbols.
+    common::string_interner strings_;
 };
 
 struct pdb_resolver::symbol_info
@@ -116,6 +123,10 @@ struct pdb_resolver::symbol_info
 
     std::size_t function_line_number;
     std::size_t instruction_line_number;
+
+    // Ids of `name` and `file_path` in `pdb_resolver::strings_`.
+    common::string_interner::id_t name_id      = 0;
+    common::string_interner::id_t file_path_id = 0;
 };
 
 struct pdb_resolver::module_info
@@ -1,6 +1,8 @@
 
 #include <snail/analysis/detail/perf_data_file_process_context.hpp>
 
+#include <variant>
+
 #include <snail/perf_data/parser/records/kernel.hpp>
 #include <snail/perf_data/parser/records/perf.hpp>
 
@@ -8,12 +10,162 @@ using namespace snail;
 using namespace snail::analysis;
 using namespace snail::analysis::detail;
 
-perf_data_file_process_context::perf_data_file_process_context()
+// The members of the records are initialized, since GCC's `-Wmaybe-uninitialized` can not see through
+// the records being constructed inside of the `std::variant` of `event_batch`.
+struct perf_data_file_process_context::comm_record
+{
+    os_pid_t    pid  = 0;
+    os_tid_t    tid  = 0;
+    timestamp_t time = 0;
+    std::string comm;
+};
+
+struct perf_data_file_process_context::fork_record
+{
+    os_pid_t    pid  = 0;
+    os_tid_t    tid  = 0;
+    timestamp_t time = 0;
+};
+
+struct perf_data_file_process_context::mmap2_record
+{
+    os_pid_t      pid  = 0;
+    timestamp_t   time = 0;
+    std::uint64_t base = 0;
+    std::uint64_t size = 0;
+    module_data   module;
+};
+
+struct perf_data_file_process_context::sample_record
+{
+    std::uintptr_t               source_key = 0;
+    std::optional<std::uint64_t> event_id;
+
+    os_tid_t              thread_id           = 0;
+    timestamp_t           timestamp           = 0;
+    instruction_pointer_t instruction_pointer = 0;
+
+    bool has_stack = false;
+};
+
+// Collects the decoded events of a single batch of the file.
+// Since samples are by far the most frequent events, they are stored separately from all other
+// events. To be able to restore the original order of the events, every other event stores the
+// number of samples that precede it.
+class perf_data_file_process_context::event_batch : public perf_data::event_batch
+{
+public:
+    explicit event_batch(perf_data_file_process_context& context) :
+        context_(&context)
+    {}
+
+    void handle(const perf_data::parser::event_header_view& event_header,
+                const perf_data::parser::event_attributes&  attributes,
+                std::span<const std::byte>                  event_data,
+                std::endian                                 byte_order) override
+    {
+        switch(event_header.type())
+        {
+        case perf_data::parser::event_type::comm:
+            push_record(decode_event(perf_data::parser::comm_event_view(attributes, event_data, byte_order)));
+            break;
+        case perf_data::parser::event_type::fork:
+            push_record(decode_event(perf_data::parser::fork_event_view(attributes, event_data, byte_order)));
+            break;
+        case perf_data::parser::event_type::mmap2:
+            push_record(decode_event(perf_data::parser::mmap2_event_view(attributes, event_data, byte_order)));
+            break;
+        case perf_data::parser::event_type::sample:
+        {
+            const auto event  = perf_data::parser::parse_event<perf_data::parser::sample_event_view>(attributes, event_data, byte_order);
+            const auto record = decode_event(event);
+            if(!record) break;
+
+            // The event data stays valid until the batch is finished, hence we can keep
+            // referring to the callchain in the event buffer.
+            samples_.push_back(batched_sample{
+                .record = *record,
+                .stack  = event.ips.value_or(perf_data::parser::callchain_view())});
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void finish() override
+    {
+        std::size_t next_sample_index = 0;
+
+        const auto apply_samples_until = [this, &next_sample_index](std::size_t end_sample_index)
+        {
+            for(; next_sample_index < end_sample_index; ++next_sample_index)
+            {
+                const auto& sample = samples_[next_sample_index];
+                context_->apply_record(sample.record, sample.stack);
+            }
+        };
+
+        for(const auto& [sample_index, record] : records_)
+        {
+            apply_samples_until(sample_index);
+            std::visit([this](const auto& record)
+                       { context_->apply_record(record); },
+                       record);
+        }
+        apply_samples_until(samples_.size());
+    }
+
+private:
+    struct ordered_record
+    {
+        std::size_t                                         sample_index;
+        std::variant<comm_record, fork_record, mmap2_record> record;
+    };
+
+    struct batched_sample
+    {
+        sample_record                     record;
+        perf_data::parser::callchain_view stack;
+    };
+
+    template<typename T>
+    void push_record(T&& record)
+    {
+        records_.push_back(ordered_record{
+            .sample_index = samples_.size(),
+            .record       = std::forward<T>(record)});
+    }
+
+    perf_data_file_process_context* context_;
+
+    std::vector<ordered_record> records_;
+    std::vector<batched_sample> samples_;
+};
+
+class perf_data_file_process_context::batched_observer_impl : public perf_data::batched_event_observer
+{
+public:
+    explicit batched_observer_impl(perf_data_file_process_context& context) :
+        context_(&context)
+    {}
+
+    std::unique_ptr<perf_data::event_batch> create_batch() override
+    {
+        return std::make_unique<event_batch>(*context_);
+    }
+
+private:
+    perf_data_file_process_context* context_;
+};
+
+perf_data_file_process_context::perf_data_file_process_context() :
+    batched_observer_(std::make_unique<batched_observer_impl>(*this))
 {
     register_event<perf_data::parser::comm_event_view>();
     register_event<perf_data::parser::fork_event_view>();
     register_event<perf_data::parser::mmap2_event_view>();
-    register_event<perf_data::parser::sample_event>();
+    register_event<perf_data::parser::sample_event_view>();
 }
 
 perf_data_file_process_context::~perf_data_file_process_context() = default;
@@ -23,6 +175,11 @@ perf_data::dispatching_event_observer& perf_data_file_process_context::observer(
     return observer_;
 }
 
+perf_data::batched_event_observer& perf_data_file_process_context::batched_observer()
+{
+    return *batched_observer_;
+}
+
 void perf_data_file_process_context::finish()
 {
     // Assign names to processes & threads (and create missing ones)
@@ -183,53 +340,48 @@ void perf_data_file_process_context::register_event()
 
 void perf_data_file_process_context::handle_event(const perf_data::parser::comm_event_view& event)
 {
-    const auto pid = event.pid();
-    const auto tid = event.tid();
-
-    assert(event.sample_id().time);
-    const auto time = *event.sample_id().time;
+    apply_record(decode_event(event));
+}
 
-    if(pid == tid)
-    {
-        process_names.insert(pid, time, process_data{
-                                            .name      = std::string(event.comm()),
-                                            .end_time  = {},
-                                            .unique_id = {},
-                                        });
-    }
+void perf_data_file_process_context::handle_event(const perf_data::parser::fork_event_view& event)
+{
+    apply_record(decode_event(event));
+}
 
-    thread_names.insert(tid, time, thread_data{
-                                       .process_id = pid,
-                                       .name       = std::string(event.comm()),
-                                       .end_time   = {},
-                                       .unique_id  = {},
-                                   });
+void perf_data_file_process_context::handle_event(const perf_data::parser::mmap2_event_view& event)
+{
+    apply_record(decode_event(event));
 }
 
-void perf_data_file_process_context::handle_event(const perf_data::parser::fork_event_view& event)
+void perf_data_file_process_context::handle_event(const perf_data::parser::sample_event_view& event)
 {
-    const auto pid  = event.pid();
-    const auto tid  = event.tid();
-    const auto time = event.time();
+    const auto record = decode_event(event);
+    if(!record) return;
 
-    if(pid == tid)
-    {
-        processes.insert(pid, time, process_data{});
-    }
+    // The callchain is inserted into the stack cache directly from the event buffer.
+    apply_record(*record, event.ips.value_or(perf_data::parser::callchain_view()));
+}
 
-    threads.insert(tid, time, thread_data{
-                                  .process_id = pid,
-                                  .name       = {},
-                                  .end_time   = {},
-                                  .unique_id  = {},
-                              });
-    threads_per_process_id_[pid].emplace(tid, time);
+perf_data_file_process_context::comm_record perf_data_file_process_context::decode_event(const perf_data::parser::comm_event_view& event)
+{
+    assert(event.sample_id().time);
+    return comm_record{
+        .pid  = event.pid(),
+        .tid  = event.tid(),
+        .time = *event.sample_id().time,
+        .comm = std::string(event.comm())};
 }
 
-void perf_data_file_process_context::handle_event(const perf_data::parser::mmap2_event_view& event)
+perf_data_file_process_context::fork_record perf_data_file_process_context::decode_event(const perf_data::parser::fork_event_view& event)
 {
-    auto& process_modules = modules_per_process_id_[event.pid()];
+    return fork_record{
+        .pid  = event.pid(),
+        .tid  = event.tid(),
+        .time = event.time()};
+}
 
+perf_data_file_process_context::mmap2_record perf_data_file_process_context::decode_event(const perf_data::parser::mmap2_event_view& event)
+{
     std::optional<perf_data::build_id> build_id;
     if(event.has_build_id())
     {
@@ -239,45 +391,107 @@ void perf_data_file_process_context::handle_event(const perf_data::parser::mmap2
     }
 
     assert(event.sample_id().time);
-    process_modules.insert(detail::module_info<module_data>{
-                               .base    = event.addr(),
-                               .size    = event.len(),
-                               .payload = {
-                                           .filename    = std::string(event.filename()),
-                                           .page_offset = event.pgoff(),
-                                           .build_id    = build_id}
-    },
-                           *event.sample_id().time);
+    return mmap2_record{
+        .pid    = event.pid(),
+        .time   = *event.sample_id().time,
+        .base   = event.addr(),
+        .size   = event.len(),
+        .module = {
+                   .filename    = std::string(event.filename()),
+                   .page_offset = event.pgoff(),
+                   .build_id    = build_id,
+                   .name_id     = 0} // interned when the record is applied
+    };
 }
 
-void perf_data_file_process_context::handle_event(const perf_data::parser::sample_event& event)
+std::optional<perf_data_file_process_context::sample_record> perf_data_file_process_context::decode_event(const perf_data::parser::sample_event_view& event)
 {
     if(event.tid == std::nullopt ||
-       event.time == std::nullopt) return;
+       event.time == std::nullopt) return std::nullopt;
 
-    const auto unique_key            = reinterpret_cast<std::uintptr_t>(event.attributes);
-    const auto [iter, is_new_source] = unique_sample_sources_.insert({unique_key, unique_sample_sources_.size()});
+    return sample_record{
+        .source_key          = reinterpret_cast<std::uintptr_t>(event.attributes),
+        .event_id            = event.id,
+        .thread_id           = *event.tid,
+        .timestamp           = *event.time,
+        .instruction_pointer = event.ip.value_or(sample_info::no_instruction_pointer),
+        .has_stack           = event.ips.has_value()};
+}
+
+void perf_data_file_process_context::apply_record(const comm_record& record)
+{
+    if(record.pid == record.tid)
+    {
+        process_names.insert(record.pid, record.time, process_data{
+                                                          .name      = record.comm,
+                                                          .end_time  = {},
+                                                          .unique_id = {},
+                                                      });
+    }
+
+    thread_names.insert(record.tid, record.time, thread_data{
+                                                     .process_id = record.pid,
+                                                     .name       = record.comm,
+                                                     .end_time   = {},
+                                                     .unique_id  = {},
+                                                 });
+}
+
+void perf_data_file_process_context::apply_record(const fork_record& record)
+{
+    if(record.pid == record.tid)
+    {
+        processes.insert(record.pid, record.time, process_data{});
+    }
+
+    threads.insert(record.tid, record.time, thread_data{
+                                                .process_id = record.pid,
+                                                .name       = {},
+                                                .end_time   = {},
+                                                .unique_id  = {},
+                                            });
+    threads_per_process_id_[record.pid].emplace(record.tid, record.time);
+}
+
+void perf_data_file_process_context::apply_record(const mmap2_record& record)
+{
+    auto& process_modules = modules_per_process_id_[record.pid];
+
+    auto module    = record.module;
+    module.name_id = module_names_.intern(module.filename);
+
+    process_modules.insert(detail::module_info<module_data>{
+                               .base    = record.base,
+                               .size    = record.size,
+                               .payload = std::move(module)},
+                           record.time);
+}
+
+template<typename StackRange>
+void perf_data_file_process_context::apply_record(const sample_record& record, const StackRange& stack)
+{
+    const auto [iter, is_new_source] = unique_sample_sources_.insert({record.source_key, unique_sample_sources_.size()});
 
     const auto source_id = iter->second;
     if(is_new_source)
     {
-        assert(!event_id_to_source_id_.contains(event.id) ||
-               event_id_to_source_id_.at(event.id) == source_id);
-        event_id_to_source_id_[event.id] = source_id;
+        assert(!event_id_to_source_id_.contains(record.event_id) ||
+               event_id_to_source_id_.at(record.event_id) == source_id);
+        event_id_to_source_id_[record.event_id] = source_id;
     }
 
-    auto& storage = samples_per_source_and_thread_id_[iter->second][*event.tid];
+    auto& storage = samples_per_source_and_thread_id_[iter->second][record.thread_id];
 
-    storage.first_sample_time = std::min(storage.first_sample_time, *event.time);
-    storage.last_sample_time  = std::max(storage.last_sample_time, *event.time);
+    storage.first_sample_time = std::min(storage.first_sample_time, record.timestamp);
+    storage.last_sample_time  = std::max(storage.last_sample_time, record.timestamp);
 
     storage.samples.push_back(sample_info{
-        .thread_id           = *event.tid,
-        .timestamp           = *event.time,
-        .instruction_pointer = event.ip,
-        .stack_index         = event.ips ? std::make_optional(stacks.insert(*event.ips)) : std::nullopt});
+        .thread_id           = record.thread_id,
+        .stack_index         = record.has_stack ? stacks.insert(stack) : stack_cache::no_stack,
+        .timestamp           = record.timestamp,
+        .instruction_pointer = record.instruction_pointer});
 
-    if(event.ips) sources_with_stacks_.insert(source_id);
+    if(record.has_stack) sources_with_stacks_.insert(source_id);
 }
 
 const std::unordered_map<perf_data_file_process_context::process_key, perf_data_file_process_context::sampled_process_info>& perf_data_file_process_context::sampled_processes() const
@@ -337,7 +551,7 @@ const module_map<perf_data_file_process_context::module_data, perf_data_file_pro
     return modules_per_process_id_.at(process_id);
 }
 
-const std::vector<perf_data_file_process_context::instruction_pointer_t>& perf_data_file_process_context::stack(std::size_t stack_index) const
+stack_cache::stack_view perf_data_file_process_context::stack(stack_cache::stack_index_t stack_index) const
 {
     return stacks.get(stack_index);
 }
@@ -1,13 +1,18 @@
 #pragma once
 
 #include <cstdint>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <set>
+#include <span>
 #include <unordered_set>
 
 #include <snail/perf_data/build_id.hpp>
 #include <snail/perf_data/dispatching_event_observer.hpp>
 
+#include <snail/common/string_interner.hpp>
+
 #include <snail/analysis/data/ids.hpp>
 
 #include <snail/analysis/detail/id_at.hpp>
@@ -20,7 +25,7 @@ namespace snail::perf_data::parser {
 struct fork_event_view;
 struct comm_event_view;
 struct mmap2_event_view;
-struct sample_event;
+struct sample_event_view;
 
 } // namespace snail::perf_data::parser
 
@@ -74,9 +79,12 @@ public:
     struct module_data
     {
         std::string                        filename;
-        std::uint64_t                      page_offset;
+        std::uint64_t                      page_offset = 0;
         std::optional<perf_data::build_id> build_id;
 
+        // Id of `filename` among the names of all modules of the context.
+        common::string_interner::id_t name_id = 0;
+
         [[nodiscard]] friend bool operator==(const module_data& lhs, const module_data& rhs)
         {
             return lhs.filename == rhs.filename &&
@@ -97,6 +105,10 @@ public:
 
     perf_data::dispatching_event_observer& observer();
 
+    // Alternative to `observer()` to be used with `perf_data_file::process_parallel`.
+    // The resulting context is the same as if all events would have been passed to `observer()`.
+    perf_data::batched_event_observer& batched_observer();
+
     void finish();
 
     process_key id_to_key(unique_process_id id) const;
@@ -118,19 +130,42 @@ public:
 
     std::span<const sample_info> thread_samples(os_tid_t thread_id, timestamp_t start_time, std::optional<timestamp_t> end_time, std::uintptr_t source_id) const;
 
-    const std::vector<instruction_pointer_t>& stack(std::size_t stack_index) const;
+    stack_cache::stack_view stack(stack_cache::stack_index_t stack_index) const;
 
 private:
+    // Events are first decoded into these records, which are then applied to the context.
+    // This allows to decode the events of a batch on a worker thread (see `event_batch`).
+    struct comm_record;
+    struct fork_record;
+    struct mmap2_record;
+    struct sample_record;
+
+    class event_batch;
+    class batched_observer_impl;
+
     template<typename T>
     void register_event();
 
     void handle_event(const perf_data::parser::comm_event_view& event);
     void handle_event(const perf_data::parser::fork_event_view& event);
     void handle_event(const perf_data::parser::mmap2_event_view& event);
-    void handle_event(const perf_data::parser::sample_event& event);
+    void handle_event(const perf_data::parser::sample_event_view& event);
+
+    static comm_record                  decode_event(const perf_data::parser::comm_event_view& event);
+    static fork_record                  decode_event(const perf_data::parser::fork_event_view& event);
+    static mmap2_record                 decode_event(const perf_data::parser::mmap2_event_view& event);
+    static std::optional<sample_record> decode_event(const perf_data::parser::sample_event_view& event);
+
+    void apply_record(const comm_record& record);
+    void apply_record(const fork_record& record);
+    void apply_record(const mmap2_record& record);
+    template<typename StackRange>
+    void apply_record(const sample_record& record, const StackRange& stack);
 
     perf_data::dispatching_event_observer observer_;
 
+    std::unique_ptr<batched_observer_impl> batched_observer_;
+
     process_history process_names;
     thread_history  thread_names;
 
@@ -145,6 +180,7 @@ private:
     std::unordered_map<unique_thread_id, thread_key>   unique_thread_id_to_key_;
 
     std::unordered_map<os_pid_t, module_map<module_data, timestamp_t>> modules_per_process_id_;
+    common::string_interner                                            module_names_;
 
     struct samples_storage
     {
@@ -174,15 +210,21 @@ struct perf_data_file_process_context::sampled_process_info
     timestamp_t process_timestamp;
 };
 
+// We store one of these for every sample in the file, hence it is packed tightly: missing values
+// are marked by `no_instruction_pointer` and `stack_cache::no_stack` instead of using `std::optional`.
 struct perf_data_file_process_context::sample_info
 {
+    static constexpr instruction_pointer_t no_instruction_pointer = std::numeric_limits<instruction_pointer_t>::max();
+
     os_tid_t thread_id;
 
-    timestamp_t timestamp;
+    stack_cache::stack_index_t stack_index;
 
-    std::optional<instruction_pointer_t> instruction_pointer;
+    timestamp_t timestamp;
 
-    std::optional<std::size_t> stack_index;
+    instruction_pointer_t instruction_pointer;
 };
 
+static_assert(sizeof(perf_data_file_process_context::sample_info) <= 24);
+
 } // namespace snail::analysis::detail
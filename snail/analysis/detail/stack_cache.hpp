@@ -2,8 +2,12 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <ranges>
-#include <unordered_map>
+#include <span>
+#include <stdexcept>
 #include <vector>
 
 #include <snail/common/hash_combine.hpp>
@@ -12,69 +16,246 @@
 
 namespace snail::analysis::detail {
 
+// Stores stacks as paths in a prefix tree (trie) that is rooted at the outermost frame.
+//
+// Stacks are inserted in the usual order (innermost frame first), but since all stacks
+// of a thread share the same outermost frames (e.g. main -> dispatcher -> worker loop),
+// storing them from the root deduplicates those common call-path prefixes.
+// Every node stores a single frame and a reference to its parent node, hence a stack is
+// identified by the index of the node that holds its innermost frame.
 class stack_cache
 {
 public:
-    using stack_t = std::vector<common::instruction_pointer_t>;
+    class stack_view;
 
-    template<std::ranges::sized_range R>
-    std::size_t insert(R&& stack_range);
+    using stack_index_t = std::uint32_t;
 
-    inline const stack_t& get(std::size_t stack_index) const;
+    // Never returned by `insert`, hence it can be used to mark the absence of a stack.
+    static constexpr stack_index_t no_stack = std::numeric_limits<stack_index_t>::max();
+
+    stack_cache();
+
+    template<std::ranges::bidirectional_range R>
+        requires std::ranges::sized_range<R>
+    stack_index_t insert(R&& stack_range);
+
+    inline stack_view get(stack_index_t stack_index) const;
+
+    // Number of frames that are actually stored, i.e. the sum of the sizes of all
+    // stacks without the shared prefixes.
+    inline std::size_t frame_count() const;
 
 private:
-    std::vector<stack_t>                                      stacks;
-    std::unordered_map<std::size_t, std::vector<std::size_t>> stack_map;
+    using node_index_t = stack_index_t;
 
-    struct stack_hasher
+    struct node
     {
-        template<std::ranges::sized_range R>
-        std::size_t operator()(R&& stack_range) const;
-
-    private:
-        std::hash<common::instruction_pointer_t> ip_hash;
+        common::instruction_pointer_t instruction_pointer;
+        node_index_t                  parent;
+        node_index_t                  depth;
     };
+
+    static constexpr node_index_t root_node_index = 0;
+
+    // Index of the child of `parent` with the given instruction pointer.
+    // Children are looked up via an open addressing hash table that stores node indices.
+    // Since the root node is never a child, `root_node_index` marks empty slots.
+    inline node_index_t find_or_insert_child(node_index_t parent, common::instruction_pointer_t instruction_pointer);
+
+    inline void grow_child_table();
+
+    static inline std::size_t child_hash(node_index_t parent, common::instruction_pointer_t instruction_pointer);
+
+    std::vector<node>         nodes;
+    std::vector<node_index_t> child_table;
 };
 
-template<std::ranges::sized_range R>
-std::size_t stack_cache::insert(R&& stack_range)
+// A stack from the cache, in the order it has been inserted (innermost frame first).
+class stack_cache::stack_view
 {
-    const auto hash = stack_hasher()(stack_range);
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = common::instruction_pointer_t;
+        using reference         = common::instruction_pointer_t;
+        using pointer           = const common::instruction_pointer_t*;
 
-    auto& saved_stack_indices = stack_map[hash];
+        iterator() = default;
+        iterator(const std::vector<node>* nodes, node_index_t node_index) :
+            nodes_(nodes),
+            node_index_(node_index)
+        {}
 
-    for(const auto& stack_index : saved_stack_indices)
+        reference operator*() const
+        {
+            return (*nodes_)[node_index_].instruction_pointer;
+        }
+
+        iterator& operator++()
+        {
+            node_index_ = (*nodes_)[node_index_].parent;
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            auto tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.node_index_ == rhs.node_index_;
+        }
+
+    private:
+        const std::vector<node>* nodes_      = nullptr;
+        node_index_t             node_index_ = root_node_index;
+    };
+
+    using value_type     = common::instruction_pointer_t;
+    using const_iterator = iterator;
+
+    stack_view() = default;
+    stack_view(const std::vector<node>* nodes, node_index_t node_index) :
+        nodes_(nodes),
+        node_index_(node_index)
+    {}
+
+    iterator begin() const
+    {
+        return {nodes_, node_index_};
+    }
+
+    iterator end() const
+    {
+        return {nodes_, root_node_index};
+    }
+
+    std::size_t size() const
     {
-        const auto& saved_stack = stacks[stack_index];
-        if(!std::ranges::equal(saved_stack, stack_range)) continue;
+        return nodes_ == nullptr ? 0 : (*nodes_)[node_index_].depth;
+    }
 
-        return stack_index;
+    bool empty() const
+    {
+        return size() == 0;
     }
 
-    const auto new_stack_index = stacks.size();
+    // The index of this stack in the cache.
+    stack_index_t index() const
+    {
+        return node_index_;
+    }
 
-    stacks.emplace_back();
-    stacks.back().reserve(std::ranges::size(stack_range));
-    std::ranges::copy(stack_range, std::back_inserter(stacks.back()));
+    // Writes the stack in reversed order (outermost frame first) to `buffer` and returns a view to it.
+    std::span<const common::instruction_pointer_t> reversed(std::vector<common::instruction_pointer_t>& buffer) const
+    {
+        buffer.resize(size());
+        auto out = buffer.rbegin();
+        for(const auto instruction_pointer : *this)
+        {
+            *out = instruction_pointer;
+            ++out;
+        }
+        return buffer;
+    }
 
-    saved_stack_indices.push_back(new_stack_index);
-    return new_stack_index;
+    template<std::ranges::input_range R>
+    bool operator==(R&& other) const
+    {
+        return std::ranges::equal(*this, other);
+    }
+
+private:
+    const std::vector<node>* nodes_      = nullptr;
+    node_index_t             node_index_ = root_node_index;
+};
+
+inline stack_cache::stack_cache()
+{
+    nodes.push_back(node{
+        .instruction_pointer = 0,
+        .parent              = root_node_index,
+        .depth               = 0});
+    child_table.resize(64, root_node_index);
+}
+
+template<std::ranges::bidirectional_range R>
+    requires std::ranges::sized_range<R>
+stack_cache::stack_index_t stack_cache::insert(R&& stack_range)
+{
+    auto current_node_index = root_node_index;
+    for(const auto instruction_pointer : std::views::reverse(stack_range))
+    {
+        current_node_index = find_or_insert_child(current_node_index, instruction_pointer);
+    }
+    return current_node_index;
+}
+
+inline stack_cache::stack_view stack_cache::get(stack_index_t stack_index) const
+{
+    assert(stack_index < nodes.size());
+    return stack_view(&nodes, stack_index);
+}
+
+inline std::size_t stack_cache::frame_count() const
+{
+    return nodes.size() - 1;
 }
 
-inline const stack_cache::stack_t& stack_cache::get(std::size_t stack_index) const
+inline stack_cache::node_index_t stack_cache::find_or_insert_child(node_index_t parent, common::instruction_pointer_t instruction_pointer)
 {
-    return stacks[stack_index];
+    const auto mask = child_table.size() - 1;
+
+    auto slot = child_hash(parent, instruction_pointer) & mask;
+    while(true)
+    {
+        const auto node_index = child_table[slot];
+        if(node_index == root_node_index) break;
+
+        const auto& child = nodes[node_index];
+        if(child.parent == parent && child.instruction_pointer == instruction_pointer) return node_index;
+
+        slot = (slot + 1) & mask;
+    }
+
+    if(nodes.size() >= std::numeric_limits<node_index_t>::max()) throw std::runtime_error("Too many stack frames");
+
+    const auto new_node_index = static_cast<node_index_t>(nodes.size());
+    nodes.push_back(node{
+        .instruction_pointer = instruction_pointer,
+        .parent              = parent,
+        .depth               = nodes[parent].depth + 1});
+    child_table[slot] = new_node_index;
+
+    // Keep the load factor of the child table below 70%
+    if(nodes.size() * 10 > child_table.size() * 7) grow_child_table();
+
+    return new_node_index;
 }
 
-template<std::ranges::sized_range R>
-std::size_t stack_cache::stack_hasher::operator()(R&& stack_range) const
+inline void stack_cache::grow_child_table()
 {
-    std::size_t hash = std::ranges::size(stack_range);
-    for(const auto ip : stack_range)
+    child_table.assign(child_table.size() * 2, root_node_index);
+
+    const auto mask = child_table.size() - 1;
+    for(node_index_t node_index = root_node_index + 1; node_index < nodes.size(); ++node_index)
     {
-        hash = common::hash_combine(hash, ip_hash(ip));
+        const auto& child = nodes[node_index];
+
+        auto slot = child_hash(child.parent, child.instruction_pointer) & mask;
+        while(child_table[slot] != root_node_index) slot = (slot + 1) & mask;
+        child_table[slot] = node_index;
     }
-    return hash;
+}
+
+inline std::size_t stack_cache::child_hash(node_index_t parent, common::instruction_pointer_t instruction_pointer)
+{
+    return common::hash_combine(parent, static_cast<std::size_t>(instruction_pointer));
 }
 
 } // namespace snail::analysis::detail
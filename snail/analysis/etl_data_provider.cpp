@@ -3,6 +3,7 @@
 
 #include <chrono>
 #include <format>
+#include <limits>
 #include <numeric>
 #include <queue>
 #include <ranges>
@@ -46,6 +47,8 @@ Duration from_relative_qpc_ticks(std::uint64_t ticks, std::uint64_t start, std::
     return from_qpc_ticks<Duration>(common::narrow_cast<std::int64_t>(relative_ticks), qpc_frequency);
 }
 
+constexpr std::size_t max_sample_batch_size = 1024;
+
 struct time_span
 {
     detail::etl_file_process_context::timestamp_t                start;
@@ -94,11 +97,26 @@ const detail::etl_file_process_context::thread_info* get_thread_from_id(const de
     return process_context.get_threads().find_at(thread_key.id, thread_key.time);
 }
 
+std::optional<std::uint64_t> make_stack_key(detail::stack_cache::stack_index_t user_stack_index,
+                                            detail::stack_cache::stack_index_t kernel_stack_index)
+{
+    if(user_stack_index == detail::stack_cache::no_stack && kernel_stack_index == detail::stack_cache::no_stack) return std::nullopt;
+
+    // Stack indices are limited to 32 bits by the stack cache, hence we can pack
+    // both (offset by one to encode a missing stack as zero) into a single key.
+    const std::uint64_t user_key   = user_stack_index != detail::stack_cache::no_stack ? std::uint64_t(user_stack_index) + 1 : 0;
+    const std::uint64_t kernel_key = kernel_stack_index != detail::stack_cache::no_stack ? std::uint64_t(kernel_stack_index) + 1 : 0;
+    return (user_key << 32) | kernel_key;
+}
+
 struct etl_sample_data : public sample_data
 {
     static constexpr detail::etl_file_process_context::os_pid_t kernel_process_id  = 0;
     static constexpr std::string_view                           unkown_module_name = "[unknown]";
 
+    // The interner never hands out its largest id, hence it can not collide with the id of any module name.
+    static constexpr common::string_interner::id_t unkown_module_name_id = std::numeric_limits<common::string_interner::id_t>::max();
+
     stack_frame resolve_frame(detail::etl_file_process_context::os_pid_t pid,
                               std::uint64_t                              instruction_pointer,
                               std::uint64_t                              timestamp) const
@@ -116,12 +134,20 @@ struct etl_sample_data : public sample_data
                                                               .load_timestamp = load_timestamp},
                                                           instruction_pointer);
 
+        const auto module_name = module == nullptr ? unkown_module_name : std::string_view(module->payload.filename);
+
+        const auto ids = stack_frame::string_ids{
+            .symbol_name = symbol.name_id,
+            .module_name = module == nullptr ? unkown_module_name_id : module->payload.name_id,
+            .file_path   = symbol.file_path_id};
+
         return stack_frame{
             .symbol_name             = symbol.name,
-            .module_name             = module == nullptr ? unkown_module_name : module->payload.filename,
+            .module_name             = module_name,
             .file_path               = symbol.file_path,
             .function_line_number    = symbol.function_line_number,
-            .instruction_line_number = symbol.instruction_line_number};
+            .instruction_line_number = symbol.instruction_line_number,
+            .ids                     = ids};
     }
 
     bool has_frame() const override
@@ -131,27 +157,33 @@ struct etl_sample_data : public sample_data
 
     bool has_stack() const override
     {
-        return user_stack != nullptr || kernel_stack != nullptr;
+        return user_stack != std::nullopt || kernel_stack != std::nullopt;
     }
 
     common::generator<stack_frame> reversed_stack() const override
     {
-        if(user_stack != nullptr)
+        if(user_stack != std::nullopt)
         {
-            for(const auto instruction_pointer : std::views::reverse(*user_stack))
+            for(const auto instruction_pointer : user_stack->reversed(reversed_stack_buffer))
             {
                 co_yield resolve_frame(process_id, instruction_pointer, user_timestamp);
             }
         }
-        if(kernel_stack != nullptr)
+        if(kernel_stack != std::nullopt)
         {
-            for(const auto instruction_pointer : std::views::reverse(*kernel_stack))
+            for(const auto instruction_pointer : kernel_stack->reversed(reversed_stack_buffer))
             {
                 co_yield resolve_frame(kernel_process_id, instruction_pointer, kernel_timestamp);
             }
         }
     }
 
+    std::optional<std::uint64_t> stack_key() const override
+    {
+        return make_stack_key(user_stack ? user_stack->index() : detail::stack_cache::no_stack,
+                              kernel_stack ? kernel_stack->index() : detail::stack_cache::no_stack);
+    }
+
     stack_frame frame() const override
     {
         return resolve_frame(process_id, instruction_pointer_, sample_timestamp);
@@ -162,10 +194,10 @@ struct etl_sample_data : public sample_data
         return from_relative_qpc_ticks<std::chrono::nanoseconds>(sample_timestamp, session_start_qpc_ticks, qpc_frequency);
     }
 
-    const std::vector<detail::etl_file_process_context::instruction_pointer_t>* user_stack;
-    const std::vector<detail::etl_file_process_context::instruction_pointer_t>* kernel_stack;
-    detail::etl_file_process_context::timestamp_t                               kernel_timestamp;
-    detail::etl_file_process_context::timestamp_t                               user_timestamp;
+    std::optional<detail::stack_cache::stack_view> user_stack;
+    std::optional<detail::stack_cache::stack_view> kernel_stack;
+    detail::etl_file_process_context::timestamp_t  kernel_timestamp;
+    detail::etl_file_process_context::timestamp_t  user_timestamp;
 
     detail::etl_file_process_context::os_pid_t process_id;
     detail::pdb_resolver*                      resolver;
@@ -177,6 +209,54 @@ struct etl_sample_data : public sample_data
 
     std::uint64_t session_start_qpc_ticks;
     std::uint64_t qpc_frequency;
+
+    // Reused for all samples to avoid allocating memory for every reversed stack.
+    mutable std::vector<detail::etl_file_process_context::instruction_pointer_t> reversed_stack_buffer;
+};
+
+struct etl_sample_batch : public sample_batch
+{
+    using sample_info = detail::etl_file_process_context::sample_info;
+
+    std::span<const sample_record> records() const override
+    {
+        return records_;
+    }
+
+    const sample_data& sample(std::size_t index) const override
+    {
+        const auto& sample = samples_[index];
+
+        current_sample_data.sample_timestamp     = sample.timestamp;
+        current_sample_data.instruction_pointer_ = sample.instruction_pointer;
+
+        if(sample.user_mode_stack != detail::stack_cache::no_stack)
+        {
+            current_sample_data.user_stack     = current_sample_data.context->stack(sample.user_mode_stack);
+            current_sample_data.user_timestamp = sample.user_timestamp;
+        }
+        else
+        {
+            current_sample_data.user_stack = std::nullopt;
+        }
+
+        if(sample.kernel_mode_stack != detail::stack_cache::no_stack)
+        {
+            current_sample_data.kernel_stack     = current_sample_data.context->stack(sample.kernel_mode_stack);
+            current_sample_data.kernel_timestamp = sample.kernel_timestamp;
+        }
+        else
+        {
+            current_sample_data.kernel_stack = std::nullopt;
+        }
+
+        return current_sample_data;
+    }
+
+    std::span<const sample_info> samples_;
+    std::vector<sample_record>   records_;
+
+    mutable etl_sample_data current_sample_data;
 };
 
 std::string win_architecture_to_str(std::uint16_t arch)
@@ -550,24 +630,24 @@ common::generator<const sample_data&> etl_data_provider::samples(sample_source_i
             current_sample_data.sample_timestamp     = sample.timestamp;
             current_sample_data.instruction_pointer_ = sample.instruction_pointer;
 
-            if(sample.user_mode_stack)
+            if(sample.user_mode_stack != detail::stack_cache::no_stack)
             {
-                current_sample_data.user_stack     = &process_context.stack(*sample.user_mode_stack);
+                current_sample_data.user_stack     = process_context.stack(sample.user_mode_stack);
                 current_sample_data.user_timestamp = sample.user_timestamp;
             }
             else
             {
-                current_sample_data.user_stack = nullptr;
+                current_sample_data.user_stack = std::nullopt;
             }
 
-            if(sample.kernel_mode_stack)
+            if(sample.kernel_mode_stack != detail::stack_cache::no_stack)
             {
-                current_sample_data.kernel_stack     = &process_context.stack(*sample.kernel_mode_stack);
+                current_sample_data.kernel_stack     = process_context.stack(sample.kernel_mode_stack);
                 current_sample_data.kernel_timestamp = sample.kernel_timestamp;
             }
             else
             {
-                current_sample_data.kernel_stack = nullptr;
+                current_sample_data.kernel_stack = std::nullopt;
             }
 
             co_yield current_sample_data;
@@ -592,6 +672,61 @@ common::generator<const sample_data&> etl_data_provider::samples(sample_source_i
     }
 }
 
+common::generator<const sample_batch&> etl_data_provider::sample_batches(sample_source_info::id_t source_id,
+                                                                         unique_process_id        process_id,
+                                                                         const sample_filter&     filter) const
+{
+    if(process_context_ == nullptr) co_return;
+    if(filter.excluded_processes.contains(process_id)) co_return;
+    if(source_id >= sample_source_internal_ids_.size()) co_return;
+
+    assert(symbol_resolver_ != nullptr);
+
+    const auto& process_context = *process_context_;
+
+    const auto process_key = process_context_->id_to_key(process_id);
+
+    etl_sample_batch batch;
+
+    batch.current_sample_data.process_id              = process_key.id;
+    batch.current_sample_data.context                 = process_context_.get();
+    batch.current_sample_data.resolver                = symbol_resolver_.get();
+    batch.current_sample_data.session_start_qpc_ticks = session_start_qpc_ticks_;
+    batch.current_sample_data.qpc_frequency           = qpc_frequency_;
+
+    batch.records_.reserve(max_sample_batch_size);
+
+    for(const auto& thread_id : process_context.get_process_threads(process_id))
+    {
+        if(filter.excluded_threads.contains(thread_id)) continue;
+
+        const auto* const thread = get_thread_from_id(*process_context_, thread_id);
+        if(thread == nullptr) continue;
+
+        const auto time_span = get_filter_timespan(*thread, filter, session_start_qpc_ticks_, qpc_frequency_);
+
+        const auto samples = process_context.thread_samples(thread->id, time_span.start, time_span.end, sample_source_internal_ids_[source_id]);
+
+        for(std::size_t offset = 0; offset < samples.size(); offset += max_sample_batch_size)
+        {
+            batch.samples_ = samples.subspan(offset, std::min(max_sample_batch_size, samples.size() - offset));
+
+            batch.records_.clear();
+            for(const auto& sample : batch.samples_)
+            {
+                batch.records_.push_back(sample_record{
+                    .thread_id           = thread_id,
+                    .timestamp           = from_relative_qpc_ticks<std::chrono::nanoseconds>(sample.timestamp, session_start_qpc_ticks_, qpc_frequency_),
+                    .instruction_pointer = sample.instruction_pointer,
+                    .stack_key           = make_stack_key(sample.user_mode_stack, sample.kernel_mode_stack),
+                    .has_stack           = sample.user_mode_stack != detail::stack_cache::no_stack || sample.kernel_mode_stack != detail::stack_cache::no_stack});
+            }
+
+            co_yield batch;
+        }
+    }
+}
+
 std::size_t etl_data_provider::count_samples(sample_source_info::id_t source_id,
                                              unique_process_id        process_id,
                                              const sample_filter&     filter) const
@@ -622,3 +757,41 @@ std::size_t etl_data_provider::count_samples(sample_source_info::id_t source_id,
 
     return process_context_->thread_samples(thread->id, time_span.start, time_span.end, sample_source_internal_ids_[source_id]).size();
 }
+
+std::vector<std::size_t> etl_data_provider::count_samples_per_time_bucket(sample_source_info::id_t source_id,
+                                                                          unique_thread_id         thread_id,
+                                                                          std::chrono::nanoseconds start_time,
+                                                                          std::chrono::nanoseconds bucket_duration,
+                                                                          std::size_t              bucket_count) const
+{
+    std::vector<std::size_t> result(bucket_count, 0);
+
+    if(process_context_ == nullptr) return result;
+    if(source_id >= sample_source_internal_ids_.size()) return result;
+
+    const auto* const thread = get_thread_from_id(*process_context_, thread_id);
+    if(thread == nullptr) return result;
+
+    const auto time_span = get_filter_timespan(*thread, {}, session_start_qpc_ticks_, qpc_frequency_);
+    const auto samples   = process_context_->thread_samples(thread->id, time_span.start, time_span.end, sample_source_internal_ids_[source_id]);
+
+    const auto to_timestamp = [this](std::chrono::nanoseconds time)
+    {
+        return static_cast<detail::etl_file_process_context::timestamp_t>(
+            session_start_qpc_ticks_ + std::max(to_qpc_ticks(time, qpc_frequency_), std::chrono::nanoseconds::rep(0)));
+    };
+
+    // The samples are sorted by time, hence we only need to find the first sample of each bucket.
+    auto bucket_begin = std::ranges::lower_bound(samples, to_timestamp(start_time), std::less<>(), &detail::etl_file_process_context::sample_info::timestamp);
+    for(std::size_t bucket_index = 0; bucket_index < bucket_count; ++bucket_index)
+    {
+        const auto bucket_end_time = start_time + bucket_duration * static_cast<std::chrono::nanoseconds::rep>(bucket_index + 1);
+
+        const auto bucket_end = std::ranges::lower_bound(bucket_begin, samples.end(), to_timestamp(bucket_end_time), std::less<>(), &detail::etl_file_process_context::sample_info::timestamp);
+
+        result[bucket_index] = static_cast<std::size_t>(bucket_end - bucket_begin);
+        bucket_begin         = bucket_end;
+    }
+
+    return result;
+}
@@ -1,6 +1,7 @@
 #include <snail/analysis/perf_data_data_provider.hpp>
 
 #include <format>
+#include <limits>
 #include <numeric>
 #include <queue>
 #include <ranges>
@@ -20,6 +21,12 @@ using namespace snail::analysis;
 
 namespace {
 
+std::optional<std::uint64_t> get_instruction_pointer(const detail::perf_data_file_process_context::sample_info& sample)
+{
+    if(sample.instruction_pointer == detail::perf_data_file_process_context::sample_info::no_instruction_pointer) return std::nullopt;
+    return sample.instruction_pointer;
+}
+
 template<typename Duration>
 Duration from_relative_timestamps(detail::perf_data_file_process_context::timestamp_t timestamp, detail::perf_data_file_process_context::timestamp_t start_timestamp)
 {
@@ -37,6 +44,8 @@ detail::perf_data_file_process_context::timestamp_t to_relative_timestamp(std::c
     return start_timestamp + common::narrow_cast<detail::perf_data_file_process_context::timestamp_t>(timestamp.count());
 }
 
+constexpr std::size_t max_sample_batch_size = 1024;
+
 struct time_span
 {
     detail::perf_data_file_process_context::timestamp_t                start;
@@ -84,6 +93,9 @@ struct perf_data_sample_data : public sample_data
 {
     static constexpr std::string_view unkown_module_name = "[unknown]";
 
+    // The interner never hands out its largest id, hence it can not collide with the id of any module name.
+    static constexpr common::string_interner::id_t unkown_module_name_id = std::numeric_limits<common::string_interner::id_t>::max();
+
     std::optional<perf_data::build_id> try_get_module_build_id(const detail::perf_data_file_process_context::module_data& module) const
     {
         if(module.build_id) return module.build_id;
@@ -110,12 +122,20 @@ struct perf_data_sample_data : public sample_data
                                                               .load_timestamp = load_timestamp},
                                                           instruction_pointer);
 
+        const auto module_name = module == nullptr ? unkown_module_name : std::string_view(module->payload.filename);
+
+        const auto ids = stack_frame::string_ids{
+            .symbol_name = symbol.name_id,
+            .module_name = module == nullptr ? unkown_module_name_id : module->payload.name_id,
+            .file_path   = symbol.file_path_id};
+
         return stack_frame{
             .symbol_name             = symbol.name,
-            .module_name             = module == nullptr ? unkown_module_name : module->payload.filename,
+            .module_name             = module_name,
             .file_path               = symbol.file_path,
             .function_line_number    = symbol.function_line_number,
-            .instruction_line_number = symbol.instruction_line_number};
+            .instruction_line_number = symbol.instruction_line_number,
+            .ids                     = ids};
     }
 
     bool has_frame() const override
@@ -125,14 +145,14 @@ struct perf_data_sample_data : public sample_data
 
     bool has_stack() const override
     {
-        return stack != nullptr;
+        return stack != std::nullopt;
     }
 
     common::generator<stack_frame> reversed_stack() const override
     {
-        if(stack == nullptr) co_return;
+        if(stack == std::nullopt) co_return;
 
-        for(const auto instruction_pointer : std::views::reverse(*stack))
+        for(const auto instruction_pointer : stack->reversed(reversed_stack_buffer))
         {
             if(instruction_pointer >= std::to_underlying(perf_data::parser::sample_stack_context_marker::max))
             {
@@ -144,6 +164,12 @@ struct perf_data_sample_data : public sample_data
         }
     }
 
+    std::optional<std::uint64_t> stack_key() const override
+    {
+        if(stack == std::nullopt) return std::nullopt;
+        return stack->index();
+    }
+
     stack_frame frame() const override
     {
         return resolve_frame(*instruction_pointer_);
@@ -154,14 +180,43 @@ struct perf_data_sample_data : public sample_data
         return from_relative_timestamps<std::chrono::nanoseconds>(timestamp_, session_start_time);
     }
 
-    const detail::perf_data_file_process_context*                                     context;
-    detail::dwarf_resolver*                                                           resolver;
-    const std::unordered_map<std::string, perf_data::build_id>*                       build_id_map;
-    detail::perf_data_file_process_context::os_pid_t                                  process_id;
-    const std::vector<detail::perf_data_file_process_context::instruction_pointer_t>* stack;
-    detail::perf_data_file_process_context::timestamp_t                               timestamp_;
-    std::optional<std::uint64_t>                                                      instruction_pointer_;
-    detail::perf_data_file_process_context::timestamp_t                               session_start_time;
+    const detail::perf_data_file_process_context*               context;
+    detail::dwarf_resolver*                                     resolver;
+    const std::unordered_map<std::string, perf_data::build_id>* build_id_map;
+    detail::perf_data_file_process_context::os_pid_t            process_id;
+    std::optional<detail::stack_cache::stack_view>              stack;
+    detail::perf_data_file_process_context::timestamp_t         timestamp_;
+    std::optional<std::uint64_t>                                instruction_pointer_;
+    detail::perf_data_file_process_context::timestamp_t         session_start_time;
+
+    // Reused for all samples to avoid allocating memory for every reversed stack.
+    mutable std::vector<detail::perf_data_file_process_context::instruction_pointer_t> reversed_stack_buffer;
+};
+
+struct perf_data_sample_batch : public sample_batch
+{
+    using sample_info = detail::perf_data_file_process_context::sample_info;
+
+    std::span<const sample_record> records() const override
+    {
+        return records_;
+    }
+
+    const sample_data& sample(std::size_t index) const override
+    {
+        const auto& sample = samples_[index];
+
+        current_sample_data.stack                = sample.stack_index != detail::stack_cache::no_stack ? std::make_optional(current_sample_data.context->stack(sample.stack_index)) : std::nullopt;
+        current_sample_data.timestamp_           = sample.timestamp;
+        current_sample_data.instruction_pointer_ = get_instruction_pointer(sample);
+
+        return current_sample_data;
+    }
+
+    std::span<const sample_info> samples_;
+    std::vector<sample_record>   records_;
+
+    mutable perf_data_sample_data current_sample_data;
 };
 
 struct next_sample_priority_info
@@ -205,9 +260,9 @@ void perf_data_data_provider::process(const std::filesystem::path&      file_pat
     process_context_ = std::make_unique<detail::perf_data_file_process_context>();
 
     perf_data::perf_data_file file(file_path);
-    file.process(process_context_->observer(),
-                 progress_listener,
-                 cancellation_token);
+    file.process_parallel(process_context_->batched_observer(),
+                          progress_listener,
+                          cancellation_token);
 
     process_context_->finish();
 
@@ -531,9 +586,9 @@ common::generator<const sample_data&> perf_data_data_provider::samples(sample_so
 
             const auto& sample = thread_data.samples[current_sample_index];
 
-            current_sample_data.stack                = sample.stack_index ? &process_context.stack(*sample.stack_index) : nullptr;
+            current_sample_data.stack                = sample.stack_index != detail::stack_cache::no_stack ? std::make_optional(process_context.stack(sample.stack_index)) : std::nullopt;
             current_sample_data.timestamp_           = sample.timestamp;
-            current_sample_data.instruction_pointer_ = sample.instruction_pointer;
+            current_sample_data.instruction_pointer_ = get_instruction_pointer(sample);
 
             co_yield current_sample_data;
 
@@ -557,6 +612,63 @@ common::generator<const sample_data&> perf_data_data_provider::samples(sample_so
     }
 }
 
+common::generator<const sample_batch&> perf_data_data_provider::sample_batches(sample_source_info::id_t source_id,
+                                                                               unique_process_id        process_id,
+                                                                               const sample_filter&     filter) const
+{
+    if(process_context_ == nullptr) co_return;
+    if(filter.excluded_processes.contains(process_id)) co_return;
+    if(source_id >= sample_source_internal_ids_.size()) co_return;
+
+    assert(symbol_resolver_ != nullptr);
+
+    const auto& process_context = *process_context_;
+
+    const auto process_key = process_context_->id_to_key(process_id);
+
+    perf_data_sample_batch batch;
+
+    batch.current_sample_data.process_id         = process_key.id;
+    batch.current_sample_data.context            = process_context_.get();
+    batch.current_sample_data.resolver           = symbol_resolver_.get();
+    batch.current_sample_data.build_id_map       = build_id_map_ ? &build_id_map_.value() : nullptr;
+    batch.current_sample_data.session_start_time = session_start_time_;
+
+    batch.records_.reserve(max_sample_batch_size);
+
+    const auto source_internal_id = sample_source_internal_ids_[source_id];
+
+    for(const auto& thread_id : process_context.get_process_threads(process_id))
+    {
+        if(filter.excluded_threads.contains(thread_id)) continue;
+
+        const auto* const thread = get_thread_from_id(*process_context_, thread_id);
+        if(thread == nullptr) continue;
+
+        const auto time_span = get_filter_timespan(*thread, filter, session_start_time_);
+
+        const auto samples = process_context.thread_samples(thread->id, time_span.start, time_span.end, source_internal_id);
+
+        for(std::size_t offset = 0; offset < samples.size(); offset += max_sample_batch_size)
+        {
+            batch.samples_ = samples.subspan(offset, std::min(max_sample_batch_size, samples.size() - offset));
+
+            batch.records_.clear();
+            for(const auto& sample : batch.samples_)
+            {
+                batch.records_.push_back(sample_record{
+                    .thread_id           = thread_id,
+                    .timestamp           = from_relative_timestamps<std::chrono::nanoseconds>(sample.timestamp, session_start_time_),
+                    .instruction_pointer = get_instruction_pointer(sample),
+                    .stack_key           = sample.stack_index != detail::stack_cache::no_stack ? std::make_optional<std::uint64_t>(sample.stack_index) : std::nullopt,
+                    .has_stack           = sample.stack_index != detail::stack_cache::no_stack});
+            }
+
+            co_yield batch;
+        }
+    }
+}
+
 std::size_t perf_data_data_provider::count_samples(sample_source_info::id_t source_id,
                                                    unique_process_id        process_id,
                                                    const sample_filter&     filter) const
@@ -590,3 +702,35 @@ std::size_t perf_data_data_provider::count_samples(sample_source_info::id_t sour
 
     return process_context_->thread_samples(thread->id, time_span.start, time_span.end, sample_source_internal_ids_[source_id]).size();
 }
+
+std::vector<std::size_t> perf_data_data_provider::count_samples_per_time_bucket(sample_source_info::id_t source_id,
+                                                                                unique_thread_id         thread_id,
+                                                                                std::chrono::nanoseconds start_time,
+                                                                                std::chrono::nanoseconds bucket_duration,
+                                                                                std::size_t              bucket_count) const
+{
+    std::vector<std::size_t> result(bucket_count, 0);
+
+    if(process_context_ == nullptr) return result;
+    if(source_id >= sample_source_internal_ids_.size()) return result;
+
+    const auto* const thread = get_thread_from_id(*process_context_, thread_id);
+    if(thread == nullptr) return result;
+
+    const auto time_span = get_filter_timespan(*thread, {}, session_start_time_);
+    const auto samples   = process_context_->thread_samples(thread->id, time_span.start, time_span.end, sample_source_internal_ids_[source_id]);
+
+    // The samples are sorted by time, hence we only need to find the first sample of each bucket.
+    auto bucket_begin = std::ranges::lower_bound(samples, to_relative_timestamp(start_time, session_start_time_), std::less<>(), &detail::perf_data_file_process_context::sample_info::timestamp);
+    for(std::size_t bucket_index = 0; bucket_index < bucket_count; ++bucket_index)
+    {
+        const auto bucket_end_time = start_time + bucket_duration * static_cast<std::chrono::nanoseconds::rep>(bucket_index + 1);
+
+        const auto bucket_end = std::ranges::lower_bound(bucket_begin, samples.end(), to_relative_timestamp(bucket_end_time, session_start_time_), std::less<>(), &detail::perf_data_file_process_context::sample_info::timestamp);
+
+        result[bucket_index] = static_cast<std::size_t>(bucket_end - bucket_begin);
+        bucket_begin         = bucket_end;
+    }
+
+    return result;
+}
@@ -49,6 +49,10 @@ public:
                                                           unique_process_id        process_id,
                                                           const sample_filter&     filter) const override;
 
+    virtual common::generator<const sample_batch&> sample_batches(sample_source_info::id_t source_id,
+                                                                  unique_process_id        process_id,
+                                                                  const sample_filter&     filter) const override;
+
     virtual std::size_t count_samples(sample_source_info::id_t source_id,
                                       unique_process_id        process_id,
                                       const sample_filter&     filter) const override;
@@ -57,6 +61,12 @@ public:
                                       unique_thread_id         thread_id,
                                       const sample_filter&     filter) const override;
 
+    virtual std::vector<std::size_t> count_samples_per_time_bucket(sample_source_info::id_t source_id,
+                                                                   unique_thread_id         thread_id,
+                                                                   std::chrono::nanoseconds start_time,
+                                                                   std::chrono::nanoseconds bucket_duration,
+                                                                   std::size_t              bucket_count) const override;
+
 private:
     std::unique_ptr<detail::perf_data_file_process_context> process_context_;
     std::unique_ptr<detail::dwarf_resolver>                 symbol_resolver_;
@@ -1,12 +1,50 @@
 #pragma once
 
+#include <cstdint>
 #include <type_traits>
 
 namespace snail::common {
 
+namespace detail {
+
+// Finalizers of MurmurHash3 (fmix64 / fmix32): every input bit affects every output bit.
+[[nodiscard]] inline constexpr std::uint64_t hash_mix64(std::uint64_t value) noexcept
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+[[nodiscard]] inline constexpr std::uint32_t hash_mix32(std::uint32_t value) noexcept
+{
+    value ^= value >> 16;
+    value *= 0x85ebca6bU;
+    value ^= value >> 13;
+    value *= 0xc2b2ae35U;
+    value ^= value >> 16;
+    return value;
+}
+
+} // namespace detail
+
+// Combines the hash `rhs` into the (already combined) hash `lhs`.
+//
+// The result depends on the order of the combined values and does not cancel out
+// for repeated values, so that e.g. permuted stacks or stacks with recursive frames
+// do not collide.
 [[nodiscard]] inline constexpr std::size_t hash_combine(std::size_t lhs, std::size_t rhs) noexcept
 {
-    return lhs ^ rhs;
+    if constexpr(sizeof(std::size_t) == sizeof(std::uint64_t))
+    {
+        return static_cast<std::size_t>(detail::hash_mix64((static_cast<std::uint64_t>(lhs) * 0x9e3779b97f4a7c15ULL) ^ static_cast<std::uint64_t>(rhs)));
+    }
+    else
+    {
+        return static_cast<std::size_t>(detail::hash_mix32((static_cast<std::uint32_t>(lhs) * 0x9e3779b9U) ^ static_cast<std::uint32_t>(rhs)));
+    }
 }
 
 } // namespace snail::common
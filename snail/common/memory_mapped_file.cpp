@@ -0,0 +1,150 @@
+
+#include <snail/common/memory_mapped_file.hpp>
+
+#include <utility>
+
+#ifdef _WIN32
+#    define NOMINMAX
+#    define WIN32_LEAN_AND_MEAN
+#    include <Windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+using namespace snail::common;
+
+memory_mapped_file::memory_mapped_file(const std::filesystem::path& file_path)
+{
+    open(file_path);
+}
+
+memory_mapped_file::~memory_mapped_file()
+{
+    close();
+}
+
+memory_mapped_file::memory_mapped_file(memory_mapped_file&& other) noexcept :
+    data_(std::exchange(other.data_, nullptr)),
+    size_(std::exchange(other.size_, 0))
+#ifdef _WIN32
+    ,
+    file_handle_(std::exchange(other.file_handle_, nullptr)),
+    mapping_handle_(std::exchange(other.mapping_handle_, nullptr))
+#endif
+{}
+
+memory_mapped_file& memory_mapped_file::operator=(memory_mapped_file&& other) noexcept
+{
+    if(this == &other) return *this;
+
+    close();
+
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+    file_handle_    = std::exchange(other.file_handle_, nullptr);
+    mapping_handle_ = std::exchange(other.mapping_handle_, nullptr);
+#endif
+
+    return *this;
+}
+
+bool memory_mapped_file::open(const std::filesystem::path& file_path) noexcept
+{
+    close();
+
+    std::error_code ec;
+    if(!std::filesystem::is_regular_file(file_path, ec) || ec) return false;
+
+#ifdef _WIN32
+    const auto file_handle = CreateFileW(file_path.c_str(),
+                                         GENERIC_READ,
+                                         FILE_SHARE_READ,
+                                         nullptr,
+                                         OPEN_EXISTING,
+                                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                                         nullptr);
+    if(file_handle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart <= 0)
+    {
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    const auto mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(mapping_handle == nullptr)
+    {
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    const auto* const view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if(view == nullptr)
+    {
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    file_handle_    = file_handle;
+    mapping_handle_ = mapping_handle;
+    data_           = static_cast<const std::byte*>(view);
+    size_           = static_cast<std::size_t>(file_size.QuadPart);
+#else
+    const auto file_descriptor = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(file_descriptor < 0) return false;
+
+    struct stat file_stat;
+    if(::fstat(file_descriptor, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) || file_stat.st_size <= 0)
+    {
+        ::close(file_descriptor);
+        return false;
+    }
+
+    const auto file_size = static_cast<std::size_t>(file_stat.st_size);
+
+    auto* const view = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+
+    // The mapping stays valid after the file descriptor has been closed.
+    ::close(file_descriptor);
+
+    if(view == MAP_FAILED) return false;
+
+    ::madvise(view, file_size, MADV_SEQUENTIAL);
+
+    data_ = static_cast<const std::byte*>(view);
+    size_ = file_size;
+#endif
+
+    return true;
+}
+
+void memory_mapped_file::close() noexcept
+{
+#ifdef _WIN32
+    if(data_ != nullptr) UnmapViewOfFile(data_);
+    if(mapping_handle_ != nullptr) CloseHandle(mapping_handle_);
+    if(file_handle_ != nullptr) CloseHandle(file_handle_);
+    mapping_handle_ = nullptr;
+    file_handle_    = nullptr;
+#else
+    if(data_ != nullptr) ::munmap(const_cast<std::byte*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool memory_mapped_file::is_open() const noexcept
+{
+    return data_ != nullptr;
+}
+
+std::span<const std::byte> memory_mapped_file::data() const noexcept
+{
+    return {data_, size_};
+}
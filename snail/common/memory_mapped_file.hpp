@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace snail::common {
+
+// Read-only memory mapping of a complete file.
+//
+// Opening the mapping is allowed to fail (e.g. for pipes, special files or empty files),
+// so that callers can fall back to regular stream based reading.
+class memory_mapped_file
+{
+public:
+    memory_mapped_file() = default;
+    explicit memory_mapped_file(const std::filesystem::path& file_path);
+
+    ~memory_mapped_file();
+
+    memory_mapped_file(const memory_mapped_file&)            = delete;
+    memory_mapped_file& operator=(const memory_mapped_file&) = delete;
+
+    memory_mapped_file(memory_mapped_file&& other) noexcept;
+    memory_mapped_file& operator=(memory_mapped_file&& other) noexcept;
+
+    // Returns `false` if the file could not be mapped.
+    bool open(const std::filesystem::path& file_path) noexcept;
+
+    void close() noexcept;
+
+    bool is_open() const noexcept;
+
+    std::span<const std::byte> data() const noexcept;
+
+private:
+    const std::byte* data_ = nullptr;
+    std::size_t      size_ = 0;
+
+#ifdef _WIN32
+    void* file_handle_    = nullptr;
+    void* mapping_handle_ = nullptr;
+#endif
+};
+
+} // namespace snail::common
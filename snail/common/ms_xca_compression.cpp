@@ -0,0 +1,245 @@
+
+#include <snail/common/ms_xca_compression.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+using namespace snail::common;
+
+namespace {
+
+class compressed_output
+{
+public:
+    explicit compressed_output(std::span<std::byte> output) :
+        output_(output)
+    {}
+
+    std::size_t position() const
+    {
+        return position_;
+    }
+
+    std::size_t reserve(std::size_t size)
+    {
+        if(position_ + size > output_.size()) throw std::runtime_error("Insufficient output buffer size");
+        const auto start = position_;
+        position_ += size;
+        return start;
+    }
+
+    template<typename T>
+    void write_at(std::size_t position, T value)
+    {
+        for(std::size_t i = 0; i < sizeof(T); ++i)
+        {
+            output_[position + i] = static_cast<std::byte>((value >> (i * 8)) & 0xFF);
+        }
+    }
+
+    template<typename T>
+    void write(T value)
+    {
+        write_at(reserve(sizeof(T)), value);
+    }
+
+    std::byte& at(std::size_t position)
+    {
+        return output_[position];
+    }
+
+private:
+    std::span<std::byte> output_;
+    std::size_t          position_ = 0;
+};
+
+// Plain LZ77 compression algorithm according to the MS-XCA.
+// See https://learn.microsoft.com/en-us/openspecs/windows_protocols/ms-xca
+//
+// This is a greedy encoder: at every position it takes the longest match that it can
+// find by following a (bounded) chain of previous positions with the same 3-byte hash.
+
+constexpr std::size_t xpress_min_match_length = 3;
+constexpr std::size_t xpress_max_offset       = 8192;
+constexpr std::size_t xpress_hash_bits        = 15;
+constexpr std::size_t xpress_max_chain_length = 16;
+
+constexpr auto xpress_no_position = std::numeric_limits<std::uint32_t>::max();
+constexpr auto no_output_position = std::numeric_limits<std::size_t>::max();
+
+inline std::uint32_t xpress_hash(const std::byte* data)
+{
+    const auto value = static_cast<std::uint32_t>(data[0]) |
+                       (static_cast<std::uint32_t>(data[1]) << 8) |
+                       (static_cast<std::uint32_t>(data[2]) << 16);
+    return (value * 2654435761U) >> (32 - xpress_hash_bits);
+}
+
+std::size_t compress_xpress(std::span<const std::byte> input,
+                            std::span<std::byte>       output)
+{
+    compressed_output out(output);
+
+    std::vector<std::uint32_t> hash_heads(std::size_t(1) << xpress_hash_bits, xpress_no_position);
+    std::vector<std::uint32_t> previous_positions(xpress_max_offset, xpress_no_position);
+
+    if(input.size() > std::numeric_limits<std::uint32_t>::max()) throw std::runtime_error("Input too large");
+
+    std::size_t   flags_position = out.reserve(4);
+    std::uint32_t flags          = 0;
+    int           flag_count     = 0;
+
+    // Position of the byte holding the length bits of the last long match, if its upper half is still free.
+    std::size_t last_length_half_position = no_output_position;
+
+    const auto insert_position = [&](std::size_t position)
+    {
+        if(position + xpress_min_match_length > input.size()) return;
+        auto& head                                                = hash_heads[xpress_hash(input.data() + position)];
+        previous_positions[position & (xpress_max_offset - 1)] = head;
+        head                                                      = static_cast<std::uint32_t>(position);
+    };
+
+    const auto push_flag = [&](bool is_match)
+    {
+        flags = (flags << 1) | (is_match ? 1 : 0);
+        ++flag_count;
+        if(flag_count == 32)
+        {
+            out.write_at(flags_position, flags);
+            flags_position = out.reserve(4);
+            flags          = 0;
+            flag_count     = 0;
+        }
+    };
+
+    std::size_t in_pos = 0;
+    while(in_pos < input.size())
+    {
+        std::size_t match_length = 0;
+        std::size_t match_offset = 0;
+
+        if(in_pos + xpress_min_match_length <= input.size())
+        {
+            const auto max_length = input.size() - in_pos;
+
+            auto candidate = hash_heads[xpress_hash(input.data() + in_pos)];
+            for(std::size_t chain_length = 0;
+                chain_length < xpress_max_chain_length && candidate != xpress_no_position && in_pos - candidate <= xpress_max_offset;
+                ++chain_length)
+            {
+                std::size_t length = 0;
+                while(length < max_length && input[candidate + length] == input[in_pos + length]) ++length;
+
+                if(length > match_length)
+                {
+                    match_length = length;
+                    match_offset = in_pos - candidate;
+                    if(length == max_length) break;
+                }
+
+                const auto previous = previous_positions[candidate & (xpress_max_offset - 1)];
+                if(previous == xpress_no_position || previous >= candidate) break;
+                candidate = previous;
+            }
+        }
+
+        if(match_length < xpress_min_match_length)
+        {
+            out.at(out.reserve(1)) = input[in_pos];
+            insert_position(in_pos);
+            ++in_pos;
+            push_flag(false);
+            continue;
+        }
+
+        const auto encoded_offset = static_cast<std::uint16_t>((match_offset - 1) << 3);
+        auto       length         = match_length - xpress_min_match_length;
+        if(length < 7)
+        {
+            out.write(static_cast<std::uint16_t>(encoded_offset | length));
+        }
+        else
+        {
+            out.write(static_cast<std::uint16_t>(encoded_offset | 7));
+            length -= 7;
+
+            // Two consecutive long matches share a single byte for their first 4 length bits.
+            const auto half_length = static_cast<std::uint8_t>(std::min(length, std::size_t(15)));
+            if(last_length_half_position == no_output_position)
+            {
+                last_length_half_position         = out.reserve(1);
+                out.at(last_length_half_position) = static_cast<std::byte>(half_length);
+            }
+            else
+            {
+                out.at(last_length_half_position) |= static_cast<std::byte>(half_length << 4);
+                last_length_half_position = no_output_position;
+            }
+
+            if(length >= 15)
+            {
+                length -= 15;
+                if(length < 255)
+                {
+                    out.write(static_cast<std::uint8_t>(length));
+                }
+                else
+                {
+                    out.write(std::uint8_t(255));
+
+                    const auto full_length = match_length - xpress_min_match_length;
+                    if(full_length <= std::numeric_limits<std::uint16_t>::max())
+                    {
+                        out.write(static_cast<std::uint16_t>(full_length));
+                    }
+                    else
+                    {
+                        out.write(std::uint16_t(0));
+                        out.write(static_cast<std::uint32_t>(full_length));
+                    }
+                }
+            }
+        }
+
+        for(std::size_t i = 0; i < match_length; ++i)
+        {
+            insert_position(in_pos + i);
+        }
+        in_pos += match_length;
+        push_flag(true);
+    }
+
+    // Fill the unused flags with ones: the decoder stops at a match flag when
+    // there is no more input.
+    flags = flag_count == 0 ? std::numeric_limits<std::uint32_t>::max() :
+                              (flags << (32 - flag_count)) | ((std::uint32_t(1) << (32 - flag_count)) - 1);
+    out.write_at(flags_position, flags);
+
+    return out.position();
+}
+
+} // namespace
+
+std::size_t snail::common::ms_xca_compress(std::span<const std::byte> input,
+                                           std::span<std::byte>       output,
+                                           ms_xca_compression_format  format)
+{
+    switch(format)
+    {
+    case ms_xca_compression_format::none:
+        if(input.size() > output.size()) throw std::runtime_error("Insufficient output buffer size");
+        std::ranges::copy(input, output.begin());
+        return input.size();
+    case ms_xca_compression_format::xpress:
+        return compress_xpress(input, output);
+    case ms_xca_compression_format::lznt1:
+    case ms_xca_compression_format::xpress_huff:
+        throw std::runtime_error("Unsupported compression format");
+    default:
+        throw std::runtime_error("Invalid compression format");
+    }
+}
@@ -0,0 +1,20 @@
+
+#pragma once
+
+#include <span>
+
+#include <snail/common/ms_xca_compression_format.hpp>
+
+namespace snail::common {
+
+// Counterpart to `ms_xca_decompress`. This is supposed to be a replacement for
+//   RtlCompressBuffer
+// but only supports the `none` and `xpress` (plain LZ77) formats.
+//
+// Returns the number of bytes written to `output`. Throws if `output` is too small
+// to hold the compressed data.
+std::size_t ms_xca_compress(std::span<const std::byte> input,
+                            std::span<std::byte>       output,
+                            ms_xca_compression_format  format);
+
+} // namespace snail::common
@@ -2,7 +2,12 @@
 #include <snail/common/ms_xca_decompression.hpp>
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <memory>
 #include <stdexcept>
+#include <vector>
 
 #include <snail/common/parser/extract.hpp>
 
@@ -10,6 +15,54 @@ using namespace snail::common;
 
 namespace {
 
+template<std::size_t ChunkSize>
+void copy_match_chunked(std::byte* destination, const std::byte* source, std::size_t length)
+{
+    while(length >= ChunkSize)
+    {
+        std::memcpy(destination, source, ChunkSize);
+        destination += ChunkSize;
+        source += ChunkSize;
+        length -= ChunkSize;
+    }
+    std::memcpy(destination, source, length);
+}
+
+// Copies `length` bytes that start `offset` bytes before `out_pos` in the output to `out_pos`.
+// The ranges may overlap, in which case the copy repeats the last `offset` bytes.
+//
+// Precondition: `0 < offset <= out_pos` and `out_pos + length <= output.size()`.
+inline void copy_match(std::span<std::byte> output, std::size_t out_pos, std::size_t offset, std::size_t length)
+{
+    auto* const       destination = output.data() + out_pos;
+    const auto* const source      = destination - offset;
+
+    if(offset >= length)
+    {
+        std::memcpy(destination, source, length);
+    }
+    else if(offset == 1)
+    {
+        std::memset(destination, std::to_integer<int>(*source), length);
+    }
+    else if(offset >= 16)
+    {
+        // Each chunk only reads bytes that have already been written.
+        copy_match_chunked<16>(destination, source, length);
+    }
+    else if(offset >= 8)
+    {
+        copy_match_chunked<8>(destination, source, length);
+    }
+    else
+    {
+        for(std::size_t i = 0; i < length; ++i)
+        {
+            destination[i] = source[i];
+        }
+    }
+}
+
 // Plain LZ77 decompression algorithm according to the MS-XCA.
 // See https://learn.microsoft.com/en-us/openspecs/windows_protocols/ms-xca
 
@@ -35,68 +88,367 @@ std::size_t decompress_xpress(std::span<const std::byte> input,
             flag_count = 32;
         }
 
+        // Consecutive literals are copied as a single run.
+        const auto pending_flags = flag_count == 32 ? flags : (flags & ((std::uint32_t(1) << flag_count) - 1));
+        const auto literal_count = std::min(static_cast<std::size_t>(std::countl_zero(pending_flags) - (32 - flag_count)),
+                                            input_size - in_offset);
+        if(literal_count > 0)
+        {
+            if(out_pos + literal_count > output_size) throw std::runtime_error("Insufficient output buffer size");
+            std::memcpy(output.data() + out_pos, input.data() + in_offset, literal_count);
+            in_offset += literal_count;
+            out_pos += literal_count;
+            flag_count -= static_cast<int>(literal_count);
+            continue;
+        }
+
         --flag_count;
 
-        if((flags & (1 << flag_count)) == 0)
+        if(in_offset + 1 >= input_size) break;
+
+        const auto match_bytes = snail::common::parser::extract_move<std::uint16_t>(input, in_offset, std::endian::little);
+
+        auto       match_length = static_cast<std::uint32_t>(match_bytes % 8);
+        const auto match_offset = static_cast<std::uint16_t>((match_bytes / 8) + 1);
+
+        if(match_length == 7)
         {
-            if(out_pos >= output_size) throw std::runtime_error("Insufficient output buffer size");
-            output[out_pos] = input[in_offset];
-            ++in_offset;
-            ++out_pos;
+            if(last_length_half_offset == 0)
+            {
+                last_length_half_offset = in_offset;
+                match_length            = snail::common::parser::extract_move<std::uint8_t>(input, in_offset, std::endian::little);
+                match_length %= 16;
+            }
+            else
+            {
+                match_length = snail::common::parser::extract<std::uint8_t>(input, last_length_half_offset, std::endian::little);
+                match_length /= 16;
+                last_length_half_offset = 0;
+            }
+            if(match_length == 15)
+            {
+                match_length = snail::common::parser::extract_move<std::uint8_t>(input, in_offset, std::endian::little);
+                if(match_length == 255)
+                {
+                    match_length = snail::common::parser::extract_move<std::uint16_t>(input, in_offset, std::endian::little);
+                    if(match_length == 0)
+                    {
+                        match_length = snail::common::parser::extract_move<std::uint32_t>(input, in_offset, std::endian::little);
+                    }
+                    if(match_length < 15 + 7)
+                    {
+                        throw std::runtime_error("Invalid compressed data");
+                    }
+                    match_length -= (15 + 7);
+                }
+                match_length += 15;
+            }
+            match_length += 7;
         }
-        else
+        match_length += 3;
+
+        if(match_offset > out_pos) throw std::runtime_error("Invalid compressed data");
+        if(out_pos + match_length > output_size) throw std::runtime_error("Insufficient output buffer size");
+        copy_match(output, out_pos, match_offset, match_length);
+        out_pos += match_length;
+    }
+
+    return out_pos;
+}
+
+// LZ77 + Huffman decompression algorithm according to the MS-XCA.
+//
+// The input consists of blocks that each decode to (at most) 64KiB of output.
+// Each block starts with a 256 byte table of 4-bit Huffman code lengths for
+// the 512 symbols, followed by the bit stream of 16-bit little endian words,
+// interleaved with additional match length bytes.
+
+constexpr std::size_t xpress_huffman_symbol_count      = 512;
+constexpr std::size_t xpress_huffman_table_size        = xpress_huffman_symbol_count / 2;
+constexpr std::size_t xpress_huffman_max_code_length   = 15;
+constexpr std::size_t xpress_huffman_block_output_size = 65536;
+
+// Every entry in the decoding table holds the symbol in the lower 9 bits and
+// its code length in the upper bits, so that a single lookup of the next
+// `table_bits` bits in the bit stream yields both.
+// The table only spans the longest code that is actually used in the block,
+// which keeps it small (and cheap to build) for most inputs.
+constexpr std::uint16_t xpress_huffman_symbol_mask   = 0x01FF;
+constexpr int           xpress_huffman_length_shift  = 9;
+constexpr std::uint16_t xpress_huffman_invalid_entry = 0;
+
+using xpress_huffman_table_entries = std::array<std::uint16_t, std::size_t(1) << xpress_huffman_max_code_length>;
+
+struct xpress_huffman_decoding_table
+{
+    int                          table_bits;
+    xpress_huffman_table_entries entries;
+};
+
+void build_xpress_huffman_decoding_table(std::span<const std::byte>     code_lengths_table,
+                                         xpress_huffman_decoding_table& decoding_table)
+{
+    std::array<std::uint8_t, xpress_huffman_symbol_count>          code_lengths;
+    std::array<std::uint16_t, xpress_huffman_max_code_length + 1> length_counts = {};
+    for(std::size_t i = 0; i < xpress_huffman_table_size; ++i)
+    {
+        const auto packed_lengths = static_cast<std::uint8_t>(code_lengths_table[i]);
+
+        code_lengths[2 * i]     = packed_lengths & 0x0F;
+        code_lengths[2 * i + 1] = packed_lengths >> 4;
+
+        ++length_counts[code_lengths[2 * i]];
+        ++length_counts[code_lengths[2 * i + 1]];
+    }
+
+    int max_code_length = static_cast<int>(xpress_huffman_max_code_length);
+    while(max_code_length > 0 && length_counts[max_code_length] == 0) --max_code_length;
+    if(max_code_length == 0) throw std::runtime_error("Invalid compressed data");
+
+    // Canonical Huffman codes are assigned in order of increasing code length,
+    // and for equal lengths in order of increasing symbol value.
+    std::array<std::uint16_t, xpress_huffman_max_code_length + 1> length_offsets;
+    length_offsets[0] = 0;
+    length_offsets[1] = 0;
+    for(int code_length = 1; code_length < max_code_length; ++code_length)
+    {
+        length_offsets[code_length + 1] = length_offsets[code_length] + length_counts[code_length];
+    }
+
+    std::array<std::uint16_t, xpress_huffman_symbol_count> sorted_symbols;
+    for(std::uint16_t symbol = 0; symbol < xpress_huffman_symbol_count; ++symbol)
+    {
+        const auto code_length = code_lengths[symbol];
+        if(code_length == 0) continue;
+        sorted_symbols[length_offsets[code_length]++] = symbol;
+    }
+
+    // A code of length `L` covers `2^(table_bits-L)` consecutive entries of the table.
+    const auto table_size = std::size_t(1) << max_code_length;
+
+    std::size_t table_pos    = 0;
+    std::size_t symbol_index = 0;
+    for(int code_length = 1; code_length <= max_code_length; ++code_length)
+    {
+        const auto entry_count = std::size_t(1) << (max_code_length - code_length);
+        const auto entry_bits  = static_cast<std::uint16_t>(code_length << xpress_huffman_length_shift);
+
+        for(std::size_t i = 0; i < length_counts[code_length]; ++i, ++symbol_index)
         {
-            if(in_offset + 1 >= input_size) break;
+            if(table_pos + entry_count > table_size) throw std::runtime_error("Invalid compressed data");
 
-            const auto match_bytes = snail::common::parser::extract_move<std::uint16_t>(input, in_offset, std::endian::little);
+            std::fill_n(decoding_table.entries.begin() + table_pos, entry_count, static_cast<std::uint16_t>(sorted_symbols[symbol_index] | entry_bits));
+            table_pos += entry_count;
+        }
+    }
+
+    // Codes that are not assigned to any symbol must not appear in the bit stream.
+    std::fill(decoding_table.entries.begin() + table_pos, decoding_table.entries.begin() + table_size, xpress_huffman_invalid_entry);
 
-            auto       match_length = static_cast<std::uint32_t>(match_bytes % 8);
-            const auto match_offset = static_cast<std::uint16_t>((match_bytes / 8) + 1);
+    decoding_table.table_bits = max_code_length;
+}
 
-            if(match_length == 7)
+std::size_t decompress_xpress_huffman(std::span<const std::byte> input,
+                                      std::span<std::byte>       output)
+{
+    std::size_t in_offset = 0;
+    std::size_t out_pos   = 0;
+
+    const auto input_size  = input.size();
+    const auto output_size = output.size();
+
+    // Valid streams may cause the bit reader to look ahead up to 32 bits past the last
+    // symbol. Everything that reads beyond that is considered to be corrupt data.
+    const auto read_next_bits = [&]() -> std::uint32_t
+    {
+        const auto offset = in_offset;
+        in_offset += 2;
+        if(offset + 2 <= input_size) return snail::common::parser::extract<std::uint16_t>(input, offset, std::endian::little);
+        if(offset >= input_size + 4) throw std::runtime_error("Invalid compressed data");
+        return 0;
+    };
+
+    const auto require_input = [&](std::size_t size)
+    {
+        if(in_offset + size > input_size) throw std::runtime_error("Invalid compressed data");
+    };
+
+    auto decoding_table = std::make_unique_for_overwrite<xpress_huffman_decoding_table>();
+
+    while(in_offset < input_size)
+    {
+        require_input(xpress_huffman_table_size + 4);
+
+        build_xpress_huffman_decoding_table(input.subspan(in_offset, xpress_huffman_table_size), *decoding_table);
+        in_offset += xpress_huffman_table_size;
+
+        std::uint32_t next_bits = read_next_bits() << 16;
+        next_bits |= read_next_bits();
+        int extra_bit_count = 16;
+
+        const auto consume_bits = [&](int bit_count)
+        {
+            next_bits <<= bit_count;
+            extra_bit_count -= bit_count;
+            if(extra_bit_count < 0)
             {
-                if(last_length_half_offset == 0)
-                {
-                    last_length_half_offset = in_offset;
-                    match_length            = snail::common::parser::extract_move<std::uint8_t>(input, in_offset, std::endian::little);
-                    match_length %= 16;
-                }
-                else
-                {
-                    match_length = snail::common::parser::extract<std::uint8_t>(input, last_length_half_offset, std::endian::little);
-                    match_length /= 16;
-                    last_length_half_offset = 0;
-                }
-                if(match_length == 15)
+                next_bits |= read_next_bits() << (-extra_bit_count);
+                extra_bit_count += 16;
+            }
+        };
+
+        const auto block_end = out_pos + xpress_huffman_block_output_size;
+
+        while(out_pos < block_end)
+        {
+            const auto entry = decoding_table->entries[next_bits >> (32 - decoding_table->table_bits)];
+            if(entry == xpress_huffman_invalid_entry) throw std::runtime_error("Invalid compressed data");
+
+            const auto symbol = static_cast<std::uint32_t>(entry & xpress_huffman_symbol_mask);
+            consume_bits(entry >> xpress_huffman_length_shift);
+
+            if(symbol < 256)
+            {
+                if(out_pos >= output_size) throw std::runtime_error("Insufficient output buffer size");
+                output[out_pos] = static_cast<std::byte>(symbol);
+                ++out_pos;
+                continue;
+            }
+
+            // The end-of-stream marker is symbol 256 at the very end of the input.
+            if(symbol == 256 && in_offset >= input_size) return out_pos;
+
+            auto       match_length           = (symbol - 256) % 16;
+            const auto match_offset_bit_count = static_cast<int>((symbol - 256) / 16);
+
+            if(match_length == 15)
+            {
+                require_input(1);
+                match_length = snail::common::parser::extract_move<std::uint8_t>(input, in_offset, std::endian::little);
+                if(match_length == 255)
                 {
-                    match_length = snail::common::parser::extract_move<std::uint8_t>(input, in_offset, std::endian::little);
-                    if(match_length == 255)
+                    require_input(2);
+                    match_length = snail::common::parser::extract_move<std::uint16_t>(input, in_offset, std::endian::little);
+                    if(match_length == 0)
+                    {
+                        require_input(4);
+                        match_length = snail::common::parser::extract_move<std::uint32_t>(input, in_offset, std::endian::little);
+                    }
+                    if(match_length < 15)
                     {
-                        match_length = snail::common::parser::extract_move<std::uint16_t>(input, in_offset, std::endian::little);
-                        if(match_length == 0)
-                        {
-                            match_length = snail::common::parser::extract_move<std::uint32_t>(input, in_offset, std::endian::little);
-                        }
-                        if(match_length < 15 + 7)
-                        {
-                            throw std::runtime_error("Invalid compressed data");
-                        }
-                        match_length -= (15 + 7);
+                        throw std::runtime_error("Invalid compressed data");
                     }
-                    match_length += 15;
+                    match_length -= 15;
                 }
-                match_length += 7;
+                match_length += 15;
             }
             match_length += 3;
 
+            // `match_offset_bit_count` is at most 15, hence the shift is always well defined.
+            const auto match_offset = (match_offset_bit_count == 0 ? 0 : (next_bits >> (32 - match_offset_bit_count))) +
+                                      (std::uint32_t(1) << match_offset_bit_count);
+            consume_bits(match_offset_bit_count);
+
             if(match_offset > out_pos) throw std::runtime_error("Invalid compressed data");
             if(out_pos + match_length > output_size) throw std::runtime_error("Insufficient output buffer size");
-            for(std::uint32_t i = 0; i < match_length; ++i)
+            copy_match(output, out_pos, match_offset, match_length);
+            out_pos += match_length;
+        }
+    }
+
+    return out_pos;
+}
+
+// LZNT1 decompression algorithm according to the MS-XCA.
+//
+// The input consists of chunks that each decode to (at most) 4KiB of output.
+// Each chunk starts with a 16-bit header holding the chunk's size and whether the
+// chunk is compressed. A zero header terminates the stream.
+
+constexpr std::size_t   lznt1_chunk_output_size = 4096;
+constexpr std::uint16_t lznt1_chunk_size_mask   = 0x0FFF;
+constexpr std::uint16_t lznt1_compressed_flag   = 0x8000;
+
+// The split of a 16-bit match token into offset and length bits depends on the current
+// position within the decompressed chunk: the offset always gets just enough bits to
+// reach the start of the chunk (but at least 4), while the remaining bits hold the length.
+constexpr auto lznt1_length_bit_counts = []()
+{
+    std::array<std::uint8_t, lznt1_chunk_output_size> result{};
+    for(std::size_t chunk_pos = 1; chunk_pos < result.size(); ++chunk_pos)
+    {
+        const auto offset_bit_count = std::max(static_cast<int>(std::bit_width(chunk_pos - 1)), 4);
+        result[chunk_pos]           = static_cast<std::uint8_t>(16 - offset_bit_count);
+    }
+    return result;
+}();
+
+std::size_t decompress_lznt1(std::span<const std::byte> input,
+                             std::span<std::byte>       output)
+{
+    std::size_t in_offset = 0;
+    std::size_t out_pos   = 0;
+
+    const auto input_size  = input.size();
+    const auto output_size = output.size();
+
+    while(in_offset + 2 <= input_size)
+    {
+        const auto chunk_header = snail::common::parser::extract_move<std::uint16_t>(input, in_offset, std::endian::little);
+        if(chunk_header == 0) break;
+
+        const auto chunk_size = static_cast<std::size_t>(chunk_header & lznt1_chunk_size_mask) + 1;
+        if(in_offset + chunk_size > input_size) throw std::runtime_error("Invalid compressed data");
+
+        const auto chunk_end = in_offset + chunk_size;
+
+        if((chunk_header & lznt1_compressed_flag) == 0)
+        {
+            if(out_pos + chunk_size > output_size) throw std::runtime_error("Insufficient output buffer size");
+            std::ranges::copy(input.subspan(in_offset, chunk_size), output.begin() + out_pos);
+            in_offset = chunk_end;
+            out_pos += chunk_size;
+            continue;
+        }
+
+        const auto chunk_start = out_pos;
+
+        while(in_offset < chunk_end)
+        {
+            const auto flags = snail::common::parser::extract_move<std::uint8_t>(input, in_offset, std::endian::little);
+
+            for(int flag_index = 0; flag_index < 8 && in_offset < chunk_end; ++flag_index)
             {
-                output[out_pos] = output[out_pos - match_offset];
-                ++out_pos;
+                if((flags & (1 << flag_index)) == 0)
+                {
+                    if(out_pos >= output_size) throw std::runtime_error("Insufficient output buffer size");
+                    output[out_pos] = input[in_offset];
+                    ++in_offset;
+                    ++out_pos;
+                }
+                else
+                {
+                    if(in_offset + 2 > chunk_end) throw std::runtime_error("Invalid compressed data");
+
+                    const auto match_token = snail::common::parser::extract_move<std::uint16_t>(input, in_offset, std::endian::little);
+
+                    const auto chunk_pos = out_pos - chunk_start;
+                    if(chunk_pos == 0 || chunk_pos >= lznt1_chunk_output_size) throw std::runtime_error("Invalid compressed data");
+
+                    const auto length_bit_count = lznt1_length_bit_counts[chunk_pos];
+
+                    const auto match_length = static_cast<std::uint32_t>(match_token & ((1 << length_bit_count) - 1)) + 3;
+                    const auto match_offset = static_cast<std::size_t>(match_token >> length_bit_count) + 1;
+
+                    if(match_offset > chunk_pos) throw std::runtime_error("Invalid compressed data");
+                    if(out_pos + match_length > output_size) throw std::runtime_error("Insufficient output buffer size");
+                    copy_match(output, out_pos, match_offset, match_length);
+                    out_pos += match_length;
+                }
             }
         }
+
+        if(out_pos - chunk_start > lznt1_chunk_output_size) throw std::runtime_error("Invalid compressed data");
     }
 
     return out_pos;
@@ -114,10 +466,11 @@ std::size_t snail::common::ms_xca_decompress(std::span<const std::byte> input,
         std::ranges::copy(input, output.begin());
         return input.size();
     case ms_xca_compression_format::lznt1:
-    case ms_xca_compression_format::xpress_huff:
-        throw std::runtime_error("Compression format not yet implemented");
+        return decompress_lznt1(input, output);
     case ms_xca_compression_format::xpress:
         return decompress_xpress(input, output);
+    case ms_xca_compression_format::xpress_huff:
+        return decompress_xpress_huffman(input, output);
     default:
         throw std::runtime_error("Invalid compression format");
     }
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cassert>
+#include <span>
+#include <stdexcept>
+
+namespace snail::common {
+
+// Provides the same interface as `chunked_reader`, but operates directly on
+// a buffer that is already available in memory (e.g. a memory mapped file).
+// Retrieved data is a view into that buffer and no copies are made.
+class span_reader
+{
+public:
+    span_reader(std::span<const std::byte> data, std::size_t offset, std::size_t desired_size)
+    {
+        if(offset > data.size() || desired_size > data.size() - offset)
+        {
+            throw std::runtime_error("Failed to move to offset");
+        }
+        data_ = data.subspan(offset, desired_size);
+    }
+
+    std::span<const std::byte> retrieve_data(std::size_t size, bool peek = false)
+    {
+        if(data_.size() - processed_size_ < size)
+        {
+            // not enough data. Since there is no further chunk to read, we are done.
+            is_exhausted_ = true;
+            return {};
+        }
+
+        const auto result_data = data_.subspan(processed_size_, size);
+
+        if(!peek) processed_size_ += size;
+
+        return result_data;
+    }
+
+    bool done() const
+    {
+        assert(processed_size_ <= data_.size());
+        return processed_size_ == data_.size();
+    }
+
+    bool keep_going() const
+    {
+        return !is_exhausted_ && !done();
+    }
+
+private:
+    std::span<const std::byte> data_;
+
+    std::size_t processed_size_ = 0;
+    bool        is_exhausted_   = false;
+};
+
+} // namespace snail::common
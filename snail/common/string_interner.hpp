@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace snail::common {
+
+// Stores every distinct string only once and identifies it by a small integer id.
+//
+// Views to the interned strings stay valid for the lifetime of the interner, so they can be
+// handed out freely. Strings that have been interned by the same interner are equal if and
+// only if their ids are equal.
+class string_interner
+{
+public:
+    using id_t = std::uint32_t;
+
+    inline id_t intern(std::string_view str);
+
+    inline std::string_view get(id_t id) const;
+
+    inline std::size_t size() const;
+
+private:
+    // A deque never moves its elements when growing, hence the views used as keys
+    // in `ids_` remain valid.
+    std::deque<std::string>                    strings_;
+    std::unordered_map<std::string_view, id_t> ids_;
+};
+
+inline string_interner::id_t string_interner::intern(std::string_view str)
+{
+    const auto iter = ids_.find(str);
+    if(iter != ids_.end()) return iter->second;
+
+    if(strings_.size() >= std::numeric_limits<id_t>::max()) throw std::runtime_error("Too many interned strings");
+
+    const auto new_id = static_cast<id_t>(strings_.size());
+    strings_.emplace_back(str);
+    ids_.emplace(strings_.back(), new_id);
+    return new_id;
+}
+
+inline std::string_view string_interner::get(id_t id) const
+{
+    assert(id < strings_.size());
+    return strings_[id];
+}
+
+inline std::size_t string_interner::size() const
+{
+    return strings_.size();
+}
+
+} // namespace snail::common
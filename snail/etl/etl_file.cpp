@@ -5,14 +5,20 @@
 #include <array>
 #include <bit>
 #include <chrono>
+#include <deque>
 #include <format>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <queue>
 #include <stdexcept>
+#include <thread>
 #include <utility>
 
 #include <snail/common/cast.hpp>
 #include <snail/common/ms_xca_decompression.hpp>
+#include <snail/common/thread_pool.hpp>
 
 #include <snail/etl/parser/buffer.hpp>
 #include <snail/etl/parser/records/kernel/header.hpp>
@@ -36,19 +42,43 @@ struct buffer_info
     std::size_t                current_payload_offset;
 };
 
+// A buffer as it has been read from the file: the payload might still be compressed.
+struct raw_buffer
+{
+    std::span<const std::byte> header_buffer;
+    std::span<const std::byte> remaining_buffer;
+    std::size_t                payload_size;
+    bool                       is_compressed;
+};
+
+// A buffer that has been loaded ahead of time. Decompression of the payload might
+// still be running on a worker thread until `decoded` is ready.
+struct loaded_buffer
+{
+    std::vector<std::byte> raw_data;     // Header and (compressed) payload. Used when reading from a stream only.
+    std::vector<std::byte> payload_data; // Decompressed payload. Used for compressed buffers only.
+
+    raw_buffer  raw;
+    buffer_info info;
+
+    std::future<void> decoded;
+};
+
 struct processor_data
 {
-    std::vector<std::byte> current_buffer_data;
+    std::unique_ptr<loaded_buffer> current_buffer;
 
     buffer_info current_buffer_info;
 
     struct file_buffer_info
     {
-        std::streampos start_pos;
-        std::int64_t   sequence_number;
+        std::uint64_t start_offset;
+        std::int64_t  sequence_number;
     };
 
     std::vector<file_buffer_info> remaining_buffers;
+
+    std::deque<std::unique_ptr<loaded_buffer>> loaded_buffers;
 };
 
 struct next_event_priority_info
@@ -63,13 +93,50 @@ struct next_event_priority_info
     }
 };
 
-buffer_info read_buffer(std::ifstream&               file_stream,
-                        std::streampos               buffer_start_pos,
-                        std::vector<std::byte>&      buffer_data,
-                        std::vector<std::byte>&      compressed_temp_data,
-                        const etl_file::header_data& file_header_,
-                        event_observer&              callbacks)
+raw_buffer make_raw_buffer(std::span<const std::byte>   header_buffer,
+                           std::span<const std::byte>   remaining_buffer,
+                           const etl_file::header_data& file_header_)
+{
+    const auto header = parser::wmi_buffer_header_view(header_buffer);
+
+    if(header.wnode().saved_offset() > file_header_.buffer_size)
+    {
+        throw std::runtime_error(std::format(
+            "Invalid ETL file: buffer offset ({}) exceeds maximum buffer size ({}).",
+            header.wnode().saved_offset(),
+            file_header_.buffer_size));
+    }
+    const auto payload_size = header.wnode().saved_offset() - parser::wmi_buffer_header_view::static_size;
+
+    // NOTE: not sure where we need to additionally test for
+    //         file_header_.log_file_mode.test(parser::log_file_mode::compressed_mode) &&
+    //         !file_header_.log_file_mode.test(parser::log_file_mode::file_mode_circular)
+    const auto is_compressed = header.buffer_flag().test(parser::etw_buffer_flag::compressed);
+
+    if(!is_compressed && header.wnode().saved_offset() > header.wnode().buffer_size())
+    {
+        throw std::runtime_error(std::format(
+            "Invalid ETL file: buffer offset ({}) exceeds buffer size ({}).",
+            header.wnode().saved_offset(),
+            header.wnode().buffer_size()));
+    }
+
+    return raw_buffer{
+        .header_buffer    = header_buffer,
+        .remaining_buffer = remaining_buffer,
+        .payload_size     = payload_size,
+        .is_compressed    = is_compressed};
+}
+
+raw_buffer read_raw_buffer(std::ifstream&               file_stream,
+                           std::uint64_t                buffer_start_offset,
+                           std::vector<std::byte>&      buffer_data,
+                           const etl_file::header_data& file_header_)
 {
+    const auto buffer_start_pos = std::streampos(common::narrow_cast<std::streamoff>(buffer_start_offset));
+
+    buffer_data.resize(file_header_.buffer_size);
+
     file_stream.seekg(buffer_start_pos);
     file_stream.read(reinterpret_cast<char*>(buffer_data.data()), parser::wmi_buffer_header_view::static_size);
 
@@ -85,74 +152,89 @@ buffer_info read_buffer(std::ifstream&               file_stream,
 
     const auto header = parser::wmi_buffer_header_view(header_buffer);
 
-    callbacks.handle_buffer(file_header_, header);
+    assert(header.wnode().buffer_size() >= parser::wmi_buffer_header_view::static_size); // has already been checked when initially reading the buffer headers
+    assert(header.wnode().buffer_size() <= file_header_.buffer_size);                     // has already been checked when initially reading the buffer headers
+    const auto remaining_buffer_size = header.wnode().buffer_size() - parser::wmi_buffer_header_view::static_size;
+
+    // Read the remaining (potentially compressed) data right behind the header.
+    file_stream.read(reinterpret_cast<char*>(buffer_data.data() + parser::wmi_buffer_header_view::static_size), remaining_buffer_size);
+
+    const auto read_remaining_bytes = file_stream.tellg() - buffer_start_pos - parser::wmi_buffer_header_view::static_size;
 
-    if(header.wnode().saved_offset() > buffer_data.size())
+    if(read_remaining_bytes < remaining_buffer_size)
     {
         throw std::runtime_error(std::format(
-            "Invalid ETL file: buffer offset ({}) exceeds maximum buffer size ({}).",
-            header.wnode().saved_offset(),
-            buffer_data.size()));
+            "Invalid ETL file: insufficient size for buffer payload. Expected {} but read only {}.",
+            remaining_buffer_size,
+            read_remaining_bytes));
     }
-    const auto payload_size = header.wnode().saved_offset() - parser::wmi_buffer_header_view::static_size;
 
-    assert(header.wnode().buffer_size() >= parser::wmi_buffer_header_view::static_size); // has already been checked when initially reading the buffer headers
-    const auto remaining_buffer_size = header.wnode().buffer_size() - parser::wmi_buffer_header_view::static_size;
+    return make_raw_buffer(header_buffer,
+                           std::span(buffer_data).subspan(parser::wmi_buffer_header_view::static_size, remaining_buffer_size),
+                           file_header_);
+}
 
-    // NOTE: not sure where we need to additionally test for
-    //         file_header_.log_file_mode.test(parser::log_file_mode::compressed_mode) &&
-    //         !file_header_.log_file_mode.test(parser::log_file_mode::file_mode_circular)
-    const auto is_compressed = header.buffer_flag().test(parser::etw_buffer_flag::compressed);
+// Same as `read_raw_buffer` but for a memory mapped file: the header and
+// remaining buffers will point directly into the mapped file data.
+raw_buffer map_raw_buffer(std::span<const std::byte>   file_data,
+                          std::uint64_t                buffer_start_offset,
+                          const etl_file::header_data& file_header_)
+{
+    const auto available_bytes = buffer_start_offset < file_data.size() ? file_data.size() - buffer_start_offset : 0;
 
-    if(!is_compressed)
+    if(available_bytes < parser::wmi_buffer_header_view::static_size)
     {
-        if(header.wnode().saved_offset() > header.wnode().buffer_size())
-        {
-            throw std::runtime_error(std::format(
-                "Invalid ETL file: buffer offset ({}) exceeds buffer size ({}).",
-                header.wnode().saved_offset(),
-                header.wnode().buffer_size()));
-        }
-
-        // Read the remaining data right into the final buffer.
-        file_stream.read(reinterpret_cast<char*>(buffer_data.data() + parser::wmi_buffer_header_view::static_size), remaining_buffer_size);
+        throw std::runtime_error(std::format(
+            "Invalid ETL file: insufficient size for buffer header. Expected {} but read only {}.",
+            parser::wmi_buffer_header_view::static_size,
+            available_bytes));
     }
-    else
-    {
-        // Read the remaining (compressed) data into a temporary buffer.
-        compressed_temp_data.resize(remaining_buffer_size);
+    const auto header_buffer = file_data.subspan(buffer_start_offset, parser::wmi_buffer_header_view::static_size);
 
-        file_stream.read(reinterpret_cast<char*>(compressed_temp_data.data()), remaining_buffer_size);
-    }
+    const auto header = parser::wmi_buffer_header_view(header_buffer);
 
-    const auto read_remaining_bytes = file_stream.tellg() - buffer_start_pos - parser::wmi_buffer_header_view::static_size;
+    assert(header.wnode().buffer_size() >= parser::wmi_buffer_header_view::static_size); // has already been checked when initially reading the buffer headers
+    const auto remaining_buffer_size = header.wnode().buffer_size() - parser::wmi_buffer_header_view::static_size;
 
-    if(read_remaining_bytes < remaining_buffer_size)
+    if(available_bytes - parser::wmi_buffer_header_view::static_size < remaining_buffer_size)
     {
         throw std::runtime_error(std::format(
             "Invalid ETL file: insufficient size for buffer payload. Expected {} but read only {}.",
             remaining_buffer_size,
-            read_remaining_bytes));
+            available_bytes - parser::wmi_buffer_header_view::static_size));
     }
 
-    const auto payload_buffer = std::span(buffer_data).subspan(parser::wmi_buffer_header_view::static_size, payload_size);
+    return make_raw_buffer(header_buffer,
+                           file_data.subspan(buffer_start_offset + parser::wmi_buffer_header_view::static_size, remaining_buffer_size),
+                           file_header_);
+}
 
-    if(is_compressed)
+// Decompresses the payload of the raw buffer (if required).
+// This does not touch any shared state and is hence safe to be called from worker threads.
+buffer_info decode_buffer(const raw_buffer&            raw,
+                          std::vector<std::byte>&      payload_data,
+                          const etl_file::header_data& file_header_)
+{
+    if(!raw.is_compressed)
     {
-        const auto decompressed_size = common::ms_xca_decompress(std::span(compressed_temp_data).subspan(0, remaining_buffer_size),
-                                                                 payload_buffer,
-                                                                 file_header_.compression_format);
+        return buffer_info{raw.header_buffer, raw.remaining_buffer.subspan(0, raw.payload_size), 0};
+    }
 
-        if(decompressed_size != payload_size)
-        {
-            throw std::runtime_error(std::format(
-                "Invalid ETL file: uncompressed size does not patch payload size. Expected {} but got {}.",
-                payload_size,
-                decompressed_size));
-        }
+    payload_data.resize(raw.payload_size);
+
+    const auto decompressed_size = common::ms_xca_decompress(raw.remaining_buffer,
+                                                             payload_data,
+                                                             file_header_.compression_format);
+
+    if(decompressed_size != raw.payload_size)
+    {
+        throw std::runtime_error(std::format(
+            "Invalid ETL file: uncompressed size does not patch payload size. Expected {} but got {}.",
+            raw.payload_size,
+            decompressed_size));
     }
 
-    return buffer_info{header_buffer, payload_buffer, 0};
+    return buffer_info{raw.header_buffer, std::span(payload_data), 0};
 }
 
 std::uint64_t peak_next_event_time(const buffer_info& buffer)
@@ -320,12 +402,12 @@ std::size_t process_next_trace(std::span<const std::byte>   payload_buffer,
 
 } // namespace
 
-etl_file::etl_file(const std::filesystem::path& file_path)
+etl_file::etl_file(const std::filesystem::path& file_path, bool use_memory_map)
 {
-    open(file_path);
+    open(file_path, use_memory_map);
 }
 
-void etl_file::open(const std::filesystem::path& file_path)
+void etl_file::open(const std::filesystem::path& file_path, bool use_memory_map)
 {
     file_stream_.open(file_path, std::ios_base::binary);
 
@@ -333,6 +415,10 @@ void etl_file::open(const std::filesystem::path& file_path)
     {
         throw std::runtime_error(std::format("Could not open file {}", file_path.string()));
     }
+
+    // If the file can not be mapped, we will just fall back to reading all buffers
+    // through the file stream.
+    if(use_memory_map) mapped_file_.open(file_path);
     std::array<std::byte, parser::wmi_buffer_header_view::static_size> file_buffer_header_data;
 
     file_stream_.read(reinterpret_cast<char*>(file_buffer_header_data.data()), file_buffer_header_data.size());
@@ -429,6 +515,12 @@ void etl_file::open(const std::filesystem::path& file_path)
 void etl_file::close()
 {
     file_stream_.close();
+    mapped_file_.close();
+}
+
+bool etl_file::is_memory_mapped() const
+{
+    return mapped_file_.is_open();
 }
 
 void etl_file::process(event_observer&                   callbacks,
@@ -441,28 +533,63 @@ void etl_file::process(event_observer&                   callbacks,
                                        header_.number_of_buffers * header_.buffer_size,
                                        "Processing events");
 
+    const auto mapped_file_data = mapped_file_.data();
+    const auto is_mapped        = mapped_file_.is_open();
+
+    // A previous call might have left the stream at the end of the file.
+    if(!is_mapped)
+    {
+        file_stream_.clear();
+        file_stream_.seekg(0);
+    }
+
     {
         std::array<std::byte, parser::wmi_buffer_header_view::static_size> header_buffer_data;
+
+        std::uint64_t next_buffer_offset = 0;
         for(std::size_t buffer_index = 0; buffer_index < header_.number_of_buffers; ++buffer_index)
         {
             if(cancellation_token && cancellation_token->is_canceled()) return;
 
-            const auto init_position = file_stream_.tellg();
-
-            file_stream_.read(reinterpret_cast<char*>(header_buffer_data.data()), header_buffer_data.size());
-
-            assert(file_stream_.good());
-
-            const auto read_bytes = file_stream_.tellg() - init_position;
-            if(read_bytes < static_cast<std::streamoff>(parser::wmi_buffer_header_view::static_size))
+            std::uint64_t              buffer_offset;
+            std::span<const std::byte> header_buffer;
+            if(is_mapped)
             {
-                throw std::runtime_error(std::format(
-                    "Invalid ETL file: insufficient size for buffer header (index {}). Expected {} but read only {}.",
-                    buffer_index,
-                    parser::wmi_buffer_header_view::static_size,
-                    read_bytes));
+                // For mapped files, the header index is just a pointer walk through the file data.
+                buffer_offset = next_buffer_offset;
+
+                const auto available_bytes = buffer_offset < mapped_file_data.size() ? mapped_file_data.size() - buffer_offset : 0;
+                if(available_bytes < parser::wmi_buffer_header_view::static_size)
+                {
+                    throw std::runtime_error(std::format(
+                        "Invalid ETL file: insufficient size for buffer header (index {}). Expected {} but read only {}.",
+                        buffer_index,
+                        parser::wmi_buffer_header_view::static_size,
+                        available_bytes));
+                }
+                header_buffer = mapped_file_data.subspan(buffer_offset, parser::wmi_buffer_header_view::static_size);
+            }
+            else
+            {
+                const auto init_position = file_stream_.tellg();
+
+                file_stream_.read(reinterpret_cast<char*>(header_buffer_data.data()), header_buffer_data.size());
+
+                assert(file_stream_.good());
+
+                const auto read_bytes = file_stream_.tellg() - init_position;
+                if(read_bytes < static_cast<std::streamoff>(parser::wmi_buffer_header_view::static_size))
+                {
+                    throw std::runtime_error(std::format(
+                        "Invalid ETL file: insufficient size for buffer header (index {}). Expected {} but read only {}.",
+                        buffer_index,
+                        parser::wmi_buffer_header_view::static_size,
+                        read_bytes));
+                }
+                buffer_offset = common::narrow_cast<std::uint64_t>(std::streamoff(init_position));
+                header_buffer = std::span(header_buffer_data);
             }
-            const auto buffer_header = parser::wmi_buffer_header_view(std::span(header_buffer_data));
+            const auto buffer_header = parser::wmi_buffer_header_view(header_buffer);
 
             const auto sequence_number = buffer_header.wnode().sequence_number();
 
@@ -497,20 +624,121 @@ void etl_file::process(event_observer&                   callbacks,
 
             per_processor_data[processor_index].remaining_buffers.push_back(
                 processor_data::file_buffer_info{
-                    .start_pos       = init_position,
+                    .start_offset    = buffer_offset,
                     .sequence_number = sequence_number});
 
-            // seek to start of next buffer
-            file_stream_.seekg(init_position + std::streamoff(buffer_header.wnode().buffer_size()));
+            // move to the start of next buffer
+            next_buffer_offset = buffer_offset + buffer_size;
+            if(!is_mapped) file_stream_.seekg(common::narrow_cast<std::streamoff>(next_buffer_offset));
         }
     }
 
-    // Sort the buffers per processor by their sequence number and read the first buffer
-    // for each process.
+    // Compressed buffers are decompressed ahead of time on a pool of worker threads, so that
+    // the event extraction below only needs to consume ready payloads. To bound the memory
+    // usage, only a fixed number of buffers per processor is loaded in advance.
+    const auto use_decompression_workers = header_.compression_format != common::ms_xca_compression_format::none;
+
+    const auto worker_count = use_decompression_workers ?
+                                  std::max(std::size_t(std::thread::hardware_concurrency()), std::size_t(2)) - 1 :
+                                  std::size_t(0);
+
+    const auto look_ahead_buffer_count = use_decompression_workers ?
+                                             std::max(std::size_t(2), 2 * worker_count / std::max(per_processor_data.size(), std::size_t(1))) :
+                                             std::size_t(1);
+
+    // ATTENTION: This needs to be declared after `per_processor_data`, so that all pending
+    //            decompression tasks are finished before any buffer is destroyed.
+    std::optional<common::thread_pool> decompression_workers;
+    if(use_decompression_workers) decompression_workers.emplace(worker_count);
+
+    std::vector<std::unique_ptr<loaded_buffer>> unused_buffers;
+
+    // Loads buffers for the given processor until the look-ahead window is full.
+    const auto load_ahead = [&](processor_data& processor_data)
+    {
+        while(processor_data.loaded_buffers.size() < look_ahead_buffer_count &&
+              !processor_data.remaining_buffers.empty())
+        {
+            // Keep in mind, that `remaining_buffers` is sorted.
+            const auto buffer_start_offset = processor_data.remaining_buffers.back().start_offset;
+            processor_data.remaining_buffers.pop_back();
+
+            std::unique_ptr<loaded_buffer> buffer;
+            if(unused_buffers.empty())
+            {
+                buffer = std::make_unique<loaded_buffer>();
+            }
+            else
+            {
+                buffer = std::move(unused_buffers.back());
+                unused_buffers.pop_back();
+            }
+
+            buffer->raw = is_mapped ?
+                              map_raw_buffer(mapped_file_data, buffer_start_offset, header_) :
+                              read_raw_buffer(file_stream_, buffer_start_offset, buffer->raw_data, header_);
+
+            if(buffer->raw.is_compressed && decompression_workers)
+            {
+                auto decoded_promise = std::make_shared<std::promise<void>>();
+                buffer->decoded      = decoded_promise->get_future();
+
+                decompression_workers->submit(
+                    [buffer = buffer.get(), decoded_promise, &file_header = header_]()
+                    {
+                        try
+                        {
+                            buffer->info = decode_buffer(buffer->raw, buffer->payload_data, file_header);
+                            decoded_promise->set_value();
+                        }
+                        catch(...)
+                        {
+                            decoded_promise->set_exception(std::current_exception());
+                        }
+                    });
+            }
+            else
+            {
+                buffer->decoded = {};
+                buffer->info    = decode_buffer(buffer->raw, buffer->payload_data, header_);
+            }
+
+            processor_data.loaded_buffers.push_back(std::move(buffer));
+        }
+    };
+
+    const auto has_next_buffer = [](const processor_data& processor_data)
+    {
+        return !processor_data.loaded_buffers.empty() || !processor_data.remaining_buffers.empty();
+    };
+
+    // Makes the next loaded buffer of the given processor the current one (waiting for
+    // its decompression if required) and refills the look-ahead window.
+    const auto next_buffer = [&](processor_data& processor_data) -> buffer_info
+    {
+        if(processor_data.loaded_buffers.empty()) load_ahead(processor_data);
+        assert(!processor_data.loaded_buffers.empty());
+
+        auto buffer = std::move(processor_data.loaded_buffers.front());
+        processor_data.loaded_buffers.pop_front();
+
+        if(buffer->decoded.valid()) buffer->decoded.get(); // will rethrow any decompression errors
+
+        callbacks.handle_buffer(header_, parser::wmi_buffer_header_view(buffer->raw.header_buffer));
+
+        if(processor_data.current_buffer) unused_buffers.push_back(std::move(processor_data.current_buffer));
+        processor_data.current_buffer = std::move(buffer);
+
+        load_ahead(processor_data);
+
+        return processor_data.current_buffer->info;
+    };
+
+    // Sort the buffers per processor by their sequence number and start loading the first
+    // buffers for each processor.
     // Then extract the time of the first event in each of the processor buffers and initialize
     // a priority queue with the first event times per processor.
     std::priority_queue<next_event_priority_info> event_queue;
-    std::vector<std::byte>                        compressed_temp_data;
     for(std::size_t processor_index = 0; processor_index < per_processor_data.size(); ++processor_index)
     {
         if(cancellation_token && cancellation_token->is_canceled()) return;
@@ -523,16 +751,18 @@ void etl_file::process(event_observer&                   callbacks,
         std::ranges::sort(remaining_buffers, [](const processor_data::file_buffer_info& lhs, const processor_data::file_buffer_info& rhs)
                           { return lhs.sequence_number > rhs.sequence_number; });
 
-        processor_data.current_buffer_data.resize(header_.buffer_size);
+        load_ahead(processor_data);
+    }
 
-        processor_data.current_buffer_info = read_buffer(file_stream_,
-                                                         remaining_buffers.back().start_pos,
-                                                         processor_data.current_buffer_data,
-                                                         compressed_temp_data,
-                                                         header_,
-                                                         callbacks);
+    for(std::size_t processor_index = 0; processor_index < per_processor_data.size(); ++processor_index)
+    {
+        if(cancellation_token && cancellation_token->is_canceled()) return;
+
+        auto& processor_data = per_processor_data[processor_index];
+
+        if(!has_next_buffer(processor_data)) continue;
 
-        remaining_buffers.pop_back();
+        processor_data.current_buffer_info = next_buffer(processor_data);
 
         event_queue.push(next_event_priority_info{
             .next_event_time = peak_next_event_time(processor_data.current_buffer_info),
@@ -572,21 +802,11 @@ void etl_file::process(event_observer&                   callbacks,
             {
                 progress.progress(header_.buffer_size - buffer_info.current_payload_offset);
 
-                auto& remaining_buffers = processor_data.remaining_buffers;
-
                 // If there are no remaining buffers for this processor, stop extracting events for it.
-                if(remaining_buffers.empty()) break;
-
-                // Read the next buffer for this processor.
-                // Keep in mind, that `remaining_buffers` is sorted.
-                buffer_info = read_buffer(file_stream_,
-                                          remaining_buffers.back().start_pos,
-                                          processor_data.current_buffer_data,
-                                          compressed_temp_data,
-                                          header_,
-                                          callbacks);
-
-                remaining_buffers.pop_back();
+                if(!has_next_buffer(processor_data)) break;
+
+                // Switch to the next buffer for this processor.
+                buffer_info = next_buffer(processor_data);
             }
 
             const auto next_event_time = peak_next_event_time(buffer_info);
@@ -7,6 +7,7 @@
 #include <span>
 
 #include <snail/common/date_time.hpp>
+#include <snail/common/memory_mapped_file.hpp>
 #include <snail/common/ms_xca_compression_format.hpp>
 #include <snail/common/progress.hpp>
 
@@ -48,9 +49,11 @@ public:
     };
 
     etl_file() = default;
-    explicit etl_file(const std::filesystem::path& file_path);
+    explicit etl_file(const std::filesystem::path& file_path, bool use_memory_map = true);
 
-    void open(const std::filesystem::path& file_path);
+    // If `use_memory_map` is set, the buffers will be read directly from a memory mapping
+    // of the file whenever the file can be mapped.
+    void open(const std::filesystem::path& file_path, bool use_memory_map = true);
 
     void close();
 
@@ -58,11 +61,14 @@ public:
                  const common::progress_listener*  progress_listener  = nullptr,
                  const common::cancellation_token* cancellation_token = nullptr);
 
+    bool is_memory_mapped() const;
+
     const header_data& header() const;
 
 private:
-    std::ifstream file_stream_;
-    header_data   header_;
+    std::ifstream              file_stream_;
+    common::memory_mapped_file mapped_file_;
+    header_data                header_;
 };
 
 class event_observer
@@ -0,0 +1,507 @@
+
+#include <snail/etl/etl_writer.hpp>
+
+#include <cassert>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <snail/common/cast.hpp>
+#include <snail/common/ms_xca_compression.hpp>
+
+#include <snail/etl/parser/buffer.hpp>
+#include <snail/etl/parser/log_file_mode.hpp>
+#include <snail/etl/parser/trace.hpp>
+#include <snail/etl/parser/trace_headers/perfinfo_trace.hpp>
+#include <snail/etl/parser/trace_headers/system_trace.hpp>
+
+using namespace snail;
+using namespace snail::etl;
+
+namespace {
+
+constexpr std::uint32_t pointer_size = 8;
+
+// Traces are always aligned to 8 byte blocks
+constexpr std::size_t event_alignment = 8;
+
+constexpr std::size_t buffer_header_size = parser::wmi_buffer_header_view::static_size;
+
+constexpr std::uint8_t trace_header_flags = parser::generic_trace_marker::trace_header_flag |
+                                            parser::generic_trace_marker::trace_header_event_trace_flag;
+
+// 1 Jan 1970 to 1 Jan 1601 in 100 nanosecond intervals
+constexpr auto unix_to_nt_epoch = common::nt_duration(116444736000000000LL);
+
+// Size of the `TIME_ZONE_INFORMATION` in the header event as given in wmicore.mof.
+constexpr std::size_t time_zone_information_size = 176;
+
+template<typename T>
+    requires std::is_integral_v<T>
+void append(std::vector<std::byte>& buffer, T value)
+{
+    const auto offset = buffer.size();
+    buffer.resize(offset + sizeof(T));
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+template<typename T>
+    requires std::is_integral_v<T>
+void write_at(std::vector<std::byte>& buffer, std::size_t offset, T value)
+{
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+void append_zeros(std::vector<std::byte>& buffer, std::size_t count)
+{
+    buffer.resize(buffer.size() + count, std::byte{});
+}
+
+void append_string(std::vector<std::byte>& buffer, std::string_view value)
+{
+    const auto offset = buffer.size();
+    buffer.resize(offset + value.size() + 1, std::byte{});
+    std::memcpy(buffer.data() + offset, value.data(), value.size());
+}
+
+void append_u16string(std::vector<std::byte>& buffer, std::u16string_view value)
+{
+    const auto offset = buffer.size();
+    buffer.resize(offset + (value.size() + 1) * sizeof(char16_t), std::byte{});
+    std::memcpy(buffer.data() + offset, value.data(), value.size() * sizeof(char16_t));
+}
+
+std::size_t align_event_size(std::size_t size)
+{
+    return (size + event_alignment - 1) / event_alignment * event_alignment;
+}
+
+std::vector<std::byte> make_buffer_header(std::uint32_t            buffer_size,
+                                          std::uint32_t            saved_offset,
+                                          std::int64_t             sequence_number,
+                                          std::uint16_t            processor_index,
+                                          std::uint32_t            state,
+                                          parser::etw_buffer_flags flags,
+                                          parser::etw_buffer_type  type,
+                                          std::uint64_t            start_time)
+{
+    std::vector<std::byte> header(buffer_header_size, std::byte{});
+    write_at(header, 0, buffer_size);
+    write_at(header, 4, saved_offset);
+    write_at(header, 8, saved_offset); // current_offset
+    write_at(header, 24, sequence_number);
+    write_at(header, 40, processor_index);
+    write_at(header, 44, state);
+    write_at(header, 48, saved_offset); // offset
+    write_at(header, 52, static_cast<std::uint16_t>(flags.data().to_ulong()));
+    write_at(header, 54, std::to_underlying(type));
+    write_at(header, 56, start_time);
+    write_at(header, 64, start_time); // start_perf_clock
+    return header;
+}
+
+} // namespace
+
+etl_writer::etl_writer(const std::filesystem::path& file_path, options options) :
+    options_(std::move(options)),
+    buffers_written_(0),
+    end_time_qpc_ticks_(options_.start_time_qpc_ticks)
+{
+    if(options_.number_of_processors == 0 || options_.number_of_processors > std::numeric_limits<std::uint16_t>::max())
+    {
+        throw std::runtime_error(std::format("Invalid number of processors: {}", options_.number_of_processors));
+    }
+    if(options_.buffer_size < 1024 || options_.buffer_size % event_alignment != 0)
+    {
+        throw std::runtime_error(std::format("Invalid buffer size: {}", options_.buffer_size));
+    }
+    if(options_.qpc_frequency == 0)
+    {
+        throw std::runtime_error("Invalid QPC frequency: 0");
+    }
+    if(options_.compression_format != common::ms_xca_compression_format::none &&
+       options_.compression_format != common::ms_xca_compression_format::xpress)
+    {
+        throw std::runtime_error(std::format("Unsupported compression format: {}", std::to_underlying(options_.compression_format)));
+    }
+
+    file_stream_.open(file_path, std::ios_base::binary | std::ios_base::trunc);
+
+    if(!file_stream_.is_open())
+    {
+        throw std::runtime_error(std::format("Could not open file {}", file_path.string()));
+    }
+
+    processor_buffers_.resize(options_.number_of_processors);
+
+    // The header buffer can only be written when all other buffers have been written.
+    // Reserve the space for it for now.
+    write_buffer({}, {}, options_.buffer_size);
+}
+
+etl_writer::~etl_writer() = default;
+
+void etl_writer::write_process_start(std::uint16_t       processor_index,
+                                     std::uint64_t       timestamp,
+                                     std::uint32_t       process_id,
+                                     std::uint32_t       parent_id,
+                                     std::string_view    image_filename,
+                                     std::u16string_view command_line)
+{
+    write_process_event(processor_index, timestamp, 1, process_id, parent_id, image_filename, command_line);
+}
+
+void etl_writer::write_process_end(std::uint16_t       processor_index,
+                                   std::uint64_t       timestamp,
+                                   std::uint32_t       process_id,
+                                   std::uint32_t       parent_id,
+                                   std::string_view    image_filename,
+                                   std::u16string_view command_line)
+{
+    write_process_event(processor_index, timestamp, 2, process_id, parent_id, image_filename, command_line);
+}
+
+void etl_writer::write_thread_start(std::uint16_t       processor_index,
+                                    std::uint64_t       timestamp,
+                                    std::uint32_t       process_id,
+                                    std::uint32_t       thread_id,
+                                    std::u16string_view thread_name)
+{
+    write_thread_event(processor_index, timestamp, 1, process_id, thread_id, thread_name);
+}
+
+void etl_writer::write_thread_end(std::uint16_t processor_index,
+                                  std::uint64_t timestamp,
+                                  std::uint32_t process_id,
+                                  std::uint32_t thread_id)
+{
+    write_thread_event(processor_index, timestamp, 2, process_id, thread_id, {});
+}
+
+void etl_writer::write_image_load(std::uint16_t       processor_index,
+                                  std::uint64_t       timestamp,
+                                  std::uint32_t       process_id,
+                                  std::uint64_t       image_base,
+                                  std::uint64_t       image_size,
+                                  std::uint32_t       image_checksum,
+                                  std::u16string_view file_name)
+{
+    // Image_Load:Image_V3
+    begin_system_event(timestamp, 3, std::to_underlying(parser::event_trace_group::process), 10, process_id, 0);
+    append(event_buffer_, image_base);
+    append(event_buffer_, image_size);
+    append(event_buffer_, process_id);
+    append(event_buffer_, image_checksum);
+    append(event_buffer_, std::uint32_t(0)); // time_date_stamp
+    append(event_buffer_, std::uint8_t(0));  // signature_level
+    append(event_buffer_, std::uint8_t(0));  // signature_type
+    append(event_buffer_, std::uint16_t(0)); // reserved_0
+    append(event_buffer_, image_base);       // default_base
+    append_zeros(event_buffer_, 4 * 4);      // reserved_1 - reserved_4
+    append_u16string(event_buffer_, file_name);
+    end_event(processor_index, timestamp);
+}
+
+void etl_writer::write_sampled_profile(std::uint16_t processor_index,
+                                       std::uint64_t timestamp,
+                                       std::uint32_t thread_id,
+                                       std::uint64_t instruction_pointer)
+{
+    // PerfInfo_SampledProfile:PerfInfo_V2
+    begin_perfinfo_event(timestamp, 2, std::to_underlying(parser::event_trace_group::perfinfo), 46);
+    append(event_buffer_, instruction_pointer);
+    append(event_buffer_, thread_id);
+    append(event_buffer_, std::uint16_t(1)); // count
+    append(event_buffer_, std::uint16_t(0)); // reserved
+    end_event(processor_index, timestamp);
+}
+
+void etl_writer::write_stack(std::uint16_t                  processor_index,
+                             std::uint64_t                  timestamp,
+                             std::uint64_t                  event_timestamp,
+                             std::uint32_t                  process_id,
+                             std::uint32_t                  thread_id,
+                             std::span<const std::uint64_t> stack)
+{
+    // StackWalk_Event:StackWalk_V2
+    begin_perfinfo_event(timestamp, 2, std::to_underlying(parser::event_trace_group::stackwalk), 32);
+    append(event_buffer_, event_timestamp);
+    append(event_buffer_, process_id);
+    append(event_buffer_, thread_id);
+    for(const auto address : stack)
+    {
+        append(event_buffer_, address);
+    }
+    end_event(processor_index, timestamp);
+}
+
+void etl_writer::finish()
+{
+    if(!file_stream_.is_open())
+    {
+        throw std::runtime_error("Cannot finish file: file is not open.");
+    }
+
+    for(std::size_t processor_index = 0; processor_index < processor_buffers_.size(); ++processor_index)
+    {
+        if(processor_buffers_[processor_index].payload.empty()) continue;
+        flush_buffer(common::narrow_cast<std::uint16_t>(processor_index));
+    }
+
+    const auto elapsed_ticks = end_time_qpc_ticks_ - options_.start_time_qpc_ticks;
+    const auto elapsed_time  = common::nt_duration((elapsed_ticks / options_.qpc_frequency) * common::nt_duration::period::den +
+                                                   (elapsed_ticks % options_.qpc_frequency) * common::nt_duration::period::den / options_.qpc_frequency);
+    const auto end_time      = options_.start_time + elapsed_time;
+
+    parser::log_file_mode_flags log_file_mode;
+    log_file_mode.set(parser::log_file_mode::file_mode_sequential);
+    if(options_.compression_format != common::ms_xca_compression_format::none)
+    {
+        log_file_mode.set(parser::log_file_mode::compressed_mode);
+    }
+
+    // EventTrace_Header:EventTraceEvent
+    begin_system_event(options_.start_time_qpc_ticks, 2, std::to_underlying(parser::event_trace_group::header), 0, 0, 0);
+    append(event_buffer_, options_.buffer_size);
+    append(event_buffer_, std::uint8_t(10)); // os_version_major
+    append(event_buffer_, std::uint8_t(0));  // os_version_minor
+    append(event_buffer_, std::uint8_t(0));  // sp_version_major
+    append(event_buffer_, std::uint8_t(0));  // sp_version_minor
+    append(event_buffer_, std::uint32_t(19045));
+    append(event_buffer_, options_.number_of_processors);
+    append(event_buffer_, static_cast<std::uint64_t>((end_time.time_since_epoch() + unix_to_nt_epoch).count()));
+    append(event_buffer_, std::uint32_t(156250)); // timer_resolution
+    append(event_buffer_, std::uint32_t(0));      // max_file_size
+    append(event_buffer_, static_cast<std::uint32_t>(log_file_mode.data().to_ulong()));
+    append(event_buffer_, buffers_written_);
+    append(event_buffer_, std::uint32_t(1)); // start_buffers
+    append(event_buffer_, pointer_size);
+    append(event_buffer_, std::uint32_t(0)); // events_lost
+    append(event_buffer_, std::uint32_t(0)); // cpu_speed
+    append(event_buffer_, std::uint64_t(0)); // logger_name
+    append(event_buffer_, std::uint64_t(0)); // log_file_name
+    append_zeros(event_buffer_, time_zone_information_size);
+    append(event_buffer_, static_cast<std::uint64_t>((options_.start_time.time_since_epoch() + unix_to_nt_epoch).count())); // boot_time
+    append(event_buffer_, options_.qpc_frequency);
+    append(event_buffer_, static_cast<std::uint64_t>((options_.start_time.time_since_epoch() + unix_to_nt_epoch).count()));
+    append(event_buffer_, std::uint32_t(1)); // reserved_flags: QPC clock
+    append(event_buffer_, std::uint32_t(0)); // buffers_lost
+    append_u16string(event_buffer_, u"NT Kernel Logger");
+    append_u16string(event_buffer_, u"");
+
+    write_at(event_buffer_, 4, common::narrow_cast<std::uint16_t>(event_buffer_.size()));
+    event_buffer_.resize(align_event_size(event_buffer_.size()), std::byte{});
+
+    // The header buffer doubles as the first buffer of the first processor, hence its only
+    // event is the header event.
+    const auto header = make_buffer_header(options_.buffer_size,
+                                           common::narrow_cast<std::uint32_t>(buffer_header_size + event_buffer_.size()),
+                                           0,
+                                           0,
+                                           log_file_mode.test(parser::log_file_mode::compressed_mode) ? std::to_underlying(options_.compression_format) : 0,
+                                           {},
+                                           parser::etw_buffer_type::header,
+                                           options_.start_time_qpc_ticks);
+
+    file_stream_.seekp(0);
+    file_stream_.write(reinterpret_cast<const char*>(header.data()), common::narrow_cast<std::streamsize>(header.size()));
+    file_stream_.write(reinterpret_cast<const char*>(event_buffer_.data()), common::narrow_cast<std::streamsize>(event_buffer_.size()));
+
+    file_stream_.close();
+
+    if(file_stream_.fail())
+    {
+        throw std::runtime_error("Failed to write ETL file.");
+    }
+}
+
+void etl_writer::write_process_event(std::uint16_t       processor_index,
+                                     std::uint64_t       timestamp,
+                                     std::uint8_t        event_type,
+                                     std::uint32_t       process_id,
+                                     std::uint32_t       parent_id,
+                                     std::string_view    image_filename,
+                                     std::u16string_view command_line)
+{
+    // Process_TypeGroup1:Process_V4
+    begin_system_event(timestamp, 4, std::to_underlying(parser::event_trace_group::process), event_type, process_id, 0);
+    append(event_buffer_, static_cast<std::uint64_t>(process_id)); // unique_process_key
+    append(event_buffer_, process_id);
+    append(event_buffer_, parent_id);
+    append(event_buffer_, std::uint32_t(1)); // session_id
+    append(event_buffer_, std::int32_t(0));  // exit_status
+    append(event_buffer_, std::uint64_t(0)); // directory_table_base
+    append(event_buffer_, std::uint32_t(0)); // flags
+    append(event_buffer_, std::uint32_t(0)); // user_sid: none
+    append_string(event_buffer_, image_filename);
+    append_u16string(event_buffer_, command_line);
+    append_u16string(event_buffer_, u""); // package_full_name
+    append_u16string(event_buffer_, u""); // application_id
+    end_event(processor_index, timestamp);
+}
+
+void etl_writer::write_thread_event(std::uint16_t       processor_index,
+                                    std::uint64_t       timestamp,
+                                    std::uint8_t        event_type,
+                                    std::uint32_t       process_id,
+                                    std::uint32_t       thread_id,
+                                    std::u16string_view thread_name)
+{
+    // Thread_TypeGroup1:Thread_V3
+    begin_system_event(timestamp, 3, std::to_underlying(parser::event_trace_group::thread), event_type, process_id, thread_id);
+    append(event_buffer_, process_id);
+    append(event_buffer_, thread_id);
+    append_zeros(event_buffer_, 7 * pointer_size); // stack_base - teb_base
+    append(event_buffer_, std::uint32_t(0));       // sub_process_tag
+    append(event_buffer_, std::uint8_t(8));        // base_priority
+    append(event_buffer_, std::uint8_t(5));        // page_priority
+    append(event_buffer_, std::uint8_t(2));        // io_priority
+    append(event_buffer_, std::uint8_t(0));        // flags
+    if(!thread_name.empty()) append_u16string(event_buffer_, thread_name);
+    end_event(processor_index, timestamp);
+}
+
+void etl_writer::begin_system_event(std::uint64_t timestamp,
+                                    std::uint16_t event_version,
+                                    std::uint8_t  event_group,
+                                    std::uint8_t  event_type,
+                                    std::uint32_t process_id,
+                                    std::uint32_t thread_id)
+{
+    event_buffer_.clear();
+    append(event_buffer_, event_version);
+    append(event_buffer_, std::to_underlying(parser::trace_header_type::system64));
+    append(event_buffer_, trace_header_flags);
+    append(event_buffer_, std::uint16_t(0)); // packet.size; will be set in `end_event`
+    append(event_buffer_, event_type);
+    append(event_buffer_, event_group);
+    append(event_buffer_, thread_id);
+    append(event_buffer_, process_id);
+    append(event_buffer_, timestamp);
+    append(event_buffer_, std::uint32_t(0)); // kernel_time
+    append(event_buffer_, std::uint32_t(0)); // user_time
+    assert(event_buffer_.size() == parser::system_trace_header_view::static_size);
+}
+
+void etl_writer::begin_perfinfo_event(std::uint64_t timestamp,
+                                      std::uint16_t event_version,
+                                      std::uint8_t  event_group,
+                                      std::uint8_t  event_type)
+{
+    event_buffer_.clear();
+    append(event_buffer_, event_version);
+    append(event_buffer_, std::to_underlying(parser::trace_header_type::perfinfo64));
+    append(event_buffer_, trace_header_flags);
+    append(event_buffer_, std::uint16_t(0)); // packet.size; will be set in `end_event`
+    append(event_buffer_, event_type);
+    append(event_buffer_, event_group);
+    append(event_buffer_, timestamp);
+    assert(event_buffer_.size() == parser::perfinfo_trace_header_view::static_size);
+}
+
+void etl_writer::end_event(std::uint16_t processor_index, std::uint64_t timestamp)
+{
+    if(!file_stream_.is_open())
+    {
+        throw std::runtime_error("Cannot write event: file is not open.");
+    }
+    if(processor_index >= processor_buffers_.size())
+    {
+        throw std::runtime_error(std::format("Invalid processor index {}", processor_index));
+    }
+
+    const auto event_size   = event_buffer_.size();
+    const auto aligned_size = align_event_size(event_size);
+    if(event_size > std::numeric_limits<std::uint16_t>::max() ||
+       aligned_size > options_.buffer_size - buffer_header_size)
+    {
+        throw std::runtime_error(std::format("Event too large: {} bytes", event_size));
+    }
+    write_at(event_buffer_, 4, static_cast<std::uint16_t>(event_size));
+
+    auto& buffer = processor_buffers_[processor_index];
+    if(buffer_header_size + buffer.payload.size() + aligned_size > options_.buffer_size)
+    {
+        flush_buffer(processor_index);
+    }
+
+    if(buffer.payload.empty()) buffer.start_time = timestamp;
+
+    buffer.payload.insert(buffer.payload.end(), event_buffer_.begin(), event_buffer_.end());
+    buffer.payload.resize(buffer.payload.size() + aligned_size - event_size, std::byte{});
+
+    end_time_qpc_ticks_ = std::max(end_time_qpc_ticks_, timestamp);
+}
+
+void etl_writer::flush_buffer(std::uint16_t processor_index)
+{
+    auto& buffer = processor_buffers_[processor_index];
+    assert(!buffer.payload.empty());
+
+    const auto saved_offset = common::narrow_cast<std::uint32_t>(buffer_header_size + buffer.payload.size());
+
+    // The sequence numbers start at 1, since 0 is the header buffer.
+    const auto sequence_number = static_cast<std::int64_t>(buffers_written_);
+
+    std::size_t compressed_size = 0;
+    if(options_.compression_format != common::ms_xca_compression_format::none)
+    {
+        // Large enough for the worst case of the plain LZ77 format: literals only.
+        compression_buffer_.resize(buffer.payload.size() + buffer.payload.size() / 8 + 8);
+        compressed_size = common::ms_xca_compress(buffer.payload, compression_buffer_, options_.compression_format);
+    }
+
+    if(compressed_size > 0 && compressed_size < buffer.payload.size())
+    {
+        parser::etw_buffer_flags flags;
+        flags.set(parser::etw_buffer_flag::compressed);
+
+        const auto header = make_buffer_header(common::narrow_cast<std::uint32_t>(buffer_header_size + compressed_size),
+                                               saved_offset,
+                                               sequence_number,
+                                               processor_index,
+                                               std::to_underlying(parser::etw_buffer_state::compressed),
+                                               flags,
+                                               parser::etw_buffer_type::generic,
+                                               buffer.start_time);
+
+        write_buffer(header, std::span(compression_buffer_).subspan(0, compressed_size), 0);
+    }
+    else
+    {
+        const auto header = make_buffer_header(options_.buffer_size,
+                                               saved_offset,
+                                               sequence_number,
+                                               processor_index,
+                                               std::to_underlying(parser::etw_buffer_state::flush),
+                                               {},
+                                               parser::etw_buffer_type::generic,
+                                               buffer.start_time);
+
+        write_buffer(header, buffer.payload, options_.buffer_size - saved_offset);
+    }
+
+    buffer.payload.clear();
+}
+
+void etl_writer::write_buffer(std::span<const std::byte> header, std::span<const std::byte> data, std::size_t padding_size)
+{
+    file_stream_.write(reinterpret_cast<const char*>(header.data()), common::narrow_cast<std::streamsize>(header.size()));
+    file_stream_.write(reinterpret_cast<const char*>(data.data()), common::narrow_cast<std::streamsize>(data.size()));
+
+    static constexpr std::array<char, 4096> zeros = {};
+    while(padding_size > 0)
+    {
+        const auto chunk_size = std::min(padding_size, zeros.size());
+        file_stream_.write(zeros.data(), common::narrow_cast<std::streamsize>(chunk_size));
+        padding_size -= chunk_size;
+    }
+
+    ++buffers_written_;
+}
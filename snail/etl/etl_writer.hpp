@@ -0,0 +1,146 @@
+
+#pragma once
+
+#include <cstdint>
+
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <snail/common/date_time.hpp>
+#include <snail/common/ms_xca_compression_format.hpp>
+
+namespace snail::etl {
+
+// Writes kernel ETL files that can be read by `etl_file`.
+//
+// Only 64-bit traces are supported. Events are collected in one buffer per processor
+// and each buffer is written to the file (optionally compressed) as soon as it is full.
+// Events of a single processor are expected to be written in increasing timestamp order.
+// The header buffer is written by `finish`.
+class etl_writer
+{
+public:
+    struct options
+    {
+        std::uint32_t buffer_size;
+        std::uint32_t number_of_processors;
+
+        std::uint64_t       qpc_frequency;
+        std::uint64_t       start_time_qpc_ticks;
+        common::nt_sys_time start_time;
+
+        common::ms_xca_compression_format compression_format;
+    };
+
+    etl_writer(const std::filesystem::path& file_path, options options);
+
+    ~etl_writer();
+
+    void write_process_start(std::uint16_t       processor_index,
+                             std::uint64_t       timestamp,
+                             std::uint32_t       process_id,
+                             std::uint32_t       parent_id,
+                             std::string_view    image_filename,
+                             std::u16string_view command_line);
+
+    void write_process_end(std::uint16_t       processor_index,
+                           std::uint64_t       timestamp,
+                           std::uint32_t       process_id,
+                           std::uint32_t       parent_id,
+                           std::string_view    image_filename,
+                           std::u16string_view command_line);
+
+    void write_thread_start(std::uint16_t       processor_index,
+                            std::uint64_t       timestamp,
+                            std::uint32_t       process_id,
+                            std::uint32_t       thread_id,
+                            std::u16string_view thread_name);
+
+    void write_thread_end(std::uint16_t processor_index,
+                          std::uint64_t timestamp,
+                          std::uint32_t process_id,
+                          std::uint32_t thread_id);
+
+    void write_image_load(std::uint16_t       processor_index,
+                          std::uint64_t       timestamp,
+                          std::uint32_t       process_id,
+                          std::uint64_t       image_base,
+                          std::uint64_t       image_size,
+                          std::uint32_t       image_checksum,
+                          std::u16string_view file_name);
+
+    void write_sampled_profile(std::uint16_t processor_index,
+                               std::uint64_t timestamp,
+                               std::uint32_t thread_id,
+                               std::uint64_t instruction_pointer);
+
+    // The stack is expected to start with the innermost frame. To be attached to a sample,
+    // `event_timestamp` has to match the timestamp of the sample on the same thread.
+    void write_stack(std::uint16_t                  processor_index,
+                     std::uint64_t                  timestamp,
+                     std::uint64_t                  event_timestamp,
+                     std::uint32_t                  process_id,
+                     std::uint32_t                  thread_id,
+                     std::span<const std::uint64_t> stack);
+
+    // Flushes all remaining buffers, writes the header buffer and closes the file.
+    // No more events can be written afterwards.
+    void finish();
+
+private:
+    struct processor_buffer
+    {
+        std::vector<std::byte> payload;
+        std::uint64_t          start_time;
+    };
+
+    void write_process_event(std::uint16_t       processor_index,
+                             std::uint64_t       timestamp,
+                             std::uint8_t        event_type,
+                             std::uint32_t       process_id,
+                             std::uint32_t       parent_id,
+                             std::string_view    image_filename,
+                             std::u16string_view command_line);
+
+    void write_thread_event(std::uint16_t       processor_index,
+                            std::uint64_t       timestamp,
+                            std::uint8_t        event_type,
+                            std::uint32_t       process_id,
+                            std::uint32_t       thread_id,
+                            std::u16string_view thread_name);
+
+    void begin_system_event(std::uint64_t timestamp,
+                            std::uint16_t event_version,
+                            std::uint8_t  event_group,
+                            std::uint8_t  event_type,
+                            std::uint32_t process_id,
+                            std::uint32_t thread_id);
+
+    void begin_perfinfo_event(std::uint64_t timestamp,
+                              std::uint16_t event_version,
+                              std::uint8_t  event_group,
+                              std::uint8_t  event_type);
+
+    void end_event(std::uint16_t processor_index, std::uint64_t timestamp);
+
+    void flush_buffer(std::uint16_t processor_index);
+
+    void write_buffer(std::span<const std::byte> header, std::span<const std::byte> data, std::size_t padding_size);
+
+    std::ofstream file_stream_;
+
+    options options_;
+
+    std::vector<processor_buffer> processor_buffers_;
+
+    std::vector<std::byte> event_buffer_;
+    std::vector<std::byte> compression_buffer_;
+
+    std::uint32_t buffers_written_;
+    std::uint64_t end_time_qpc_ticks_;
+};
+
+} // namespace snail::etl
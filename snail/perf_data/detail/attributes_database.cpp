@@ -39,6 +39,16 @@ std::optional<std::size_t> snail::perf_data::detail::calculate_id_back_offset(co
     return offset;
 }
 
+void event_attributes_database::add(parser::event_attributes attributes, std::span<const std::uint64_t> ids)
+{
+    all_attributes.push_back(std::move(attributes));
+    for(const auto id : ids)
+    {
+        id_to_attributes[id] = &all_attributes.back();
+    }
+    validate();
+}
+
 void event_attributes_database::validate()
 {
     if(all_attributes.empty())
@@ -2,6 +2,8 @@
 #pragma once
 
 #include <bit>
+#include <cstdint>
+#include <deque>
 #include <optional>
 #include <span>
 #include <type_traits>
@@ -23,9 +25,14 @@ std::optional<std::size_t> calculate_id_back_offset(const parser::sample_format_
 
 struct event_attributes_database
 {
-    std::vector<parser::event_attributes>                        all_attributes;
+    // A deque never moves its elements when growing, hence the pointers in `id_to_attributes` and
+    // the attributes handed out by `get_event_attributes` stay valid when more attributes are added.
+    std::deque<parser::event_attributes>                         all_attributes;
     std::unordered_map<std::uint64_t, parser::event_attributes*> id_to_attributes;
 
+    // Appends the attributes for the events with the given ids and validates the database afterwards.
+    void add(parser::event_attributes attributes, std::span<const std::uint64_t> ids);
+
     void validate();
 
     const parser::event_attributes& get_event_attributes(std::endian                byte_order,
@@ -26,6 +26,10 @@ struct perf_data_file_header_data
     section_data event_types;
 
     parser::header_feature_flags additional_features;
+
+    // In pipe mode, the header consists of the magic and the size only and all other
+    // information is transmitted as events. See `perf_data_file::is_pipe_mode`.
+    bool is_pipe_mode;
 };
 
 } // namespace snail::perf_data::detail
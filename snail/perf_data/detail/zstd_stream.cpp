@@ -0,0 +1,91 @@
+
+#include <snail/perf_data/detail/zstd_stream.hpp>
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+
+#include <zstd.h>
+
+using namespace snail::perf_data::detail;
+
+zstd_stream_decompressor::zstd_stream_decompressor() :
+    stream_(ZSTD_createDStream())
+{
+    if(stream_ == nullptr) throw std::runtime_error("Failed to create zstd decompression stream");
+}
+
+zstd_stream_decompressor::~zstd_stream_decompressor()
+{
+    ZSTD_freeDStream(stream_);
+}
+
+void zstd_stream_decompressor::decompress(std::span<const std::byte> input, std::vector<std::byte>& output)
+{
+    ZSTD_inBuffer in_buffer{
+        .src  = input.data(),
+        .size = input.size(),
+        .pos  = 0};
+
+    // Decompress into the free space at the end of `output`, growing it as long as the
+    // decompressor can not make any more progress with the available space.
+    auto output_size = output.size();
+    while(true)
+    {
+        if(output.size() - output_size < ZSTD_DStreamOutSize()) output.resize(output_size + std::max(input.size() * 4, ZSTD_DStreamOutSize()));
+
+        ZSTD_outBuffer out_buffer{
+            .dst  = output.data() + output_size,
+            .size = output.size() - output_size,
+            .pos  = 0};
+
+        const auto result = ZSTD_decompressStream(stream_, &out_buffer, &in_buffer);
+        if(ZSTD_isError(result))
+        {
+            throw std::runtime_error(std::format("Failed to decompress perf.data record: {}", ZSTD_getErrorName(result)));
+        }
+        output_size += out_buffer.pos;
+
+        // If the output buffer has not been filled completely, all data that is available from
+        // the input so far has been flushed.
+        if(in_buffer.pos == in_buffer.size && out_buffer.pos < out_buffer.size) break;
+    }
+    output.resize(output_size);
+}
+
+zstd_stream_compressor::zstd_stream_compressor(int level) :
+    stream_(ZSTD_createCStream())
+{
+    if(stream_ == nullptr) throw std::runtime_error("Failed to create zstd compression stream");
+
+    ZSTD_CCtx_setParameter(stream_, ZSTD_c_compressionLevel, level);
+}
+
+zstd_stream_compressor::~zstd_stream_compressor()
+{
+    ZSTD_freeCStream(stream_);
+}
+
+bool zstd_stream_compressor::compress_some(std::span<const std::byte> input, std::size_t& input_position, std::span<std::byte> output, std::size_t& output_size)
+{
+    ZSTD_inBuffer in_buffer{
+        .src  = input.data(),
+        .size = input.size(),
+        .pos  = input_position};
+
+    ZSTD_outBuffer out_buffer{
+        .dst  = output.data(),
+        .size = output.size(),
+        .pos  = 0};
+
+    const auto remaining = ZSTD_compressStream2(stream_, &out_buffer, &in_buffer, ZSTD_e_flush);
+    if(ZSTD_isError(remaining))
+    {
+        throw std::runtime_error(std::format("Failed to compress perf.data record: {}", ZSTD_getErrorName(remaining)));
+    }
+
+    input_position = in_buffer.pos;
+    output_size    = out_buffer.pos;
+
+    return remaining == 0 && in_buffer.pos == in_buffer.size;
+}
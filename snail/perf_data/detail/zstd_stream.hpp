@@ -0,0 +1,74 @@
+
+#pragma once
+
+#include <cstddef>
+
+#include <span>
+#include <vector>
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+
+namespace snail::perf_data::detail {
+
+// perf compresses the payloads of all `compressed` records of a file as a single zstd stream
+// (each record holds the data up to a flush of the stream). Hence, the payloads need to be
+// passed through the same decompressor in file order.
+class zstd_stream_decompressor
+{
+public:
+    zstd_stream_decompressor();
+    ~zstd_stream_decompressor();
+
+    zstd_stream_decompressor(const zstd_stream_decompressor&)            = delete;
+    zstd_stream_decompressor& operator=(const zstd_stream_decompressor&) = delete;
+
+    // Decompresses the payload of a single record and appends the result to `output`.
+    void decompress(std::span<const std::byte> input, std::vector<std::byte>& output);
+
+private:
+    ZSTD_DCtx_s* stream_;
+};
+
+// Counterpart to `zstd_stream_decompressor`.
+class zstd_stream_compressor
+{
+public:
+    explicit zstd_stream_compressor(int level);
+    ~zstd_stream_compressor();
+
+    zstd_stream_compressor(const zstd_stream_compressor&)            = delete;
+    zstd_stream_compressor& operator=(const zstd_stream_compressor&) = delete;
+
+    // Compresses `input` and flushes the stream. The result is split into chunks of at most
+    // `max_chunk_size` bytes, each of which is passed to `write_chunk`.
+    template<typename F>
+    void compress(std::span<const std::byte> input, std::size_t max_chunk_size, F&& write_chunk);
+
+private:
+    // Compresses as much of the input as fits into `output`. Returns whether the stream has been
+    // flushed completely.
+    bool compress_some(std::span<const std::byte> input, std::size_t& input_position, std::span<std::byte> output, std::size_t& output_size);
+
+    ZSTD_CCtx_s*           stream_;
+    std::vector<std::byte> chunk_buffer_;
+};
+
+template<typename F>
+void zstd_stream_compressor::compress(std::span<const std::byte> input, std::size_t max_chunk_size, F&& write_chunk)
+{
+    chunk_buffer_.resize(max_chunk_size);
+
+    std::size_t input_position = 0;
+    while(true)
+    {
+        std::size_t output_size = 0;
+
+        const auto flushed = compress_some(input, input_position, chunk_buffer_, output_size);
+        if(output_size > 0) write_chunk(std::span<const std::byte>(chunk_buffer_).subspan(0, output_size));
+
+        if(flushed) break;
+    }
+}
+
+} // namespace snail::perf_data::detail
@@ -9,7 +9,6 @@ void perf_data_metadata::extract_event_attributes_database(detail::event_attribu
 {
     database.all_attributes.clear();
     database.id_to_attributes.clear();
-    database.all_attributes.reserve(event_desc.size());
     for(const auto& data : event_desc)
     {
         database.all_attributes.push_back(data.attribute);
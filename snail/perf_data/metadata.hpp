@@ -64,7 +64,15 @@ struct perf_data_metadata
     // dir_format;
     // bpf_prog_info;
     // bpf_btf;
-    // compressed;
+    struct compressed_data
+    {
+        std::uint32_t version;
+        std::uint32_t type; // 1 = zstd
+        std::uint32_t level;
+        std::uint32_t ratio;
+        std::uint32_t mmap_len;
+    };
+    std::optional<compressed_data> compressed;
     // cpu_pmu_caps;
     // clock_data;
     // hybrid_topology;
@@ -45,11 +45,11 @@ sample_id snail::perf_data::parser::parse_sample_id_back(const sample_format_fla
 }
 
 template<>
-sample_event snail::perf_data::parser::parse_event(const event_attributes&    attributes,
-                                                   std::span<const std::byte> buffer,
-                                                   std::endian                byte_order)
+sample_event_view snail::perf_data::parser::parse_event(const event_attributes&    attributes,
+                                                        std::span<const std::byte> buffer,
+                                                        std::endian                byte_order)
 {
-    sample_event result;
+    sample_event_view result;
 
     std::size_t offset = event_header_view::static_size;
 
@@ -71,27 +71,56 @@ sample_event snail::perf_data::parser::parse_event(const event_attributes&    at
 
     if(attributes.sample_format.test(parser::sample_format::call_chain))
     {
-        const auto                 size = extract_move<std::uint64_t>(buffer, offset, byte_order);
-        std::vector<std::uint64_t> ips(static_cast<std::size_t>(size));
-        for(auto& ip : ips)
-        {
-            ip = extract_move<std::uint64_t>(buffer, offset, byte_order);
-        }
-        result.ips = std::move(ips);
+        const auto size = static_cast<std::size_t>(extract_move<std::uint64_t>(buffer, offset, byte_order));
+        result.ips      = callchain_view(buffer.subspan(offset, size * sizeof(std::uint64_t)), byte_order);
+        offset += size * sizeof(std::uint64_t);
     }
 
     if(attributes.sample_format.test(parser::sample_format::raw))
     {
-        const auto                size = extract_move<std::uint64_t>(buffer, offset, byte_order);
-        std::vector<std::uint8_t> data(static_cast<std::size_t>(size));
-        for(auto& entry : data)
-        {
-            entry = extract_move<std::uint8_t>(buffer, offset, byte_order);
-        }
-        result.data = std::move(data);
+        const auto size = static_cast<std::size_t>(extract_move<std::uint64_t>(buffer, offset, byte_order));
+        result.data     = buffer.subspan(offset, size);
+        offset += size;
     }
 
     assert(offset == buffer.size()); // Remaining fields not yet supported
 
     return result;
 }
+
+template<>
+sample_event snail::perf_data::parser::parse_event(const event_attributes&    attributes,
+                                                   std::span<const std::byte> buffer,
+                                                   std::endian                byte_order)
+{
+    const auto view = parse_event<sample_event_view>(attributes, buffer, byte_order);
+
+    sample_event result{
+        .attributes = view.attributes,
+        .id         = view.id,
+        .ip         = view.ip,
+        .pid        = view.pid,
+        .tid        = view.tid,
+        .time       = view.time,
+        .addr       = view.addr,
+        .stream_id  = view.stream_id,
+        .cpu        = view.cpu,
+        .res        = view.res,
+        .period     = view.period,
+        .ips        = {},
+        .data       = {}};
+
+    if(view.ips)
+    {
+        result.ips.emplace(view.ips->size());
+        view.ips->copy_to(*result.ips);
+    }
+
+    if(view.data)
+    {
+        const auto* const data = reinterpret_cast<const std::uint8_t*>(view.data->data());
+        result.data.emplace(data, data + view.data->size());
+    }
+
+    return result;
+}
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <cassert>
 #include <cstdint>
+#include <cstring>
 
+#include <algorithm>
+#include <bit>
+#include <iterator>
 #include <optional>
+#include <span>
 #include <type_traits>
 #include <vector>
 
@@ -180,6 +186,140 @@ enum class sample_stack_context_marker : std::uint64_t
     max = static_cast<std::uint64_t>(-4095),
 };
 
+// The instruction pointers of a sample callchain, read directly from the event buffer.
+class callchain_view
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = std::uint64_t;
+        using reference         = std::uint64_t;
+
+        iterator() = default;
+        iterator(const callchain_view* view, std::size_t index) :
+            view_(view),
+            index_(index)
+        {}
+
+        reference operator*() const
+        {
+            return (*view_)[index_];
+        }
+
+        iterator& operator++()
+        {
+            ++index_;
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            auto tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        iterator& operator--()
+        {
+            --index_;
+            return *this;
+        }
+        iterator operator--(int)
+        {
+            auto tmp = *this;
+            --(*this);
+            return tmp;
+        }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.index_ == rhs.index_;
+        }
+
+    private:
+        const callchain_view* view_  = nullptr;
+        std::size_t           index_ = 0;
+    };
+
+    using value_type     = std::uint64_t;
+    using const_iterator = iterator;
+
+    callchain_view() = default;
+    callchain_view(std::span<const std::byte> buffer, std::endian byte_order) :
+        buffer_(buffer),
+        byte_order_(byte_order)
+    {
+        assert(buffer.size() % sizeof(std::uint64_t) == 0);
+    }
+
+    std::size_t size() const { return buffer_.size() / sizeof(std::uint64_t); }
+    bool        empty() const { return buffer_.empty(); }
+
+    std::uint64_t operator[](std::size_t index) const
+    {
+        return common::parser::extract<std::uint64_t>(buffer_, index * sizeof(std::uint64_t), byte_order_);
+    }
+
+    iterator begin() const { return {this, 0}; }
+    iterator end() const { return {this, size()}; }
+
+    // Copies all instruction pointers to `destination`, which needs to hold at least `size()` entries.
+    // If the buffer is in the native byte order, this is a single `memcpy`.
+    void copy_to(std::span<std::uint64_t> destination) const
+    {
+        assert(destination.size() >= size());
+        if(byte_order_ == std::endian::native)
+        {
+            if(!buffer_.empty()) std::memcpy(destination.data(), buffer_.data(), buffer_.size());
+        }
+        else
+        {
+            std::ranges::copy(*this, destination.begin());
+        }
+    }
+
+private:
+    std::span<const std::byte> buffer_;
+    std::endian                byte_order_ = std::endian::native;
+};
+
+// Same as `sample_event`, but the variable sized fields are views into the event buffer.
+// Parsing this does not require any heap allocations, but it is only valid as long as the
+// event buffer is.
+struct sample_event_view
+{
+    static inline constexpr parser::event_type event_type = parser::event_type::sample;
+
+    const event_attributes* attributes;
+
+    std::optional<std::uint64_t> id;
+    std::optional<std::uint64_t> ip;
+
+    std::optional<std::uint32_t> pid;
+    std::optional<std::uint32_t> tid;
+
+    std::optional<std::uint64_t> time;
+    std::optional<std::uint64_t> addr;
+
+    std::optional<std::uint64_t> stream_id;
+
+    std::optional<std::uint32_t> cpu;
+    std::optional<std::uint32_t> res;
+
+    std::optional<std::uint64_t> period;
+
+    std::optional<callchain_view> ips;
+
+    std::optional<std::span<const std::byte>> data;
+};
+
+template<>
+sample_event_view parse_event(const event_attributes&    attributes,
+                              std::span<const std::byte> buffer,
+                              std::endian                byte_order);
+
 struct sample_event
 {
     static inline constexpr parser::event_type event_type = parser::event_type::sample;
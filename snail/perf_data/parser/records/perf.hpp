@@ -2,12 +2,77 @@
 
 #include <cstdint>
 
+#include <algorithm>
 #include <type_traits>
 
 #include <snail/perf_data/parser/event.hpp>
+#include <snail/perf_data/parser/event_attributes.hpp>
+#include <snail/perf_data/parser/header_feature.hpp>
 
 namespace snail::perf_data::parser {
 
+// Only used in pipe mode, where it replaces the attributes section of the file.
+struct header_attr_event_view : private parser::event_view_base
+{
+    static inline constexpr parser::event_type event_type = parser::event_type::header_attr;
+
+    using event_view_base::buffer;
+    using event_view_base::event_view_base;
+    using event_view_base::header;
+
+    inline auto attributes_size() const { return extract<std::uint32_t>(4); }
+    inline auto attributes() const
+    {
+        return event_attributes_view(buffer().subspan(0, std::min(std::size_t(attributes_size()), event_attributes_view::static_size)), byte_order());
+    }
+
+    inline std::size_t ids_count() const { return (buffer().size() - attributes_size()) / sizeof(std::uint64_t); }
+    inline auto        id(std::size_t index) const { return extract<std::uint64_t>(attributes_size() + index * sizeof(std::uint64_t)); }
+};
+
+// Only used in pipe mode, where it replaces the feature sections at the end of the file.
+// The data is stored in the same format as in the feature sections.
+struct header_feature_event_view : private parser::event_view_base
+{
+    static inline constexpr parser::event_type event_type = parser::event_type::header_feature;
+
+    using event_view_base::buffer;
+    using event_view_base::event_view_base;
+    using event_view_base::header;
+
+    inline auto feature() const { return header_feature(extract<std::uint64_t>(0)); }
+    inline auto data() const { return buffer().subspan(8); }
+};
+
+enum class event_update_type : std::uint64_t
+{
+    unit  = 0,
+    scale = 1,
+    name  = 2,
+    cpus  = 3
+};
+
+struct event_update_event_view : private parser::event_view_base
+{
+    static inline constexpr parser::event_type event_type = parser::event_type::event_update;
+
+    using event_view_base::buffer;
+    using event_view_base::event_view_base;
+    using event_view_base::header;
+
+    inline auto type() const { return extract<event_update_type>(0); }
+    inline auto id() const { return extract<std::uint64_t>(8); }
+
+    inline auto name() const
+    {
+        assert(type() == event_update_type::name);
+        return extract_string(16, name_length);
+    }
+
+private:
+    mutable std::optional<std::size_t> name_length;
+};
+
 struct finished_round_event_view : private parser::event_view_base
 {
     static inline constexpr parser::event_type event_type = parser::event_type::finished_round;
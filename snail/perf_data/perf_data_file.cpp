@@ -1,21 +1,32 @@
 
 #include <snail/perf_data/perf_data_file.hpp>
 
+#include <algorithm>
 #include <array>
 #include <bit>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <format>
+#include <future>
 #include <iostream>
+#include <mutex>
 #include <optional>
 #include <span>
+#include <spanstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <snail/common/bit_flags.hpp>
 #include <snail/common/cast.hpp>
 #include <snail/common/chunked_reader.hpp>
+#include <snail/common/span_reader.hpp>
 #include <snail/common/stream_position.hpp>
+#include <snail/common/thread_pool.hpp>
 
 #include <snail/perf_data/parser/event.hpp>
 #include <snail/perf_data/parser/event_attributes.hpp>
@@ -26,6 +37,7 @@
 
 #include <snail/perf_data/detail/attributes_database.hpp>
 #include <snail/perf_data/detail/file_header.hpp>
+#include <snail/perf_data/detail/zstd_stream.hpp>
 #include <snail/perf_data/metadata.hpp>
 
 #include <snail/common/detail/dump.hpp>
@@ -38,6 +50,23 @@ namespace {
 
 inline constexpr std::size_t max_chunk_size = 0xFFFF + 1;
 
+// When processing in parallel, batches are only cut at a `finished_round` record once they
+// have reached this size, so that the per-batch overhead stays small for traces with many small rounds.
+inline constexpr std::size_t min_batch_size = 1024 * 1024;
+
+// Traces without any `finished_round` records (or with huge rounds) are cut at the next event
+// boundary once a batch reaches this size, to bound the memory usage of the batches in flight.
+// Decoding an event does not depend on any other event, hence this does not change the result.
+inline constexpr std::size_t max_batch_size = 16 * 1024 * 1024;
+
+// When decompressing on a separate thread, the decompressed events are passed on in chunks of
+// (at least) this size, and at most `max_pending_chunks` are buffered at any time.
+inline constexpr std::size_t min_chunk_size     = 1024 * 1024;
+inline constexpr std::size_t max_pending_chunks = 4;
+
+// The only compression type supported by perf (`perf record -z`).
+inline constexpr std::uint32_t zstd_compression_type = 1;
+
 void read_attributes_section(std::ifstream&                            file_stream,
                              const detail::perf_data_file_header_data& header,
                              detail::event_attributes_database&        attributes_database)
@@ -95,7 +124,6 @@ void read_attributes_section(std::ifstream&                            file_stre
 
     attributes_database.all_attributes.clear();
     attributes_database.id_to_attributes.clear();
-    attributes_database.all_attributes.reserve(attributes.size());
     for(const auto& data : attributes)
     {
         attributes_database.all_attributes.push_back(data.attributes);
@@ -134,10 +162,9 @@ parser::header_feature proceed_to_next_feature(const parser::header_feature_flag
     return parser::header_feature(next_feature_index);
 }
 
-template<typename F>
-void read_events(std::ifstream&                            file_stream,
+template<typename Reader, typename F>
+void read_events(Reader&                                   reader,
                  const detail::perf_data_file_header_data& header,
-                 std::uint64_t                             offset,
                  std::uint64_t                             size,
                  F&&                                       callback,
                  const common::progress_listener*          progress_listener,
@@ -146,7 +173,6 @@ void read_events(std::ifstream&                            file_stream,
     common::progress_reporter progress(progress_listener, size,
                                        "Processing events");
 
-    auto reader = common::chunked_reader<max_chunk_size>(file_stream, offset, size);
     while(reader.keep_going())
     {
         if(cancellation_token && cancellation_token->is_canceled()) return;
@@ -177,7 +203,153 @@ void read_events(std::ifstream&                            file_stream,
     progress.finish();
 }
 
+// Reads the events in the given section either directly from the memory mapped file
+// (if available) or through a chunked reader on top of the file stream.
+template<typename F>
+void read_events(std::ifstream&                            file_stream,
+                 std::span<const std::byte>                mapped_file_data,
+                 const detail::perf_data_file_header_data& header,
+                 std::uint64_t                             offset,
+                 std::uint64_t                             size,
+                 F&&                                       callback,
+                 const common::progress_listener*          progress_listener,
+                 const common::cancellation_token*         cancellation_token)
+{
+    if(!mapped_file_data.empty())
+    {
+        auto reader = common::span_reader(mapped_file_data, offset, size);
+        read_events(reader, header, size, std::forward<F>(callback), progress_listener, cancellation_token);
+    }
+    else
+    {
+        auto reader = common::chunked_reader<max_chunk_size>(file_stream, offset, size);
+        read_events(reader, header, size, std::forward<F>(callback), progress_listener, cancellation_token);
+    }
+}
+
+void add_build_id(perf_data_metadata& metadata, std::span<const std::byte> event_buffer, std::endian byte_order)
+{
+    const auto event = parser::header_build_id_event_view(event_buffer, byte_order);
+
+    if(!metadata.build_ids) metadata.build_ids.emplace();
+
+    auto& build_id_entry = metadata.build_ids.value()[std::string(event.filename())];
+
+    const auto event_build_id = event.build_id();
+    build_id_entry.size_      = event_build_id.size();
+    std::ranges::copy(event_build_id, build_id_entry.buffer_.begin());
+}
+
+// Reads the data of a single header feature that is stored in the given stream.
+// Build IDs are stored as a sequence of events instead and need to be handled separately.
+void read_feature(std::istream&          stream,
+                  std::endian            byte_order,
+                  parser::header_feature feature,
+                  perf_data_metadata&    metadata)
+{
+    switch(feature)
+    {
+    // case parser::header_feature::tracing_data:
+    case parser::header_feature::hostname:
+        metadata.hostname = common::parser::read_string(stream, byte_order);
+        break;
+    case parser::header_feature::osrelease:
+        metadata.os_release = common::parser::read_string(stream, byte_order);
+        break;
+    case parser::header_feature::version:
+        metadata.version = common::parser::read_string(stream, byte_order);
+        break;
+    case parser::header_feature::arch:
+        metadata.arch = common::parser::read_string(stream, byte_order);
+        break;
+    case parser::header_feature::nr_cpus:
+        metadata.nr_cpus = {
+            .nr_cpus_available = common::parser::read_int<std::uint32_t>(stream, byte_order),
+            .nr_cpus_online    = common::parser::read_int<std::uint32_t>(stream, byte_order)};
+        break;
+    case parser::header_feature::cpu_desc:
+        metadata.cpu_desc = common::parser::read_string(stream, byte_order);
+        break;
+    case parser::header_feature::cpu_id:
+        metadata.cpu_id = common::parser::read_string(stream, byte_order);
+        break;
+    case parser::header_feature::total_mem:
+        metadata.total_mem = common::parser::read_int<std::uint64_t>(stream, byte_order);
+        break;
+    case parser::header_feature::cmdline:
+        metadata.cmdline = common::parser::read_string_list(stream, byte_order);
+        break;
+    case parser::header_feature::event_desc:
+    {
+        const auto                  nr_events = common::parser::read_int<std::uint32_t>(stream, byte_order);
+        [[maybe_unused]] const auto attr_size = common::parser::read_int<std::uint32_t>(stream, byte_order);
+
+        std::array<std::byte, parser::event_attributes_view::static_size> attribute_buffer;
+
+        const auto max_buffer_size = std::min(std::size_t(attr_size), parser::event_attributes_view::static_size);
+
+        for(std::uint32_t event_i = 0; event_i < nr_events; ++event_i)
+        {
+            stream.read(reinterpret_cast<char*>(attribute_buffer.data()), max_buffer_size);
+            if(attr_size > parser::event_attributes_view::static_size) stream.seekg(attr_size - parser::event_attributes_view::static_size, std::ios::cur);
+
+            const auto attribute_view = parser::event_attributes_view(std::span(attribute_buffer).subspan(0, max_buffer_size), byte_order);
+            const auto nr_ids         = common::parser::read_int<std::uint32_t>(stream, byte_order);
+            auto       event_string   = common::parser::read_string(stream, byte_order);
+
+            std::vector<std::uint64_t> ids;
+            for(std::uint32_t id_i = 0; id_i < nr_ids; ++id_i)
+            {
+                ids.push_back(common::parser::read_int<std::uint64_t>(stream, byte_order));
+            }
+
+            metadata.event_desc.push_back(perf_data_metadata::event_desc_data{
+                .attribute    = attribute_view.instantiate(),
+                .event_string = std::move(event_string),
+                .ids          = std::move(ids)});
+        }
+        break;
+    }
+    // case parser::header_feature::cpu_topology:
+    // case parser::header_feature::numa_topology:
+    // case parser::header_feature::branch_stack:
+    // case parser::header_feature::pmu_mappings:
+    // case parser::header_feature::group_desc:
+    // case parser::header_feature::aux_trace:
+    // case parser::header_feature::stat:
+    // case parser::header_feature::cache:
+    case parser::header_feature::sample_time:
+        metadata.sample_time = {
+            .start = std::chrono::nanoseconds(common::parser::read_int<std::uint64_t>(stream, byte_order)),
+            .end   = std::chrono::nanoseconds(common::parser::read_int<std::uint64_t>(stream, byte_order))};
+        break;
+    // case parser::header_feature::mem_topology:
+    case parser::header_feature::clockid:
+        metadata.clockid = common::parser::read_int<std::uint64_t>(stream, byte_order);
+        break;
+    // case parser::header_feature::dir_format:
+    // case parser::header_feature::bpf_prog_info:
+    // case parser::header_feature::bpf_btf:
+    case parser::header_feature::compressed:
+        metadata.compressed = {
+            .version  = common::parser::read_int<std::uint32_t>(stream, byte_order),
+            .type     = common::parser::read_int<std::uint32_t>(stream, byte_order),
+            .level    = common::parser::read_int<std::uint32_t>(stream, byte_order),
+            .ratio    = common::parser::read_int<std::uint32_t>(stream, byte_order),
+            .mmap_len = common::parser::read_int<std::uint32_t>(stream, byte_order)};
+        break;
+    // case parser::header_feature::cpu_pmu_caps:
+    // case parser::header_feature::clock_data:
+    // case parser::header_feature::hybrid_topology:
+    // case parser::header_feature::pmu_caps:
+    //     break;
+    default:
+        break;
+    }
+}
+
 void read_metadata(std::ifstream&                            file_stream,
+                   std::span<const std::byte>                mapped_file_data,
                    const detail::perf_data_file_header_data& header,
                    perf_data_metadata&                       metadata)
 {
@@ -202,159 +374,777 @@ void read_metadata(std::ifstream&                            file_stream,
 
             file_stream.seekg(common::narrow_cast<std::streamoff>(metadata_section.offset()));
 
-            switch(current_feature)
+            if(current_feature == parser::header_feature::build_id)
             {
-            // case parser::header_feature::tracing_data:
-            case parser::header_feature::build_id:
                 read_events(
                     file_stream,
+                    mapped_file_data,
                     header,
                     metadata_section.offset(), metadata_section.size(),
                     [&header, &metadata](parser::event_header_view /*event_header*/,
                                          std::span<const std::byte> event_buffer)
                     {
-                        const auto event = parser::header_build_id_event_view(event_buffer, header.byte_order);
-
-                        if(!metadata.build_ids) metadata.build_ids.emplace();
-
-                        auto& build_id_entry = metadata.build_ids.value()[std::string(event.filename())];
-
-                        const auto event_build_id = event.build_id();
-                        build_id_entry.size_      = event_build_id.size();
-                        std::ranges::copy(event_build_id, build_id_entry.buffer_.begin());
+                        add_build_id(metadata, event_buffer, header.byte_order);
                     },
                     nullptr,
                     nullptr);
-                break;
-            case parser::header_feature::hostname:
-                metadata.hostname = common::parser::read_string(file_stream, header.byte_order);
-                break;
-            case parser::header_feature::osrelease:
-                metadata.os_release = common::parser::read_string(file_stream, header.byte_order);
-                break;
-            case parser::header_feature::version:
-                metadata.version = common::parser::read_string(file_stream, header.byte_order);
-                break;
-            case parser::header_feature::arch:
-                metadata.arch = common::parser::read_string(file_stream, header.byte_order);
-                break;
-            case parser::header_feature::nr_cpus:
-                metadata.nr_cpus = {
-                    .nr_cpus_available = common::parser::read_int<std::uint32_t>(file_stream, header.byte_order),
-                    .nr_cpus_online    = common::parser::read_int<std::uint32_t>(file_stream, header.byte_order)};
-                break;
-            case parser::header_feature::cpu_desc:
-                metadata.cpu_desc = common::parser::read_string(file_stream, header.byte_order);
-                break;
-            case parser::header_feature::cpu_id:
-                metadata.cpu_id = common::parser::read_string(file_stream, header.byte_order);
-                break;
-            case parser::header_feature::total_mem:
-                metadata.total_mem = common::parser::read_int<std::uint64_t>(file_stream, header.byte_order);
-                break;
-            case parser::header_feature::cmdline:
-                metadata.cmdline = common::parser::read_string_list(file_stream, header.byte_order);
-                break;
-            case parser::header_feature::event_desc:
+            }
+            else
             {
-                const auto                  nr_events = common::parser::read_int<std::uint32_t>(file_stream, header.byte_order);
-                [[maybe_unused]] const auto attr_size = common::parser::read_int<std::uint32_t>(file_stream, header.byte_order);
-
-                std::array<std::byte, parser::event_attributes_view::static_size> attribute_buffer;
+                read_feature(file_stream, header.byte_order, current_feature, metadata);
+            }
+        }
+    }
+}
 
-                const auto max_buffer_size = std::min(std::size_t(attr_size), parser::event_attributes_view::static_size);
+void dispatch_event(const detail::perf_data_file_header_data& header,
+                    const detail::event_attributes_database&  attributes_database,
+                    event_observer&                           callbacks,
+                    parser::event_header_view                 event_header,
+                    std::span<const std::byte>                event_buffer)
+{
+    if(is_kernel_event(event_header.type()))
+    {
+        const auto& event_attributes = attributes_database.get_event_attributes(header.byte_order, event_header.type(), event_buffer.subspan(parser::event_header_view::static_size));
+        callbacks.handle(event_header, event_attributes, event_buffer, header.byte_order);
+    }
+    else
+    {
+        callbacks.handle(event_header, event_buffer, header.byte_order);
+    }
+}
 
-                for(std::uint32_t event_i = 0; event_i < nr_events; ++event_i)
-                {
-                    file_stream.read(reinterpret_cast<char*>(attribute_buffer.data()), max_buffer_size);
-                    if(attr_size > parser::event_attributes_view::static_size) file_stream.seekg(attr_size - parser::event_attributes_view::static_size, std::ios::cur);
+// Extracts the events from the payloads of `compressed` records.
+// Since events can span multiple consecutive records, an incomplete event at the end of
+// a payload is kept until the payload of the next record has been decompressed.
+class compressed_events_reader
+{
+public:
+    template<typename F>
+    void process(std::span<const std::byte> event_buffer, std::endian byte_order, F&& callback)
+    {
+        decompressor_.decompress(event_buffer.subspan(parser::event_header_view::static_size), buffer_);
 
-                    const auto attribute_view = parser::event_attributes_view(std::span(attribute_buffer).subspan(0, max_buffer_size), header.byte_order);
-                    const auto nr_ids         = common::parser::read_int<std::uint32_t>(file_stream, header.byte_order);
-                    auto       event_string   = common::parser::read_string(file_stream, header.byte_order);
+        const auto buffer = std::span<const std::byte>(buffer_);
 
-                    std::vector<std::uint64_t> ids;
-                    for(std::uint32_t id_i = 0; id_i < nr_ids; ++id_i)
-                    {
-                        ids.push_back(common::parser::read_int<std::uint64_t>(file_stream, header.byte_order));
-                    }
+        std::size_t offset = 0;
+        while(buffer.size() - offset >= parser::event_header_view::static_size)
+        {
+            const auto event_header = parser::event_header_view(buffer.subspan(offset, parser::event_header_view::static_size), byte_order);
 
-                    metadata.event_desc.push_back(perf_data_metadata::event_desc_data{
-                        .attribute    = attribute_view.instantiate(),
-                        .event_string = std::move(event_string),
-                        .ids          = std::move(ids)});
-                }
-                break;
-            }
-            // case parser::header_feature::cpu_topology:
-            // case parser::header_feature::numa_topology:
-            // case parser::header_feature::branch_stack:
-            // case parser::header_feature::pmu_mappings:
-            // case parser::header_feature::group_desc:
-            // case parser::header_feature::aux_trace:
-            // case parser::header_feature::stat:
-            // case parser::header_feature::cache:
-            case parser::header_feature::sample_time:
-                metadata.sample_time = {
-                    .start = std::chrono::nanoseconds(common::parser::read_int<std::uint64_t>(file_stream, header.byte_order)),
-                    .end   = std::chrono::nanoseconds(common::parser::read_int<std::uint64_t>(file_stream, header.byte_order))};
-                break;
-            // case parser::header_feature::mem_topology:
-            case parser::header_feature::clockid:
-                metadata.clockid = common::parser::read_int<std::uint64_t>(file_stream, header.byte_order);
-                break;
-            // case parser::header_feature::dir_format:
-            // case parser::header_feature::bpf_prog_info:
-            // case parser::header_feature::bpf_btf:
-            // case parser::header_feature::compressed:
-            // case parser::header_feature::cpu_pmu_caps:
-            // case parser::header_feature::clock_data:
-            // case parser::header_feature::hybrid_topology:
-            // case parser::header_feature::pmu_caps:
-            //     break;
-            default:
-                break;
+            if(event_header.size() < parser::event_header_view::static_size)
+            {
+                throw std::runtime_error(std::format(
+                    "Invalid compressed event in perf.data: Event size is given as {} bytes but header is at least {} bytes.",
+                    event_header.size(),
+                    parser::event_header_view::static_size));
             }
+
+            if(buffer.size() - offset < event_header.size()) break;
+
+            callback(event_header, buffer.subspan(offset, event_header.size()));
+
+            offset += event_header.size();
         }
+
+        buffer_.erase(buffer_.begin(), buffer_.begin() + common::narrow_cast<std::ptrdiff_t>(offset));
     }
-}
+
+private:
+    detail::zstd_stream_decompressor decompressor_;
+    std::vector<std::byte>           buffer_;
+};
+
+// Passes the events to the observer on the current thread. `compressed` records are
+// decompressed on the way.
+class serial_event_decoder
+{
+public:
+    serial_event_decoder(const detail::perf_data_file_header_data& header,
+                         const detail::event_attributes_database&  attributes_database,
+                         event_observer&                           callbacks) :
+        header_(&header),
+        attributes_database_(&attributes_database),
+        callbacks_(&callbacks)
+    {}
+
+    void handle(parser::event_header_view  event_header,
+                std::span<const std::byte> event_buffer)
+    {
+        if(event_header.type() == parser::event_type::compressed)
+        {
+            if(!compressed_events_) compressed_events_.emplace();
+            compressed_events_->process(event_buffer, header_->byte_order,
+                                        [this](parser::event_header_view  decompressed_event_header,
+                                               std::span<const std::byte> decompressed_event_buffer)
+                                        {
+                                            dispatch_event(*header_, *attributes_database_, *callbacks_, decompressed_event_header, decompressed_event_buffer);
+                                        });
+        }
+        else
+        {
+            dispatch_event(*header_, *attributes_database_, *callbacks_, event_header, event_buffer);
+        }
+    }
+
+private:
+    const detail::perf_data_file_header_data* header_;
+    const detail::event_attributes_database*  attributes_database_;
+    event_observer*                           callbacks_;
+
+    std::optional<compressed_events_reader> compressed_events_;
+};
 
 void read_data_section(std::ifstream&                            file_stream,
+                       std::span<const std::byte>                mapped_file_data,
                        const detail::perf_data_file_header_data& header,
                        const detail::event_attributes_database&  attributes_database,
                        event_observer&                           callbacks,
                        const common::progress_listener*          progress_listener,
                        const common::cancellation_token*         cancellation_token)
 {
+    serial_event_decoder decoder(header, attributes_database, callbacks);
+
     read_events(
         file_stream,
+        mapped_file_data,
         header,
         header.data.offset, header.data.size,
-        [&header, &attributes_database, &callbacks](parser::event_header_view  event_header,
-                                                    std::span<const std::byte> event_buffer)
+        [&decoder](parser::event_header_view  event_header,
+                   std::span<const std::byte> event_buffer)
         {
-            if(is_kernel_event(event_header.type()))
+            decoder.handle(event_header, event_buffer);
+        },
+        progress_listener,
+        cancellation_token);
+}
+
+// A bounded queue that passes chunks of events from a single producer thread to a single
+// consumer thread.
+class event_chunk_queue
+{
+public:
+    struct chunk
+    {
+        // A sequence of complete (uncompressed) events.
+        std::vector<std::byte> data;
+
+        // The number of bytes of the data section that have been read to produce this chunk.
+        std::size_t file_size = 0;
+    };
+
+    explicit event_chunk_queue(std::size_t max_size) :
+        max_size_(max_size)
+    {}
+
+    // Blocks while the queue is full. Returns `false` if the consumer has stopped.
+    bool push(chunk&& new_chunk)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_variable_.wait(lock, [this]
+                                 { return stopped_ || chunks_.size() < max_size_; });
+        if(stopped_) return false;
+
+        chunks_.push_back(std::move(new_chunk));
+        condition_variable_.notify_all();
+        return true;
+    }
+
+    // Called by the producer after the last chunk has been pushed or when it failed.
+    void finish(std::exception_ptr error = nullptr)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_ = true;
+        error_    = error;
+        condition_variable_.notify_all();
+    }
+
+    // Blocks until a chunk is available. Returns `std::nullopt` after the last chunk has been
+    // consumed and rethrows any error of the producer.
+    std::optional<chunk> pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_variable_.wait(lock, [this]
+                                 { return finished_ || !chunks_.empty(); });
+        if(chunks_.empty())
+        {
+            if(error_) std::rethrow_exception(error_);
+            return std::nullopt;
+        }
+
+        auto result = std::move(chunks_.front());
+        chunks_.pop_front();
+        condition_variable_.notify_all();
+        return result;
+    }
+
+    // Called by the consumer to make the producer stop.
+    void stop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopped_ = true;
+        condition_variable_.notify_all();
+    }
+
+private:
+    std::size_t max_size_;
+
+    std::deque<chunk> chunks_;
+
+    std::mutex              mutex_;
+    std::condition_variable condition_variable_;
+
+    bool               stopped_  = false;
+    bool               finished_ = false;
+    std::exception_ptr error_;
+};
+
+// Used for files that have been recorded with compression enabled (`perf record -z`).
+// The data section is read and decompressed on a separate thread, that passes chunks of
+// uncompressed events to the current thread. Hence, the decompression overlaps with the
+// processing of the events.
+void read_compressed_data_section(std::ifstream&                            file_stream,
+                                  std::span<const std::byte>                mapped_file_data,
+                                  const detail::perf_data_file_header_data& header,
+                                  const detail::event_attributes_database&  attributes_database,
+                                  event_observer&                           callbacks,
+                                  const common::progress_listener*          progress_listener,
+                                  const common::cancellation_token*         cancellation_token)
+{
+    common::progress_reporter progress(progress_listener, header.data.size,
+                                       "Processing events");
+
+    event_chunk_queue          queue(max_pending_chunks);
+    common::cancellation_token reader_cancellation;
+
+    std::thread reader_thread(
+        [&]()
+        {
+            try
             {
-                const auto& event_attributes = attributes_database.get_event_attributes(header.byte_order, event_header.type(), event_buffer.subspan(parser::event_header_view::static_size));
-                callbacks.handle(event_header, event_attributes, event_buffer, header.byte_order);
+                compressed_events_reader compressed_events;
+                event_chunk_queue::chunk current_chunk;
+
+                const auto append_event = [&current_chunk](parser::event_header_view /*event_header*/,
+                                                           std::span<const std::byte> event_buffer)
+                {
+                    current_chunk.data.insert(current_chunk.data.end(), event_buffer.begin(), event_buffer.end());
+                };
+
+                read_events(
+                    file_stream,
+                    mapped_file_data,
+                    header,
+                    header.data.offset, header.data.size,
+                    [&](parser::event_header_view  event_header,
+                        std::span<const std::byte> event_buffer)
+                    {
+                        if(event_header.type() == parser::event_type::compressed)
+                        {
+                            compressed_events.process(event_buffer, header.byte_order, append_event);
+                        }
+                        else
+                        {
+                            append_event(event_header, event_buffer);
+                        }
+                        current_chunk.file_size += event_buffer.size();
+
+                        if(current_chunk.data.size() >= min_chunk_size)
+                        {
+                            if(!queue.push(std::exchange(current_chunk, {}))) reader_cancellation.cancel();
+                        }
+                    },
+                    nullptr,
+                    &reader_cancellation);
+
+                if(!reader_cancellation.is_canceled()) queue.push(std::move(current_chunk));
+                queue.finish();
             }
-            else
+            catch(...)
+            {
+                queue.finish(std::current_exception());
+            }
+        });
+
+    // Make sure the reader thread is always stopped and joined, even if processing an event throws.
+    struct reader_thread_joiner
+    {
+        event_chunk_queue& queue;
+        std::thread&       thread;
+
+        ~reader_thread_joiner()
+        {
+            queue.stop();
+            thread.join();
+        }
+    };
+    const auto joiner = reader_thread_joiner{queue, reader_thread};
+
+    while(auto chunk = queue.pop())
+    {
+        if(cancellation_token && cancellation_token->is_canceled()) return;
+
+        auto reader = common::span_reader(chunk->data, 0, chunk->data.size());
+        read_events(
+            reader,
+            header,
+            chunk->data.size(),
+            [&header, &attributes_database, &callbacks](parser::event_header_view  event_header,
+                                                        std::span<const std::byte> event_buffer)
+            {
+                dispatch_event(header, attributes_database, callbacks, event_header, event_buffer);
+            },
+            nullptr,
+            nullptr);
+
+        progress.progress(chunk->file_size);
+    }
+
+    progress.finish();
+}
+
+struct pending_batch
+{
+    // If the file is memory mapped and the batch does not contain any decompressed events,
+    // `data` points directly into the mapping. Otherwise all events are copied to `storage`.
+    std::vector<std::byte>     storage;
+    std::span<const std::byte> data;
+    bool                       owns_data;
+
+    // The number of bytes of the data section that have been read for this batch.
+    std::size_t file_size = 0;
+
+    std::unique_ptr<event_batch> observer;
+
+    std::future<void> decoded;
+};
+
+// Splits a sequence of events into batches and decodes them in parallel. The current thread passes
+// in the events and they are cut into batches, while the batches are decoded on worker threads. Once the
+// maximum number of batches is in flight, the current thread waits for the oldest batch and finishes
+// it, so that all batches are finished in file order.
+// `compressed` records are decompressed on the current thread, since the payloads of all records
+// form a single compressed stream.
+class parallel_event_decoder
+{
+public:
+    // If `is_mapped` is set, all events passed to `handle` are expected to point into the mapped file.
+    parallel_event_decoder(const detail::perf_data_file_header_data& header,
+                           const detail::event_attributes_database&  attributes_database,
+                           batched_event_observer&                   callbacks,
+                           bool                                      is_mapped,
+                           common::progress_reporter*                progress) :
+        header_(&header),
+        attributes_database_(&attributes_database),
+        callbacks_(&callbacks),
+        is_mapped_(is_mapped),
+        progress_(progress),
+        max_pending_count_(2 * worker_count()),
+        decoding_workers_(worker_count())
+    {}
+
+    void handle(parser::event_header_view  event_header,
+                std::span<const std::byte> event_buffer)
+    {
+        if(current_batch_ == nullptr)
+        {
+            current_batch_            = std::make_unique<pending_batch>();
+            current_batch_->owns_data = !is_mapped_;
+            current_batch_->observer  = callbacks_->create_batch();
+        }
+
+        if(event_header.type() == parser::event_type::compressed)
+        {
+            if(!compressed_events_) compressed_events_.emplace();
+            compressed_events_->process(event_buffer, header_->byte_order,
+                                        [this](parser::event_header_view /*event_header*/,
+                                               std::span<const std::byte> decompressed_event_buffer)
+                                        {
+                                            append_event(decompressed_event_buffer, false);
+                                        });
+        }
+        else
+        {
+            append_event(event_buffer, is_mapped_);
+        }
+        current_batch_->file_size += event_buffer.size();
+
+        const auto batch_size = current_batch_->owns_data ? current_batch_->storage.size() : current_batch_->data.size();
+
+        if((event_header.type() == parser::event_type::finished_round && batch_size >= min_batch_size) ||
+           batch_size >= max_batch_size)
+        {
+            submit_current_batch();
+        }
+    }
+
+    // Decodes and finishes all events that have been passed to `handle` so far.
+    // Returns `false` if the processing has been canceled.
+    bool finish(const common::cancellation_token* cancellation_token)
+    {
+        submit_current_batch();
+
+        while(!pending_batches_.empty())
+        {
+            if(cancellation_token && cancellation_token->is_canceled()) return false;
+
+            finish_oldest_batch();
+        }
+        return true;
+    }
+
+private:
+    static std::size_t worker_count()
+    {
+        return std::max(std::size_t(std::thread::hardware_concurrency()), std::size_t(2)) - 1;
+    }
+
+    // `is_file_view` is true if `event_buffer` points into the mapped file.
+    void append_event(std::span<const std::byte> event_buffer, bool is_file_view)
+    {
+        auto& batch = *current_batch_;
+        if(is_file_view && !batch.owns_data)
+        {
+            // All events are views into the mapped file, hence consecutive events are contiguous.
+            assert(batch.data.empty() || batch.data.data() + batch.data.size() == event_buffer.data());
+            batch.data = std::span(batch.data.empty() ? event_buffer.data() : batch.data.data(),
+                                   batch.data.size() + event_buffer.size());
+        }
+        else
+        {
+            if(!batch.owns_data)
             {
-                callbacks.handle(event_header, event_buffer, header.byte_order);
+                batch.storage.assign(batch.data.begin(), batch.data.end());
+                batch.data      = {};
+                batch.owns_data = true;
             }
+            batch.storage.insert(batch.storage.end(), event_buffer.begin(), event_buffer.end());
+        }
+    }
+
+    void finish_oldest_batch()
+    {
+        auto batch = std::move(pending_batches_.front());
+        pending_batches_.pop_front();
+
+        batch->decoded.get(); // will rethrow any decoding errors
+        batch->observer->finish();
+
+        if(progress_ != nullptr) progress_->progress(batch->file_size);
+    }
+
+    void submit_current_batch()
+    {
+        if(current_batch_ == nullptr) return;
+
+        auto batch = std::move(current_batch_);
+        if(batch->owns_data) batch->data = batch->storage;
+
+        auto decoded_promise = std::make_shared<std::promise<void>>();
+        batch->decoded       = decoded_promise->get_future();
+
+        decoding_workers_.submit(
+            [batch = batch.get(), decoded_promise, &header = *header_, &attributes_database = *attributes_database_]()
+            {
+                try
+                {
+                    auto reader = common::span_reader(batch->data, 0, batch->data.size());
+                    read_events(
+                        reader,
+                        header,
+                        batch->data.size(),
+                        [batch, &header, &attributes_database](parser::event_header_view  event_header,
+                                                               std::span<const std::byte> event_buffer)
+                        {
+                            dispatch_event(header, attributes_database, *batch->observer, event_header, event_buffer);
+                        },
+                        nullptr,
+                        nullptr);
+                    decoded_promise->set_value();
+                }
+                catch(...)
+                {
+                    decoded_promise->set_exception(std::current_exception());
+                }
+            });
+
+        pending_batches_.push_back(std::move(batch));
+
+        if(pending_batches_.size() >= max_pending_count_) finish_oldest_batch();
+    }
+
+    const detail::perf_data_file_header_data* header_;
+    const detail::event_attributes_database*  attributes_database_;
+    batched_event_observer*                   callbacks_;
+    bool                                      is_mapped_;
+    common::progress_reporter*                progress_;
+
+    std::size_t max_pending_count_;
+
+    std::deque<std::unique_ptr<pending_batch>> pending_batches_;
+
+    // ATTENTION: This needs to be declared after `pending_batches_`, so that all pending
+    //            decoding tasks are finished before any batch is destroyed.
+    common::thread_pool decoding_workers_;
+
+    std::unique_ptr<pending_batch> current_batch_;
+
+    std::optional<compressed_events_reader> compressed_events_;
+};
+
+void read_data_section_parallel(std::ifstream&                            file_stream,
+                                std::span<const std::byte>                mapped_file_data,
+                                const detail::perf_data_file_header_data& header,
+                                const detail::event_attributes_database&  attributes_database,
+                                batched_event_observer&                   callbacks,
+                                const common::progress_listener*          progress_listener,
+                                const common::cancellation_token*         cancellation_token)
+{
+    common::progress_reporter progress(progress_listener, header.data.size,
+                                       "Processing events");
+
+    parallel_event_decoder decoder(header, attributes_database, callbacks, !mapped_file_data.empty(), &progress);
+
+    read_events(
+        file_stream,
+        mapped_file_data,
+        header,
+        header.data.offset, header.data.size,
+        [&decoder](parser::event_header_view  event_header,
+                   std::span<const std::byte> event_buffer)
+        {
+            decoder.handle(event_header, event_buffer);
         },
-        progress_listener,
+        nullptr,
         cancellation_token);
+
+    if(cancellation_token && cancellation_token->is_canceled()) return;
+
+    if(!decoder.finish(cancellation_token)) return;
+
+    progress.finish();
+}
+
+// Reads the events of a file in pipe mode (e.g. written by `perf record -o -`). Such a file
+// consists of a minimal header followed by a stream of events that is read sequentially until
+// its end, without seeking. The attributes, build IDs and header features that are stored in
+// dedicated sections of regular files are part of this stream, and are collected here.
+// `before_attributes_change` is called before `attributes_database` is modified.
+template<typename F, typename G>
+void read_pipe_events(std::istream&                             stream,
+                      const detail::perf_data_file_header_data& header,
+                      perf_data_metadata&                       metadata,
+                      detail::event_attributes_database&        attributes_database,
+                      F&&                                       callback,
+                      G&&                                       before_attributes_change,
+                      const common::cancellation_token*         cancellation_token)
+{
+    const auto read_exactly = [&stream](std::byte* data, std::size_t size)
+    {
+        stream.read(reinterpret_cast<char*>(data), common::narrow_cast<std::streamsize>(size));
+        return stream.gcount() == common::narrow_cast<std::streamsize>(size);
+    };
+
+    const auto skip_exactly = [&stream](std::uint64_t size)
+    {
+        stream.ignore(common::narrow_cast<std::streamsize>(size));
+        if(stream.gcount() != common::narrow_cast<std::streamsize>(size))
+        {
+            throw std::runtime_error("Invalid perf.data stream: unexpected end of stream.");
+        }
+    };
+
+    std::vector<std::byte> event_buffer(parser::event_header_view::static_size);
+
+    while(true)
+    {
+        if(cancellation_token && cancellation_token->is_canceled()) return;
+
+        event_buffer.resize(parser::event_header_view::static_size);
+        if(!read_exactly(event_buffer.data(), event_buffer.size()))
+        {
+            if(stream.gcount() == 0) break; // regular end of the stream
+
+            throw std::runtime_error("Invalid perf.data stream: unexpected end of stream.");
+        }
+
+        const auto event_size = parser::event_header_view(event_buffer, header.byte_order).size();
+        if(event_size < parser::event_header_view::static_size)
+        {
+            throw std::runtime_error(std::format(
+                "Invalid perf.data stream: Event size is given as {} bytes but header is at least {} bytes.",
+                event_size,
+                parser::event_header_view::static_size));
+        }
+
+        event_buffer.resize(event_size);
+        if(!read_exactly(event_buffer.data() + parser::event_header_view::static_size, event_size - parser::event_header_view::static_size))
+        {
+            throw std::runtime_error("Invalid perf.data stream: unexpected end of stream.");
+        }
+
+        const auto event_header = parser::event_header_view(std::span(event_buffer).subspan(0, parser::event_header_view::static_size), header.byte_order);
+
+        switch(event_header.type())
+        {
+        case parser::event_type::header_attr:
+        {
+            const auto event = parser::header_attr_event_view(event_buffer, header.byte_order);
+
+            std::vector<std::uint64_t> ids;
+            ids.reserve(event.ids_count());
+            for(std::size_t id_index = 0; id_index < event.ids_count(); ++id_index)
+            {
+                ids.push_back(event.id(id_index));
+            }
+
+            before_attributes_change();
+
+            // The attributes are appended without rebuilding the database, since the events decoded so
+            // far might still refer to the existing attributes.
+            auto attributes = event.attributes().instantiate();
+            attributes_database.add(attributes, ids);
+
+            // The attributes are kept as event descriptions, so that the names from later
+            // `event_update` records can be attached to them.
+            metadata.event_desc.push_back(perf_data_metadata::event_desc_data{
+                .attribute    = std::move(attributes),
+                .event_string = {},
+                .ids          = std::move(ids)});
+            break;
+        }
+        case parser::event_type::event_update:
+        {
+            const auto event = parser::event_update_event_view(event_buffer, header.byte_order);
+            if(event.type() != parser::event_update_type::name) break;
+
+            for(auto& event_desc : metadata.event_desc)
+            {
+                if(std::ranges::find(event_desc.ids, event.id()) == event_desc.ids.end()) continue;
+                event_desc.event_string = event.name();
+                break;
+            }
+            break;
+        }
+        case parser::event_type::header_feature:
+        {
+            const auto event = parser::header_feature_event_view(event_buffer, header.byte_order);
+
+            // The event descriptions are built from the `header_attr` records instead.
+            if(event.feature() == parser::header_feature::event_desc) break;
+
+            const auto data           = event.data();
+            auto       feature_stream = std::ispanstream(std::span(reinterpret_cast<const char*>(data.data()), data.size()));
+            read_feature(feature_stream, header.byte_order, event.feature(), metadata);
+            break;
+        }
+        case parser::event_type::header_build_id:
+            add_build_id(metadata, event_buffer, header.byte_order);
+            break;
+        case parser::event_type::header_tracing_data:
+        {
+            // The tracing data follows the record, padded to 8 bytes.
+            const auto tracing_data_size = common::parser::extract<std::uint32_t>(event_buffer, parser::event_header_view::static_size, header.byte_order);
+            skip_exactly((std::uint64_t(tracing_data_size) + 7) / 8 * 8);
+            break;
+        }
+        case parser::event_type::auxtrace:
+        {
+            // The AUX area data follows the record.
+            skip_exactly(common::parser::extract<std::uint64_t>(event_buffer, parser::event_header_view::static_size, header.byte_order));
+            break;
+        }
+        default:
+            if(parser::is_kernel_event(event_header.type()) && attributes_database.all_attributes.empty())
+            {
+                throw std::runtime_error("Invalid perf.data stream: missing event attributes before the first event.");
+            }
+            break;
+        }
+
+        callback(event_header, std::span<const std::byte>(event_buffer));
+    }
+}
+
+void read_pipe_data(std::istream&                             stream,
+                    const detail::perf_data_file_header_data& header,
+                    perf_data_metadata&                       metadata,
+                    detail::event_attributes_database&        attributes_database,
+                    event_observer&                           callbacks,
+                    const common::progress_listener*          progress_listener,
+                    const common::cancellation_token*         cancellation_token)
+{
+    // The total size of a stream is unknown, hence we can only report start and end.
+    common::progress_reporter progress(progress_listener, 0,
+                                       "Processing events");
+
+    serial_event_decoder decoder(header, attributes_database, callbacks);
+
+    read_pipe_events(
+        stream,
+        header,
+        metadata,
+        attributes_database,
+        [&decoder](parser::event_header_view  event_header,
+                   std::span<const std::byte> event_buffer)
+        {
+            decoder.handle(event_header, event_buffer);
+        },
+        []() {},
+        cancellation_token);
+
+    if(cancellation_token && cancellation_token->is_canceled()) return;
+
+    progress.finish();
+}
+
+void read_pipe_data_parallel(std::istream&                             stream,
+                             const detail::perf_data_file_header_data& header,
+                             perf_data_metadata&                       metadata,
+                             detail::event_attributes_database&        attributes_database,
+                             batched_event_observer&                   callbacks,
+                             const common::progress_listener*          progress_listener,
+                             const common::cancellation_token*         cancellation_token)
+{
+    // The total size of a stream is unknown, hence we can only report start and end.
+    common::progress_reporter progress(progress_listener, 0,
+                                       "Processing events");
+
+    parallel_event_decoder decoder(header, attributes_database, callbacks, false, nullptr);
+
+    read_pipe_events(
+        stream,
+        header,
+        metadata,
+        attributes_database,
+        [&decoder](parser::event_header_view  event_header,
+                   std::span<const std::byte> event_buffer)
+        {
+            decoder.handle(event_header, event_buffer);
+        },
+        [&decoder]()
+        {
+            // The batches in flight are decoded with the current attributes. perf writes all
+            // attributes at the start of the stream, hence this does usually not stall anything.
+            decoder.finish(nullptr);
+        },
+        cancellation_token);
+
+    if(cancellation_token && cancellation_token->is_canceled()) return;
+
+    if(!decoder.finish(cancellation_token)) return;
+
+    progress.finish();
 }
 
 } // namespace
 
-perf_data_file::perf_data_file(const std::filesystem::path& file_path)
+perf_data_file::perf_data_file(const std::filesystem::path& file_path, bool use_memory_map)
 {
-    open(file_path);
+    open(file_path, use_memory_map);
 }
 
-void perf_data_file::open(const std::filesystem::path& file_path)
+void perf_data_file::open(const std::filesystem::path& file_path, bool use_memory_map)
 {
     file_stream_.open(file_path, std::ios_base::binary);
 
@@ -364,16 +1154,20 @@ void perf_data_file::open(const std::filesystem::path& file_path)
     }
 
     std::array<std::byte, parser::header_view::static_size> file_buffer_data;
-    file_stream_.read(reinterpret_cast<char*>(file_buffer_data.data()), file_buffer_data.size());
 
-    const auto read_bytes = file_stream_.tellg() - std::streampos(0);
+    // The file might be a pipe, hence we only read the part of the header that is common to
+    // the regular and the pipe mode first, and we do not use the stream position.
+    constexpr std::size_t pipe_header_size = 16;
+
+    file_stream_.read(reinterpret_cast<char*>(file_buffer_data.data()), pipe_header_size);
 
-    if(read_bytes < static_cast<std::streamoff>(parser::header_view::static_size))
+    if(file_stream_.gcount() < static_cast<std::streamsize>(pipe_header_size))
     {
+        const auto read_bytes = file_stream_.gcount();
         close();
         throw std::runtime_error(std::format(
             "Invalid perf.data file: insufficient size for header. Expected {} but read only {}.",
-            parser::header_view::static_size,
+            pipe_header_size,
             read_bytes));
     }
 
@@ -406,18 +1200,51 @@ void perf_data_file::open(const std::filesystem::path& file_path)
                                      std::endian::native :
                                      non_native_byte_order;
 
-    const auto header = parser::header_view(file_buffer, file_byte_order);
-    assert(header.magic() == magic_v2);
+    const auto header_size = common::parser::extract<std::uint64_t>(file_buffer, 8, file_byte_order);
+
+    if(header_size == pipe_header_size)
+    {
+        header_ = std::make_unique<detail::perf_data_file_header_data>(detail::perf_data_file_header_data{
+            .byte_order          = file_byte_order,
+            .size                = header_size,
+            .attribute_size      = 0,
+            .attributes          = {},
+            .data                = {},
+            .event_types         = {},
+            .additional_features = {},
+            .is_pipe_mode        = true});
+        return;
+    }
 
-    if(header.size() != parser::header_view::static_size)
+    if(header_size != parser::header_view::static_size)
     {
         close();
         throw std::runtime_error(std::format(
-            "Invalid perf.data file: Invalid header size.\n  Expected {} but got {}.",
+            "Invalid perf.data file: Invalid header size.\n  Expected {} (or {} in pipe mode) but got {}.",
             parser::header_view::static_size,
-            header.size()));
+            pipe_header_size,
+            header_size));
     }
 
+    file_stream_.read(reinterpret_cast<char*>(file_buffer_data.data() + pipe_header_size), parser::header_view::static_size - pipe_header_size);
+
+    if(file_stream_.gcount() < static_cast<std::streamsize>(parser::header_view::static_size - pipe_header_size))
+    {
+        const auto read_bytes = pipe_header_size + file_stream_.gcount();
+        close();
+        throw std::runtime_error(std::format(
+            "Invalid perf.data file: insufficient size for header. Expected {} but read only {}.",
+            parser::header_view::static_size,
+            read_bytes));
+    }
+
+    const auto header = parser::header_view(file_buffer, file_byte_order);
+    assert(header.magic() == magic_v2);
+    assert(header.size() == parser::header_view::static_size);
+
+    // If the file can not be mapped, we will just fall back to reading all data through the file stream.
+    if(use_memory_map) mapped_file_.open(file_path);
+
     header_ = std::make_unique<detail::perf_data_file_header_data>(detail::perf_data_file_header_data{
         .byte_order     = file_byte_order,
         .size           = header.size(),
@@ -434,7 +1261,8 @@ void perf_data_file::open(const std::filesystem::path& file_path)
                                                                            .offset = header.event_types().offset(),
                                                                            .size   = header.event_types().size(),
                                                                            },
-        .additional_features = header.additional_features()
+        .additional_features = header.additional_features(),
+        .is_pipe_mode        = false
     });
 }
 
@@ -443,12 +1271,55 @@ perf_data_file::~perf_data_file() = default;
 void perf_data_file::close()
 {
     file_stream_.close();
-    header_ = nullptr;
+    mapped_file_.close();
+    header_          = nullptr;
+    stream_consumed_ = false;
 }
 
 void perf_data_file::process(event_observer&                   callbacks,
                              const common::progress_listener*  progress_listener,
                              const common::cancellation_token* cancellation_token)
+{
+    detail::event_attributes_database attributes_database;
+    prepare_processing(attributes_database);
+
+    if(header_->is_pipe_mode)
+    {
+        read_pipe_data(file_stream_, *header_, *metadata_, attributes_database, callbacks, progress_listener, cancellation_token);
+        return;
+    }
+
+    if(metadata_->compressed)
+    {
+        read_compressed_data_section(file_stream_, mapped_file_.data(), *header_, attributes_database, callbacks, progress_listener, cancellation_token);
+    }
+    else
+    {
+        read_data_section(file_stream_, mapped_file_.data(), *header_, attributes_database, callbacks, progress_listener, cancellation_token);
+    }
+
+    read_event_types_section(file_stream_, *header_);
+}
+
+void perf_data_file::process_parallel(batched_event_observer&           callbacks,
+                                      const common::progress_listener*  progress_listener,
+                                      const common::cancellation_token* cancellation_token)
+{
+    detail::event_attributes_database attributes_database;
+    prepare_processing(attributes_database);
+
+    if(header_->is_pipe_mode)
+    {
+        read_pipe_data_parallel(file_stream_, *header_, *metadata_, attributes_database, callbacks, progress_listener, cancellation_token);
+        return;
+    }
+
+    read_data_section_parallel(file_stream_, mapped_file_.data(), *header_, attributes_database, callbacks, progress_listener, cancellation_token);
+
+    read_event_types_section(file_stream_, *header_);
+}
+
+void perf_data_file::prepare_processing(detail::event_attributes_database& attributes_database)
 {
     if(!file_stream_.is_open())
     {
@@ -460,24 +1331,44 @@ void perf_data_file::process(event_observer&                   callbacks,
         throw std::runtime_error("Cannot process file: missing header data.");
     }
 
-    detail::event_attributes_database attributes_database;
+    metadata_ = std::make_unique<perf_data_metadata>();
+
+    // In pipe mode, all information is collected while reading the stream of events.
+    // Since the stream can not be rewound, it can only be processed once.
+    if(header_->is_pipe_mode)
+    {
+        if(stream_consumed_) throw std::runtime_error("Cannot process file: a stream in pipe mode can only be processed once.");
+        stream_consumed_ = true;
+        return;
+    }
 
     if(!header_->additional_features.test(parser::header_feature::event_desc))
     {
         read_attributes_section(file_stream_, *header_, attributes_database);
     }
 
-    metadata_ = std::make_unique<perf_data_metadata>();
-    read_metadata(file_stream_, *header_, *metadata_);
+    read_metadata(file_stream_, mapped_file_.data(), *header_, *metadata_);
 
     if(header_->additional_features.test(parser::header_feature::event_desc))
     {
         metadata_->extract_event_attributes_database(attributes_database);
     }
 
-    read_data_section(file_stream_, *header_, attributes_database, callbacks, progress_listener, cancellation_token);
+    if(metadata_->compressed && metadata_->compressed->type != zstd_compression_type)
+    {
+        throw std::runtime_error(std::format("Cannot process file: unsupported compression type {}.", metadata_->compressed->type));
+    }
+}
 
-    read_event_types_section(file_stream_, *header_);
+bool perf_data_file::is_pipe_mode() const
+{
+    assert(header_ != nullptr);
+    return header_->is_pipe_mode;
+}
+
+bool perf_data_file::is_memory_mapped() const
+{
+    return mapped_file_.is_open();
 }
 
 const perf_data_metadata& perf_data_file::metadata() const
@@ -4,8 +4,10 @@
 #include <bit>
 #include <filesystem>
 #include <fstream>
+#include <memory>
 #include <span>
 
+#include <snail/common/memory_mapped_file.hpp>
 #include <snail/common/progress.hpp>
 
 namespace snail::perf_data {
@@ -20,22 +22,28 @@ struct event_attributes;
 namespace detail {
 
 struct perf_data_file_header_data;
+struct event_attributes_database;
 
 } // namespace detail
 
 struct perf_data_metadata;
 
 class event_observer;
+class batched_event_observer;
 
 class perf_data_file
 {
 public:
     perf_data_file() = default;
-    explicit perf_data_file(const std::filesystem::path& file_path);
+    explicit perf_data_file(const std::filesystem::path& file_path, bool use_memory_map = true);
 
     ~perf_data_file();
 
-    void open(const std::filesystem::path& file_path);
+    // If `use_memory_map` is set, events will be read directly from a memory mapping
+    // of the file whenever the file can be mapped.
+    // The file can also be a pipe (e.g. `/dev/stdin`) that delivers a perf.data stream
+    // in pipe mode (see `is_pipe_mode`).
+    void open(const std::filesystem::path& file_path, bool use_memory_map = true);
 
     void close();
 
@@ -43,13 +51,32 @@ public:
                  const common::progress_listener*  progress_listener  = nullptr,
                  const common::cancellation_token* cancellation_token = nullptr);
 
+    // Same as `process`, but the events are decoded in parallel on a pool of worker threads.
+    // See `batched_event_observer` for details.
+    void process_parallel(batched_event_observer&           callbacks,
+                          const common::progress_listener*  progress_listener  = nullptr,
+                          const common::cancellation_token* cancellation_token = nullptr);
+
+    // Whether the file has been written in pipe mode (e.g. by `perf record -o -`). In pipe mode,
+    // the events are read sequentially as a stream and the metadata is collected from the
+    // events on the way, hence it is only complete after processing. Such a file can only
+    // be processed once.
+    bool is_pipe_mode() const;
+
+    bool is_memory_mapped() const;
+
     const perf_data_metadata& metadata() const;
 
 private:
-    std::ifstream file_stream_;
+    void prepare_processing(detail::event_attributes_database& attributes_database);
+
+    std::ifstream              file_stream_;
+    common::memory_mapped_file mapped_file_;
 
     std::unique_ptr<detail::perf_data_file_header_data> header_;
     std::unique_ptr<perf_data_metadata>                 metadata_;
+
+    bool stream_consumed_ = false;
 };
 
 class event_observer
@@ -61,4 +88,29 @@ public:
     virtual void handle(const parser::event_header_view& /*event_header*/, std::span<const std::byte> /*event_data*/, std::endian /*byte_order*/) {}
 };
 
+// Receives the events of a single batch of the data section.
+// The events are passed to the `handle` functions on a worker thread, hence a batch should only
+// collect the events in some intermediate form. `finish` is called afterwards on the thread that
+// is processing the file, in the same order as the batches appear in the file.
+// The event data passed to `handle` stays valid until `finish` has returned.
+class event_batch : public event_observer
+{
+public:
+    virtual void finish() = 0;
+};
+
+// Observer for `perf_data_file::process_parallel`.
+//
+// The data section is split into batches at `finished_round` records. perf writes such a record
+// whenever it has flushed all its per-CPU buffers, hence the events between two of them form
+// an independent unit. Every batch is decoded into its own `event_batch` that is created
+// by `create_batch` on the thread that is processing the file.
+class batched_event_observer
+{
+public:
+    virtual ~batched_event_observer() = default;
+
+    virtual std::unique_ptr<event_batch> create_batch() = 0;
+};
+
 } // namespace snail::perf_data
@@ -0,0 +1,508 @@
+
+#include <snail/perf_data/perf_data_writer.hpp>
+
+#include <cassert>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <snail/common/cast.hpp>
+
+#include <snail/perf_data/parser/event.hpp>
+#include <snail/perf_data/parser/event_attributes.hpp>
+#include <snail/perf_data/parser/header.hpp>
+#include <snail/perf_data/parser/header_feature.hpp>
+#include <snail/perf_data/parser/records/perf.hpp>
+
+#include <snail/perf_data/detail/zstd_stream.hpp>
+
+using namespace snail;
+using namespace snail::perf_data;
+
+namespace {
+
+// "PERFILE2" encoded as 64-bit integer.
+constexpr std::uint64_t magic_v2 = 0x3245'4c49'4652'4550ULL;
+
+// Size of `perf_event_attr` up to (and including) `config3` (PERF_ATTR_SIZE_VER8).
+constexpr std::size_t attribute_size = 136;
+
+// A `perf_file_attr`: the attributes followed by a file section for the attribute IDs.
+constexpr std::size_t file_attribute_size = attribute_size + parser::file_section_view::static_size;
+
+constexpr std::uint64_t attributes_offset = parser::header_view::static_size;
+constexpr std::uint64_t data_offset       = attributes_offset + file_attribute_size;
+
+// PERF_COUNT_SW_CPU_CLOCK
+constexpr std::uint32_t counter_type   = parser::attribute_type::software;
+constexpr std::uint64_t counter_config = 0;
+
+constexpr auto features = std::array{
+    parser::header_feature::hostname,
+    parser::header_feature::osrelease,
+    parser::header_feature::arch,
+    parser::header_feature::nr_cpus,
+    parser::header_feature::cmdline,
+    parser::header_feature::event_desc,
+    parser::header_feature::sample_time};
+
+// Events are collected up to this size before they are compressed. Just like perf does with
+// the ring buffer size, this is stored as `mmap_len` in the compression header feature.
+constexpr std::size_t compression_buffer_size = 512 * 1024;
+
+// The size of a `compressed` record is stored in the 16-bit size field of the event header.
+constexpr std::size_t max_compressed_payload_size = std::numeric_limits<std::uint16_t>::max() - parser::event_header_view::static_size;
+
+// PERF_COMP_ZSTD
+constexpr std::uint32_t zstd_compression_type = 1;
+
+// In pipe mode, the header consists of the magic and its size only.
+constexpr std::uint64_t pipe_header_size = 16;
+
+// In pipe mode, the name of the event is attached to the attributes by this ID.
+constexpr std::uint64_t pipe_event_id = 1;
+
+template<typename T>
+    requires std::is_integral_v<T>
+void append(std::vector<std::byte>& buffer, T value)
+{
+    const auto offset = buffer.size();
+    buffer.resize(offset + sizeof(T));
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+template<typename T>
+    requires std::is_integral_v<T>
+void write_at(std::vector<std::byte>& buffer, std::size_t offset, T value)
+{
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+// Appends the string null terminated and padded to the given alignment.
+void append_padded(std::vector<std::byte>& buffer, std::string_view value, std::size_t alignment)
+{
+    const auto padded_size = (value.size() + 1 + alignment - 1) / alignment * alignment;
+
+    const auto offset = buffer.size();
+    buffer.resize(offset + padded_size, std::byte{});
+    std::memcpy(buffer.data() + offset, value.data(), value.size());
+}
+
+// Appends a string as it is stored in the header features: a 32-bit length
+// followed by the null terminated string, padded to 64 bytes.
+void append_string(std::vector<std::byte>& buffer, std::string_view value)
+{
+    constexpr std::size_t alignment = 64;
+
+    append(buffer, common::narrow_cast<std::uint32_t>((value.size() + 1 + alignment - 1) / alignment * alignment));
+    append_padded(buffer, value, alignment);
+}
+
+void append_attributes(std::vector<std::byte>& buffer, const perf_data_writer::options& options)
+{
+    parser::sample_format_flags sample_format;
+    sample_format.set(parser::sample_format::ip);
+    sample_format.set(parser::sample_format::tid);
+    sample_format.set(parser::sample_format::time);
+    sample_format.set(parser::sample_format::call_chain);
+    sample_format.set(parser::sample_format::period);
+
+    parser::attribute_flags flags;
+    flags.set(parser::attribute_flag::inherit);
+    flags.set(parser::attribute_flag::mmap);
+    flags.set(parser::attribute_flag::comm);
+    flags.set(parser::attribute_flag::task);
+    flags.set(parser::attribute_flag::sample_id_all);
+    flags.set(parser::attribute_flag::mmap2);
+
+    const auto offset = buffer.size();
+    buffer.resize(offset + attribute_size, std::byte{});
+
+    write_at(buffer, offset + 0, counter_type);
+    write_at(buffer, offset + 4, common::narrow_cast<std::uint32_t>(attribute_size));
+    write_at(buffer, offset + 8, counter_config);
+    write_at(buffer, offset + 16, options.sample_period);
+    write_at(buffer, offset + 24, static_cast<std::uint64_t>(sample_format.data().to_ullong()));
+    write_at(buffer, offset + 40, static_cast<std::uint64_t>(flags.data().to_ullong()));
+}
+
+} // namespace
+
+perf_data_writer::perf_data_writer(const std::filesystem::path& file_path, options options) :
+    options_(std::move(options)),
+    data_offset_(data_offset),
+    data_size_(0),
+    first_time_(std::numeric_limits<std::uint64_t>::max()),
+    last_time_(std::numeric_limits<std::uint64_t>::min()),
+    uncompressed_size_(0),
+    compressed_size_(0)
+{
+    file_stream_.open(file_path, std::ios_base::binary | std::ios_base::trunc);
+
+    if(!file_stream_.is_open())
+    {
+        throw std::runtime_error(std::format("Could not open file {}", file_path.string()));
+    }
+
+    if(options_.compression_level)
+    {
+        compressor_ = std::make_unique<detail::zstd_stream_compressor>(*options_.compression_level);
+    }
+
+    if(options_.pipe_mode)
+    {
+        write_pipe_header();
+        return;
+    }
+
+    // The header is written when finishing the file, but the attributes are known already.
+    std::vector<std::byte> buffer(parser::header_view::static_size, std::byte{});
+    append_attributes(buffer, options_);
+    append(buffer, std::uint64_t(0)); // ids.offset
+    append(buffer, std::uint64_t(0)); // ids.size
+
+    assert(buffer.size() == data_offset_);
+    file_stream_.write(reinterpret_cast<const char*>(buffer.data()), common::narrow_cast<std::streamsize>(buffer.size()));
+}
+
+perf_data_writer::~perf_data_writer() = default;
+
+void perf_data_writer::write_comm(std::uint64_t    time,
+                                  std::uint32_t    pid,
+                                  std::uint32_t    tid,
+                                  std::string_view comm)
+{
+    begin_event(std::to_underlying(parser::event_type::comm), 0);
+    append(event_buffer_, pid);
+    append(event_buffer_, tid);
+    append_padded(event_buffer_, comm, 8);
+    end_event(pid, tid, time);
+}
+
+void perf_data_writer::write_fork(std::uint64_t time,
+                                  std::uint32_t pid,
+                                  std::uint32_t ppid,
+                                  std::uint32_t tid,
+                                  std::uint32_t ptid)
+{
+    begin_event(std::to_underlying(parser::event_type::fork), 0);
+    append(event_buffer_, pid);
+    append(event_buffer_, ppid);
+    append(event_buffer_, tid);
+    append(event_buffer_, ptid);
+    append(event_buffer_, time);
+    end_event(pid, tid, time);
+}
+
+void perf_data_writer::write_mmap2(std::uint64_t    time,
+                                   std::uint32_t    pid,
+                                   std::uint32_t    tid,
+                                   std::uint64_t    address,
+                                   std::uint64_t    length,
+                                   std::uint64_t    page_offset,
+                                   std::string_view filename)
+{
+    begin_event(std::to_underlying(parser::event_type::mmap2), std::to_underlying(parser::header_misc_mask::user));
+    append(event_buffer_, pid);
+    append(event_buffer_, tid);
+    append(event_buffer_, address);
+    append(event_buffer_, length);
+    append(event_buffer_, page_offset);
+    event_buffer_.resize(event_buffer_.size() + 24, std::byte{}); // maj, min, ino, ino_generation
+    append(event_buffer_, std::uint32_t(5));                     // prot: PROT_READ | PROT_EXEC
+    append(event_buffer_, std::uint32_t(2));                     // flags: MAP_PRIVATE
+    append_padded(event_buffer_, filename, 8);
+    end_event(pid, tid, time);
+}
+
+void perf_data_writer::write_sample(std::uint64_t                  time,
+                                    std::uint32_t                  pid,
+                                    std::uint32_t                  tid,
+                                    std::uint64_t                  instruction_pointer,
+                                    std::span<const std::uint64_t> callchain)
+{
+    begin_event(std::to_underlying(parser::event_type::sample), std::to_underlying(parser::header_misc_mask::user));
+    append(event_buffer_, instruction_pointer);
+    append(event_buffer_, pid);
+    append(event_buffer_, tid);
+    append(event_buffer_, time);
+    append(event_buffer_, options_.sample_period);
+    append(event_buffer_, static_cast<std::uint64_t>(callchain.size()));
+    for(const auto address : callchain)
+    {
+        append(event_buffer_, address);
+    }
+
+    first_time_ = std::min(first_time_, time);
+    last_time_  = std::max(last_time_, time);
+
+    // Samples do not have a trailing sample ID.
+    end_event(pid, tid, time);
+}
+
+void perf_data_writer::write_finished_round()
+{
+    // perf writes `finished_round` records uncompressed, hence all events of
+    // the round need to be written before.
+    write_compressed_events();
+
+    // Events that are generated by perf itself do not have a sample ID.
+    begin_event(std::to_underlying(parser::event_type::finished_round), 0);
+    write_event(false);
+}
+
+void perf_data_writer::finish()
+{
+    if(!file_stream_.is_open())
+    {
+        throw std::runtime_error("Cannot finish file: file is not open.");
+    }
+
+    write_compressed_events();
+
+    if(options_.pipe_mode)
+    {
+        // These features are only known at the end.
+        write_feature_event(parser::header_feature::sample_time);
+        if(compressor_ != nullptr) write_feature_event(parser::header_feature::compressed);
+
+        file_stream_.close();
+
+        if(file_stream_.fail())
+        {
+            throw std::runtime_error("Failed to write perf.data file.");
+        }
+        return;
+    }
+
+    auto active_features = std::vector<parser::header_feature>(features.begin(), features.end());
+    if(compressor_ != nullptr) active_features.push_back(parser::header_feature::compressed);
+
+    // The header features are stored right behind the data section: first a file
+    // section for every feature, followed by the actual data of the features.
+    const auto features_offset = data_offset_ + data_size_;
+
+    std::vector<std::byte> feature_sections;
+    std::vector<std::byte> feature_data;
+
+    const auto feature_data_offset = features_offset + active_features.size() * parser::file_section_view::static_size;
+
+    for(const auto feature : active_features)
+    {
+        const auto feature_offset = feature_data.size();
+
+        append_feature(feature, feature_data);
+
+        append(feature_sections, feature_data_offset + feature_offset);
+        append(feature_sections, static_cast<std::uint64_t>(feature_data.size() - feature_offset));
+    }
+
+    file_stream_.write(reinterpret_cast<const char*>(feature_sections.data()), common::narrow_cast<std::streamsize>(feature_sections.size()));
+    file_stream_.write(reinterpret_cast<const char*>(feature_data.data()), common::narrow_cast<std::streamsize>(feature_data.size()));
+
+    parser::header_feature_flags feature_flags;
+    for(const auto feature : active_features)
+    {
+        feature_flags.set(feature);
+    }
+
+    std::vector<std::byte> header;
+    append(header, magic_v2);
+    append(header, static_cast<std::uint64_t>(parser::header_view::static_size));
+    append(header, static_cast<std::uint64_t>(file_attribute_size));
+    append(header, attributes_offset);
+    append(header, static_cast<std::uint64_t>(file_attribute_size));
+    append(header, data_offset_);
+    append(header, data_size_);
+    append(header, std::uint64_t(0)); // event_types.offset
+    append(header, std::uint64_t(0)); // event_types.size
+    for(std::size_t word_index = 0; word_index < 4; ++word_index)
+    {
+        std::uint64_t word = 0;
+        for(std::size_t bit_index = 0; bit_index < 64; ++bit_index)
+        {
+            if(feature_flags.data().test(word_index * 64 + bit_index)) word |= std::uint64_t(1) << bit_index;
+        }
+        append(header, word);
+    }
+    assert(header.size() == parser::header_view::static_size);
+
+    file_stream_.seekp(0);
+    file_stream_.write(reinterpret_cast<const char*>(header.data()), common::narrow_cast<std::streamsize>(header.size()));
+
+    file_stream_.close();
+
+    if(file_stream_.fail())
+    {
+        throw std::runtime_error("Failed to write perf.data file.");
+    }
+}
+
+void perf_data_writer::append_feature(parser::header_feature feature, std::vector<std::byte>& buffer) const
+{
+    switch(feature)
+    {
+    case parser::header_feature::hostname:
+        append_string(buffer, options_.hostname);
+        break;
+    case parser::header_feature::osrelease:
+        append_string(buffer, options_.os_release);
+        break;
+    case parser::header_feature::arch:
+        append_string(buffer, options_.arch);
+        break;
+    case parser::header_feature::nr_cpus:
+        append(buffer, options_.number_of_cpus); // available
+        append(buffer, options_.number_of_cpus); // online
+        break;
+    case parser::header_feature::cmdline:
+        append(buffer, common::narrow_cast<std::uint32_t>(options_.command_line.size()));
+        for(const auto& argument : options_.command_line)
+        {
+            append_string(buffer, argument);
+        }
+        break;
+    case parser::header_feature::event_desc:
+        append(buffer, std::uint32_t(1)); // number of events
+        append(buffer, common::narrow_cast<std::uint32_t>(attribute_size));
+        append_attributes(buffer, options_);
+        append(buffer, std::uint32_t(0)); // number of ids
+        append_string(buffer, options_.event_name);
+        break;
+    case parser::header_feature::sample_time:
+        append(buffer, first_time_ <= last_time_ ? first_time_ : std::uint64_t(0));
+        append(buffer, first_time_ <= last_time_ ? last_time_ : std::uint64_t(0));
+        break;
+    case parser::header_feature::compressed:
+        append(buffer, std::uint32_t(0)); // version
+        append(buffer, zstd_compression_type);
+        append(buffer, common::narrow_cast<std::uint32_t>(*options_.compression_level));
+        append(buffer, common::narrow_cast<std::uint32_t>(compressed_size_ > 0 ? (uncompressed_size_ + compressed_size_ / 2) / compressed_size_ : 0)); // ratio
+        append(buffer, common::narrow_cast<std::uint32_t>(compression_buffer_size));                                                                       // mmap_len
+        break;
+    default:
+        std::unreachable();
+    }
+}
+
+void perf_data_writer::begin_event(std::uint32_t type, std::uint16_t misc)
+{
+    if(!file_stream_.is_open())
+    {
+        throw std::runtime_error("Cannot write event: file is not open.");
+    }
+
+    event_buffer_.clear();
+    append(event_buffer_, type);
+    append(event_buffer_, misc);
+    append(event_buffer_, std::uint16_t(0)); // size; will be set in `write_event`
+}
+
+void perf_data_writer::end_event(std::uint32_t pid, std::uint32_t tid, std::uint64_t time)
+{
+    const auto type = parser::event_type(*reinterpret_cast<const std::uint32_t*>(event_buffer_.data()));
+    if(type != parser::event_type::sample)
+    {
+        append(event_buffer_, pid);
+        append(event_buffer_, tid);
+        append(event_buffer_, time);
+    }
+
+    write_event(compressor_ != nullptr);
+}
+
+void perf_data_writer::write_event(bool compress)
+{
+    if(event_buffer_.size() > std::numeric_limits<std::uint16_t>::max())
+    {
+        throw std::runtime_error(std::format("Event too large: {} bytes", event_buffer_.size()));
+    }
+    write_at(event_buffer_, 6, static_cast<std::uint16_t>(event_buffer_.size()));
+
+    if(!compress)
+    {
+        write_data(event_buffer_);
+        return;
+    }
+
+    // Make sure the decompressed data of a single flush never exceeds the buffer size, since perf
+    // relies on that when decompressing.
+    if(uncompressed_events_.size() + event_buffer_.size() > compression_buffer_size) write_compressed_events();
+
+    uncompressed_events_.insert(uncompressed_events_.end(), event_buffer_.begin(), event_buffer_.end());
+}
+
+void perf_data_writer::write_pipe_header()
+{
+    std::vector<std::byte> header;
+    append(header, magic_v2);
+    append(header, pipe_header_size);
+    write_data(header);
+
+    begin_event(std::to_underlying(parser::event_type::header_attr), 0);
+    append_attributes(event_buffer_, options_);
+    append(event_buffer_, pipe_event_id);
+    write_event(false);
+
+    begin_event(std::to_underlying(parser::event_type::event_update), 0);
+    append(event_buffer_, std::to_underlying(parser::event_update_type::name));
+    append(event_buffer_, pipe_event_id);
+    append_padded(event_buffer_, options_.event_name, 8);
+    write_event(false);
+
+    for(const auto feature : features)
+    {
+        // The event description is transmitted by the events above, and the sample time is
+        // only known at the end.
+        if(feature == parser::header_feature::event_desc ||
+           feature == parser::header_feature::sample_time) continue;
+
+        write_feature_event(feature);
+    }
+}
+
+void perf_data_writer::write_feature_event(parser::header_feature feature)
+{
+    begin_event(std::to_underlying(parser::event_type::header_feature), 0);
+    append(event_buffer_, static_cast<std::uint64_t>(feature));
+    append_feature(feature, event_buffer_);
+    write_event(false);
+}
+
+void perf_data_writer::write_compressed_events()
+{
+    if(uncompressed_events_.empty()) return;
+
+    assert(compressor_ != nullptr);
+
+    compressor_->compress(
+        uncompressed_events_,
+        max_compressed_payload_size,
+        [this](std::span<const std::byte> payload)
+        {
+            std::vector<std::byte> record_header;
+            append(record_header, std::to_underlying(parser::event_type::compressed));
+            append(record_header, std::uint16_t(0)); // misc
+            append(record_header, common::narrow_cast<std::uint16_t>(parser::event_header_view::static_size + payload.size()));
+
+            write_data(record_header);
+            write_data(payload);
+
+            compressed_size_ += payload.size();
+        });
+
+    uncompressed_size_ += uncompressed_events_.size();
+    uncompressed_events_.clear();
+}
+
+void perf_data_writer::write_data(std::span<const std::byte> data)
+{
+    file_stream_.write(reinterpret_cast<const char*>(data.data()), common::narrow_cast<std::streamsize>(data.size()));
+    data_size_ += data.size();
+}
@@ -0,0 +1,127 @@
+
+#pragma once
+
+#include <cstdint>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace snail::perf_data {
+
+namespace parser {
+enum class header_feature;
+} // namespace parser
+
+namespace detail {
+class zstd_stream_compressor;
+} // namespace detail
+
+// Writes perf.data files that can be read by `perf_data_file`.
+//
+// All events share a single set of event attributes: samples carry the instruction pointer,
+// thread and process ids, the timestamp, the period and the callchain and all other events
+// carry the process and thread id and the timestamp as sample ID.
+// Events are streamed to the file in the order they are written and are expected to be
+// written in increasing timestamp order. The header and the metadata are written by `finish`.
+//
+// If a compression level is given, the events are compressed with zstd into `compressed`
+// records, just like `perf record -z` does.
+//
+// In pipe mode, the file is written like `perf record -o -` does: the attributes and the
+// metadata are written as events, and the file is written strictly sequentially (hence it
+// can be a pipe).
+class perf_data_writer
+{
+public:
+    struct options
+    {
+        std::string hostname;
+        std::string os_release;
+        std::string arch;
+
+        std::uint32_t number_of_cpus;
+
+        std::vector<std::string> command_line;
+
+        std::string   event_name;
+        std::uint64_t sample_period;
+
+        // If set, events are compressed with the given zstd compression level.
+        std::optional<int> compression_level = std::nullopt;
+
+        bool pipe_mode = false;
+    };
+
+    perf_data_writer(const std::filesystem::path& file_path, options options);
+
+    ~perf_data_writer();
+
+    void write_comm(std::uint64_t    time,
+                    std::uint32_t    pid,
+                    std::uint32_t    tid,
+                    std::string_view comm);
+
+    void write_fork(std::uint64_t time,
+                    std::uint32_t pid,
+                    std::uint32_t ppid,
+                    std::uint32_t tid,
+                    std::uint32_t ptid);
+
+    void write_mmap2(std::uint64_t    time,
+                     std::uint32_t    pid,
+                     std::uint32_t    tid,
+                     std::uint64_t    address,
+                     std::uint64_t    length,
+                     std::uint64_t    page_offset,
+                     std::string_view filename);
+
+    // The callchain is expected to start with the innermost frame.
+    void write_sample(std::uint64_t                  time,
+                      std::uint32_t                  pid,
+                      std::uint32_t                  tid,
+                      std::uint64_t                  instruction_pointer,
+                      std::span<const std::uint64_t> callchain);
+
+    // Marks the end of a round: all events written so far can be processed independently
+    // of the events that are written afterwards.
+    void write_finished_round();
+
+    // Writes the metadata and the file header and closes the file.
+    // No more events can be written afterwards.
+    void finish();
+
+private:
+    void begin_event(std::uint32_t type, std::uint16_t misc);
+    void end_event(std::uint32_t pid, std::uint32_t tid, std::uint64_t time);
+    void write_event(bool compress);
+    void write_pipe_header();
+    void write_feature_event(parser::header_feature feature);
+    void append_feature(parser::header_feature feature, std::vector<std::byte>& buffer) const;
+    void write_compressed_events();
+    void write_data(std::span<const std::byte> data);
+
+    std::ofstream file_stream_;
+
+    options options_;
+
+    std::vector<std::byte> event_buffer_;
+
+    std::uint64_t data_offset_;
+    std::uint64_t data_size_;
+
+    std::uint64_t first_time_;
+    std::uint64_t last_time_;
+
+    std::unique_ptr<detail::zstd_stream_compressor> compressor_;
+    std::vector<std::byte>                          uncompressed_events_;
+    std::uint64_t                                   uncompressed_size_;
+    std::uint64_t                                   compressed_size_;
+};
+
+} // namespace snail::perf_data
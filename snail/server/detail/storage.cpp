@@ -2,6 +2,7 @@
 #include <snail/server/detail/storage.hpp>
 
 #include <algorithm>
+#include <numeric>
 #include <ranges>
 #include <unordered_map>
 
@@ -16,18 +17,68 @@ using namespace snail::server::detail;
 
 namespace {
 
+// The ids of all functions of a process, sorted only as far as they have been requested yet.
+struct sorted_functions
+{
+    // The first `sorted_front` and the last `sorted_back` entries are at their final positions,
+    // the entries in between are in unspecified order.
+    std::vector<analysis::function_info::id_t> ids;
+
+    std::size_t sorted_front = 0;
+    std::size_t sorted_back  = 0;
+};
+
+// Makes sure that at least the first `count` entries (or the last ones, if `reversed`) are sorted.
+template<typename Compare>
+void sort_functions(sorted_functions& functions, std::size_t count, bool reversed, Compare compare)
+{
+    auto& ids = functions.ids;
+
+    auto& sorted_count = reversed ? functions.sorted_back : functions.sorted_front;
+
+    count = std::min(count, ids.size());
+    if(count <= sorted_count) return;
+
+    const auto unsorted_begin = functions.sorted_front;
+    const auto unsorted_end   = ids.size() - functions.sorted_back;
+
+    // Sort at least twice as many entries as before, so that paging through all entries results
+    // in only a logarithmic number of partial sorts. If a large part of the entries needs to be
+    // sorted anyway, sorting all of them is cheaper.
+    const auto new_sorted_count = std::max(count, 2 * sorted_count);
+    if(new_sorted_count * 4 >= ids.size() || new_sorted_count - sorted_count >= unsorted_end - unsorted_begin)
+    {
+        std::sort(ids.begin() + unsorted_begin, ids.begin() + unsorted_end, compare);
+        functions.sorted_front = ids.size();
+        functions.sorted_back  = ids.size();
+        return;
+    }
+
+    if(reversed)
+    {
+        std::partial_sort(ids.rbegin() + functions.sorted_back, ids.rbegin() + new_sorted_count, ids.rend() - unsorted_begin,
+                          [&compare](const analysis::function_info::id_t& lhs, const analysis::function_info::id_t& rhs)
+                          { return compare(rhs, lhs); });
+    }
+    else
+    {
+        std::partial_sort(ids.begin() + unsorted_begin, ids.begin() + new_sorted_count, ids.begin() + unsorted_end, compare);
+    }
+    sorted_count = new_sorted_count;
+}
+
 struct document_storage
 {
     struct analysis_data
     {
         std::optional<analysis::stacks_analysis> stacks_analysis;
 
-        std::optional<std::vector<analysis::function_info::id_t>> functions_by_name;
+        std::optional<sorted_functions> functions_by_name;
 
         struct sample_sort_data
         {
-            std::optional<std::vector<analysis::function_info::id_t>> by_self_samples;
-            std::optional<std::vector<analysis::function_info::id_t>> by_total_samples;
+            std::optional<sorted_functions> by_self_samples;
+            std::optional<sorted_functions> by_total_samples;
         };
         std::unordered_map<analysis::sample_source_info::id_t, sample_sort_data> functions_by_samples;
     };
@@ -43,6 +94,16 @@ struct document_storage
         analysis_data>
         analysis_per_process;
 
+    // Allows to re-analyze a process quickly when the time range or the excluded threads of the
+    // filter change. Those are independent of the filter, hence they are kept until the document is re-read.
+    // Since building an index costs about as much as analyzing the process directly, the indices are only
+    // built once the time range or the excluded threads of the filter have been changed for the first time.
+    bool use_time_index = false;
+    std::unordered_map<
+        analysis::unique_process_id,
+        analysis::stacks_time_index>
+        time_index_per_process;
+
     const std::unordered_map<analysis::sample_source_info::id_t, std::size_t>& get_total_samples_counts()
     {
         if(total_samples_counts.has_value()) return total_samples_counts.value();
@@ -74,8 +135,7 @@ struct document_storage
         if(data.stacks_analysis == std::nullopt)
         {
             data = analysis_data{
-                .stacks_analysis      = snail::analysis::analyze_stacks(*data_provider, process_id, filter,
-                                                                        progress_listener, cancellation_token),
+                .stacks_analysis      = analyze_process(process_id, progress_listener, cancellation_token),
                 .functions_by_name    = {},
                 .functions_by_samples = {},
             };
@@ -83,8 +143,38 @@ struct document_storage
         return *data.stacks_analysis;
     }
 
+    analysis::stacks_analysis analyze_process(analysis::unique_process_id       process_id,
+                                              const common::progress_listener*  progress_listener,
+                                              const common::cancellation_token* cancellation_token)
+    {
+        if(!use_time_index)
+        {
+            return snail::analysis::analyze_stacks(*data_provider, process_id, filter,
+                                                   progress_listener, cancellation_token);
+        }
+
+        auto iter = time_index_per_process.find(process_id);
+        if(iter == time_index_per_process.end())
+        {
+            auto index = snail::analysis::make_stacks_time_index(*data_provider, process_id, progress_listener, cancellation_token);
+            if(index != std::nullopt) iter = time_index_per_process.emplace(process_id, std::move(*index)).first;
+        }
+        if(iter != time_index_per_process.end())
+        {
+            return snail::analysis::analyze_stacks(iter->second, filter);
+        }
+
+        // Only reached if creating the index has been canceled.
+        return snail::analysis::analyze_stacks(*data_provider, process_id, filter,
+                                               progress_listener, cancellation_token);
+    }
+
+    // Returns all functions of the process, of which at least the first `count` (or the last ones,
+    // if `reversed`) are sorted.
     const std::vector<analysis::function_info::id_t>& get_sorted_functions(analysis::unique_process_id       process_id,
                                                                            sort_by_kind                      sort_by,
+                                                                           bool                              reversed,
+                                                                           std::size_t                       count,
                                                                            const common::progress_listener*  progress_listener,
                                                                            const common::cancellation_token* cancellation_token)
     {
@@ -96,58 +186,65 @@ struct document_storage
 
         auto& data = analysis_per_process[process_id];
 
+        const auto get_or_create = [&function_ids_view](std::optional<sorted_functions>& functions) -> sorted_functions&
+        {
+            if(functions == std::nullopt)
+            {
+                functions = sorted_functions{
+                    .ids          = std::vector<snail::analysis::function_info::id_t>(function_ids_view.begin(), function_ids_view.end()),
+                    .sorted_front = 0,
+                    .sorted_back  = 0,
+                };
+            }
+            return *functions;
+        };
+
         return std::visit(
-            [&data, &stacks_analysis, &function_ids_view]<typename T>(const T& sort_by) -> const std::vector<analysis::function_info::id_t>&
+            [&data, &stacks_analysis, &get_or_create, reversed, count]<typename T>(const T& sort_by) -> const std::vector<analysis::function_info::id_t>&
             {
                 if constexpr(std::is_same_v<T, detail::sort_by_name>)
                 {
-                    if(data.functions_by_name == std::nullopt)
-                    {
-                        data.functions_by_name = std::vector<snail::analysis::function_info::id_t>(function_ids_view.begin(), function_ids_view.end());
-                        std::ranges::sort(*data.functions_by_name, [&stacks_analysis](const snail::analysis::function_info::id_t& lhs, const snail::analysis::function_info::id_t& rhs)
-                                          { return stacks_analysis.get_function(lhs).name < stacks_analysis.get_function(rhs).name; });
-                    }
-                    return *data.functions_by_name;
+                    auto& functions = get_or_create(data.functions_by_name);
+                    sort_functions(functions, count, reversed,
+                                   [&stacks_analysis](const snail::analysis::function_info::id_t& lhs, const snail::analysis::function_info::id_t& rhs)
+                                   { return stacks_analysis.get_function(lhs).name < stacks_analysis.get_function(rhs).name; });
+                    return functions.ids;
                 }
                 if constexpr(std::is_same_v<T, detail::sort_by_samples>)
                 {
                     const auto source_id   = sort_by.sample_source_id;
                     auto&      source_data = data.functions_by_samples[source_id];
 
-                    auto& sorted_functions = sort_by.sum == detail::sort_by_samples::sum_type::self ?
-                                                 source_data.by_self_samples :
-                                                 source_data.by_total_samples;
-                    if(sorted_functions == std::nullopt)
+                    auto& functions = get_or_create(sort_by.sum == detail::sort_by_samples::sum_type::self ?
+                                                        source_data.by_self_samples :
+                                                        source_data.by_total_samples);
+                    switch(sort_by.sum)
                     {
-                        sorted_functions = std::vector<snail::analysis::function_info::id_t>(function_ids_view.begin(), function_ids_view.end());
-                        switch(sort_by.sum)
-                        {
-                        default:
-                        case detail::sort_by_samples::sum_type::total:
-                            std::ranges::sort(*sorted_functions,
-                                              [&stacks_analysis, source_id](const snail::analysis::function_info::id_t& lhs, const snail::analysis::function_info::id_t& rhs)
-                                              {
-                                                  const auto& lhs_function = stacks_analysis.get_function(lhs);
-                                                  const auto& rhs_function = stacks_analysis.get_function(rhs);
-                                                  const auto  lhs_value    = lhs_function.hits.get(source_id).total;
-                                                  const auto  rhs_value    = rhs_function.hits.get(source_id).total;
-                                                  return lhs_value < rhs_value || (lhs_value == rhs_value && lhs_function.name < rhs_function.name);
-                                              });
-                            break;
-                        case detail::sort_by_samples::sum_type::self:
-                            std::ranges::sort(*sorted_functions,
-                                              [&stacks_analysis, source_id](const snail::analysis::function_info::id_t& lhs, const snail::analysis::function_info::id_t& rhs)
-                                              {
-                                                  const auto& lhs_function = stacks_analysis.get_function(lhs);
-                                                  const auto& rhs_function = stacks_analysis.get_function(rhs);
-                                                  const auto  lhs_value    = lhs_function.hits.get(source_id).self;
-                                                  const auto  rhs_value    = rhs_function.hits.get(source_id).self;
-                                                  return lhs_value < rhs_value || (lhs_value == rhs_value && lhs_function.name < rhs_function.name);
-                                              });
-                            break;
-                        }
+                    default:
+                    case detail::sort_by_samples::sum_type::total:
+                        sort_functions(functions, count, reversed,
+                                       [&stacks_analysis, source_id](const snail::analysis::function_info::id_t& lhs, const snail::analysis::function_info::id_t& rhs)
+                                       {
+                                           const auto& lhs_function = stacks_analysis.get_function(lhs);
+                                           const auto& rhs_function = stacks_analysis.get_function(rhs);
+                                           const auto  lhs_value    = stacks_analysis.get_hits(lhs_function).get(source_id).total;
+                                           const auto  rhs_value    = stacks_analysis.get_hits(rhs_function).get(source_id).total;
+                                           return lhs_value < rhs_value || (lhs_value == rhs_value && lhs_function.name < rhs_function.name);
+                                       });
+                        break;
+                    case detail::sort_by_samples::sum_type::self:
+                        sort_functions(functions, count, reversed,
+                                       [&stacks_analysis, source_id](const snail::analysis::function_info::id_t& lhs, const snail::analysis::function_info::id_t& rhs)
+                                       {
+                                           const auto& lhs_function = stacks_analysis.get_function(lhs);
+                                           const auto& rhs_function = stacks_analysis.get_function(rhs);
+                                           const auto  lhs_value    = stacks_analysis.get_hits(lhs_function).get(source_id).self;
+                                           const auto  rhs_value    = stacks_analysis.get_hits(rhs_function).get(source_id).self;
+                                           return lhs_value < rhs_value || (lhs_value == rhs_value && lhs_function.name < rhs_function.name);
+                                       });
+                        break;
                     }
-                    return *sorted_functions;
+                    return functions.ids;
                 }
             },
             sort_by);
@@ -200,11 +297,13 @@ document_id storage::create_document(const std::filesystem::path& path)
     const auto new_id = impl_->take_document_id();
 
     impl_->open_documents[new_id] = document_storage{
-        .path                 = path,
-        .data_provider        = nullptr,
-        .filter               = {},
-        .total_samples_counts = {},
-        .analysis_per_process = {},
+        .path                   = path,
+        .data_provider          = nullptr,
+        .filter                 = {},
+        .total_samples_counts   = {},
+        .analysis_per_process   = {},
+        .use_time_index         = false,
+        .time_index_per_process = {},
     };
     return new_id;
 }
@@ -225,6 +324,9 @@ void storage::read_document(const document_id&                id,
     data_provider->process(document.path, progress_listener, cancellation_token);
 
     document.data_provider = std::move(data_provider);
+    document.total_samples_counts.reset();
+    document.analysis_per_process.clear();
+    document.time_index_per_process.clear();
 }
 
 void storage::close_document(const document_id& id)
@@ -246,6 +348,12 @@ void storage::apply_document_filter(const document_id& document_id, analysis::sa
 {
     auto& document = impl_->get_document_storage(document_id);
     if(document.filter == filter) return;
+    if(document.filter.min_time != filter.min_time ||
+       document.filter.max_time != filter.max_time ||
+       document.filter.excluded_threads != filter.excluded_threads)
+    {
+        document.use_time_index = true;
+    }
     document.filter = std::move(filter);
     document.total_samples_counts.reset();
     document.analysis_per_process.clear();
@@ -282,7 +390,7 @@ std::span<const analysis::function_info::id_t> storage::get_functions_page(const
 {
     auto& document = impl_->get_document_storage(document_id);
 
-    const auto& sorted_functions = document.get_sorted_functions(process_id, sort_by, progress_listener, cancellation_token);
+    const auto& sorted_functions = document.get_sorted_functions(process_id, sort_by, reversed, (page_index + 1) * page_size, progress_listener, cancellation_token);
 
     const auto page_start = std::min(page_index * page_size, sorted_functions.size());
     const auto page_end   = std::min((page_index + 1) * page_size, sorted_functions.size());
@@ -292,3 +400,84 @@ std::span<const analysis::function_info::id_t> storage::get_functions_page(const
     return reversed ? std::span(sorted_functions.data() + sorted_functions.size() - page_end, current_page_size) :
                       std::span(sorted_functions.data() + page_start, current_page_size);
 }
+
+std::vector<process_function> storage::get_hottest_functions(const detail::document_id&        document_id,
+                                                             sort_by_samples                   sort_by,
+                                                             std::size_t                       count,
+                                                             const common::progress_listener*  progress_listener,
+                                                             const common::cancellation_token* cancellation_token)
+{
+    auto& document = impl_->get_document_storage(document_id);
+    if(document.data_provider == nullptr) throw std::runtime_error("Document has not been read yet.");
+
+    // The hottest functions of each process, starting with the hottest one.
+    struct process_functions
+    {
+        analysis::unique_process_id                    process_id;
+        const analysis::stacks_analysis*               stacks_analysis;
+        std::span<const analysis::function_info::id_t> functions;
+        std::size_t                                    next_index;
+
+        analysis::function_info::id_t next_function() const
+        {
+            return functions[functions.size() - 1 - next_index];
+        }
+
+        std::size_t next_hits(const sort_by_samples& sort_by) const
+        {
+            const auto hits = stacks_analysis->get_hits(stacks_analysis->get_function(next_function())).get(sort_by.sample_source_id);
+            return sort_by.sum == sort_by_samples::sum_type::self ? hits.self : hits.total;
+        }
+    };
+
+    std::vector<process_functions> processes;
+    for(const auto process_id : document.data_provider->sampling_processes())
+    {
+        const auto& stacks_analysis  = document.get_process_analysis(process_id, progress_listener, cancellation_token);
+        const auto& sorted_functions = document.get_sorted_functions(process_id, sort_by, true, count, progress_listener, cancellation_token);
+
+        const auto process_count = std::min(count, sorted_functions.size());
+        if(process_count == 0) continue;
+
+        processes.push_back(process_functions{
+            .process_id      = process_id,
+            .stacks_analysis = &stacks_analysis,
+            .functions       = std::span(sorted_functions).subspan(sorted_functions.size() - process_count),
+            .next_index      = 0});
+    }
+
+    // Merge the per-process lists by always taking the hottest of their next functions.
+    const auto compare = [&processes, &sort_by](std::size_t lhs, std::size_t rhs)
+    {
+        const auto lhs_hits = processes[lhs].next_hits(sort_by);
+        const auto rhs_hits = processes[rhs].next_hits(sort_by);
+        return lhs_hits < rhs_hits || (lhs_hits == rhs_hits && lhs > rhs);
+    };
+
+    std::vector<std::size_t> heap(processes.size());
+    std::iota(heap.begin(), heap.end(), std::size_t(0));
+    std::ranges::make_heap(heap, compare);
+
+    std::vector<process_function> result;
+    while(result.size() < count && !heap.empty())
+    {
+        std::ranges::pop_heap(heap, compare);
+
+        auto& process = processes[heap.back()];
+        result.push_back(process_function{
+            .process_id  = process.process_id,
+            .function_id = process.next_function()});
+
+        ++process.next_index;
+        if(process.next_index < process.functions.size())
+        {
+            std::ranges::push_heap(heap, compare);
+        }
+        else
+        {
+            heap.pop_back();
+        }
+    }
+
+    return result;
+}
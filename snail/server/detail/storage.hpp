@@ -3,9 +3,12 @@
 #include <filesystem>
 #include <memory>
 #include <span>
+#include <unordered_map>
 #include <variant>
+#include <vector>
 
 #include <snail/analysis/data/functions.hpp>
+#include <snail/analysis/data/ids.hpp>
 #include <snail/analysis/data/sample_source.hpp>
 
 #include <snail/server/detail/document_id.hpp>
@@ -15,7 +18,6 @@ namespace snail::analysis {
 struct stacks_analysis;
 struct options;
 struct sample_filter;
-struct unique_process_id;
 class path_map;
 class data_provider;
 
@@ -47,6 +49,12 @@ struct sort_by_samples
 
 using sort_by_kind = std::variant<sort_by_name, sort_by_samples>;
 
+struct process_function
+{
+    analysis::unique_process_id   process_id;
+    analysis::function_info::id_t function_id;
+};
+
 class storage
 {
 public:
@@ -85,6 +93,13 @@ public:
                                                                       const common::progress_listener*  progress_listener,
                                                                       const common::cancellation_token* cancellation_token);
 
+    // The `count` functions of all sampling processes with the most hits, starting with the hottest one.
+    std::vector<process_function> get_hottest_functions(const document_id&                id,
+                                                        sort_by_samples                   sort_by,
+                                                        std::size_t                       count,
+                                                        const common::progress_listener*  progress_listener,
+                                                        const common::cancellation_token* cancellation_token);
+
 private:
     struct impl;
 
@@ -1,11 +1,14 @@
 #include <snail/server/snail_server.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <format>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <span>
 #include <thread>
 #include <unordered_map>
 
@@ -124,14 +127,14 @@ double make_percent(T value, U max_value)
     return max_value == 0 ? 0.0 : (static_cast<double>(value) * 100.0 / static_cast<double>(max_value));
 }
 
-auto make_hits_json(const analysis::source_hit_counts&                                         hits_per_source,
+auto make_hits_json(std::span<const analysis::hit_counts>                                      hits_per_source,
                     const std::unordered_map<analysis::sample_source_info::id_t, std::size_t>& total_hits)
 {
     auto results = nlohmann::json::array();
 
-    for(analysis::sample_source_info::id_t source_id = 0; source_id < hits_per_source.counts_per_source.size(); ++source_id)
+    for(analysis::sample_source_info::id_t source_id = 0; source_id < hits_per_source.size(); ++source_id)
     {
-        const auto& hits   = hits_per_source.counts_per_source[source_id];
+        const auto& hits   = hits_per_source[source_id];
         const auto& totals = total_hits.at(source_id);
 
         results.push_back({
@@ -153,7 +156,7 @@ const analysis::call_tree_node* get_top_child(const analysis::stacks_analysis&
     for(const auto child_id : current_node.children)
     {
         const auto& child = stacks_analysis.get_call_tree_node(child_id);
-        if(top_child == nullptr || child.hits.get(source_id).total > top_child->hits.get(source_id).total)
+        if(top_child == nullptr || stacks_analysis.get_hits(child).get(source_id).total > stacks_analysis.get_hits(*top_child).get(source_id).total)
         {
             top_child = &child;
         }
@@ -175,7 +178,7 @@ auto append_call_tree_node_children(const analysis::stacks_analysis&
     const auto expand_top_child = expand_hot_path &&
                                   top_child != nullptr &&
                                   hot_source_id &&
-                                  top_child->hits.get(*hot_source_id).total > current_node.hits.get(*hot_source_id).self;
+                                  stacks_analysis.get_hits(*top_child).get(*hot_source_id).total > stacks_analysis.get_hits(current_node).get(*hot_source_id).self;
 
     std::size_t top_child_index = 0;
     for(std::size_t child_index = 0; child_index < current_node.children.size(); ++child_index) // TODO: views::enumerate
@@ -193,7 +196,7 @@ auto append_call_tree_node_children(const analysis::stacks_analysis&
             {"functionId", child.function_id},
             {"module", child_module.name},
             {"type", "function"},
-            {"hits", make_hits_json(child.hits, total_hits)},
+            {"hits", make_hits_json(stacks_analysis.get_hits(child).counts_per_source, total_hits)},
             {"isHot", expand_top_child && is_top_child}
         });
 
@@ -216,9 +219,9 @@ auto make_function_json(const analysis::stacks_analysis&
                         const analysis::process_info&                                              process,
                         const analysis::function_info&                                             function,
                         const std::unordered_map<analysis::sample_source_info::id_t, std::size_t>& total_hits,
-                        const analysis::source_hit_counts*                                         hits = nullptr)
+                        std::optional<analysis::source_hit_counts_view>                            hits = std::nullopt)
 {
-    if(hits == nullptr) hits = &function.hits;
+    if(hits == std::nullopt) hits = stacks_analysis.get_hits(function);
 
     const auto is_root = function.id == stacks_analysis.get_function_root().id;
 
@@ -235,16 +238,16 @@ auto make_function_json(const analysis::stacks_analysis&
         {"id", function.id},
         {"module", std::move(module_name)},
         {"type", type},
-        {"hits", make_hits_json(*hits, total_hits)}
+        {"hits", make_hits_json(hits->counts_per_source, total_hits)}
     };
 }
 
-auto make_callers_callees_json(const analysis::stacks_analysis&                                                      stacks_analysis,
-                               const analysis::process_info&                                                         process,
-                               const auto                                                                            max_entries,
-                               const std::unordered_map<analysis::sample_source_info::id_t, std::size_t>&            total_hits,
-                               analysis::sample_source_info::id_t                                                    sort_source_id,
-                               const std::unordered_map<analysis::function_info::id_t, analysis::source_hit_counts>& functions)
+auto make_callers_callees_json(const analysis::stacks_analysis&                                           stacks_analysis,
+                               const analysis::process_info&                                              process,
+                               const auto                                                                 max_entries,
+                               const std::unordered_map<analysis::sample_source_info::id_t, std::size_t>& total_hits,
+                               analysis::sample_source_info::id_t                                         sort_source_id,
+                               const analysis::hits_by_key_view&                                          functions)
 {
     assert(max_entries >= 1);
     struct id_and_count
@@ -254,11 +257,12 @@ auto make_callers_callees_json(const analysis::stacks_analysis&
     };
 
     std::vector<id_and_count> counts_per_function;
-    for(const auto& [id, hits] : functions)
+    counts_per_function.reserve(functions.size());
+    for(std::size_t index = 0; index < functions.size(); ++index)
     {
         counts_per_function.push_back(
-            {.id    = id,
-             .count = hits.get(sort_source_id).total});
+            {.id    = static_cast<analysis::function_info::id_t>(functions.key(index)),
+             .count = functions.hits(index).get(sort_source_id).total});
     }
 
     std::sort(
@@ -286,11 +290,11 @@ auto make_callers_callees_json(const analysis::stacks_analysis&
         analysis::source_hit_counts accumulated_hits;
         for(const auto& [id, count] : std::views::drop(counts_per_function, regular_items_count))
         {
-            const auto& function = stacks_analysis.get_function(id);
+            const auto function_hits = stacks_analysis.get_hits(stacks_analysis.get_function(id));
 
-            for(analysis::sample_source_info::id_t source_id = 0; source_id < function.hits.counts_per_source.size(); ++source_id)
+            for(analysis::sample_source_info::id_t source_id = 0; source_id < function_hits.counts_per_source.size(); ++source_id)
             {
-                const auto& hits = function.hits.counts_per_source[source_id];
+                const auto& hits = function_hits.counts_per_source[source_id];
 
                 accumulated_hits.get(source_id).total = hits.total;
                 accumulated_hits.get(source_id).self  = hits.self;
@@ -303,7 +307,7 @@ auto make_callers_callees_json(const analysis::stacks_analysis&
                 {"id", nlohmann::json(nullptr)},
                 {"module", "[multiple]"},
                 {"type", "accumulated"},
-                {"hits", make_hits_json(accumulated_hits, total_hits)},
+                {"hits", make_hits_json(accumulated_hits.counts_per_source, total_hits)},
         });
     }
     return result;
@@ -909,56 +913,26 @@ struct snail_server::impl
                    const common::cancellation_token&         cancellation_token,
                    const common::progress_listener*          progress_listener) -> nlohmann::json
             {
-                struct intermediate_function_info
-                {
-                    analysis::unique_process_id    process_id;
-                    const analysis::function_info* function;
-                };
-
-                std::vector<intermediate_function_info> intermediate_functions;
-
                 const auto& data_provider = storage_.get_data({request.document_id()});
 
-                const auto source_id = request.source_id();
-
                 const auto sort_by = detail::sort_by_samples{
-                    .sample_source_id = source_id,
+                    .sample_source_id = request.source_id(),
                     .sum              = detail::sort_by_samples::sum_type::self,
                 };
 
-                for(const auto process_id : data_provider.sampling_processes())
-                {
-                    const auto& stacks_analysis = storage_.get_stacks_analysis({request.document_id()}, process_id, progress_listener, &cancellation_token);
-                    const auto& function_ids    = storage_.get_functions_page({request.document_id()}, process_id,
-                                                                              sort_by,
-                                                                              true,
-                                                                              request.count(), 0,
+                const auto hottest_functions = storage_.get_hottest_functions({request.document_id()}, sort_by, request.count(),
                                                                               progress_listener, &cancellation_token);
 
-                    for(const auto function_id : function_ids)
-                    {
-                        intermediate_functions.push_back(intermediate_function_info{
-                            .process_id = process_id,
-                            .function   = &stacks_analysis.get_function(function_id)});
-                    }
-                }
-
-                std::ranges::sort(intermediate_functions,
-                                  [source_id](const intermediate_function_info& lhs, const intermediate_function_info& rhs)
-                                  {
-                                      return lhs.function->hits.get(source_id).self > rhs.function->hits.get(source_id).self;
-                                  });
-
                 const auto& total_hits = storage_.get_total_samples_counts({request.document_id()});
 
                 auto json_functions = nlohmann::json::array();
-                for(const auto& entry : intermediate_functions | std::views::take(request.count()))
+                for(const auto& entry : hottest_functions)
                 {
                     const auto& stacks_analysis = storage_.get_stacks_analysis({request.document_id()}, entry.process_id, progress_listener, &cancellation_token);
                     const auto& process_info    = data_provider.process_info(entry.process_id);
                     json_functions.push_back({
                         {"processKey", entry.process_id.key},
-                        {"function", make_function_json(stacks_analysis, process_info, *entry.function, total_hits)}
+                        {"function", make_function_json(stacks_analysis, process_info, stacks_analysis.get_function(entry.function_id), total_hits)}
                     });
                 }
 
@@ -1078,6 +1052,64 @@ struct snail_server::impl
                 };
             });
 
+        register_document_request<retrieve_sample_timeline_request>(
+            detail::document_access_type::read_only,
+            [this](const retrieve_sample_timeline_request& request, const common::cancellation_token& cancellation_token) -> nlohmann::json
+            {
+                // Every bucket is counted for every thread and sample source, hence limit their number.
+                constexpr std::size_t max_bucket_count = 10'000;
+
+                if(request.bucket_count() == 0) throw jsonrpc::invalid_request_error("'bucketCount' needs to be positive.");
+                if(request.bucket_count() > max_bucket_count) throw jsonrpc::invalid_request_error("'bucketCount' must not be larger than 10000.");
+
+                const auto& data_provider = storage_.get_data({request.document_id()});
+                const auto& process       = data_provider.process_info({request.process_key()});
+
+                // The times are converted to signed nanoseconds, hence they can not be arbitrarily large.
+                constexpr auto max_time = static_cast<std::size_t>(std::numeric_limits<std::chrono::nanoseconds::rep>::max());
+
+                if(request.start_time() && *request.start_time() > max_time) throw jsonrpc::invalid_request_error("'startTime' is out of range.");
+                if(request.end_time() && *request.end_time() > max_time) throw jsonrpc::invalid_request_error("'endTime' is out of range.");
+
+                const auto start_time = std::chrono::nanoseconds(request.start_time() ? static_cast<std::chrono::nanoseconds::rep>(*request.start_time()) : 0);
+                const auto end_time   = request.end_time() ? std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(*request.end_time())) : data_provider.session_info().runtime;
+                if(end_time < start_time) throw jsonrpc::invalid_request_error("'endTime' is before 'startTime'.");
+
+                // Round up, so that the buckets cover the whole time range. Buckets need to have a positive duration,
+                // even if the time range is empty. The remainder is checked separately, since adding `bucket_count - 1`
+                // to the range duration could overflow.
+                const auto bucket_count    = static_cast<std::chrono::nanoseconds::rep>(request.bucket_count());
+                const auto range_duration  = (end_time - start_time).count();
+                const auto bucket_duration = std::chrono::nanoseconds(std::max<std::chrono::nanoseconds::rep>(range_duration / bucket_count + (range_duration % bucket_count != 0 ? 1 : 0), 1));
+
+                auto json_threads = nlohmann::json::array();
+                for(const auto& thread_info : data_provider.threads_info(process.unique_id))
+                {
+                    if(cancellation_token.is_canceled()) return nullptr;
+
+                    auto json_thread_counts = nlohmann::json::array();
+                    for(const auto& source_info : data_provider.sample_sources())
+                    {
+                        auto counts = data_provider.count_samples_per_time_bucket(source_info.id, thread_info.unique_id,
+                                                                                  start_time, bucket_duration, request.bucket_count());
+                        json_thread_counts.push_back({
+                            {"sourceId", source_info.id   },
+                            {"counts",   std::move(counts)},
+                        });
+                    }
+                    json_threads.push_back({
+                        {"key",    thread_info.unique_id.key    },
+                        {"counts", std::move(json_thread_counts)},
+                    });
+                }
+
+                return {
+                    {"startTime",      start_time.count()     },
+                    {"bucketDuration", bucket_duration.count()},
+                    {"threads",        std::move(json_threads)}
+                };
+            });
+
         register_document_request<retrieve_call_tree_hot_path_request>(
             detail::document_access_type::write, // TODO: change to read_only?
             [this](const retrieve_call_tree_hot_path_request& request,
@@ -1101,7 +1133,7 @@ struct snail_server::impl
                     {"functionId", current_node->function_id},
                     {"module", "[multiple]"},
                     {"type", "process"},
-                    {"hits", make_hits_json(current_node->hits, total_hits)},
+                    {"hits", make_hits_json(stacks_analysis.get_hits(*current_node).counts_per_source, total_hits)},
                     {"isHot", true}
                 };
 
@@ -1167,8 +1199,8 @@ struct snail_server::impl
 
                 auto function_json = make_function_json(stacks_analysis, process, function, total_hits);
 
-                auto callers_json = make_callers_callees_json(stacks_analysis, process, max_entries, total_hits, request.sort_source_id(), function.callers);
-                auto callees_json = make_callers_callees_json(stacks_analysis, process, max_entries, total_hits, request.sort_source_id(), function.callees);
+                auto callers_json = make_callers_callees_json(stacks_analysis, process, max_entries, total_hits, request.sort_source_id(), stacks_analysis.get_callers(function));
+                auto callees_json = make_callers_callees_json(stacks_analysis, process, max_entries, total_hits, request.sort_source_id(), stacks_analysis.get_callees(function));
 
                 return {
                     {"function", std::move(function_json)},
@@ -1197,21 +1229,23 @@ struct snail_server::impl
 
                 std::vector<nlohmann::json> line_hits;
 
-                line_hits.reserve(function.hits_by_line.size());
-                for(const auto& [line_number, hits] : function.hits_by_line)
+                const auto hits_by_line = stacks_analysis.get_hits_by_line(function);
+
+                line_hits.reserve(hits_by_line.size());
+                for(std::size_t index = 0; index < hits_by_line.size(); ++index)
                 {
                     if(cancellation_token.is_canceled()) break;
 
                     line_hits.push_back(
                         nlohmann::json{
-                            {"lineNumber", line_number},
-                            {"hits", make_hits_json(hits, total_hits)},
+                            {"lineNumber", hits_by_line.key(index)},
+                            {"hits", make_hits_json(hits_by_line.hits(index).counts_per_source, total_hits)},
                     });
                 }
 
                 return {
                     {"filePath", file.path},
-                    {"hits", make_hits_json(function.hits, total_hits)},
+                    {"hits", make_hits_json(stacks_analysis.get_hits(function).counts_per_source, total_hits)},
                     {"lineNumber", *function.line_number},
                     {"lineHits", nlohmann::json(std::move(line_hits))}
                 };
@@ -0,0 +1,335 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <exception>
+#include <format>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <helpers.hpp>
+
+#include <snail/analysis/analysis.hpp>
+#include <snail/analysis/data_provider.hpp>
+#include <snail/analysis/perf_data_data_provider.hpp>
+
+#include <snail/common/string_interner.hpp>
+#include <snail/common/system.hpp>
+
+using namespace snail;
+using namespace snail::analysis;
+using namespace snail::detail::tests;
+
+namespace {
+
+constexpr auto synthetic_process_id   = unique_process_id{.key = 1};
+constexpr auto synthetic_thread_count = 4;
+
+struct synthetic_sample_data : public sample_data
+{
+    bool has_frame() const override
+    {
+        return true;
+    }
+
+    bool has_stack() const override
+    {
+        return true;
+    }
+
+    stack_frame frame() const override
+    {
+        return stack->front();
+    }
+
+    common::generator<stack_frame> reversed_stack() const override
+    {
+        for(const auto& frame : *stack)
+        {
+            co_yield stack_frame{frame};
+        }
+    }
+
+    std::optional<std::uint64_t> stack_key() const override
+    {
+        return key;
+    }
+
+    std::chrono::nanoseconds timestamp() const override
+    {
+        return time;
+    }
+
+    const std::vector<stack_frame>* stack = nullptr;
+    std::uint64_t                   key   = 0;
+    std::chrono::nanoseconds        time  = {};
+};
+
+struct synthetic_sample_batch : public sample_batch
+{
+    std::span<const sample_record> records() const override
+    {
+        return records_;
+    }
+
+    const sample_data& sample(std::size_t index) const override
+    {
+        const auto& record = records_[index];
+        current_.stack     = &(*stacks_)[*record.stack_key];
+        current_.key       = *record.stack_key;
+        current_.time      = record.timestamp;
+        return current_;
+    }
+
+    const std::vector<std::vector<stack_frame>>* stacks_ = nullptr;
+    std::span<const sample_record>               records_;
+
+    mutable synthetic_sample_data current_;
+};
+
+// Samples of a single process with a fixed number of distinct stacks. The stacks share some
+// outer frames and are distributed randomly (but deterministically) to the samples and threads.
+class synthetic_samples_provider : public samples_provider
+{
+public:
+    synthetic_samples_provider(std::size_t sample_count, std::size_t stack_count)
+    {
+        sources_.push_back(sample_source_info{
+            .id                    = 0,
+            .name                  = "synthetic",
+            .number_of_samples     = sample_count,
+            .average_sampling_rate = 1000.0,
+            .has_stacks            = true});
+
+        std::mt19937 random(42);
+
+        constexpr std::size_t module_count   = 8;
+        constexpr std::size_t function_count = 512;
+        constexpr std::size_t shared_depth   = 4;
+
+        std::vector<stack_frame> functions;
+        for(std::size_t i = 0; i < function_count; ++i)
+        {
+            const auto symbol_name_id = strings_.intern(std::format("function_{}", i));
+            const auto module_name_id = strings_.intern(std::format("module_{}", i % module_count));
+            const auto file_path_id   = strings_.intern(std::format("/src/file_{}.cpp", i / 4));
+            functions.push_back(stack_frame{
+                .symbol_name             = strings_.get(symbol_name_id),
+                .module_name             = strings_.get(module_name_id),
+                .file_path               = strings_.get(file_path_id),
+                .function_line_number    = 10 * (i % 4),
+                .instruction_line_number = 10 * (i % 4) + 1,
+                .ids                     = stack_frame::string_ids{
+                                        .symbol_name = symbol_name_id,
+                                        .module_name = module_name_id,
+                                        .file_path   = file_path_id}
+            });
+        }
+
+        std::uniform_int_distribution<std::size_t> function_distribution(shared_depth, function_count - 1);
+        std::uniform_int_distribution<std::size_t> depth_distribution(8, 40);
+        for(std::size_t i = 0; i < stack_count; ++i)
+        {
+            // Outermost frame first
+            auto& stack = stacks_.emplace_back(functions.begin(), functions.begin() + shared_depth);
+
+            const auto depth = depth_distribution(random);
+            while(stack.size() < depth)
+            {
+                auto frame                    = functions[function_distribution(random)];
+                frame.instruction_line_number = frame.function_line_number + stack.size() % 8;
+                stack.push_back(frame);
+            }
+        }
+
+        std::uniform_int_distribution<std::uint64_t> stack_distribution(0, stack_count - 1);
+        for(std::size_t i = 0; i < sample_count; ++i)
+        {
+            records_.push_back(sample_record{
+                .thread_id           = unique_thread_id{.key = i % synthetic_thread_count},
+                .timestamp           = std::chrono::milliseconds(i),
+                .instruction_pointer = 0,
+                .stack_key           = stack_distribution(random),
+                .has_stack           = true});
+        }
+    }
+
+    const std::vector<sample_source_info>& sample_sources() const override
+    {
+        return sources_;
+    }
+
+    common::generator<const sample_data&> samples(sample_source_info::id_t source_id,
+                                                  unique_process_id        process_id,
+                                                  const sample_filter&     filter) const override
+    {
+        for(const auto& batch : sample_batches(source_id, process_id, filter))
+        {
+            for(std::size_t i = 0; i < batch.records().size(); ++i)
+            {
+                co_yield batch.sample(i);
+            }
+        }
+    }
+
+    common::generator<const sample_batch&> sample_batches(sample_source_info::id_t /*source_id*/,
+                                                          unique_process_id        process_id,
+                                                          const sample_filter&     filter) const override
+    {
+        if(process_id != synthetic_process_id) co_return;
+        if(!filter.excluded_processes.empty() || !filter.excluded_threads.empty()) throw std::runtime_error("Thread and process filters are not supported");
+
+        const auto records = filtered_records(filter);
+
+        synthetic_sample_batch batch;
+        batch.stacks_ = &stacks_;
+        for(std::size_t offset = 0; offset < records.size(); offset += batch_size)
+        {
+            batch.records_ = records.subspan(offset, std::min(batch_size, records.size() - offset));
+            co_yield batch;
+        }
+    }
+
+    std::size_t count_samples(sample_source_info::id_t /*source_id*/,
+                              unique_process_id        process_id,
+                              const sample_filter&     filter) const override
+    {
+        if(process_id != synthetic_process_id) return 0;
+        return filtered_records(filter).size();
+    }
+
+    std::size_t count_samples(sample_source_info::id_t /*source_id*/,
+                              unique_thread_id         thread_id,
+                              const sample_filter&     filter) const override
+    {
+        return std::ranges::count(filtered_records(filter), thread_id, &sample_record::thread_id);
+    }
+
+    std::vector<std::size_t> count_samples_per_time_bucket(sample_source_info::id_t /*source_id*/,
+                                                           unique_thread_id /*thread_id*/,
+                                                           std::chrono::nanoseconds /*start_time*/,
+                                                           std::chrono::nanoseconds /*bucket_duration*/,
+                                                           std::size_t /*bucket_count*/) const override
+    {
+        throw std::runtime_error("Not implemented");
+    }
+
+private:
+    static constexpr std::size_t batch_size = 1024;
+
+    std::span<const sample_record> filtered_records(const sample_filter& filter) const
+    {
+        const auto begin = filter.min_time ? std::ranges::lower_bound(records_, *filter.min_time, {}, &sample_record::timestamp) : records_.begin();
+        const auto end   = filter.max_time ? std::ranges::upper_bound(records_, *filter.max_time, {}, &sample_record::timestamp) : records_.end();
+        return std::span(begin, end);
+    }
+
+    std::vector<sample_source_info> sources_;
+
+    common::string_interner               strings_;
+    std::vector<std::vector<stack_frame>> stacks_;
+    std::vector<sample_record>            records_;
+};
+
+// Arguments: number of samples, number of distinct stacks, number of worker threads
+void analyze_stacks_synthetic(benchmark::State& state)
+{
+    const auto sample_count = static_cast<std::size_t>(state.range(0));
+
+    const synthetic_samples_provider provider(sample_count, static_cast<std::size_t>(state.range(1)));
+
+    for(auto _ : state)
+    {
+        auto result = analyze_stacks(provider, synthetic_process_id, {}, nullptr, nullptr, static_cast<std::size_t>(state.range(2)));
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * sample_count));
+}
+
+// Arguments: number of samples, number of distinct stacks, number of worker threads
+//
+// Analyzes the second quarter of all samples from an index that has been built beforehand.
+void analyze_stacks_time_index_synthetic(benchmark::State& state)
+{
+    const auto sample_count = static_cast<std::size_t>(state.range(0));
+
+    const synthetic_samples_provider provider(sample_count, static_cast<std::size_t>(state.range(1)));
+
+    const auto index = make_stacks_time_index(provider, synthetic_process_id);
+
+    const auto filter = sample_filter{
+        .min_time           = std::chrono::milliseconds(sample_count / 4),
+        .max_time           = std::chrono::milliseconds(sample_count / 2),
+        .excluded_processes = {},
+        .excluded_threads   = {}};
+
+    for(auto _ : state)
+    {
+        auto result = analyze_stacks(*index, filter, static_cast<std::size_t>(state.range(2)));
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * (sample_count / 4)));
+}
+
+void analyze_stacks_perf_data(benchmark::State& state, const std::filesystem::path& relative_data_dir, const std::filesystem::path& file_name)
+{
+    const auto file_path = find_test_file(state, relative_data_dir / "record" / file_name);
+    if(!file_path) return;
+
+    // Disable all symbol downloading & caching
+    dwarf_symbol_find_options symbol_options;
+    symbol_options.debuginfod_urls_.clear();
+    symbol_options.debuginfod_cache_dir_ = common::get_temp_dir() / "should-not-exist-2f4f23da-ef58-4f0c-8f99-a83aed90fbbe";
+
+    symbol_options.search_dirs_.clear();
+    symbol_options.search_dirs_.push_back(file_path->parent_path().parent_path() / "bin");
+
+    perf_data_data_provider provider(symbol_options);
+    try
+    {
+        provider.process(*file_path, nullptr, nullptr);
+    }
+    catch(const std::exception& error)
+    {
+        state.SkipWithError(error.what());
+        return;
+    }
+
+    std::vector<unique_process_id> process_ids;
+    for(const auto process_id : provider.sampling_processes())
+    {
+        process_ids.push_back(process_id);
+    }
+
+    for(auto _ : state)
+    {
+        for(const auto process_id : process_ids)
+        {
+            auto result = analyze_stacks(provider, process_id);
+            benchmark::DoNotOptimize(result);
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * provider.session_info().number_of_samples));
+}
+
+} // namespace
+
+BENCHMARK(analyze_stacks_synthetic)
+    ->ArgNames({"samples", "stacks", "threads"})
+    ->Args({10'000, 100, 1})
+    ->Args({100'000, 1'000, 1})
+    ->Args({1'000'000, 10'000, 1})
+    ->Args({1'000'000, 10'000, 0})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(analyze_stacks_time_index_synthetic)
+    ->ArgNames({"samples", "stacks", "threads"})
+    ->Args({1'000'000, 10'000, 1})
+    ->Args({1'000'000, 10'000, 0})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(analyze_stacks_perf_data, inner, std::filesystem::path("tests") / "apps" / "inner" / "dist" / "linux" / "deb", "inner-perf.data")
+    ->Unit(benchmark::kMillisecond);
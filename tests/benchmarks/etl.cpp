@@ -0,0 +1,197 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+
+#include <helpers.hpp>
+
+#include <snail/etl/etl_file.hpp>
+#include <snail/etl/etl_writer.hpp>
+
+using namespace snail;
+using namespace snail::detail::tests;
+
+namespace {
+
+class counting_event_observer : public etl::event_observer
+{
+public:
+    std::size_t count = 0;
+
+    void handle(const etl::etl_file::header_data& /*file_header*/, const etl::parser::system_trace_header_view& /*trace_header*/, std::span<const std::byte> /*user_data*/) override
+    {
+        ++count;
+    }
+    void handle(const etl::etl_file::header_data& /*file_header*/, const etl::parser::compact_trace_header_view& /*trace_header*/, std::span<const std::byte> /*user_data*/) override
+    {
+        ++count;
+    }
+    void handle(const etl::etl_file::header_data& /*file_header*/, const etl::parser::perfinfo_trace_header_view& /*trace_header*/, std::span<const std::byte> /*user_data*/) override
+    {
+        ++count;
+    }
+    void handle(const etl::etl_file::header_data& /*file_header*/, const etl::parser::event_header_trace_header_view& /*trace_header*/, std::span<const std::byte> /*user_data*/) override
+    {
+        ++count;
+    }
+    void handle(const etl::etl_file::header_data& /*file_header*/, const etl::parser::full_header_trace_header_view& /*trace_header*/, std::span<const std::byte> /*user_data*/) override
+    {
+        ++count;
+    }
+    void handle(const etl::etl_file::header_data& /*file_header*/, const etl::parser::instance_trace_header_view& /*trace_header*/, std::span<const std::byte> /*user_data*/) override
+    {
+        ++count;
+    }
+};
+
+std::u16string to_u16string(std::string_view ascii)
+{
+    return std::u16string(ascii.begin(), ascii.end());
+}
+
+// Writes an ETL file with the shape of `generated_trace_shape`.
+void write_generated_etl(const std::filesystem::path& file_path)
+{
+    using shape = generated_trace_shape;
+
+    // 100ns QPC ticks
+    constexpr std::uint64_t qpc_frequency        = 10'000'000;
+    constexpr std::uint64_t start_time_qpc_ticks = 10'000'000;
+
+    constexpr std::uint32_t first_thread_id      = 100000;
+    constexpr std::uint16_t number_of_processors = 8;
+
+    const auto stacks = make_generated_stacks();
+
+    etl::etl_writer writer(file_path,
+                           etl::etl_writer::options{
+                               .buffer_size          = 64 * 1024,
+                               .number_of_processors = number_of_processors,
+                               .qpc_frequency        = qpc_frequency,
+                               .start_time_qpc_ticks = start_time_qpc_ticks,
+                               .start_time           = common::nt_sys_time(std::chrono::seconds(1'700'000'000)),
+                               .compression_format   = common::ms_xca_compression_format::none});
+
+    const auto get_tid = [](std::size_t thread_index)
+    {
+        return static_cast<std::uint32_t>(first_thread_id + thread_index);
+    };
+
+    std::uint64_t timestamp = start_time_qpc_ticks;
+
+    writer.write_process_start(0, timestamp, shape::process_id, 4, "benchmark.exe", u"C:\\benchmark\\benchmark.exe");
+    for(std::size_t module_index = 0; module_index < shape::number_of_modules; ++module_index)
+    {
+        writer.write_image_load(0, timestamp, shape::process_id, shape::module_base_address + module_index * shape::module_size, shape::module_size, 0,
+                                to_u16string(std::format("C:\\benchmark\\module_{}.dll", module_index)));
+    }
+    for(std::size_t thread_index = 0; thread_index < shape::number_of_threads; ++thread_index)
+    {
+        writer.write_thread_start(0, timestamp, shape::process_id, get_tid(thread_index), to_u16string(std::format("thread_{}", thread_index)));
+    }
+
+    std::mt19937_64 random(43);
+    for(std::size_t sample_index = 0; sample_index < shape::samples_per_thread * shape::number_of_threads; ++sample_index)
+    {
+        const auto& stack = stacks[random() % stacks.size()];
+
+        const auto thread_index    = sample_index % shape::number_of_threads;
+        const auto processor_index = static_cast<std::uint16_t>(thread_index % number_of_processors);
+        const auto tid             = get_tid(thread_index);
+
+        ++timestamp;
+        writer.write_sampled_profile(processor_index, timestamp, tid, stack.front());
+        writer.write_stack(processor_index, timestamp, timestamp, shape::process_id, tid, stack);
+    }
+
+    writer.finish();
+}
+
+const std::filesystem::path& get_generated_etl_file()
+{
+    static const auto file = []()
+    {
+        auto result = std::make_unique<temporary_file>("snail-benchmark-generated.etl");
+        write_generated_etl(result->path());
+        return result;
+    }();
+    return file->path();
+}
+
+// Argument: whether to use a memory mapping
+void process_etl_file(benchmark::State& state, const std::filesystem::path& file_path)
+{
+    const auto use_memory_map = state.range(0) != 0;
+
+    std::optional<etl::etl_file> file;
+
+    // Process the file once before measuring, which also makes sure that it is valid.
+    try
+    {
+        file.emplace(file_path, use_memory_map);
+
+        counting_event_observer observer;
+        file->process(observer);
+    }
+    catch(const std::exception& error)
+    {
+        state.SkipWithError(error.what());
+        return;
+    }
+
+    std::size_t events = 0;
+    for(auto _ : state)
+    {
+        counting_event_observer observer;
+        file->process(observer);
+        events += observer.count;
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * std::filesystem::file_size(file_path)));
+    state.counters["events"] = benchmark::Counter(static_cast<double>(events), benchmark::Counter::kIsRate);
+}
+
+// Argument: whether to use a memory mapping
+void etl_file_process(benchmark::State& state, const std::filesystem::path& relative_path)
+{
+    const auto file_path = find_test_file(state, relative_path);
+    if(!file_path) return;
+
+    process_etl_file(state, *file_path);
+}
+
+// Argument: whether to use a memory mapping
+//
+// Unlike the benchmarks on the recorded files, this one does not depend on any test data.
+void etl_file_process_generated(benchmark::State& state)
+{
+    try
+    {
+        process_etl_file(state, get_generated_etl_file());
+    }
+    catch(const std::exception& error)
+    {
+        state.SkipWithError(error.what());
+    }
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(etl_file_process, ordered, std::filesystem::path("tests") / "apps" / "ordered" / "dist" / "windows" / "deb" / "record" / "ordered_merged.etl")
+    ->ArgName("memory_map")
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(etl_file_process_generated)
+    ->ArgName("memory_map")
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond);
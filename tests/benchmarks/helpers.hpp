@@ -0,0 +1,103 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <folders.hpp>
+
+namespace snail::detail::tests {
+
+// Returns the full path to a file from the test data or marks the benchmark as skipped
+// if it can not be found.
+inline std::optional<std::filesystem::path> find_test_file(benchmark::State&            state,
+                                                           const std::filesystem::path& relative_path)
+{
+    const auto root_dir = get_root_dir();
+    if(!root_dir)
+    {
+        state.SkipWithError("Missing root dir. Did you forget to pass --snail-root-dir=<dir> to the benchmark executable?");
+        return std::nullopt;
+    }
+
+    auto file_path = *root_dir / relative_path;
+    if(!std::filesystem::exists(file_path))
+    {
+        state.SkipWithError(("Missing test file: " + file_path.string()).c_str());
+        return std::nullopt;
+    }
+    return file_path;
+}
+
+// A file in the temporary directory that is removed again when this object is destroyed.
+// Used for traces that are generated by the benchmarks themselves, so that those do not depend
+// on the recorded test data.
+class temporary_file
+{
+public:
+    explicit temporary_file(const std::filesystem::path& filename) :
+        path_(std::filesystem::temp_directory_path() / filename)
+    {}
+
+    ~temporary_file()
+    {
+        std::error_code error;
+        std::filesystem::remove(path_, error);
+    }
+
+    temporary_file(const temporary_file&)            = delete;
+    temporary_file& operator=(const temporary_file&) = delete;
+
+    const std::filesystem::path& path() const
+    {
+        return path_;
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+// Shape of the traces that are generated by the benchmarks. Every module occupies 1 MiB of the
+// address space of the single process, which spreads its samples evenly over all threads.
+struct generated_trace_shape
+{
+    static constexpr std::uint64_t module_base_address = 0x7f00'0000'0000;
+    static constexpr std::uint64_t module_size         = 0x10'0000;
+
+    static constexpr std::uint32_t process_id         = 1000;
+    static constexpr std::size_t   number_of_threads  = 8;
+    static constexpr std::size_t   number_of_modules  = 16;
+    static constexpr std::size_t   samples_per_thread = 25'000;
+};
+
+// Returns a fixed set of random stacks (innermost frame first) within the modules of
+// `generated_trace_shape`. The stacks are the same on every run.
+inline std::vector<std::vector<std::uint64_t>> make_generated_stacks()
+{
+    constexpr std::size_t number_of_stacks = 256;
+    constexpr std::size_t min_stack_depth  = 4;
+    constexpr std::size_t max_stack_depth  = 48;
+
+    std::mt19937_64 random(42);
+
+    std::vector<std::vector<std::uint64_t>> stacks(number_of_stacks);
+    for(auto& stack : stacks)
+    {
+        stack.resize(min_stack_depth + random() % (max_stack_depth - min_stack_depth + 1));
+        for(auto& address : stack)
+        {
+            address = generated_trace_shape::module_base_address +
+                      (random() % generated_trace_shape::number_of_modules) * generated_trace_shape::module_size +
+                      random() % generated_trace_shape::module_size;
+        }
+    }
+    return stacks;
+}
+
+} // namespace snail::detail::tests
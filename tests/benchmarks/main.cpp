@@ -0,0 +1,14 @@
+#include <benchmark/benchmark.h>
+
+#include <folders.hpp>
+
+int main(int argc, char** argv)
+{
+    ::benchmark::Initialize(&argc, argv);
+
+    snail::detail::tests::parse_command_line(argc, argv);
+
+    ::benchmark::RunSpecifiedBenchmarks();
+    ::benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <snail/analysis/detail/module_map.hpp>
+
+using namespace snail;
+using namespace snail::analysis::detail;
+
+namespace {
+
+struct module_id
+{
+    std::size_t id;
+
+    [[nodiscard]] friend bool operator==(const module_id& lhs, const module_id& rhs)
+    {
+        return lhs.id == rhs.id;
+    }
+};
+
+using timestamp_t = std::uint64_t;
+
+struct module_load
+{
+    module_info<module_id> module;
+    timestamp_t            load_timestamp;
+};
+
+// Modules that are loaded at increasing addresses, where every 8th module is later replaced by
+// another module that overlaps with it and its neighbors.
+std::vector<module_load> make_module_loads(std::size_t module_count)
+{
+    std::mt19937 random(42);
+
+    std::uniform_int_distribution<std::uint64_t> size_distribution(0x1'0000, 0x10'0000);
+    std::uniform_int_distribution<std::uint64_t> gap_distribution(0, 0x1'0000);
+
+    std::vector<module_load> result;
+
+    std::uint64_t next_base = 0x7f00'0000'0000;
+    for(std::size_t i = 0; i < module_count; ++i)
+    {
+        const auto size = size_distribution(random);
+        result.push_back(module_load{
+            .module         = {.base = next_base, .size = size, .payload = {.id = i}},
+            .load_timestamp = i
+        });
+        next_base += size + gap_distribution(random);
+    }
+
+    for(std::size_t i = 0; i < module_count; i += 8)
+    {
+        const auto& replaced = result[i].module;
+        result.push_back(module_load{
+            .module         = {.base = replaced.base + replaced.size / 2, .size = replaced.size, .payload = {.id = module_count + i}},
+            .load_timestamp = module_count + i
+        });
+    }
+
+    return result;
+}
+
+// Argument: number of modules
+void module_map_insert(benchmark::State& state)
+{
+    const auto module_loads = make_module_loads(static_cast<std::size_t>(state.range(0)));
+
+    for(auto _ : state)
+    {
+        module_map<module_id, timestamp_t> map;
+        for(const auto& load : module_loads)
+        {
+            map.insert(load.module, load.load_timestamp);
+        }
+        benchmark::DoNotOptimize(map);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * module_loads.size()));
+}
+
+// Argument: number of modules
+void module_map_find(benchmark::State& state)
+{
+    const auto module_loads = make_module_loads(static_cast<std::size_t>(state.range(0)));
+
+    module_map<module_id, timestamp_t> map;
+    for(const auto& load : module_loads)
+    {
+        map.insert(load.module, load.load_timestamp);
+    }
+
+    // Look up addresses within the loaded modules, at random times after they have been loaded.
+    std::mt19937 random(1337);
+
+    constexpr std::size_t lookup_count = 4096;
+
+    std::vector<std::pair<std::uint64_t, timestamp_t>> lookups;
+    for(std::size_t i = 0; i < lookup_count; ++i)
+    {
+        const auto& load = module_loads[std::uniform_int_distribution<std::size_t>(0, module_loads.size() - 1)(random)];
+
+        const auto address   = load.module.base + std::uniform_int_distribution<std::uint64_t>(0, load.module.size - 1)(random);
+        const auto timestamp = load.load_timestamp + std::uniform_int_distribution<timestamp_t>(0, module_loads.size())(random);
+        lookups.emplace_back(address, timestamp);
+    }
+
+    for(auto _ : state)
+    {
+        for(const auto& [address, timestamp] : lookups)
+        {
+            benchmark::DoNotOptimize(map.find(address, timestamp));
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * lookups.size()));
+}
+
+} // namespace
+
+BENCHMARK(module_map_insert)
+    ->ArgName("modules")
+    ->RangeMultiplier(8)
+    ->Range(8, 4096);
+
+BENCHMARK(module_map_find)
+    ->ArgName("modules")
+    ->RangeMultiplier(8)
+    ->Range(8, 4096);
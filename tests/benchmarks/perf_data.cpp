@@ -0,0 +1,178 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <optional>
+#include <random>
+
+#include <helpers.hpp>
+
+#include <snail/perf_data/perf_data_file.hpp>
+#include <snail/perf_data/perf_data_writer.hpp>
+
+using namespace snail;
+using namespace snail::detail::tests;
+
+namespace {
+
+class counting_event_observer : public perf_data::event_observer
+{
+public:
+    std::size_t count = 0;
+
+    void handle(const perf_data::parser::event_header_view& /*event_header*/, const perf_data::parser::event_attributes& /*attributes*/, std::span<const std::byte> /*event_data*/, std::endian /*byte_order*/) override
+    {
+        ++count;
+    }
+    void handle(const perf_data::parser::event_header_view& /*event_header*/, std::span<const std::byte> /*event_data*/, std::endian /*byte_order*/) override
+    {
+        ++count;
+    }
+};
+
+// Writes a perf.data file with the shape of `generated_trace_shape`.
+void write_generated_perf_data(const std::filesystem::path& file_path)
+{
+    using shape = generated_trace_shape;
+
+    // perf finishes a round whenever it has flushed the buffers of all CPUs.
+    // We simply emit one after a fixed number of samples.
+    constexpr std::size_t samples_per_round = 1000;
+
+    const auto stacks = make_generated_stacks();
+
+    perf_data::perf_data_writer writer(file_path,
+                                       perf_data::perf_data_writer::options{
+                                           .hostname          = "benchmark",
+                                           .os_release        = "6.0.0-benchmark",
+                                           .arch              = "x86_64",
+                                           .number_of_cpus    = 8,
+                                           .command_line      = {"perf", "record", "-g", "benchmark"},
+                                           .event_name        = "cpu-clock",
+                                           .sample_period     = 1'000'000,
+                                           .compression_level = std::nullopt,
+                                           .pipe_mode         = false});
+
+    // On Linux, the main thread has the same id as its process.
+    const auto get_tid = [](std::size_t thread_index)
+    {
+        return static_cast<std::uint32_t>(shape::process_id + thread_index);
+    };
+
+    std::uint64_t time = 1'000'000'000;
+
+    writer.write_fork(time, shape::process_id, 1, shape::process_id, 1);
+    writer.write_comm(time, shape::process_id, shape::process_id, "benchmark");
+    for(std::size_t module_index = 0; module_index < shape::number_of_modules; ++module_index)
+    {
+        writer.write_mmap2(time, shape::process_id, shape::process_id, shape::module_base_address + module_index * shape::module_size, shape::module_size, 0,
+                           std::format("/usr/lib/benchmark/libmodule_{}.so", module_index));
+    }
+    for(std::size_t thread_index = 1; thread_index < shape::number_of_threads; ++thread_index)
+    {
+        writer.write_fork(time, shape::process_id, shape::process_id, get_tid(thread_index), shape::process_id);
+    }
+    writer.write_finished_round();
+
+    std::mt19937_64 random(43);
+    for(std::size_t sample_index = 0; sample_index < shape::samples_per_thread * shape::number_of_threads; ++sample_index)
+    {
+        const auto& stack = stacks[random() % stacks.size()];
+
+        writer.write_sample(++time, shape::process_id, get_tid(sample_index % shape::number_of_threads), stack.front(), stack);
+        if((sample_index + 1) % samples_per_round == 0) writer.write_finished_round();
+    }
+
+    writer.finish();
+}
+
+const std::filesystem::path& get_generated_perf_data_file()
+{
+    static const auto file = []()
+    {
+        auto result = std::make_unique<temporary_file>("snail-benchmark-generated.perf.data");
+        write_generated_perf_data(result->path());
+        return result;
+    }();
+    return file->path();
+}
+
+// Argument: whether to use a memory mapping
+void process_perf_data_file(benchmark::State& state, const std::filesystem::path& file_path)
+{
+    const auto use_memory_map = state.range(0) != 0;
+
+    std::optional<perf_data::perf_data_file> file;
+
+    // Process the file once before measuring, which also makes sure that it is valid.
+    try
+    {
+        file.emplace(file_path, use_memory_map);
+
+        counting_event_observer observer;
+        file->process(observer);
+    }
+    catch(const std::exception& error)
+    {
+        state.SkipWithError(error.what());
+        return;
+    }
+
+    std::size_t events = 0;
+    for(auto _ : state)
+    {
+        counting_event_observer observer;
+        file->process(observer);
+        events += observer.count;
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * std::filesystem::file_size(file_path)));
+    state.counters["events"] = benchmark::Counter(static_cast<double>(events), benchmark::Counter::kIsRate);
+}
+
+// Argument: whether to use a memory mapping
+void perf_data_file_process(benchmark::State& state, const std::filesystem::path& relative_path)
+{
+    const auto file_path = find_test_file(state, relative_path);
+    if(!file_path) return;
+
+    process_perf_data_file(state, *file_path);
+}
+
+// Argument: whether to use a memory mapping
+//
+// Unlike the benchmarks on the recorded files, this one does not depend on any test data.
+void perf_data_file_process_generated(benchmark::State& state)
+{
+    try
+    {
+        process_perf_data_file(state, get_generated_perf_data_file());
+    }
+    catch(const std::exception& error)
+    {
+        state.SkipWithError(error.what());
+    }
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(perf_data_file_process, inner, std::filesystem::path("tests") / "apps" / "inner" / "dist" / "linux" / "deb" / "record" / "inner-perf.data")
+    ->ArgName("memory_map")
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(perf_data_file_process, ordered, std::filesystem::path("tests") / "apps" / "ordered" / "dist" / "linux" / "deb" / "record" / "ordered-perf.data")
+    ->ArgName("memory_map")
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(perf_data_file_process_generated)
+    ->ArgName("memory_map")
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,163 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <helpers.hpp>
+
+#include <snail/analysis/detail/dwarf_resolver.hpp>
+#include <snail/analysis/detail/pdb_resolver.hpp>
+
+#include <snail/analysis/options.hpp>
+#include <snail/analysis/path_map.hpp>
+
+using namespace snail;
+using namespace snail::analysis;
+using namespace snail::analysis::detail;
+using namespace snail::detail::tests;
+
+namespace {
+
+// The range of a function in the image, relative to its start.
+struct function_range
+{
+    std::uint64_t begin;
+    std::uint64_t end;
+};
+
+// Returns every address (relative to the start of the image) within the given functions.
+std::vector<std::uint64_t> make_relative_addresses(std::initializer_list<function_range> functions)
+{
+    std::vector<std::uint64_t> result;
+    for(const auto& function : functions)
+    {
+        for(auto address = function.begin; address < function.end; ++address)
+        {
+            result.push_back(address);
+        }
+    }
+    return result;
+}
+
+// Resolves all addresses with the given resolver and returns the number of resolved symbols that are not generic.
+template<typename Resolver>
+std::size_t resolve_all(Resolver& resolver, const typename Resolver::module_info& module, const std::vector<std::uint64_t>& addresses)
+{
+    std::size_t resolved = 0;
+    for(const auto address : addresses)
+    {
+        const auto& symbol = resolver.resolve_symbol(module, address);
+        benchmark::DoNotOptimize(&symbol);
+        if(!symbol.is_generic) ++resolved;
+    }
+    return resolved;
+}
+
+// Argument: whether to keep the resolver (and hence its caches) across iterations.
+//
+// With a fresh resolver per iteration, this measures loading the debug information and the
+// first lookup of every address. Otherwise, all lookups after the first iteration hit the
+// symbol cache of the resolver.
+template<typename Resolver, typename MakeResolver>
+void resolve_symbols(benchmark::State& state, MakeResolver make_resolver, const typename Resolver::module_info& module, const std::vector<std::uint64_t>& addresses)
+{
+    const auto keep_resolver = state.range(0) != 0;
+
+    // Resolve the addresses once before measuring, which also makes sure that the debug
+    // information is available. Without LLVM support, or if the test binaries are only
+    // Git LFS pointers, all symbols would be generic.
+    auto resolver = make_resolver();
+    if(resolve_all(*resolver, module, addresses) == 0)
+    {
+        state.SkipWithError("Could not resolve any symbol. Is snail built with LLVM support and are the Git LFS files checked out?");
+        return;
+    }
+
+    for(auto _ : state)
+    {
+        if(!keep_resolver)
+        {
+            state.PauseTiming();
+            resolver = make_resolver();
+            state.ResumeTiming();
+        }
+        resolve_all(*resolver, module, addresses);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * addresses.size()));
+}
+
+void dwarf_resolver_resolve(benchmark::State& state)
+{
+    const auto exe_path = find_test_file(state, std::filesystem::path("tests") / "apps" / "inner" / "dist" / "linux" / "deb" / "bin" / "inner");
+    if(!exe_path) return;
+
+    const auto exe_path_str = exe_path->string();
+
+    const dwarf_resolver::module_info module = {
+        .image_filename = std::string_view(exe_path_str),
+        .build_id       = {},
+        .image_base     = 0x0040'2000,
+        .page_offset    = 0x0000'2000,
+        .process_id     = 456,
+        .load_timestamp = 789};
+
+    // compute_inner_product and main
+    auto addresses = make_relative_addresses({
+        {0x245a, 0x245a + 0x100},
+        {0x25e0, 0x25e0 + 0x100}
+    });
+    for(auto& address : addresses) address += module.image_base - module.page_offset;
+
+    resolve_symbols<dwarf_resolver>(
+        state, []()
+        { return std::make_unique<dwarf_resolver>(); },
+        module, addresses);
+}
+
+void pdb_resolver_resolve(benchmark::State& state)
+{
+    const auto exe_path = find_test_file(state, std::filesystem::path("tests") / "apps" / "inner" / "dist" / "windows" / "deb" / "bin" / "inner.exe");
+    if(!exe_path) return;
+
+    const auto exe_path_str = exe_path->string();
+
+    const pdb_resolver::module_info module = {
+        .image_filename = std::string_view(exe_path_str),
+        .image_base     = 0x0040'2000,
+        .checksum       = 0,
+        .pdb_info       = {},
+        .process_id     = 456,
+        .load_timestamp = 789};
+
+    // make_random_vector and compute_inner_product
+    auto addresses = make_relative_addresses({
+        {0x1A80, 0x1BE2},
+        {0x1BF0, 0x1CCB}
+    });
+    for(auto& address : addresses) address += module.image_base;
+
+    resolve_symbols<pdb_resolver>(
+        state, []()
+        { return std::make_unique<pdb_resolver>(pdb_symbol_find_options{}, path_map{}, filter_options{}, false); },
+        module, addresses);
+}
+
+} // namespace
+
+BENCHMARK(dwarf_resolver_resolve)
+    ->ArgName("keep_resolver")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(pdb_resolver_resolve)
+    ->ArgName("keep_resolver")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
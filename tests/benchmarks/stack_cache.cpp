@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <snail/analysis/detail/stack_cache.hpp>
+
+#include <snail/common/types.hpp>
+
+using namespace snail;
+using namespace snail::analysis::detail;
+
+namespace {
+
+// Stacks (innermost frame first) of up to 64 frames that share some outer frames, and continue with
+// instruction pointers from a limited set, so that there are common prefixes of varying lengths.
+std::vector<std::vector<common::instruction_pointer_t>> make_stacks(std::size_t stack_count)
+{
+    std::mt19937 random(42);
+
+    std::uniform_int_distribution<std::size_t>                   depth_distribution(8, 64);
+    std::uniform_int_distribution<common::instruction_pointer_t> instruction_pointer_distribution(0, 31);
+
+    constexpr std::size_t shared_depth = 6;
+
+    std::vector<std::vector<common::instruction_pointer_t>> result;
+    for(std::size_t i = 0; i < stack_count; ++i)
+    {
+        // Build the stack from the outermost frame
+        std::vector<common::instruction_pointer_t> stack;
+        for(std::size_t depth = 0; depth < shared_depth; ++depth)
+        {
+            stack.push_back(0x40'0000 + depth * 0x100);
+        }
+
+        const auto depth = depth_distribution(random);
+        while(stack.size() < depth)
+        {
+            stack.push_back(0x7f00'0000'0000 + stack.size() * 0x1000 + instruction_pointer_distribution(random) * 0x10);
+        }
+
+        std::ranges::reverse(stack);
+        result.push_back(std::move(stack));
+    }
+    return result;
+}
+
+// Argument: number of stacks
+//
+// Inserts stacks into an empty cache, hence most of them are new.
+void stack_cache_insert(benchmark::State& state)
+{
+    const auto stacks = make_stacks(static_cast<std::size_t>(state.range(0)));
+
+    for(auto _ : state)
+    {
+        stack_cache cache;
+        for(const auto& stack : stacks)
+        {
+            benchmark::DoNotOptimize(cache.insert(stack));
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * stacks.size()));
+}
+
+// Argument: number of stacks
+//
+// Inserts stacks into a cache that already contains all of them.
+void stack_cache_insert_existing(benchmark::State& state)
+{
+    const auto stacks = make_stacks(static_cast<std::size_t>(state.range(0)));
+
+    stack_cache cache;
+    for(const auto& stack : stacks)
+    {
+        cache.insert(stack);
+    }
+
+    for(auto _ : state)
+    {
+        for(const auto& stack : stacks)
+        {
+            benchmark::DoNotOptimize(cache.insert(stack));
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * stacks.size()));
+}
+
+} // namespace
+
+BENCHMARK(stack_cache_insert)
+    ->ArgName("stacks")
+    ->RangeMultiplier(10)
+    ->Range(1'000, 100'000);
+
+BENCHMARK(stack_cache_insert_existing)
+    ->ArgName("stacks")
+    ->RangeMultiplier(10)
+    ->Range(1'000, 100'000);
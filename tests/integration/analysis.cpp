@@ -1,8 +1,11 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cmath>
+#include <numeric>
 #include <ranges>
+#include <tuple>
 
 #include <folders.hpp>
 
@@ -72,6 +75,90 @@ struct test_progress_listener : public common::progress_listener
     std::optional<cancel_info> cancel_at = std::nullopt;
 };
 
+struct sample_summary
+{
+    std::chrono::nanoseconds     timestamp;
+    std::optional<std::uint64_t> stack_key;
+    bool                         has_stack;
+    bool                         has_frame;
+    std::vector<std::string>     stack_symbols;
+
+    friend bool operator==(const sample_summary&, const sample_summary&) = default;
+};
+
+std::vector<std::string> to_symbols(common::generator<analysis::stack_frame> stack)
+{
+    std::vector<std::string> result;
+    for(const auto& frame : stack) result.emplace_back(frame.symbol_name);
+    return result;
+}
+
+void sort_by_time(std::vector<sample_summary>& samples)
+{
+    std::ranges::stable_sort(samples, [](const sample_summary& lhs, const sample_summary& rhs)
+                             { return std::tie(lhs.timestamp, lhs.stack_key) < std::tie(rhs.timestamp, rhs.stack_key); });
+}
+
+// Checks that the batched samples are the same as the samples yielded one by one.
+void expect_equal_sample_batches(const analysis::samples_provider& data_provider,
+                                 analysis::sample_source_info::id_t source_id,
+                                 analysis::unique_process_id        process_id,
+                                 const analysis::sample_filter&     filter)
+{
+    std::vector<sample_summary> expected_samples;
+    for(const auto& sample : data_provider.samples(source_id, process_id, filter))
+    {
+        expected_samples.push_back(sample_summary{
+            .timestamp     = sample.timestamp(),
+            .stack_key     = sample.stack_key(),
+            .has_stack     = sample.has_stack(),
+            .has_frame     = sample.has_frame(),
+            .stack_symbols = to_symbols(sample.reversed_stack())});
+    }
+
+    std::vector<sample_summary> batched_samples;
+    for(const auto& batch : data_provider.sample_batches(source_id, process_id, filter))
+    {
+        const auto records = batch.records();
+        for(std::size_t i = 0; i < records.size(); ++i)
+        {
+            if(i > 0)
+            {
+                EXPECT_LE(records[i - 1].timestamp, records[i].timestamp);
+            }
+
+            const auto& sample = batch.sample(i);
+            EXPECT_EQ(records[i].timestamp, sample.timestamp());
+
+            batched_samples.push_back(sample_summary{
+                .timestamp     = records[i].timestamp,
+                .stack_key     = records[i].stack_key,
+                .has_stack     = records[i].has_stack,
+                .has_frame     = records[i].instruction_pointer.has_value(),
+                .stack_symbols = to_symbols(sample.reversed_stack())});
+        }
+    }
+
+    sort_by_time(expected_samples);
+    sort_by_time(batched_samples);
+    EXPECT_EQ(batched_samples.size(), expected_samples.size());
+    EXPECT_TRUE(batched_samples == expected_samples);
+}
+
+// Checks that the time buckets of a thread cover all of its samples.
+void expect_complete_sample_timeline(const analysis::data_provider&     data_provider,
+                                     analysis::sample_source_info::id_t source_id,
+                                     analysis::unique_thread_id         thread_id)
+{
+    constexpr std::size_t bucket_count = 10;
+
+    const auto bucket_duration = data_provider.session_info().runtime / bucket_count + std::chrono::nanoseconds(1);
+
+    const auto counts = data_provider.count_samples_per_time_bucket(source_id, thread_id, std::chrono::nanoseconds(0), bucket_duration, bucket_count);
+    EXPECT_EQ(counts.size(), bucket_count);
+    EXPECT_EQ(std::accumulate(counts.begin(), counts.end(), std::size_t(0)), data_provider.count_samples(source_id, thread_id));
+}
+
 } // namespace
 
 namespace snail::analysis {
@@ -306,6 +393,7 @@ TEST(DiagsessionDataProvider, ProcessInner)
     }
     EXPECT_EQ(sample_count, 292);
     EXPECT_EQ(data_provider.count_samples(sample_source.id, unique_sampling_process_id, filter), 292);
+    expect_equal_sample_batches(data_provider, sample_source.id, unique_sampling_process_id, filter);
     EXPECT_EQ(data_provider.count_samples(sample_source.id, thread_4224.unique_id, filter), 3);
     EXPECT_EQ(data_provider.count_samples(sample_source.id, thread_6180.unique_id, filter), 2);
     EXPECT_EQ(data_provider.count_samples(sample_source.id, thread_3828.unique_id, filter), 286);
@@ -514,6 +602,11 @@ TEST(DiagsessionDataProvider, ProcessInner)
     EXPECT_EQ(data_provider.count_samples(sample_source.id, thread_6180.unique_id, filter), 2);
     EXPECT_EQ(data_provider.count_samples(sample_source.id, thread_3828.unique_id, filter), 286);
     EXPECT_EQ(data_provider.count_samples(sample_source.id, thread_3148.unique_id, filter), 1);
+
+    for(const auto& thread : {thread_4224, thread_6180, thread_3828, thread_3148})
+    {
+        expect_complete_sample_timeline(data_provider, sample_source.id, thread.unique_id);
+    }
 }
 
 TEST(DiagsessionDataProvider, ProcessInnerCancel)
@@ -889,6 +982,7 @@ TEST(PerfDataDataProvider, ProcessInner)
     EXPECT_EQ(sample_count, 1524);
     EXPECT_EQ(data_provider.count_samples(sample_source.id, unique_sampling_process_id, filter), 1524);
     EXPECT_EQ(data_provider.count_samples(sample_source.id, threads[0].unique_id, filter), 1524);
+    expect_equal_sample_batches(data_provider, sample_source.id, unique_sampling_process_id, filter);
 
     // Filter complete range
     filter.min_time = 0ns;
@@ -1036,6 +1130,8 @@ TEST(PerfDataDataProvider, ProcessInner)
     EXPECT_EQ(sample_count, 0);
     EXPECT_EQ(data_provider.count_samples(sample_source.id, unique_sampling_process_id, filter), 0);
     EXPECT_EQ(data_provider.count_samples(sample_source.id, threads[0].unique_id, filter), 1524);
+
+    expect_complete_sample_timeline(data_provider, sample_source.id, threads[0].unique_id);
 }
 
 TEST(PerfDataDataProvider, ProcessInnerCancel)
@@ -443,3 +443,40 @@ TEST(EtlFile, ReadInnerCancel)
     EXPECT_EQ(guid_event_counts, expected_guid_event_counts);
     EXPECT_EQ(group_event_counts, expected_group_event_counts);
 }
+
+TEST(EtlFile, ReadOrderedStreamAndMapped)
+{
+    ASSERT_TRUE(get_root_dir().has_value()) << "Missing root dir. Did you forget to pass --snail-root-dir=<dir> to the test executable?";
+    const auto file_path = get_root_dir().value() / "tests" / "apps" / "ordered" / "dist" / "windows" / "deb" / "record" / "ordered_merged.etl";
+    ASSERT_TRUE(std::filesystem::exists(file_path)) << "Missing test file:\n  " << file_path << "\nDid you forget checking out GIT LFS files?";
+
+    etl::etl_file mapped_file(file_path, true);
+    etl::etl_file stream_file(file_path, false);
+
+    EXPECT_TRUE(mapped_file.is_memory_mapped());
+    EXPECT_FALSE(stream_file.is_memory_mapped());
+
+    const auto collect_timestamps = [](etl::etl_file& file)
+    {
+        std::vector<std::uint64_t> timestamps;
+
+        etl::dispatching_event_observer observer;
+        observer.register_unknown_event(
+            [&timestamps]([[maybe_unused]] const etl::etl_file::header_data& file_header,
+                          const etl::any_group_trace_header&                 header,
+                          [[maybe_unused]] const std::span<const std::byte>& event_data)
+            {
+                timestamps.push_back(std::visit([](const auto& header)
+                                                { return std::uint64_t(header.system_time()); },
+                                                header));
+            });
+        file.process(observer);
+        return timestamps;
+    };
+
+    const auto mapped_timestamps = collect_timestamps(mapped_file);
+    const auto stream_timestamps = collect_timestamps(stream_file);
+
+    EXPECT_FALSE(mapped_timestamps.empty());
+    EXPECT_EQ(mapped_timestamps, stream_timestamps);
+}
@@ -313,3 +313,27 @@ TEST(PerfDataFile, ReadInnerCancel)
 
     EXPECT_EQ(counting_observer.counts, expected_event_counts);
 }
+
+TEST(PerfDataFile, ReadInnerStreamAndMapped)
+{
+    ASSERT_TRUE(get_root_dir().has_value()) << "Missing root dir. Did you forget to pass --snail-root-dir=<dir> to the test executable?";
+    const auto file_path = get_root_dir().value() / "tests" / "apps" / "inner" / "dist" / "linux" / "deb" / "record" / "inner-perf.data";
+    ASSERT_TRUE(std::filesystem::exists(file_path)) << "Missing test file:\n  " << file_path << "\nDid you forget checking out GIT LFS files?";
+
+    perf_data::perf_data_file mapped_file(file_path, true);
+    perf_data::perf_data_file stream_file(file_path, false);
+
+    EXPECT_TRUE(mapped_file.is_memory_mapped());
+    EXPECT_FALSE(stream_file.is_memory_mapped());
+
+    counting_event_observer mapped_counting_observer;
+    counting_event_observer stream_counting_observer;
+
+    mapped_file.process(mapped_counting_observer);
+    stream_file.process(stream_counting_observer);
+
+    EXPECT_EQ(mapped_counting_observer.counts, stream_counting_observer.counts);
+    EXPECT_EQ(mapped_file.metadata().hostname, stream_file.metadata().hostname);
+    EXPECT_EQ(mapped_file.metadata().sample_time->start, stream_file.metadata().sample_time->start);
+    EXPECT_EQ(mapped_file.metadata().event_desc.size(), stream_file.metadata().event_desc.size());
+}
@@ -50,6 +50,19 @@ export interface ThreadSampleInfo {
     counts: SampleCountInfo[];
 }
 
+export interface SampleTimelineCounts {
+    sourceId: number;
+
+    // The number of samples in each time bucket.
+    counts: number[];
+}
+
+export interface ThreadSampleTimeline {
+    key: number;
+
+    counts: SampleTimelineCounts[];
+}
+
 export interface PmcCounterInfo {
     count: number;
 
@@ -304,6 +317,32 @@ export interface RetrieveProcessSampleInfoResult {
     threads: ThreadSampleInfo[];
 }
 
+export interface RetrieveSampleTimelineParams {
+    bucketCount: number;
+
+    // In nanoseconds since session start. Defaults to the session start.
+    startTime?: number;
+
+    // In nanoseconds since session start. Defaults to the session end.
+    endTime?: number;
+
+    processKey: number;
+
+    // The id of the document to perform the operation on.
+    // This should be an id that resulted from a call to `readDocument`.
+    documentId: number;
+}
+
+export interface RetrieveSampleTimelineResult {
+    // Start time of the first bucket (in nanoseconds since the session start).
+    startTime: number;
+
+    // Duration of each bucket (in nanoseconds).
+    bucketDuration: number;
+
+    threads: ThreadSampleTimeline[];
+}
+
 export interface RetrieveCallTreeHotPathParams extends WorkDoneProgressParams {
     sourceId: number;
 
@@ -480,6 +519,9 @@ export const retrieveHottestFunctionsRequestType = new rpc.RequestType<RetrieveH
 export const retrieveProcessSampleInfoRequestType = new rpc.RequestType<RetrieveProcessSampleInfoParams, RetrieveProcessSampleInfoResult, void>('retrieveProcessSampleInfo');
 
 
+export const retrieveSampleTimelineRequestType = new rpc.RequestType<RetrieveSampleTimelineParams, RetrieveSampleTimelineResult, void>('retrieveSampleTimeline');
+
+
 export const retrieveCallTreeHotPathRequestType = new rpc.RequestType<RetrieveCallTreeHotPathParams, RetrieveCallTreeHotPathResult, void>('retrieveCallTreeHotPath');
 
 
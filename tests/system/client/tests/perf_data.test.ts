@@ -231,6 +231,33 @@ describe("InnerPerfData", function () {
         assert.strictEqual(thread_info!.counts[0].numberOfSamples, 1524);
     });
 
+    it("sampleTimeline", async () => {
+        const processesResponse = await fixture.connection.sendRequest(snail.retrieveProcessesRequestType, {
+            documentId: documentId
+        });
+        const process = processesResponse.processes.find(proc => proc.osId == 248);
+        assert.isDefined(process);
+
+        const thread = process!.threads[0]
+
+        const response = await fixture.connection.sendRequest(snail.retrieveSampleTimelineRequestType, {
+            documentId: documentId,
+            processKey: process!.key,
+            bucketCount: 20
+        });
+
+        assert.strictEqual(response.startTime, 0);
+        assert.isAbove(response.bucketDuration, 0);
+        assert.strictEqual(response.threads.length, 1);
+
+        const thread_timeline = response.threads.find(info => info.key == thread.key);
+        assert.isDefined(thread_timeline);
+        assert.strictEqual(thread_timeline!.counts.length, 1);
+        assert.strictEqual(thread_timeline!.counts[0].sourceId, sourceId);
+        assert.strictEqual(thread_timeline!.counts[0].counts.length, 20);
+        assert.strictEqual(thread_timeline!.counts[0].counts.reduce((sum, count) => sum + count, 0), 1524);
+    });
+
     it("callTreeHotPath", async () => {
         const processesResponse = await fixture.connection.sendRequest(snail.retrieveProcessesRequestType, {
             documentId: documentId
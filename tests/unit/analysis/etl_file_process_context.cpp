@@ -1304,17 +1304,17 @@ TEST(EtlFileProcessContext, Stacks)
     EXPECT_EQ(thread_1_samples[0].timestamp, 10);
     EXPECT_EQ(thread_1_samples[0].thread_id, 111);
     EXPECT_EQ(thread_1_samples[0].instruction_pointer, 0x1'234A);
-    EXPECT_NE(thread_1_samples[0].user_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*thread_1_samples[0].user_mode_stack), (std::vector<std::uint64_t>{0x1'234B, 0x1'234C, 0x1'234D}));
-    EXPECT_NE(thread_1_samples[0].kernel_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*thread_1_samples[0].kernel_mode_stack), (std::vector<std::uint64_t>{0x1234'B000'0000'0000, 0x1234'C000'0000'0000, 0x1234'D000'0000'0000}));
+    EXPECT_NE(thread_1_samples[0].user_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(thread_1_samples[0].user_mode_stack), (std::vector<std::uint64_t>{0x1'234B, 0x1'234C, 0x1'234D}));
+    EXPECT_NE(thread_1_samples[0].kernel_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(thread_1_samples[0].kernel_mode_stack), (std::vector<std::uint64_t>{0x1234'B000'0000'0000, 0x1234'C000'0000'0000, 0x1234'D000'0000'0000}));
 
     EXPECT_EQ(thread_1_samples[1].timestamp, 20);
     EXPECT_EQ(thread_1_samples[1].thread_id, 111);
     EXPECT_EQ(thread_1_samples[1].instruction_pointer, 0x5'678A);
-    EXPECT_NE(thread_1_samples[1].user_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*thread_1_samples[1].user_mode_stack), (std::vector<std::uint64_t>{0x5'678B, 0x5'678C, 0x5'678D}));
-    EXPECT_EQ(thread_1_samples[1].kernel_mode_stack, std::nullopt);
+    EXPECT_NE(thread_1_samples[1].user_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(thread_1_samples[1].user_mode_stack), (std::vector<std::uint64_t>{0x5'678B, 0x5'678C, 0x5'678D}));
+    EXPECT_EQ(thread_1_samples[1].kernel_mode_stack, stack_cache::no_stack);
 }
 
 TEST(EtlFileProcessContext, MixedSamplesStacks)
@@ -1387,17 +1387,17 @@ TEST(EtlFileProcessContext, MixedSamplesStacks)
     EXPECT_EQ(samples_1[0].timestamp, 10);
     EXPECT_EQ(samples_1[0].thread_id, 111);
     EXPECT_EQ(samples_1[0].instruction_pointer, 0x1'234A);
-    EXPECT_NE(samples_1[0].user_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*samples_1[0].user_mode_stack), (std::vector<std::uint64_t>{0x1'234B, 0x1'234C, 0x1'234D}));
-    EXPECT_NE(samples_1[0].kernel_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*samples_1[0].kernel_mode_stack), (std::vector<std::uint64_t>{0x1234'B000'0000'0000, 0x1234'C000'0000'0000, 0x1234'D000'0000'0000}));
+    EXPECT_NE(samples_1[0].user_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(samples_1[0].user_mode_stack), (std::vector<std::uint64_t>{0x1'234B, 0x1'234C, 0x1'234D}));
+    EXPECT_NE(samples_1[0].kernel_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(samples_1[0].kernel_mode_stack), (std::vector<std::uint64_t>{0x1234'B000'0000'0000, 0x1234'C000'0000'0000, 0x1234'D000'0000'0000}));
 
     EXPECT_EQ(samples_1[1].timestamp, 20);
     EXPECT_EQ(samples_1[1].thread_id, 111);
     EXPECT_EQ(samples_1[1].instruction_pointer, 0x9'101A);
-    EXPECT_NE(samples_1[1].user_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*samples_1[1].user_mode_stack), (std::vector<std::uint64_t>{0x9'101B, 0x9'101C, 0x9'101D}));
-    EXPECT_EQ(samples_1[1].kernel_mode_stack, std::nullopt);
+    EXPECT_NE(samples_1[1].user_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(samples_1[1].user_mode_stack), (std::vector<std::uint64_t>{0x9'101B, 0x9'101C, 0x9'101D}));
+    EXPECT_EQ(samples_1[1].kernel_mode_stack, stack_cache::no_stack);
 
     // Check samples for the "BranchMispredictions" samples.
     const auto samples_2 = context.thread_samples(111, 10, std::nullopt, 11);
@@ -1406,9 +1406,9 @@ TEST(EtlFileProcessContext, MixedSamplesStacks)
     EXPECT_EQ(samples_2[0].timestamp, 15);
     EXPECT_EQ(samples_2[0].thread_id, 111);
     EXPECT_EQ(samples_2[0].instruction_pointer, 0x5'678A);
-    EXPECT_NE(samples_2[0].user_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*samples_2[0].user_mode_stack), (std::vector<std::uint64_t>{0x5'678B, 0x5'678C, 0x5'678D}));
-    EXPECT_EQ(samples_2[0].kernel_mode_stack, std::nullopt);
+    EXPECT_NE(samples_2[0].user_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(samples_2[0].user_mode_stack), (std::vector<std::uint64_t>{0x5'678B, 0x5'678C, 0x5'678D}));
+    EXPECT_EQ(samples_2[0].kernel_mode_stack, stack_cache::no_stack);
 }
 
 TEST(EtlFileProcessContext, MixedSamplesCachedStacks)
@@ -1504,24 +1504,24 @@ TEST(EtlFileProcessContext, MixedSamplesCachedStacks)
     EXPECT_EQ(samples_1[0].timestamp, 10);
     EXPECT_EQ(samples_1[0].thread_id, 111);
     EXPECT_EQ(samples_1[0].instruction_pointer, 0x1'234A);
-    EXPECT_NE(samples_1[0].user_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*samples_1[0].user_mode_stack), (std::vector<std::uint64_t>{0x1'234B, 0x1'234C, 0x1'234D}));
-    EXPECT_NE(samples_1[0].kernel_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*samples_1[0].kernel_mode_stack), (std::vector<std::uint64_t>{0x1234'B000'0000'0000, 0x1234'C000'0000'0000, 0x1234'D000'0000'0000}));
+    EXPECT_NE(samples_1[0].user_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(samples_1[0].user_mode_stack), (std::vector<std::uint64_t>{0x1'234B, 0x1'234C, 0x1'234D}));
+    EXPECT_NE(samples_1[0].kernel_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(samples_1[0].kernel_mode_stack), (std::vector<std::uint64_t>{0x1234'B000'0000'0000, 0x1234'C000'0000'0000, 0x1234'D000'0000'0000}));
 
     EXPECT_EQ(samples_1[1].timestamp, 20);
     EXPECT_EQ(samples_1[1].thread_id, 111);
     EXPECT_EQ(samples_1[1].instruction_pointer, 0x9'101A);
-    EXPECT_NE(samples_1[1].user_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*samples_1[1].user_mode_stack), (std::vector<std::uint64_t>{0x9'101B, 0x9'101C, 0x9'101D}));
-    EXPECT_EQ(samples_1[1].kernel_mode_stack, std::nullopt);
+    EXPECT_NE(samples_1[1].user_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(samples_1[1].user_mode_stack), (std::vector<std::uint64_t>{0x9'101B, 0x9'101C, 0x9'101D}));
+    EXPECT_EQ(samples_1[1].kernel_mode_stack, stack_cache::no_stack);
 
     EXPECT_EQ(samples_1[2].timestamp, 21);
     EXPECT_EQ(samples_1[2].thread_id, 111);
     EXPECT_EQ(samples_1[2].instruction_pointer, 0x9'101E);
-    EXPECT_NE(samples_1[2].user_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*samples_1[2].user_mode_stack), (std::vector<std::uint64_t>{0x9'101B, 0x9'101C, 0x9'101D}));
-    EXPECT_EQ(samples_1[2].kernel_mode_stack, std::nullopt);
+    EXPECT_NE(samples_1[2].user_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(samples_1[2].user_mode_stack), (std::vector<std::uint64_t>{0x9'101B, 0x9'101C, 0x9'101D}));
+    EXPECT_EQ(samples_1[2].kernel_mode_stack, stack_cache::no_stack);
 
     // Check samples for the "BranchMispredictions" source.
     const auto samples_2 = context.thread_samples(111, 10, std::nullopt, 11);
@@ -1530,16 +1530,16 @@ TEST(EtlFileProcessContext, MixedSamplesCachedStacks)
     EXPECT_EQ(samples_2[0].timestamp, 15);
     EXPECT_EQ(samples_2[0].thread_id, 111);
     EXPECT_EQ(samples_2[0].instruction_pointer, 0x5'678A);
-    EXPECT_NE(samples_2[0].user_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*samples_2[0].user_mode_stack), (std::vector<std::uint64_t>{0x5'678B, 0x5'678C, 0x5'678D}));
-    EXPECT_EQ(samples_2[0].kernel_mode_stack, std::nullopt);
+    EXPECT_NE(samples_2[0].user_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(samples_2[0].user_mode_stack), (std::vector<std::uint64_t>{0x5'678B, 0x5'678C, 0x5'678D}));
+    EXPECT_EQ(samples_2[0].kernel_mode_stack, stack_cache::no_stack);
 
     EXPECT_EQ(samples_2[1].timestamp, 23);
     EXPECT_EQ(samples_2[1].thread_id, 111);
     EXPECT_EQ(samples_2[1].instruction_pointer, 0x9'101E);
-    EXPECT_NE(samples_2[1].user_mode_stack, std::nullopt);
-    EXPECT_EQ(context.stack(*samples_2[1].user_mode_stack), (std::vector<std::uint64_t>{0x7'101B, 0x9'101C}));
-    EXPECT_EQ(samples_2[1].kernel_mode_stack, std::nullopt);
+    EXPECT_NE(samples_2[1].user_mode_stack, stack_cache::no_stack);
+    EXPECT_EQ(context.stack(samples_2[1].user_mode_stack), (std::vector<std::uint64_t>{0x7'101B, 0x9'101C}));
+    EXPECT_EQ(samples_2[1].kernel_mode_stack, stack_cache::no_stack);
 }
 
 TEST(EtlFileProcessContext, ContextSwitchPmc)
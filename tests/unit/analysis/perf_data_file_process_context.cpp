@@ -1,7 +1,12 @@
+#include <filesystem>
+#include <format>
+
 #include <gtest/gtest.h>
 
 #include <snail/analysis/detail/perf_data_file_process_context.hpp>
 
+#include <snail/perf_data/perf_data_file.hpp>
+#include <snail/perf_data/perf_data_writer.hpp>
 #include <snail/perf_data/parser/records/kernel.hpp>
 
 #include <snail/common/cast.hpp>
@@ -191,6 +196,24 @@ void push_sample_event(perf_data::dispatching_event_observer& observer,
     observer.handle(event_header, event_attributes, event_data, std::endian::little);
 }
 
+template<typename Entries>
+void expect_same_entries(const Entries& lhs, const Entries& rhs)
+{
+    ASSERT_EQ(lhs.size(), rhs.size());
+    for(const auto& [id, lhs_entries] : lhs)
+    {
+        const auto& rhs_entries = rhs.at(id);
+        ASSERT_EQ(lhs_entries.size(), rhs_entries.size());
+        for(std::size_t i = 0; i < lhs_entries.size(); ++i)
+        {
+            EXPECT_EQ(lhs_entries[i].timestamp, rhs_entries[i].timestamp);
+            EXPECT_EQ(lhs_entries[i].payload, rhs_entries[i].payload);
+            EXPECT_EQ(lhs_entries[i].payload.end_time, rhs_entries[i].payload.end_time);
+            EXPECT_EQ(lhs_entries[i].payload.unique_id, rhs_entries[i].payload.unique_id);
+        }
+    }
+}
+
 } // namespace
 
 TEST(PerfDataFileProcessContext, Processes)
@@ -375,7 +398,7 @@ TEST(PerfDataFileProcessContext, Samples)
     EXPECT_EQ(samples_123[0].thread_id, 123);
     EXPECT_EQ(samples_123[0].timestamp, 20);
     EXPECT_EQ(samples_123[0].instruction_pointer, 0xAA11);
-    EXPECT_EQ(samples_123[0].stack_index, 0);
+    ASSERT_NE(samples_123[0].stack_index, stack_cache::no_stack);
 
     const auto samples_222 = context.thread_samples(222, 25, 30, sample_source_id);
     EXPECT_EQ(samples_222.size(), 2);
@@ -383,12 +406,13 @@ TEST(PerfDataFileProcessContext, Samples)
     EXPECT_EQ(samples_222[0].thread_id, 222);
     EXPECT_EQ(samples_222[0].timestamp, 25);
     EXPECT_EQ(samples_222[0].instruction_pointer, 0xAA22);
-    EXPECT_EQ(samples_222[0].stack_index, 1);
+    ASSERT_NE(samples_222[0].stack_index, stack_cache::no_stack);
+    EXPECT_NE(samples_222[0].stack_index, samples_123[0].stack_index);
 
     EXPECT_EQ(samples_222[1].thread_id, 222);
     EXPECT_EQ(samples_222[1].timestamp, 30);
     EXPECT_EQ(samples_222[1].instruction_pointer, 0xAA33);
-    EXPECT_EQ(samples_222[1].stack_index, 0);
+    EXPECT_EQ(samples_222[1].stack_index, samples_123[0].stack_index);
 
     const auto samples_456 = context.thread_samples(456, 40, 40, sample_source_id);
     EXPECT_EQ(samples_456.size(), 1);
@@ -396,9 +420,103 @@ TEST(PerfDataFileProcessContext, Samples)
     EXPECT_EQ(samples_456[0].thread_id, 456);
     EXPECT_EQ(samples_456[0].timestamp, 40);
     EXPECT_EQ(samples_456[0].instruction_pointer, 0xBB11);
-    EXPECT_EQ(samples_456[0].stack_index, 2);
+    ASSERT_NE(samples_456[0].stack_index, stack_cache::no_stack);
+    EXPECT_NE(samples_456[0].stack_index, samples_123[0].stack_index);
+    EXPECT_NE(samples_456[0].stack_index, samples_222[0].stack_index);
+
+    EXPECT_EQ(context.stack(samples_123[0].stack_index), (std::vector<std::uint64_t>{0xAAA1, 0xAAA2, 0xAAA3}));
+    EXPECT_EQ(context.stack(samples_222[0].stack_index), (std::vector<std::uint64_t>{0xAAB1, 0xAAB2}));
+    EXPECT_EQ(context.stack(samples_456[0].stack_index), (std::vector<std::uint64_t>{0xBBA1, 0xBBA2}));
+}
+
+TEST(PerfDataFileProcessContext, ParallelMatchesSerial)
+{
+    const auto file_path = std::filesystem::temp_directory_path() / "snail-test-ParallelMatchesSerial.data";
+
+    constexpr std::uint32_t process_count    = 3;
+    constexpr std::uint32_t threads_per_proc = 4;
+    constexpr std::size_t   rounds           = 1000;
 
-    EXPECT_EQ(context.stack(0), (std::vector<std::uint64_t>{0xAAA1, 0xAAA2, 0xAAA3}));
-    EXPECT_EQ(context.stack(1), (std::vector<std::uint64_t>{0xAAB1, 0xAAB2}));
-    EXPECT_EQ(context.stack(2), (std::vector<std::uint64_t>{0xBBA1, 0xBBA2}));
+    {
+        perf_data::perf_data_writer writer(file_path,
+                                           perf_data::perf_data_writer::options{
+                                               .hostname       = "test-host",
+                                               .os_release     = "6.0.0-test",
+                                               .arch           = "x86_64",
+                                               .number_of_cpus = 4,
+                                               .command_line   = {"perf", "record", "-g"},
+                                               .event_name     = "cpu-clock",
+                                               .sample_period  = 1000});
+
+        std::uint64_t time = 1;
+        for(std::size_t round = 0; round < rounds; ++round)
+        {
+            for(std::uint32_t process_index = 0; process_index < process_count; ++process_index)
+            {
+                const auto pid = 100 + process_index * 10;
+                if(round == 0)
+                {
+                    writer.write_fork(time, pid, 1, pid, 1);
+                    writer.write_comm(time, pid, pid, std::format("process-{}", process_index));
+                    writer.write_mmap2(time, pid, pid, 0x7f0000000000, 0x10000, 0, "/usr/lib/libtest.so");
+                }
+                // Restart one of the threads in some of the rounds
+                if(round % 50 == 25)
+                {
+                    writer.write_fork(time, pid, pid, pid + 1, pid);
+                    writer.write_comm(time, pid, pid + 1, std::format("thread-{}", round));
+                }
+                for(std::uint32_t thread_index = 0; thread_index < threads_per_proc; ++thread_index)
+                {
+                    std::vector<std::uint64_t> callchain;
+                    for(std::size_t frame = 0; frame < 8 + (round + thread_index) % 16; ++frame)
+                    {
+                        callchain.push_back(0x7f0000001000 + ((round * frame + thread_index) % 64) * 0x10);
+                    }
+                    writer.write_sample(time++, pid, pid + thread_index, callchain.front(), callchain);
+                }
+            }
+            writer.write_finished_round();
+        }
+        writer.finish();
+    }
+
+    perf_data_file_process_context serial_context;
+    perf_data_file_process_context parallel_context;
+
+    perf_data::perf_data_file(file_path).process(serial_context.observer());
+    perf_data::perf_data_file(file_path, false).process_parallel(parallel_context.batched_observer());
+
+    std::filesystem::remove(file_path);
+
+    serial_context.finish();
+    parallel_context.finish();
+
+    expect_same_entries(serial_context.get_processes().all_entries(), parallel_context.get_processes().all_entries());
+    expect_same_entries(serial_context.get_threads().all_entries(), parallel_context.get_threads().all_entries());
+
+    EXPECT_EQ(serial_context.sampled_processes().size(), process_count);
+    EXPECT_EQ(parallel_context.sampled_processes().size(), process_count);
+
+    for(std::uint32_t process_index = 0; process_index < process_count; ++process_index)
+    {
+        const auto pid = 100 + process_index * 10;
+        EXPECT_EQ(serial_context.get_modules(pid).all_modules().size(), 1);
+        EXPECT_EQ(parallel_context.get_modules(pid).all_modules().size(), 1);
+
+        for(std::uint32_t thread_index = 0; thread_index < threads_per_proc; ++thread_index)
+        {
+            const auto serial_samples   = serial_context.thread_samples(pid + thread_index, 0, std::nullopt, 0);
+            const auto parallel_samples = parallel_context.thread_samples(pid + thread_index, 0, std::nullopt, 0);
+            ASSERT_EQ(serial_samples.size(), rounds);
+            ASSERT_EQ(parallel_samples.size(), rounds);
+            for(std::size_t i = 0; i < rounds; ++i)
+            {
+                EXPECT_EQ(serial_samples[i].timestamp, parallel_samples[i].timestamp);
+                EXPECT_EQ(serial_samples[i].instruction_pointer, parallel_samples[i].instruction_pointer);
+                EXPECT_EQ(serial_samples[i].stack_index, parallel_samples[i].stack_index);
+                EXPECT_EQ(serial_context.stack(serial_samples[i].stack_index), parallel_context.stack(parallel_samples[i].stack_index));
+            }
+        }
+    }
 }
@@ -3,6 +3,11 @@
 
 #include <snail/analysis/detail/stack_cache.hpp>
 
+#include <algorithm>
+#include <ranges>
+#include <string>
+#include <vector>
+
 using namespace snail;
 using namespace snail::analysis::detail;
 
@@ -49,3 +54,108 @@ TEST(StackCache, Insert)
     const auto index_4 = cache.insert(std::span(stack_1).subspan(0, 2));
     EXPECT_EQ(index_4, index_2);
 }
+
+TEST(StackCache, InsertRecursiveAndPermuted)
+{
+    stack_cache cache;
+
+    // Stacks with the shapes that are common in real traces:
+    // recursive frames and frames that appear in different orders.
+    std::vector<std::vector<common::instruction_pointer_t>> stacks;
+
+    const common::instruction_pointer_t base_address = 0x7ff6'1234'0000;
+
+    for(std::size_t depth = 1; depth <= 64; ++depth)
+    {
+        for(std::size_t leaf = 0; leaf < 8; ++leaf)
+        {
+            std::vector<common::instruction_pointer_t> stack = {base_address + 0x10 * leaf, base_address + 0x400};
+            stack.insert(stack.end(), depth, base_address + 0x800);
+            stack.push_back(base_address + 0xc00);
+            stacks.push_back(std::move(stack));
+        }
+    }
+
+    std::vector<common::instruction_pointer_t> permuted_stack = {
+        base_address + 0x100,
+        base_address + 0x200,
+        base_address + 0x300,
+        base_address + 0x400,
+        base_address + 0x500,
+        base_address + 0x600};
+    do
+    {
+        stacks.push_back(permuted_stack);
+    } while(std::ranges::next_permutation(permuted_stack).found);
+
+    std::vector<std::size_t> indices;
+    for(const auto& stack : stacks)
+    {
+        indices.push_back(cache.insert(stack));
+    }
+
+    for(std::size_t i = 0; i < stacks.size(); ++i)
+    {
+        EXPECT_EQ(cache.get(indices[i]), stacks[i]);
+        EXPECT_EQ(cache.insert(stacks[i]), indices[i]);
+    }
+
+    std::ranges::sort(indices);
+    EXPECT_EQ(std::ranges::adjacent_find(indices), indices.end());
+}
+
+TEST(StackCache, InsertEmpty)
+{
+    stack_cache cache;
+
+    const auto index = cache.insert(std::vector<common::instruction_pointer_t>{});
+    EXPECT_TRUE(cache.get(index).empty());
+    EXPECT_EQ(cache.get(index).size(), 0);
+    EXPECT_EQ(cache.frame_count(), 0);
+}
+
+TEST(StackCache, SharedPrefixes)
+{
+    stack_cache cache;
+
+    // All stacks share the same 48 outermost frames, but have distinct innermost frames.
+    std::vector<common::instruction_pointer_t> common_frames;
+    for(std::size_t i = 0; i < 48; ++i)
+    {
+        common_frames.push_back(0x1000 + i);
+    }
+
+    std::size_t total_frame_count = 0;
+    for(std::size_t i = 0; i < 1000; ++i)
+    {
+        std::vector<common::instruction_pointer_t> stack = {0x9000 + i, 0x8000 + (i % 10)};
+        stack.insert(stack.end(), common_frames.begin(), common_frames.end());
+        total_frame_count += stack.size();
+
+        const auto index = cache.insert(stack);
+        EXPECT_EQ(cache.get(index).size(), stack.size());
+        EXPECT_EQ(cache.get(index), stack);
+    }
+
+    EXPECT_EQ(cache.frame_count(), 48 + 10 + 1000);
+
+    RecordProperty("total_frames", std::to_string(total_frame_count));
+    RecordProperty("stored_frames", std::to_string(cache.frame_count()));
+}
+
+TEST(StackCache, Reversed)
+{
+    stack_cache cache;
+
+    const auto stack_1 = std::vector<common::instruction_pointer_t>{1, 2, 3, 4};
+    const auto stack_2 = std::vector<common::instruction_pointer_t>{5, 3, 4};
+
+    const auto index_1 = cache.insert(stack_1);
+    const auto index_2 = cache.insert(stack_2);
+
+    std::vector<common::instruction_pointer_t> buffer;
+    EXPECT_TRUE(std::ranges::equal(cache.get(index_1).reversed(buffer), std::vector<common::instruction_pointer_t>{4, 3, 2, 1}));
+    EXPECT_TRUE(std::ranges::equal(cache.get(index_2).reversed(buffer), std::vector<common::instruction_pointer_t>{4, 3, 5}));
+
+    EXPECT_EQ(cache.frame_count(), 5);
+}
@@ -1,7 +1,11 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cmath>
+#include <format>
+#include <map>
+#include <set>
 
 #include <snail/analysis/analysis.hpp>
 #include <snail/analysis/data_provider.hpp>
@@ -13,9 +17,14 @@ namespace {
 
 struct test_sample_data : public sample_data
 {
-    test_sample_data(std::optional<stack_frame> frame, std::optional<std::vector<stack_frame>> frames) :
+    test_sample_data(std::optional<stack_frame>              frame,
+                     std::optional<std::vector<stack_frame>> frames,
+                     std::optional<std::uint64_t>            stack_key = std::nullopt,
+                     std::chrono::nanoseconds                timestamp = {}) :
         frame_(std::move(frame)),
-        frames_(std::move(frames))
+        frames_(std::move(frames)),
+        stack_key_(stack_key),
+        timestamp_(timestamp)
     {}
 
     bool has_frame() const override
@@ -43,13 +52,39 @@ struct test_sample_data : public sample_data
         return *frame_;
     }
 
+    std::optional<std::uint64_t> stack_key() const override
+    {
+        return stack_key_;
+    }
+
     std::chrono::nanoseconds timestamp() const override
     {
-        return std::chrono::nanoseconds(0); // not used in this test
+        return timestamp_;
     }
 
     std::optional<stack_frame>              frame_;
     std::optional<std::vector<stack_frame>> frames_;
+    std::optional<std::uint64_t>            stack_key_;
+    std::chrono::nanoseconds                timestamp_;
+
+    // If not set, the sample belongs to the provider's `expected_thread_id_`.
+    std::optional<unique_thread_id> thread_id_;
+};
+
+struct test_sample_batch : public sample_batch
+{
+    std::span<const sample_record> records() const override
+    {
+        return records_;
+    }
+
+    const sample_data& sample(std::size_t index) const override
+    {
+        return *samples_[index];
+    }
+
+    std::vector<const test_sample_data*> samples_;
+    std::vector<sample_record>           records_;
 };
 
 class test_samples_provider : public samples_provider
@@ -62,32 +97,100 @@ public:
 
     common::generator<const sample_data&> samples(sample_source_info::id_t source_id,
                                                   unique_process_id        process_id,
-                                                  const sample_filter& /*filter*/) const override
+                                                  const sample_filter&     filter) const override
     {
         if(process_id != expected_process_id_) co_return;
+        if(filter.excluded_processes.contains(process_id)) co_return;
         if(!samples_.contains(source_id)) co_return;
 
-        for(const auto& sample : samples_.at(source_id))
+        for(const auto* const sample : filtered_samples(source_id, filter))
+        {
+            co_yield *sample;
+        }
+    }
+    common::generator<const sample_batch&> sample_batches(sample_source_info::id_t source_id,
+                                                          unique_process_id        process_id,
+                                                          const sample_filter&     filter) const override
+    {
+        if(process_id != expected_process_id_) co_return;
+        if(filter.excluded_processes.contains(process_id)) co_return;
+        if(!samples_.contains(source_id)) co_return;
+
+        const auto samples = filtered_samples(source_id, filter);
+
+        test_sample_batch batch;
+        for(std::size_t offset = 0; offset < samples.size(); offset += batch_size_)
         {
-            co_yield sample;
+            batch.samples_.assign(samples.begin() + offset, samples.begin() + std::min(offset + batch_size_, samples.size()));
+
+            batch.records_.clear();
+            for(const auto* const sample : batch.samples_)
+            {
+                batch.records_.push_back(sample_record{
+                    .thread_id           = sample->thread_id_.value_or(expected_thread_id_),
+                    .timestamp           = sample->timestamp(),
+                    .instruction_pointer = sample->has_frame() ? std::make_optional<std::uint64_t>(0) : std::nullopt,
+                    .stack_key           = sample->stack_key(),
+                    .has_stack           = sample->has_stack()});
+            }
+
+            co_yield batch;
         }
     }
+
     std::size_t count_samples(sample_source_info::id_t source_id,
                               unique_process_id        process_id,
-                              const sample_filter& /*filter*/) const override
+                              const sample_filter&     filter) const override
     {
         if(process_id != expected_process_id_) return 0;
+        if(filter.excluded_processes.contains(process_id)) return 0;
         if(!samples_.contains(source_id)) return 0;
-        return samples_.at(source_id).size();
+        return filtered_samples(source_id, filter).size();
     }
 
     std::size_t count_samples(sample_source_info::id_t source_id,
                               unique_thread_id         thread_id,
-                              const sample_filter& /*filter*/) const override
+                              const sample_filter&     filter) const override
     {
-        if(thread_id != expected_thread_id_) return 0;
         if(!samples_.contains(source_id)) return 0;
-        return samples_.at(source_id).size();
+        return std::ranges::count_if(filtered_samples(source_id, filter), [this, thread_id](const test_sample_data* sample)
+                                     { return sample->thread_id_.value_or(expected_thread_id_) == thread_id; });
+    }
+
+    std::vector<std::size_t> count_samples_per_time_bucket(sample_source_info::id_t source_id,
+                                                           unique_thread_id         thread_id,
+                                                           std::chrono::nanoseconds start_time,
+                                                           std::chrono::nanoseconds bucket_duration,
+                                                           std::size_t              bucket_count) const override
+    {
+        std::vector<std::size_t> result(bucket_count, 0);
+        if(!samples_.contains(source_id)) return result;
+        for(const auto& sample : samples_.at(source_id))
+        {
+            if(sample.thread_id_.value_or(expected_thread_id_) != thread_id) continue;
+            if(sample.timestamp_ < start_time) continue;
+            const auto bucket_index = static_cast<std::size_t>((sample.timestamp_ - start_time) / bucket_duration);
+            if(bucket_index < bucket_count) ++result[bucket_index];
+        }
+        return result;
+    }
+
+    // The samples of each source need to be sorted by their timestamps.
+    std::vector<const test_sample_data*> filtered_samples(sample_source_info::id_t source_id,
+                                                          const sample_filter&     filter) const
+    {
+        const auto& samples = samples_.at(source_id);
+
+        const auto begin = filter.min_time ? std::ranges::lower_bound(samples, *filter.min_time, {}, &test_sample_data::timestamp_) : samples.begin();
+        const auto end   = filter.max_time ? std::ranges::upper_bound(samples, *filter.max_time, {}, &test_sample_data::timestamp_) : samples.end();
+
+        std::vector<const test_sample_data*> result;
+        for(auto iter = begin; iter < end; ++iter)
+        {
+            if(filter.excluded_threads.contains(iter->thread_id_.value_or(expected_thread_id_))) continue;
+            result.push_back(&*iter);
+        }
+        return result;
     }
 
     std::vector<sample_source_info> sources_;
@@ -95,11 +198,24 @@ public:
     unique_process_id expected_process_id_;
     unique_thread_id  expected_thread_id_;
 
+    std::size_t batch_size_ = 1;
+
     std::unordered_map<sample_source_info::id_t, std::vector<test_sample_data>> samples_;
 };
 
 using line_hits_map = std::unordered_map<std::size_t, source_hit_counts>;
-using caller_map    = std::unordered_map<function_info::id_t, source_hit_counts>;
+using caller_map    = std::unordered_map<std::size_t, source_hit_counts>; // keyed by function id
+
+std::unordered_map<std::size_t, source_hit_counts> to_hits_map(const hits_by_key_view& hits_by_key)
+{
+    std::unordered_map<std::size_t, source_hit_counts> result;
+    for(std::size_t index = 0; index < hits_by_key.size(); ++index)
+    {
+        const auto counts = hits_by_key.hits(index).counts_per_source;
+        result.emplace(hits_by_key.key(index), source_hit_counts{.counts_per_source = {counts.begin(), counts.end()}});
+    }
+    return result;
+}
 
 struct test_progress_listener : public common::progress_listener
 {
@@ -134,6 +250,141 @@ struct test_progress_listener : public common::progress_listener
     std::optional<double> cancel_at = std::nullopt;
 };
 
+void expect_equal_call_trees(const stacks_analysis& lhs, const call_tree_node& lhs_node,
+                             const stacks_analysis& rhs, const call_tree_node& rhs_node)
+{
+    EXPECT_EQ(lhs_node.function_id, rhs_node.function_id);
+    EXPECT_EQ(lhs.get_hits(lhs_node), rhs.get_hits(rhs_node));
+    ASSERT_EQ(lhs_node.children.size(), rhs_node.children.size());
+    for(std::size_t i = 0; i < lhs_node.children.size(); ++i)
+    {
+        expect_equal_call_trees(lhs, lhs.get_call_tree_node(lhs_node.children[i]),
+                                rhs, rhs.get_call_tree_node(rhs_node.children[i]));
+    }
+}
+
+void expect_equal_analyses(const stacks_analysis& lhs, const stacks_analysis& rhs)
+{
+    ASSERT_EQ(lhs.all_modules().size(), rhs.all_modules().size());
+    for(std::size_t i = 0; i < lhs.all_modules().size(); ++i)
+    {
+        const auto& lhs_module = lhs.all_modules()[i];
+        const auto& rhs_module = rhs.all_modules()[i];
+        EXPECT_EQ(lhs_module.name, rhs_module.name);
+        EXPECT_EQ(lhs.get_hits(lhs_module), rhs.get_hits(rhs_module));
+    }
+
+    ASSERT_EQ(lhs.all_files().size(), rhs.all_files().size());
+    for(std::size_t i = 0; i < lhs.all_files().size(); ++i)
+    {
+        const auto& lhs_file = lhs.all_files()[i];
+        const auto& rhs_file = rhs.all_files()[i];
+        EXPECT_EQ(lhs_file.path, rhs_file.path);
+        EXPECT_EQ(lhs.get_hits(lhs_file), rhs.get_hits(rhs_file));
+    }
+
+    ASSERT_EQ(lhs.all_functions().size(), rhs.all_functions().size());
+    for(std::size_t i = 0; i <= lhs.all_functions().size(); ++i)
+    {
+        const auto& lhs_function = i < lhs.all_functions().size() ? lhs.all_functions()[i] : lhs.get_function_root();
+        const auto& rhs_function = i < rhs.all_functions().size() ? rhs.all_functions()[i] : rhs.get_function_root();
+        EXPECT_EQ(lhs_function.name, rhs_function.name);
+        EXPECT_EQ(lhs_function.module_id, rhs_function.module_id);
+        EXPECT_EQ(lhs_function.file_id, rhs_function.file_id);
+        EXPECT_EQ(lhs_function.line_number, rhs_function.line_number);
+        EXPECT_EQ(lhs.get_hits(lhs_function), rhs.get_hits(rhs_function));
+        EXPECT_EQ(to_hits_map(lhs.get_callers(lhs_function)), to_hits_map(rhs.get_callers(rhs_function)));
+        EXPECT_EQ(to_hits_map(lhs.get_callees(lhs_function)), to_hits_map(rhs.get_callees(rhs_function)));
+        EXPECT_EQ(to_hits_map(lhs.get_hits_by_line(lhs_function)), to_hits_map(rhs.get_hits_by_line(rhs_function)));
+    }
+
+    expect_equal_call_trees(lhs, lhs.get_call_tree_root(),
+                            rhs, rhs.get_call_tree_root());
+}
+
+// Same as `expect_equal_analyses`, but matches all entries by their names instead of their ids.
+void expect_equivalent_analyses(const stacks_analysis& lhs, const stacks_analysis& rhs)
+{
+    const auto function_name = [](const stacks_analysis& analysis, std::size_t function_id)
+    {
+        const auto& function = analysis.get_function(static_cast<function_info::id_t>(function_id));
+        if(function.id == analysis.get_function_root().id) return function.name;
+        return std::format("{}!{}", analysis.get_module(function.module_id).name, function.name);
+    };
+    const auto to_named_hits_map = [&function_name](const stacks_analysis& analysis, const hits_by_key_view& hits_by_key)
+    {
+        std::map<std::string, source_hit_counts> result;
+        for(const auto& [key, hits] : to_hits_map(hits_by_key))
+        {
+            result.emplace(function_name(analysis, key), hits);
+        }
+        return result;
+    };
+
+    ASSERT_EQ(lhs.all_modules().size(), rhs.all_modules().size());
+    for(const auto& lhs_module : lhs.all_modules())
+    {
+        const auto rhs_module = std::ranges::find(rhs.all_modules(), lhs_module.name, &module_info::name);
+        ASSERT_NE(rhs_module, rhs.all_modules().end()) << lhs_module.name;
+        EXPECT_EQ(lhs.get_hits(lhs_module), rhs.get_hits(*rhs_module));
+    }
+
+    ASSERT_EQ(lhs.all_files().size(), rhs.all_files().size());
+    for(const auto& lhs_file : lhs.all_files())
+    {
+        const auto rhs_file = std::ranges::find(rhs.all_files(), lhs_file.path, &file_info::path);
+        ASSERT_NE(rhs_file, rhs.all_files().end()) << lhs_file.path;
+        EXPECT_EQ(lhs.get_hits(lhs_file), rhs.get_hits(*rhs_file));
+    }
+
+    const auto find_function = [&function_name](const stacks_analysis& analysis, const std::string& name) -> const function_info*
+    {
+        if(name == analysis.get_function_root().name) return &analysis.get_function_root();
+        for(const auto& function : analysis.all_functions())
+        {
+            if(function_name(analysis, function.id) == name) return &function;
+        }
+        return nullptr;
+    };
+
+    ASSERT_EQ(lhs.all_functions().size(), rhs.all_functions().size());
+    for(std::size_t i = 0; i <= lhs.all_functions().size(); ++i)
+    {
+        const auto& lhs_function = i < lhs.all_functions().size() ? lhs.all_functions()[i] : lhs.get_function_root();
+        const auto  name         = function_name(lhs, lhs_function.id);
+
+        const auto* const rhs_function = find_function(rhs, name);
+        ASSERT_NE(rhs_function, nullptr) << name;
+
+        EXPECT_EQ(lhs_function.file_id.has_value(), rhs_function->file_id.has_value()) << name;
+        if(lhs_function.file_id && rhs_function->file_id)
+        {
+            EXPECT_EQ(lhs.get_file(*lhs_function.file_id).path, rhs.get_file(*rhs_function->file_id).path) << name;
+        }
+        EXPECT_EQ(lhs_function.line_number, rhs_function->line_number) << name;
+        EXPECT_EQ(lhs.get_hits(lhs_function), rhs.get_hits(*rhs_function)) << name;
+        EXPECT_EQ(to_named_hits_map(lhs, lhs.get_callers(lhs_function)), to_named_hits_map(rhs, rhs.get_callers(*rhs_function))) << name;
+        EXPECT_EQ(to_named_hits_map(lhs, lhs.get_callees(lhs_function)), to_named_hits_map(rhs, rhs.get_callees(*rhs_function))) << name;
+        EXPECT_EQ(to_hits_map(lhs.get_hits_by_line(lhs_function)), to_hits_map(rhs.get_hits_by_line(*rhs_function))) << name;
+    }
+
+    const auto expect_equivalent_call_trees = [&](const auto& self, const call_tree_node& lhs_node, const call_tree_node& rhs_node) -> void
+    {
+        EXPECT_EQ(function_name(lhs, lhs_node.function_id), function_name(rhs, rhs_node.function_id));
+        EXPECT_EQ(lhs.get_hits(lhs_node), rhs.get_hits(rhs_node));
+        ASSERT_EQ(lhs_node.children.size(), rhs_node.children.size());
+        for(const auto lhs_child_id : lhs_node.children)
+        {
+            const auto& lhs_child = lhs.get_call_tree_node(lhs_child_id);
+            const auto  rhs_child = std::ranges::find_if(rhs_node.children, [&](call_tree_node::id_t rhs_child_id)
+                                                         { return function_name(rhs, rhs.get_call_tree_node(rhs_child_id).function_id) == function_name(lhs, lhs_child.function_id); });
+            ASSERT_NE(rhs_child, rhs_node.children.end());
+            self(self, lhs_child, rhs.get_call_tree_node(*rhs_child));
+        }
+    };
+    expect_equivalent_call_trees(expect_equivalent_call_trees, lhs.get_call_tree_root(), rhs.get_call_tree_root());
+}
+
 } // namespace
 
 TEST(Analysis, SampleStacksFullInfo)
@@ -261,26 +512,26 @@ TEST(Analysis, SampleStacksFullInfo)
     EXPECT_EQ(&analysis_result.get_file(file_b_iter->id), &*file_b_iter);
 
     // Check function hits
-    EXPECT_EQ(function_root.hits.get(source_id).total, 3);
-    EXPECT_EQ(function_root.hits.get(source_id).self, 1);
-    EXPECT_EQ(func_a_iter->hits.get(source_id).total, 2);
-    EXPECT_EQ(func_a_iter->hits.get(source_id).self, 0);
-    EXPECT_EQ(func_b_iter->hits.get(source_id).total, 2);
-    EXPECT_EQ(func_b_iter->hits.get(source_id).self, 2);
-    EXPECT_EQ(func_c_iter->hits.get(source_id).total, 1);
-    EXPECT_EQ(func_c_iter->hits.get(source_id).self, 0);
+    EXPECT_EQ(analysis_result.get_hits(function_root).get(source_id).total, 3);
+    EXPECT_EQ(analysis_result.get_hits(function_root).get(source_id).self, 1);
+    EXPECT_EQ(analysis_result.get_hits(*func_a_iter).get(source_id).total, 2);
+    EXPECT_EQ(analysis_result.get_hits(*func_a_iter).get(source_id).self, 0);
+    EXPECT_EQ(analysis_result.get_hits(*func_b_iter).get(source_id).total, 2);
+    EXPECT_EQ(analysis_result.get_hits(*func_b_iter).get(source_id).self, 2);
+    EXPECT_EQ(analysis_result.get_hits(*func_c_iter).get(source_id).total, 1);
+    EXPECT_EQ(analysis_result.get_hits(*func_c_iter).get(source_id).self, 0);
 
     // Check module hits
-    EXPECT_EQ(mod_a_iter->hits.get(source_id).total, 3);
-    EXPECT_EQ(mod_a_iter->hits.get(source_id).self, 0);
-    EXPECT_EQ(mod_b_iter->hits.get(source_id).total, 2);
-    EXPECT_EQ(mod_b_iter->hits.get(source_id).self, 2);
+    EXPECT_EQ(analysis_result.get_hits(*mod_a_iter).get(source_id).total, 3);
+    EXPECT_EQ(analysis_result.get_hits(*mod_a_iter).get(source_id).self, 0);
+    EXPECT_EQ(analysis_result.get_hits(*mod_b_iter).get(source_id).total, 2);
+    EXPECT_EQ(analysis_result.get_hits(*mod_b_iter).get(source_id).self, 2);
 
     // Check file hits
-    EXPECT_EQ(file_a_iter->hits.get(source_id).total, 3);
-    EXPECT_EQ(file_a_iter->hits.get(source_id).self, 0);
-    EXPECT_EQ(file_b_iter->hits.get(source_id).total, 2);
-    EXPECT_EQ(file_b_iter->hits.get(source_id).self, 2);
+    EXPECT_EQ(analysis_result.get_hits(*file_a_iter).get(source_id).total, 3);
+    EXPECT_EQ(analysis_result.get_hits(*file_a_iter).get(source_id).self, 0);
+    EXPECT_EQ(analysis_result.get_hits(*file_b_iter).get(source_id).total, 2);
+    EXPECT_EQ(analysis_result.get_hits(*file_b_iter).get(source_id).self, 2);
 
     // Check function file associations
     EXPECT_EQ(func_a_iter->file_id, file_a_iter->id);
@@ -298,50 +549,50 @@ TEST(Analysis, SampleStacksFullInfo)
     EXPECT_EQ(func_c_iter->line_number, 50);
 
     // Check function line hits
-    EXPECT_EQ(func_a_iter->hits_by_line,
+    EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_a_iter)),
               (line_hits_map{
                   {15, {{{}, {.total = 2, .self = 0}}}}
     }));
-    EXPECT_EQ(func_b_iter->hits_by_line,
+    EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_b_iter)),
               (line_hits_map{
                   {100, {{{}, {.total = 1, .self = 1}}}},
                   {110, {{{}, {.total = 1, .self = 1}}}}
     }));
-    EXPECT_EQ(func_c_iter->hits_by_line,
+    EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_c_iter)),
               (line_hits_map{
                   {60, {{{}, {.total = 1, .self = 0}}}}
     }));
 
     // Check function callers
-    EXPECT_EQ(function_root.callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(function_root)),
               (caller_map{}));
-    EXPECT_EQ(func_a_iter->callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_a_iter)),
               (caller_map{
                   {function_root.id, {{{}, {.total = 2, .self = 0}}}}
     }));
-    EXPECT_EQ(func_b_iter->callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_b_iter)),
               (caller_map{
                   {func_a_iter->id, {{{}, {.total = 1, .self = 0}}}},
                   {func_c_iter->id, {{{}, {.total = 1, .self = 0}}}}
     }));
-    EXPECT_EQ(func_c_iter->callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_c_iter)),
               (caller_map{
                   {func_a_iter->id, {{{}, {.total = 1, .self = 0}}}}
     }));
 
     // Check function callees
-    EXPECT_EQ(function_root.callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(function_root)),
               (caller_map{
                   {func_a_iter->id, {{{}, {.total = 2, .self = 0}}}}
     }));
-    EXPECT_EQ(func_a_iter->callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_a_iter)),
               (caller_map{
                   {func_b_iter->id, {{{}, {.total = 1, .self = 0}}}},
                   {func_c_iter->id, {{{}, {.total = 1, .self = 0}}}}
     }));
-    EXPECT_EQ(func_b_iter->callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_b_iter)),
               (caller_map{}));
-    EXPECT_EQ(func_c_iter->callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_c_iter)),
               (caller_map{
                   {func_b_iter->id, {{{}, {.total = 1, .self = 0}}}}
     }));
@@ -350,7 +601,7 @@ TEST(Analysis, SampleStacksFullInfo)
     const auto& call_tree_root = analysis_result.get_call_tree_root();
     EXPECT_EQ(&analysis_result.get_call_tree_node(call_tree_root.id), &call_tree_root);
     EXPECT_EQ(call_tree_root.function_id, function_root.id);
-    EXPECT_EQ(call_tree_root.hits, (source_hit_counts{
+    EXPECT_EQ(analysis_result.get_hits(call_tree_root), (source_hit_counts{
                                        {{}, {.total = 3, .self = 1}}
     }));
     EXPECT_EQ(call_tree_root.children.size(), 1);
@@ -358,7 +609,7 @@ TEST(Analysis, SampleStacksFullInfo)
     // root => func_a
     const auto call_tree_node_a = analysis_result.get_call_tree_node(call_tree_root.children[0]);
     EXPECT_EQ(call_tree_node_a.function_id, func_a_iter->id);
-    EXPECT_EQ(call_tree_node_a.hits, (source_hit_counts{
+    EXPECT_EQ(analysis_result.get_hits(call_tree_node_a), (source_hit_counts{
                                          {{}, {.total = 2, .self = 0}}
     }));
     EXPECT_EQ(call_tree_node_a.children.size(), 2);
@@ -369,7 +620,7 @@ TEST(Analysis, SampleStacksFullInfo)
     EXPECT_NE(a_b_id_iter, call_tree_node_a.children.end());
     const auto call_tree_node_a_b = analysis_result.get_call_tree_node(*a_b_id_iter);
     EXPECT_EQ(call_tree_node_a_b.id, *a_b_id_iter);
-    EXPECT_EQ(call_tree_node_a_b.hits, (source_hit_counts{
+    EXPECT_EQ(analysis_result.get_hits(call_tree_node_a_b), (source_hit_counts{
                                            {{}, {.total = 1, .self = 1}}
     }));
     EXPECT_EQ(call_tree_node_a_b.children.size(), 0);
@@ -380,7 +631,7 @@ TEST(Analysis, SampleStacksFullInfo)
     EXPECT_NE(a_c_id_iter, call_tree_node_a.children.end());
     const auto call_tree_node_a_c = analysis_result.get_call_tree_node(*a_c_id_iter);
     EXPECT_EQ(call_tree_node_a_c.id, *a_c_id_iter);
-    EXPECT_EQ(call_tree_node_a_c.hits, (source_hit_counts{
+    EXPECT_EQ(analysis_result.get_hits(call_tree_node_a_c), (source_hit_counts{
                                            {{}, {.total = 1, .self = 0}}
     }));
     EXPECT_EQ(call_tree_node_a_c.children.size(), 1);
@@ -388,12 +639,337 @@ TEST(Analysis, SampleStacksFullInfo)
     // func_a => func_c => func_b
     const auto call_tree_node_a_c_b = analysis_result.get_call_tree_node(call_tree_node_a_c.children[0]);
     EXPECT_EQ(call_tree_node_a_c_b.function_id, func_b_iter->id);
-    EXPECT_EQ(call_tree_node_a_c_b.hits, (source_hit_counts{
+    EXPECT_EQ(analysis_result.get_hits(call_tree_node_a_c_b), (source_hit_counts{
                                              {{}, {.total = 1, .self = 1}}
     }));
     EXPECT_EQ(call_tree_node_a_c_b.children.size(), 0);
 }
 
+TEST(Analysis, SampleStacksCachedByKey)
+{
+    const auto process_id = unique_process_id{.key = 123};
+
+    const auto frame_a = stack_frame{
+        .symbol_name             = "func_a",
+        .module_name             = "mod_a.so",
+        .file_path               = "/home/path/to/file/a.cpp",
+        .function_line_number    = 10,
+        .instruction_line_number = 15};
+    const auto frame_b = stack_frame{
+        .symbol_name             = "func_b",
+        .module_name             = "mod_b.dll",
+        .file_path               = "C:/path/to/file/b.h",
+        .function_line_number    = 100,
+        .instruction_line_number = 110};
+    const auto frame_c = stack_frame{
+        .symbol_name             = "func_c",
+        .module_name             = "mod_a.so",
+        .file_path               = "",
+        .function_line_number    = 0,
+        .instruction_line_number = 0};
+
+    const auto stack_0 = std::vector{frame_a, frame_b};
+    const auto stack_1 = std::vector{frame_a, frame_c, frame_b};
+    const auto stack_2 = std::vector{frame_a, frame_c, frame_c};
+    const auto stack_3 = std::vector<stack_frame>{};
+
+    const auto make_samples = [&](bool with_keys)
+    {
+        const auto key = [with_keys](std::uint64_t value)
+        { return with_keys ? std::optional(value) : std::nullopt; };
+
+        return std::vector{
+            test_sample_data(std::nullopt, stack_1, key(1)),
+            test_sample_data(std::nullopt, stack_0, key(0)),
+            test_sample_data(std::nullopt, stack_1, key(1)),
+            test_sample_data(std::nullopt, stack_2, key(2)),
+            test_sample_data(std::nullopt, stack_1, std::nullopt),
+            test_sample_data(std::nullopt, stack_3, key(3)),
+            test_sample_data(std::nullopt, stack_0, key(0)),
+            test_sample_data(std::nullopt, stack_3, key(3)),
+            test_sample_data(std::nullopt, stack_2, key(2)),
+            test_sample_data(std::nullopt, stack_1, key(1))};
+    };
+
+    const auto make_provider = [&](bool with_keys)
+    {
+        test_samples_provider samples_provider;
+        samples_provider.expected_process_id_ = process_id;
+        samples_provider.sources_             = {
+            {.id                    = 0,
+             .name                  = "source A",
+             .number_of_samples     = 0,
+             .average_sampling_rate = 1.0,
+             .has_stacks            = true},
+            {.id                    = 1,
+             .name                  = "source B",
+             .number_of_samples     = 0,
+             .average_sampling_rate = 1.0,
+             .has_stacks            = true}
+        };
+        samples_provider.samples_ = {
+            {0, make_samples(with_keys)},
+            {1, make_samples(with_keys)}
+        };
+        samples_provider.batch_size_ = 4;
+        return samples_provider;
+    };
+
+    const auto uncached_result = analyze_stacks(make_provider(false), process_id);
+    const auto cached_result   = analyze_stacks(make_provider(true), process_id);
+
+    // Some sanity checks on the expected values
+    ASSERT_EQ(cached_result.all_functions().size(), 3);
+    const auto& func_c = cached_result.all_functions()[1];
+    EXPECT_EQ(func_c.name, "func_c");
+    EXPECT_EQ(cached_result.get_hits(func_c).get(0).total, 8);
+    EXPECT_EQ(cached_result.get_hits(func_c).get(0).self, 2);
+    EXPECT_EQ(cached_result.get_hits(func_c).get(1).total, 8);
+    EXPECT_EQ(cached_result.get_hits(func_c).get(1).self, 2);
+    EXPECT_EQ(cached_result.get_hits(cached_result.get_function_root()).get(1), (hit_counts{.total = 10, .self = 2}));
+
+    // Resolving every stack only once should not make any difference
+    expect_equal_analyses(cached_result, uncached_result);
+}
+
+TEST(Analysis, SampleStacksParallel)
+{
+    const auto process_id = unique_process_id{.key = 123};
+
+    test_samples_provider samples_provider;
+    samples_provider.expected_process_id_ = process_id;
+    samples_provider.sources_             = {
+        {.id                    = 0,
+         .name                  = "source A",
+         .number_of_samples     = 0,
+         .average_sampling_rate = 1.0,
+         .has_stacks            = true},
+        {.id                    = 1,
+         .name                  = "source B",
+         .number_of_samples     = 0,
+         .average_sampling_rate = 1.0,
+         .has_stacks            = true}
+    };
+
+    // Generate pseudo random stacks over a small set of functions, so that the stacks share
+    // many functions, modules, files and call tree nodes.
+    std::uint32_t random_state = 42;
+    const auto    next_random  = [&random_state](std::uint32_t max)
+    {
+        random_state = random_state * 1664525U + 1013904223U;
+        return (random_state >> 8) % max;
+    };
+
+    std::vector<std::string> function_names;
+    std::vector<std::string> module_names;
+    std::vector<std::string> file_paths;
+    for(std::size_t i = 0; i < 30; ++i) function_names.push_back(std::format("func_{}", i));
+    for(std::size_t i = 0; i < 7; ++i) module_names.push_back(std::format("mod_{}.so", i));
+    for(std::size_t i = 0; i < 5; ++i) file_paths.push_back(std::format("/path/to/file_{}.cpp", i));
+
+    std::vector<std::vector<stack_frame>> stacks;
+    for(std::size_t stack_index = 0; stack_index < 200; ++stack_index)
+    {
+        auto& stack = stacks.emplace_back();
+
+        const auto depth = next_random(12);
+        for(std::size_t frame_index = 0; frame_index < depth; ++frame_index)
+        {
+            const auto function_index = frame_index == 0 ? 0 : next_random(30);
+            const auto has_file       = function_index % 4 != 0;
+            stack.push_back(stack_frame{
+                .symbol_name             = function_names[function_index],
+                .module_name             = module_names[function_index % 7],
+                .file_path               = has_file ? std::string_view(file_paths[function_index % 5]) : std::string_view(),
+                .function_line_number    = has_file ? function_index * 100 : 0,
+                .instruction_line_number = has_file ? function_index * 100 + next_random(10) : 0});
+        }
+    }
+
+    // The same stacks, but with interned strings
+    common::string_interner               strings;
+    std::vector<std::vector<stack_frame>> interned_stacks = stacks;
+    for(auto& stack : interned_stacks)
+    {
+        for(auto& frame : stack)
+        {
+            frame.ids = stack_frame::string_ids{
+                .symbol_name = strings.intern(frame.symbol_name),
+                .module_name = strings.intern(frame.module_name),
+                .file_path   = strings.intern(frame.file_path)};
+        }
+    }
+
+    test_samples_provider interned_samples_provider = samples_provider;
+
+    for(sample_source_info::id_t source_id = 0; source_id < 2; ++source_id)
+    {
+        auto& samples          = samples_provider.samples_[source_id];
+        auto& interned_samples = interned_samples_provider.samples_[source_id];
+        for(std::size_t sample_index = 0; sample_index < 1000; ++sample_index)
+        {
+            const auto stack_index = next_random(source_id == 0 ? 200 : 50);
+            const auto stack_key   = sample_index % 3 == 0 ? std::nullopt : std::optional<std::uint64_t>(stack_index);
+            samples.emplace_back(std::nullopt, stacks[stack_index], stack_key);
+            interned_samples.emplace_back(std::nullopt, interned_stacks[stack_index], stack_key);
+        }
+    }
+
+    samples_provider.batch_size_          = 64;
+    interned_samples_provider.batch_size_ = 64;
+
+    const auto serial_result = analyze_stacks(samples_provider, process_id, {}, nullptr, nullptr, 1);
+    EXPECT_EQ(serial_result.get_hits(serial_result.get_function_root()).get(0).total, 1000);
+    EXPECT_EQ(serial_result.get_hits(serial_result.get_function_root()).get(1).total, 1000);
+
+    for(const std::size_t worker_count : {2, 3, 8})
+    {
+        const auto parallel_result = analyze_stacks(samples_provider, process_id, {}, nullptr, nullptr, worker_count);
+        expect_equal_analyses(parallel_result, serial_result);
+    }
+
+    // Looking up the functions, modules and files by the interned ids should not make any difference
+    const auto interned_result = analyze_stacks(interned_samples_provider, process_id, {}, nullptr, nullptr, 1);
+    expect_equal_analyses(interned_result, serial_result);
+}
+
+TEST(Analysis, SampleStacksTimeIndex)
+{
+    const auto process_id = unique_process_id{.key = 123};
+
+    test_samples_provider samples_provider;
+    samples_provider.expected_process_id_ = process_id;
+    samples_provider.batch_size_          = 100;
+    samples_provider.sources_             = {
+        {.id                    = 0,
+         .name                  = "source A",
+         .number_of_samples     = 0,
+         .average_sampling_rate = 1.0,
+         .has_stacks            = true},
+        {.id                    = 1,
+         .name                  = "source B",
+         .number_of_samples     = 0,
+         .average_sampling_rate = 1.0,
+         .has_stacks            = true}
+    };
+
+    std::uint32_t random_state = 1234;
+    const auto    next_random  = [&random_state](std::uint32_t max)
+    {
+        random_state = random_state * 1664525U + 1013904223U;
+        return (random_state >> 8) % max;
+    };
+
+    std::vector<std::string> function_names;
+    std::vector<std::string> module_names;
+    std::vector<std::string> file_paths;
+    for(std::size_t i = 0; i < 20; ++i) function_names.push_back(std::format("func_{}", i));
+    for(std::size_t i = 0; i < 4; ++i) module_names.push_back(std::format("mod_{}.so", i));
+    for(std::size_t i = 0; i < 3; ++i) file_paths.push_back(std::format("/path/to/file_{}.cpp", i));
+
+    const auto make_frame = [&](std::size_t function_index)
+    {
+        const auto has_file = function_index % 3 != 0;
+        return stack_frame{
+            .symbol_name             = function_names[function_index],
+            .module_name             = module_names[function_index % 4],
+            .file_path               = has_file ? std::string_view(file_paths[function_index % 3]) : std::string_view(),
+            .function_line_number    = has_file ? function_index * 100 : 0,
+            .instruction_line_number = has_file ? function_index * 100 + next_random(5) : 0};
+    };
+
+    std::vector<std::vector<stack_frame>> stacks;
+    for(std::size_t stack_index = 0; stack_index < 100; ++stack_index)
+    {
+        auto& stack = stacks.emplace_back();
+
+        const auto depth = next_random(8);
+        for(std::size_t frame_index = 0; frame_index < depth; ++frame_index)
+        {
+            stack.push_back(make_frame(frame_index == 0 ? 0 : next_random(20)));
+        }
+    }
+
+    // Samples of both sources interleave in time, and some of them only have a single frame.
+    // The samples are spread over a few threads, each of which hits a different set of stacks.
+    constexpr std::size_t samples_per_source = 10000;
+    constexpr std::size_t thread_count       = 6;
+    for(sample_source_info::id_t source_id = 0; source_id < 2; ++source_id)
+    {
+        auto& samples = samples_provider.samples_[source_id];
+        for(std::size_t sample_index = 0; sample_index < samples_per_source; ++sample_index)
+        {
+            const auto timestamp = std::chrono::nanoseconds(sample_index * 10 + source_id * 5);
+            const auto thread    = next_random(thread_count);
+            if(sample_index % 7 == 0)
+            {
+                samples.emplace_back(make_frame(next_random(20)), std::nullopt, std::nullopt, timestamp);
+            }
+            else
+            {
+                const auto stack_index = (thread * 17 + next_random(source_id == 0 ? 40 : 15)) % stacks.size();
+                const auto stack_key   = sample_index % 5 == 0 ? std::nullopt : std::optional<std::uint64_t>(stack_index);
+                samples.emplace_back(std::nullopt, stacks[stack_index], stack_key, timestamp);
+            }
+            samples.back().thread_id_ = unique_thread_id{.key = 100 + thread};
+        }
+    }
+
+    const auto index = make_stacks_time_index(samples_provider, process_id);
+    ASSERT_TRUE(index.has_value());
+    EXPECT_EQ(index->process_id(), process_id);
+
+    using std::chrono::nanoseconds;
+
+    const auto time_filter = [](std::optional<nanoseconds> min_time, std::optional<nanoseconds> max_time)
+    {
+        return sample_filter{
+            .min_time           = min_time,
+            .max_time           = max_time,
+            .excluded_processes = {},
+            .excluded_threads   = {}};
+    };
+
+    const std::vector<sample_filter> filters = {
+        time_filter(std::nullopt, std::nullopt),
+        time_filter(nanoseconds(0), nanoseconds(samples_per_source * 10)),
+        time_filter(nanoseconds(12345), std::nullopt),
+        time_filter(std::nullopt, nanoseconds(54321)),
+        time_filter(nanoseconds(1000), nanoseconds(1500)),        // within a single bucket
+        time_filter(nanoseconds(15), nanoseconds(95'005)),        // many buckets, inclusive bounds
+        time_filter(nanoseconds(40'960), nanoseconds(81'915)),    // exactly on the buckets
+        time_filter(nanoseconds(500'000), nanoseconds(600'000))}; // no samples at all
+
+    // Thread 99 does not exist at all
+    const std::vector<std::set<unique_thread_id>> excluded_threads = {
+        {},
+        {unique_thread_id{.key = 101}},
+        {unique_thread_id{.key = 99}, unique_thread_id{.key = 100}, unique_thread_id{.key = 103}, unique_thread_id{.key = 104}}};
+
+    for(auto filter : filters)
+    {
+        for(const auto& excluded : excluded_threads)
+        {
+            filter.excluded_threads = excluded;
+
+            const auto direct_result  = analyze_stacks(samples_provider, process_id, filter);
+            const auto indexed_result = analyze_stacks(*index, filter);
+            expect_equivalent_analyses(indexed_result, direct_result);
+        }
+    }
+
+    // Excluding the process or all of its threads leaves nothing
+    auto excluding_filter = time_filter(std::nullopt, std::nullopt);
+    excluding_filter.excluded_processes.insert(process_id);
+    expect_equivalent_analyses(analyze_stacks(*index, excluding_filter), analyze_stacks(samples_provider, process_id, excluding_filter));
+
+    excluding_filter = time_filter(nanoseconds(1000), std::nullopt);
+    for(std::size_t thread = 0; thread < thread_count; ++thread) excluding_filter.excluded_threads.insert(unique_thread_id{.key = 100 + thread});
+    const auto empty_result = analyze_stacks(*index, excluding_filter);
+    EXPECT_TRUE(empty_result.all_functions().empty());
+    EXPECT_EQ(empty_result.get_hits(empty_result.get_function_root()).get(0).total, 0);
+}
+
 TEST(Analysis, SampleStacksMissingFile)
 {
     const auto process_id = unique_process_id{.key = 123};
@@ -506,24 +1082,24 @@ TEST(Analysis, SampleStacksMissingFile)
     EXPECT_EQ(&analysis_result.get_file(file_a_iter->id), &*file_a_iter);
 
     // Check function hits
-    EXPECT_EQ(function_root.hits.get(source_id).total, 2);
-    EXPECT_EQ(function_root.hits.get(source_id).self, 0);
-    EXPECT_EQ(func_a_iter->hits.get(source_id).total, 1);
-    EXPECT_EQ(func_a_iter->hits.get(source_id).self, 0);
-    EXPECT_EQ(func_b_iter->hits.get(source_id).total, 1);
-    EXPECT_EQ(func_b_iter->hits.get(source_id).self, 1);
-    EXPECT_EQ(func_c_iter->hits.get(source_id).total, 1);
-    EXPECT_EQ(func_c_iter->hits.get(source_id).self, 0);
-    EXPECT_EQ(func_d_iter->hits.get(source_id).total, 1);
-    EXPECT_EQ(func_d_iter->hits.get(source_id).self, 1);
+    EXPECT_EQ(analysis_result.get_hits(function_root).get(source_id).total, 2);
+    EXPECT_EQ(analysis_result.get_hits(function_root).get(source_id).self, 0);
+    EXPECT_EQ(analysis_result.get_hits(*func_a_iter).get(source_id).total, 1);
+    EXPECT_EQ(analysis_result.get_hits(*func_a_iter).get(source_id).self, 0);
+    EXPECT_EQ(analysis_result.get_hits(*func_b_iter).get(source_id).total, 1);
+    EXPECT_EQ(analysis_result.get_hits(*func_b_iter).get(source_id).self, 1);
+    EXPECT_EQ(analysis_result.get_hits(*func_c_iter).get(source_id).total, 1);
+    EXPECT_EQ(analysis_result.get_hits(*func_c_iter).get(source_id).self, 0);
+    EXPECT_EQ(analysis_result.get_hits(*func_d_iter).get(source_id).total, 1);
+    EXPECT_EQ(analysis_result.get_hits(*func_d_iter).get(source_id).self, 1);
 
     // Check module hits
-    EXPECT_EQ(mod_a_iter->hits.get(source_id).total, 4);
-    EXPECT_EQ(mod_a_iter->hits.get(source_id).self, 2);
+    EXPECT_EQ(analysis_result.get_hits(*mod_a_iter).get(source_id).total, 4);
+    EXPECT_EQ(analysis_result.get_hits(*mod_a_iter).get(source_id).self, 2);
 
     // Check file hits
-    EXPECT_EQ(file_a_iter->hits.get(source_id).total, 2);
-    EXPECT_EQ(file_a_iter->hits.get(source_id).self, 1);
+    EXPECT_EQ(analysis_result.get_hits(*file_a_iter).get(source_id).total, 2);
+    EXPECT_EQ(analysis_result.get_hits(*file_a_iter).get(source_id).self, 1);
 
     // Check function file associations
     EXPECT_EQ(func_a_iter->file_id, file_a_iter->id);
@@ -544,63 +1120,63 @@ TEST(Analysis, SampleStacksMissingFile)
     EXPECT_EQ(func_d_iter->line_number, 50);
 
     // Check function line hits
-    EXPECT_EQ(func_a_iter->hits_by_line,
+    EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_a_iter)),
               (line_hits_map{
                   {15, {{{}, {.total = 1, .self = 0}}}}
     }));
-    EXPECT_EQ(func_b_iter->hits_by_line,
+    EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_b_iter)),
               (line_hits_map{}));
-    EXPECT_EQ(func_c_iter->hits_by_line,
+    EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_c_iter)),
               (line_hits_map{}));
-    EXPECT_EQ(func_d_iter->hits_by_line,
+    EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_d_iter)),
               (line_hits_map{
                   {60, {{{}, {.total = 1, .self = 1}}}}
     }));
 
     // Check function callers
-    EXPECT_EQ(function_root.callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(function_root)),
               (caller_map{}));
-    EXPECT_EQ(func_a_iter->callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_a_iter)),
               (caller_map{
                   {function_root.id, {{{}, {.total = 1, .self = 0}}}}
     }));
-    EXPECT_EQ(func_b_iter->callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_b_iter)),
               (caller_map{
                   {func_a_iter->id, {{{}, {.total = 1, .self = 0}}}},
     }));
-    EXPECT_EQ(func_c_iter->callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_c_iter)),
               (caller_map{
                   {function_root.id, {{{}, {.total = 1, .self = 0}}}}
     }));
-    EXPECT_EQ(func_d_iter->callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_d_iter)),
               (caller_map{
                   {func_c_iter->id, {{{}, {.total = 1, .self = 0}}}},
     }));
 
     // Check function callees
-    EXPECT_EQ(function_root.callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(function_root)),
               (caller_map{
                   {func_a_iter->id, {{{}, {.total = 1, .self = 0}}}},
                   {func_c_iter->id, {{{}, {.total = 1, .self = 0}}}}
     }));
-    EXPECT_EQ(func_a_iter->callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_a_iter)),
               (caller_map{
                   {func_b_iter->id, {{{}, {.total = 1, .self = 0}}}},
     }));
-    EXPECT_EQ(func_b_iter->callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_b_iter)),
               (caller_map{}));
-    EXPECT_EQ(func_c_iter->callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_c_iter)),
               (caller_map{
                   {func_d_iter->id, {{{}, {.total = 1, .self = 0}}}}
     }));
-    EXPECT_EQ(func_d_iter->callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_d_iter)),
               (caller_map{}));
 
     // check call tree
     const auto& call_tree_root = analysis_result.get_call_tree_root();
     EXPECT_EQ(&analysis_result.get_call_tree_node(call_tree_root.id), &call_tree_root);
     EXPECT_EQ(call_tree_root.function_id, function_root.id);
-    EXPECT_EQ(call_tree_root.hits, (source_hit_counts{
+    EXPECT_EQ(analysis_result.get_hits(call_tree_root), (source_hit_counts{
                                        {{}, {.total = 2, .self = 0}}
     }));
     EXPECT_EQ(call_tree_root.children.size(), 2);
@@ -611,7 +1187,7 @@ TEST(Analysis, SampleStacksMissingFile)
     EXPECT_NE(a_id_iter, call_tree_root.children.end());
     const auto call_tree_node_a = analysis_result.get_call_tree_node(*a_id_iter);
     EXPECT_EQ(call_tree_node_a.id, *a_id_iter);
-    EXPECT_EQ(call_tree_node_a.hits, (source_hit_counts{
+    EXPECT_EQ(analysis_result.get_hits(call_tree_node_a), (source_hit_counts{
                                          {{}, {.total = 1, .self = 0}}
     }));
     EXPECT_EQ(call_tree_node_a.children.size(), 1);
@@ -622,7 +1198,7 @@ TEST(Analysis, SampleStacksMissingFile)
     EXPECT_NE(c_id_iter, call_tree_root.children.end());
     const auto call_tree_node_c = analysis_result.get_call_tree_node(*c_id_iter);
     EXPECT_EQ(call_tree_node_c.id, *c_id_iter);
-    EXPECT_EQ(call_tree_node_c.hits, (source_hit_counts{
+    EXPECT_EQ(analysis_result.get_hits(call_tree_node_c), (source_hit_counts{
                                          {{}, {.total = 1, .self = 0}}
     }));
     EXPECT_EQ(call_tree_node_c.children.size(), 1);
@@ -630,7 +1206,7 @@ TEST(Analysis, SampleStacksMissingFile)
     // root => func_a => func_b
     const auto call_tree_node_a_b = analysis_result.get_call_tree_node(call_tree_node_a.children[0]);
     EXPECT_EQ(call_tree_node_a_b.function_id, func_b_iter->id);
-    EXPECT_EQ(call_tree_node_a_b.hits, (source_hit_counts{
+    EXPECT_EQ(analysis_result.get_hits(call_tree_node_a_b), (source_hit_counts{
                                            {{}, {.total = 1, .self = 1}}
     }));
     EXPECT_EQ(call_tree_node_a_b.children.size(), 0);
@@ -638,7 +1214,7 @@ TEST(Analysis, SampleStacksMissingFile)
     // root => func_c => func_d
     const auto call_tree_node_c_d = analysis_result.get_call_tree_node(call_tree_node_c.children[0]);
     EXPECT_EQ(call_tree_node_c_d.function_id, func_d_iter->id);
-    EXPECT_EQ(call_tree_node_c_d.hits, (source_hit_counts{
+    EXPECT_EQ(analysis_result.get_hits(call_tree_node_c_d), (source_hit_counts{
                                            {{}, {.total = 1, .self = 1}}
     }));
     EXPECT_EQ(call_tree_node_c_d.children.size(), 0);
@@ -768,26 +1344,26 @@ TEST(Analysis, SampleNoStacks)
     EXPECT_EQ(&analysis_result.get_file(file_b_iter->id), &*file_b_iter);
 
     // Check function hits
-    EXPECT_EQ(function_root.hits.get(source_id).total, 0);
-    EXPECT_EQ(function_root.hits.get(source_id).self, 0);
-    EXPECT_EQ(func_a_iter->hits.get(source_id).total, 2);
-    EXPECT_EQ(func_a_iter->hits.get(source_id).self, 2);
-    EXPECT_EQ(func_b_iter->hits.get(source_id).total, 1);
-    EXPECT_EQ(func_b_iter->hits.get(source_id).self, 1);
-    EXPECT_EQ(func_c_iter->hits.get(source_id).total, 1);
-    EXPECT_EQ(func_c_iter->hits.get(source_id).self, 1);
+    EXPECT_EQ(analysis_result.get_hits(function_root).get(source_id).total, 0);
+    EXPECT_EQ(analysis_result.get_hits(function_root).get(source_id).self, 0);
+    EXPECT_EQ(analysis_result.get_hits(*func_a_iter).get(source_id).total, 2);
+    EXPECT_EQ(analysis_result.get_hits(*func_a_iter).get(source_id).self, 2);
+    EXPECT_EQ(analysis_result.get_hits(*func_b_iter).get(source_id).total, 1);
+    EXPECT_EQ(analysis_result.get_hits(*func_b_iter).get(source_id).self, 1);
+    EXPECT_EQ(analysis_result.get_hits(*func_c_iter).get(source_id).total, 1);
+    EXPECT_EQ(analysis_result.get_hits(*func_c_iter).get(source_id).self, 1);
 
     // Check module hits
-    EXPECT_EQ(mod_a_iter->hits.get(source_id).total, 3);
-    EXPECT_EQ(mod_a_iter->hits.get(source_id).self, 3);
-    EXPECT_EQ(mod_b_iter->hits.get(source_id).total, 1);
-    EXPECT_EQ(mod_b_iter->hits.get(source_id).self, 1);
+    EXPECT_EQ(analysis_result.get_hits(*mod_a_iter).get(source_id).total, 3);
+    EXPECT_EQ(analysis_result.get_hits(*mod_a_iter).get(source_id).self, 3);
+    EXPECT_EQ(analysis_result.get_hits(*mod_b_iter).get(source_id).total, 1);
+    EXPECT_EQ(analysis_result.get_hits(*mod_b_iter).get(source_id).self, 1);
 
     // Check file hits
-    EXPECT_EQ(file_a_iter->hits.get(source_id).total, 3);
-    EXPECT_EQ(file_a_iter->hits.get(source_id).self, 3);
-    EXPECT_EQ(file_b_iter->hits.get(source_id).total, 1);
-    EXPECT_EQ(file_b_iter->hits.get(source_id).self, 1);
+    EXPECT_EQ(analysis_result.get_hits(*file_a_iter).get(source_id).total, 3);
+    EXPECT_EQ(analysis_result.get_hits(*file_a_iter).get(source_id).self, 3);
+    EXPECT_EQ(analysis_result.get_hits(*file_b_iter).get(source_id).total, 1);
+    EXPECT_EQ(analysis_result.get_hits(*file_b_iter).get(source_id).self, 1);
 
     // Check function file associations
     EXPECT_EQ(func_a_iter->file_id, file_a_iter->id);
@@ -805,45 +1381,45 @@ TEST(Analysis, SampleNoStacks)
     EXPECT_EQ(func_c_iter->line_number, 50);
 
     // Check function line hits
-    EXPECT_EQ(func_a_iter->hits_by_line,
+    EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_a_iter)),
               (line_hits_map{
                   {12, {{{}, {.total = 1, .self = 1}}}},
                   {15, {{{}, {.total = 1, .self = 1}}}},
     }));
-    EXPECT_EQ(func_b_iter->hits_by_line,
+    EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_b_iter)),
               (line_hits_map{
                   {100, {{{}, {.total = 1, .self = 1}}}},
     }));
-    EXPECT_EQ(func_c_iter->hits_by_line,
+    EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_c_iter)),
               (line_hits_map{
                   {60, {{{}, {.total = 1, .self = 1}}}}
     }));
 
     // Check function callers
-    EXPECT_EQ(function_root.callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(function_root)),
               (caller_map{}));
-    EXPECT_EQ(func_a_iter->callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_a_iter)),
               (caller_map{}));
-    EXPECT_EQ(func_b_iter->callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_b_iter)),
               (caller_map{}));
-    EXPECT_EQ(func_c_iter->callers,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_c_iter)),
               (caller_map{}));
 
     // Check function callees
-    EXPECT_EQ(function_root.callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(function_root)),
               (caller_map{}));
-    EXPECT_EQ(func_a_iter->callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_a_iter)),
               (caller_map{}));
-    EXPECT_EQ(func_b_iter->callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_b_iter)),
               (caller_map{}));
-    EXPECT_EQ(func_c_iter->callees,
+    EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_c_iter)),
               (caller_map{}));
 
     // check call tree
     const auto& call_tree_root = analysis_result.get_call_tree_root();
     EXPECT_EQ(&analysis_result.get_call_tree_node(call_tree_root.id), &call_tree_root);
     EXPECT_EQ(call_tree_root.function_id, function_root.id);
-    EXPECT_EQ(call_tree_root.hits, (source_hit_counts{
+    EXPECT_EQ(analysis_result.get_hits(call_tree_root), (source_hit_counts{
                                        {{}, {.total = 0, .self = 0}}
     }));
     EXPECT_EQ(call_tree_root.children.size(), 0);
@@ -991,24 +1567,24 @@ TEST(Analysis, SampleNoStacksCancel)
         EXPECT_EQ(&analysis_result.get_file(file_b_iter->id), &*file_b_iter);
 
         // Check function hits
-        EXPECT_EQ(function_root.hits.get(source_id).total, 0);
-        EXPECT_EQ(function_root.hits.get(source_id).self, 0);
-        EXPECT_EQ(func_a_iter->hits.get(source_id).total, 1);
-        EXPECT_EQ(func_a_iter->hits.get(source_id).self, 1);
-        EXPECT_EQ(func_b_iter->hits.get(source_id).total, 1);
-        EXPECT_EQ(func_b_iter->hits.get(source_id).self, 1);
+        EXPECT_EQ(analysis_result.get_hits(function_root).get(source_id).total, 0);
+        EXPECT_EQ(analysis_result.get_hits(function_root).get(source_id).self, 0);
+        EXPECT_EQ(analysis_result.get_hits(*func_a_iter).get(source_id).total, 1);
+        EXPECT_EQ(analysis_result.get_hits(*func_a_iter).get(source_id).self, 1);
+        EXPECT_EQ(analysis_result.get_hits(*func_b_iter).get(source_id).total, 1);
+        EXPECT_EQ(analysis_result.get_hits(*func_b_iter).get(source_id).self, 1);
 
         // Check module hits
-        EXPECT_EQ(mod_a_iter->hits.get(source_id).total, 1);
-        EXPECT_EQ(mod_a_iter->hits.get(source_id).self, 1);
-        EXPECT_EQ(mod_b_iter->hits.get(source_id).total, 1);
-        EXPECT_EQ(mod_b_iter->hits.get(source_id).self, 1);
+        EXPECT_EQ(analysis_result.get_hits(*mod_a_iter).get(source_id).total, 1);
+        EXPECT_EQ(analysis_result.get_hits(*mod_a_iter).get(source_id).self, 1);
+        EXPECT_EQ(analysis_result.get_hits(*mod_b_iter).get(source_id).total, 1);
+        EXPECT_EQ(analysis_result.get_hits(*mod_b_iter).get(source_id).self, 1);
 
         // Check file hits
-        EXPECT_EQ(file_a_iter->hits.get(source_id).total, 1);
-        EXPECT_EQ(file_a_iter->hits.get(source_id).self, 1);
-        EXPECT_EQ(file_b_iter->hits.get(source_id).total, 1);
-        EXPECT_EQ(file_b_iter->hits.get(source_id).self, 1);
+        EXPECT_EQ(analysis_result.get_hits(*file_a_iter).get(source_id).total, 1);
+        EXPECT_EQ(analysis_result.get_hits(*file_a_iter).get(source_id).self, 1);
+        EXPECT_EQ(analysis_result.get_hits(*file_b_iter).get(source_id).total, 1);
+        EXPECT_EQ(analysis_result.get_hits(*file_b_iter).get(source_id).self, 1);
 
         // Check function file associations
         EXPECT_EQ(func_a_iter->file_id, file_a_iter->id);
@@ -1023,36 +1599,36 @@ TEST(Analysis, SampleNoStacksCancel)
         EXPECT_EQ(func_b_iter->line_number, 100);
 
         // Check function line hits
-        EXPECT_EQ(func_a_iter->hits_by_line,
+        EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_a_iter)),
                   (line_hits_map{
                       {15, {{{}, {.total = 1, .self = 1}}}},
         }));
-        EXPECT_EQ(func_b_iter->hits_by_line,
+        EXPECT_EQ(to_hits_map(analysis_result.get_hits_by_line(*func_b_iter)),
                   (line_hits_map{
                       {100, {{{}, {.total = 1, .self = 1}}}},
         }));
 
         // Check function callers
-        EXPECT_EQ(function_root.callers,
+        EXPECT_EQ(to_hits_map(analysis_result.get_callers(function_root)),
                   (caller_map{}));
-        EXPECT_EQ(func_a_iter->callers,
+        EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_a_iter)),
                   (caller_map{}));
-        EXPECT_EQ(func_b_iter->callers,
+        EXPECT_EQ(to_hits_map(analysis_result.get_callers(*func_b_iter)),
                   (caller_map{}));
 
         // Check function callees
-        EXPECT_EQ(function_root.callees,
+        EXPECT_EQ(to_hits_map(analysis_result.get_callees(function_root)),
                   (caller_map{}));
-        EXPECT_EQ(func_a_iter->callees,
+        EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_a_iter)),
                   (caller_map{}));
-        EXPECT_EQ(func_b_iter->callees,
+        EXPECT_EQ(to_hits_map(analysis_result.get_callees(*func_b_iter)),
                   (caller_map{}));
 
         // check call tree
         const auto& call_tree_root = analysis_result.get_call_tree_root();
         EXPECT_EQ(&analysis_result.get_call_tree_node(call_tree_root.id), &call_tree_root);
         EXPECT_EQ(call_tree_root.function_id, function_root.id);
-        EXPECT_EQ(call_tree_root.hits, (source_hit_counts{
+        EXPECT_EQ(analysis_result.get_hits(call_tree_root), (source_hit_counts{
                                            {{}, {.total = 0, .self = 0}}
         }));
         EXPECT_EQ(call_tree_root.children.size(), 0);
@@ -1083,18 +1659,18 @@ TEST(Analysis, SampleNoStacksCancel)
 
         EXPECT_EQ(&analysis_result.get_function(function_root.id), &function_root);
 
-        EXPECT_EQ(function_root.hits.get(source_id).total, 0);
-        EXPECT_EQ(function_root.hits.get(source_id).self, 0);
+        EXPECT_EQ(analysis_result.get_hits(function_root).get(source_id).total, 0);
+        EXPECT_EQ(analysis_result.get_hits(function_root).get(source_id).self, 0);
 
-        EXPECT_EQ(function_root.callers,
+        EXPECT_EQ(to_hits_map(analysis_result.get_callers(function_root)),
                   (caller_map{}));
-        EXPECT_EQ(function_root.callees,
+        EXPECT_EQ(to_hits_map(analysis_result.get_callees(function_root)),
                   (caller_map{}));
 
         const auto& call_tree_root = analysis_result.get_call_tree_root();
         EXPECT_EQ(&analysis_result.get_call_tree_node(call_tree_root.id), &call_tree_root);
         EXPECT_EQ(call_tree_root.function_id, function_root.id);
-        EXPECT_EQ(call_tree_root.hits, (source_hit_counts{
+        EXPECT_EQ(analysis_result.get_hits(call_tree_root), (source_hit_counts{
                                            {{}, {.total = 0, .self = 0}}
         }));
         EXPECT_EQ(call_tree_root.children.size(), 0);
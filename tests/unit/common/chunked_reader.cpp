@@ -1,8 +1,10 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
 
 #include <snail/common/chunked_reader.hpp>
+#include <snail/common/span_reader.hpp>
 
 using namespace snail::common;
 
@@ -113,3 +115,71 @@ TEST(ChunkedReader, ReadMatching)
 
     EXPECT_FALSE(reader.keep_going());
 }
+
+TEST(SpanReader, CreateEmpty)
+{
+    span_reader reader(std::span<const std::byte>(), 0, 0);
+
+    EXPECT_TRUE(reader.done());
+    EXPECT_FALSE(reader.keep_going());
+}
+
+TEST(SpanReader, CreateInvalidOffset)
+{
+    const std::array<std::byte, 4> data = {};
+    EXPECT_THROW(span_reader(std::span(data), 8, 0), std::runtime_error);
+    EXPECT_THROW(span_reader(std::span(data), 2, 4), std::runtime_error);
+}
+
+TEST(SpanReader, Read)
+{
+    const std::string_view ref_data = "Prefix DATA I AM INTERESTED IN suffix";
+
+    const auto ref_data_1 = std::as_bytes(std::span(ref_data)).subspan(7, 10);
+    const auto ref_data_2 = std::as_bytes(std::span(ref_data)).subspan(17, 5);
+    const auto ref_data_3 = std::as_bytes(std::span(ref_data)).subspan(22, 8);
+
+    span_reader reader(std::as_bytes(std::span(ref_data)), 7, 23);
+
+    EXPECT_TRUE(reader.keep_going());
+
+    const auto data_0 = reader.retrieve_data(10, true);
+    EXPECT_TRUE(std::ranges::equal(data_0, ref_data_1));
+    EXPECT_EQ(data_0.data(), ref_data_1.data()); // no copy
+
+    const auto data_1 = reader.retrieve_data(10);
+    EXPECT_TRUE(std::ranges::equal(data_1, ref_data_1));
+
+    EXPECT_TRUE(reader.keep_going());
+
+    const auto data_2 = reader.retrieve_data(5);
+    EXPECT_TRUE(std::ranges::equal(data_2, ref_data_2));
+
+    EXPECT_TRUE(reader.keep_going());
+
+    const auto data_3 = reader.retrieve_data(8);
+    EXPECT_TRUE(std::ranges::equal(data_3, ref_data_3));
+
+    EXPECT_TRUE(reader.done());
+    EXPECT_FALSE(reader.keep_going());
+}
+
+TEST(SpanReader, ReadInsufficient)
+{
+    const std::string_view ref_data = "Prefix DATA I AM INTERESTED IN suffix";
+
+    span_reader reader(std::as_bytes(std::span(ref_data)), 7, 12);
+
+    EXPECT_TRUE(reader.keep_going());
+
+    const auto data_1 = reader.retrieve_data(10);
+    EXPECT_EQ(data_1.size(), 10);
+
+    EXPECT_TRUE(reader.keep_going());
+
+    const auto data_2 = reader.retrieve_data(10);
+    EXPECT_TRUE(data_2.empty());
+
+    EXPECT_FALSE(reader.done());
+    EXPECT_FALSE(reader.keep_going());
+}
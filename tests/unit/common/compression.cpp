@@ -1,11 +1,16 @@
 
 #include <array>
 #include <bit>
+#include <chrono>
+#include <format>
+#include <iostream>
 #include <memory>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <snail/common/ms_xca_compression.hpp>
 #include <snail/common/ms_xca_decompression.hpp>
 
 #include <random>
@@ -78,6 +83,327 @@ using namespace snail;
 //     //     workspace.get());
 // }
 
+namespace {
+
+std::string make_repetitive_data()
+{
+    std::string result = "abcdef"
+                         "gg"
+                         "hhh"
+                         "iiii"
+                         "jjjjj"
+                         "kkkkkkkkkk"
+                         "jjjjjjjjjjjjjjjjjjjj"
+                         "llllllllllllllllllllllllllllllllllllllll"
+                         "mmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmm"
+                         "oooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooo"
+                         "pppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppp";;
+    for(std::size_t i = 0; i < (0xFFFF + 5); ++i)
+    {
+        result.push_back('q');
+    }
+    return result;
+}
+
+const std::string_view text_data = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et "
+                                   "dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex "
+                                   "ea commodo consequat.";
+
+// The following buffers hold `make_repetitive_data()` and `text_data` compressed with the
+// different MS-XCA formats. They have been produced by an encoder written against the
+// MS-XCA specification.
+
+const std::array<std::uint8_t, 546> repetitive_xpress_huff = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x50, 0x55, 0x55, 0x45, 0x53, 0x55, 0x55, 0x50, 0x55, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x55, 0x00, 0x00, 0x04, 0x00, 0x00, 0x04, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x65, 0x84, 0x55, 0x3a, 0x01, 0x10, 0x5f, 0x6f, 0x57, 0xf8, 0x93, 0xed, 0xb3, 0xa3, 0x15, 0xd2,
+    0xc3, 0x3d, 0x8d, 0x00, 0x00, 0xff, 0x3c, 0x01, 0xff, 0x72, 0xfd, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x98, 0x00, 0x00, 0xff,
+    0x8a, 0x02};
+
+const std::array<std::uint8_t, 460> repetitive_lznt1 = {
+    0x69, 0xb1, 0x00, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x67, 0x50, 0x68, 0x68, 0x68, 0x69,
+    0x00, 0x00, 0x6a, 0x01, 0x00, 0x6b, 0x57, 0x06, 0x00, 0x02, 0x70, 0x0c, 0x00, 0x6c, 0x24, 0x00,
+    0x6d, 0x4c, 0x00, 0x6f, 0xdd, 0x9c, 0x00, 0x70, 0x7f, 0x00, 0x7f, 0x00, 0x38, 0x00, 0x71, 0x3f,
+    0x00, 0x3f, 0x00, 0xff, 0x3f, 0x00, 0x3f, 0x00, 0x3f, 0x00, 0x3f, 0x00, 0x1f, 0x00, 0x1f, 0x00,
+    0x1f, 0x00, 0x1f, 0x00, 0xff, 0x1f, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x1f,
+    0x00, 0x1f, 0x00, 0x1f, 0x00, 0xff, 0x1f, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x1f, 0x00,
+    0x1f, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0xff, 0x1f, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x1f,
+    0x00, 0x1f, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0xff, 0x1f, 0x00, 0x1f, 0x00, 0x0f, 0x00, 0x0f, 0x00,
+    0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0xff, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f,
+    0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0xff, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00,
+    0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0xff, 0x0f, 0x00, 0x0f, 0x00, 0x0f,
+    0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0xff, 0x0f, 0x00, 0x0f, 0x00,
+    0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0xff, 0x0f, 0x00, 0x0f,
+    0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0xff, 0x0f, 0x00,
+    0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0xff, 0x0f,
+    0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0xff,
+    0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00,
+    0xff, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f,
+    0x00, 0xff, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00,
+    0x0f, 0x00, 0xff, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f,
+    0x00, 0x0f, 0x00, 0xff, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00,
+    0x0f, 0x00, 0x0f, 0x00, 0xff, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f, 0x00, 0x0f,
+    0x00, 0x0f, 0x00, 0x0f, 0x00, 0x07, 0x0f, 0x00, 0x0f, 0x00, 0x0a, 0x00, 0x03, 0xb0, 0x02, 0x71,
+    0xfc, 0x0f, 0x03, 0xb0, 0x02, 0x71, 0xfc, 0x0f, 0x03, 0xb0, 0x02, 0x71, 0xfc, 0x0f, 0x03, 0xb0,
+    0x02, 0x71, 0xfc, 0x0f, 0x03, 0xb0, 0x02, 0x71, 0xfc, 0x0f, 0x03, 0xb0, 0x02, 0x71, 0xfc, 0x0f,
+    0x03, 0xb0, 0x02, 0x71, 0xfc, 0x0f, 0x03, 0xb0, 0x02, 0x71, 0xfc, 0x0f, 0x03, 0xb0, 0x02, 0x71,
+    0xfc, 0x0f, 0x03, 0xb0, 0x02, 0x71, 0xfc, 0x0f, 0x03, 0xb0, 0x02, 0x71, 0xfc, 0x0f, 0x03, 0xb0,
+    0x02, 0x71, 0xfc, 0x0f, 0x03, 0xb0, 0x02, 0x71, 0xfc, 0x0f, 0x03, 0xb0, 0x02, 0x71, 0xfc, 0x0f,
+    0x03, 0xb0, 0x02, 0x71, 0xfc, 0x0f, 0x03, 0xb0, 0x02, 0x71, 0x8a, 0x02};
+
+const std::array<std::uint8_t, 59> repetitive_xpress = {
+    0xaf, 0xea, 0x0a, 0x00, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x67, 0x68, 0x68, 0x68, 0x69,
+    0x00, 0x00, 0x6a, 0x01, 0x00, 0x6b, 0x06, 0x00, 0x72, 0x00, 0x07, 0x00, 0xf5, 0x6c, 0x07, 0x00,
+    0x0e, 0x6d, 0x07, 0x00, 0xff, 0x36, 0x6f, 0x07, 0x00, 0x86, 0x70, 0x07, 0x00, 0xff, 0xff, 0x3c,
+    0x01, 0x71, 0x07, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00};
+
+const std::array<std::uint8_t, 374> text_xpress_huff = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x40, 0x58, 0x45, 0x70, 0x30, 0x00, 0x45, 0x45, 0x76, 0x45, 0x44, 0x08, 0x08, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x76, 0x77, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x70, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x7d, 0xf6, 0x03, 0x2b, 0x53, 0xb4, 0xbe, 0x0b, 0x42, 0x1f, 0x84, 0x0c, 0x9e, 0x65, 0xcf, 0x42,
+    0x5b, 0x98, 0xcd, 0x4a, 0x25, 0x68, 0xc6, 0xce, 0x73, 0x2c, 0x2e, 0xd0, 0xf6, 0x0f, 0xdf, 0xc2,
+    0x85, 0x78, 0x0c, 0x35, 0x12, 0xf7, 0xb6, 0xad, 0x39, 0xfd, 0xb9, 0xb1, 0x66, 0xbd, 0x48, 0x45,
+    0x7c, 0xc2, 0xf8, 0x70, 0xf0, 0x59, 0x86, 0xda, 0x99, 0x4e, 0x98, 0x40, 0x69, 0x3d, 0x8f, 0x39,
+    0x0b, 0x79, 0xdc, 0x92, 0x18, 0x38, 0x9f, 0xfe, 0xce, 0x9f, 0xc8, 0x8d, 0xa3, 0x75, 0x2f, 0x03,
+    0xaa, 0x13, 0x5f, 0xb8, 0xd5, 0xa5, 0xa4, 0x8c, 0xc8, 0x97, 0x61, 0xac, 0xcf, 0x1a, 0xaf, 0xe1,
+    0x98, 0xf2, 0xaa, 0x3d, 0x99, 0xee, 0x76, 0xdb, 0x4f, 0x85, 0x5b, 0x2e, 0x47, 0xc9, 0x07, 0xf5,
+    0xe7, 0x8a, 0xd8, 0x9f, 0x00, 0x00};
+
+const std::array<std::uint8_t, 225> text_lznt1 = {
+    0xde, 0xb0, 0x00, 0x4c, 0x6f, 0x72, 0x65, 0x6d, 0x20, 0x69, 0x70, 0x00, 0x73, 0x75, 0x6d, 0x20,
+    0x64, 0x6f, 0x6c, 0x6f, 0x00, 0x72, 0x20, 0x73, 0x69, 0x74, 0x20, 0x61, 0x6d, 0x00, 0x65, 0x74,
+    0x2c, 0x20, 0x63, 0x6f, 0x6e, 0x73, 0x00, 0x65, 0x63, 0x74, 0x65, 0x74, 0x75, 0x72, 0x20, 0x00,
+    0x61, 0x64, 0x69, 0x70, 0x69, 0x73, 0x63, 0x69, 0x40, 0x6e, 0x67, 0x20, 0x65, 0x6c, 0x69, 0x00,
+    0x70, 0x73, 0x04, 0x65, 0x64, 0x00, 0xc0, 0x20, 0x65, 0x69, 0x75, 0x73, 0x00, 0x6d, 0x6f, 0x64,
+    0x20, 0x74, 0x65, 0x6d, 0x70, 0x01, 0x00, 0x78, 0x69, 0x6e, 0x63, 0x69, 0x64, 0x69, 0x64, 0x00,
+    0x75, 0x6e, 0x74, 0x20, 0x75, 0x74, 0x20, 0x6c, 0x44, 0x61, 0x62, 0x00, 0xbc, 0x20, 0x65, 0x74,
+    0x03, 0xb4, 0x65, 0x00, 0x20, 0x6d, 0x61, 0x67, 0x6e, 0x61, 0x20, 0x61, 0x00, 0x6c, 0x69, 0x71,
+    0x75, 0x61, 0x2e, 0x20, 0x55, 0x40, 0x74, 0x20, 0x65, 0x6e, 0x69, 0x6d, 0x00, 0x5b, 0x20, 0x14,
+    0x6d, 0x69, 0x01, 0x08, 0x76, 0x00, 0x0e, 0x61, 0x6d, 0x2c, 0x00, 0x20, 0x71, 0x75, 0x69, 0x73,
+    0x20, 0x6e, 0x6f, 0x00, 0x73, 0x74, 0x72, 0x75, 0x64, 0x20, 0x65, 0x78, 0x00, 0x65, 0x72, 0x63,
+    0x69, 0x74, 0x61, 0x74, 0x69, 0x00, 0x6f, 0x6e, 0x20, 0x75, 0x6c, 0x6c, 0x61, 0x6d, 0x8c, 0x63,
+    0x6f, 0x03, 0x59, 0x01, 0x24, 0x69, 0x73, 0x69, 0x01, 0x69, 0x89, 0x02, 0x52, 0x69, 0x70, 0x00,
+    0x2c, 0x20, 0x65, 0x61, 0x00, 0xb8, 0x1a, 0x6d, 0x00, 0x93, 0x6f, 0x03, 0xc0, 0x00, 0x6a, 0x74,
+    0x2e};
+
+const std::array<std::uint8_t, 224> text_xpress = {
+    0x00, 0x00, 0x00, 0x00, 0x4c, 0x6f, 0x72, 0x65, 0x6d, 0x20, 0x69, 0x70, 0x73, 0x75, 0x6d, 0x20,
+    0x64, 0x6f, 0x6c, 0x6f, 0x72, 0x20, 0x73, 0x69, 0x74, 0x20, 0x61, 0x6d, 0x65, 0x74, 0x2c, 0x20,
+    0x63, 0x6f, 0x6e, 0x73, 0x20, 0x02, 0x00, 0x00, 0x65, 0x63, 0x74, 0x65, 0x74, 0x75, 0x72, 0x20,
+    0x61, 0x64, 0x69, 0x70, 0x69, 0x73, 0x63, 0x69, 0x6e, 0x67, 0x20, 0x65, 0x6c, 0x69, 0xe0, 0x00,
+    0x73, 0x65, 0x64, 0x80, 0x01, 0x20, 0x65, 0x69, 0x75, 0x73, 0x22, 0x00, 0x80, 0x00, 0x6d, 0x6f,
+    0x64, 0x20, 0x74, 0x65, 0x6d, 0x70, 0xe0, 0x01, 0x69, 0x6e, 0x63, 0x69, 0x64, 0x69, 0x64, 0x75,
+    0x6e, 0x74, 0x20, 0x75, 0x74, 0x20, 0x6c, 0x61, 0x62, 0xf0, 0x02, 0x20, 0x65, 0x74, 0xd3, 0x02,
+    0x65, 0x28, 0x02, 0x00, 0x00, 0x20, 0x6d, 0x61, 0x67, 0x6e, 0x61, 0x20, 0x61, 0x6c, 0x69, 0x71,
+    0x75, 0x61, 0x2e, 0x20, 0x55, 0x74, 0x20, 0x65, 0x6e, 0x69, 0x6d, 0xd8, 0x02, 0x20, 0x6d, 0x69,
+    0x41, 0x00, 0x76, 0x70, 0x00, 0x61, 0x6d, 0x2c, 0x00, 0x00, 0x00, 0x00, 0x20, 0x71, 0x75, 0x69,
+    0x73, 0x20, 0x6e, 0x6f, 0x73, 0x74, 0x72, 0x75, 0x64, 0x20, 0x65, 0x78, 0x65, 0x72, 0x63, 0x69,
+    0x74, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0x20, 0x75, 0x6c, 0x6c, 0x61, 0x6d, 0xff, 0x59, 0x91, 0x31,
+    0x63, 0x6f, 0xcb, 0x02, 0x21, 0x01, 0x69, 0x73, 0x69, 0x49, 0x03, 0x92, 0x02, 0x69, 0x70, 0x60,
+    0x01, 0x20, 0x65, 0x61, 0xc0, 0x05, 0x6d, 0x98, 0x04, 0x6f, 0x03, 0x06, 0x50, 0x03, 0x74, 0x2e};
+
+// Synthetic data that resembles the event records in an ETL buffer: fixed size records
+// with a constant header, a few distinct thread ids and instruction pointers and
+// steadily increasing timestamps.
+std::string make_record_data()
+{
+    std::string result;
+
+    const auto append = [&result]<typename T>(T value)
+    {
+        for(std::size_t i = 0; i < sizeof(T); ++i)
+        {
+            result.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+        }
+    };
+
+    for(std::uint64_t i = 0; i < 128; ++i)
+    {
+        append(std::uint16_t(32));
+        append(std::uint16_t(0x0a01));
+        append(static_cast<std::uint32_t>(0x1a2c + 4 * (i % 3)));
+        append(std::uint64_t(0x01d98a3c00000000) + i * 1000 + (i * 7919) % 97);
+        append(std::uint64_t(0x00007ff612340000) + ((i * 13) % 8) * 0x40);
+        append(i % 4);
+    }
+    return result;
+}
+
+// `make_record_data()` compressed with plain Xpress by the same encoder as above.
+const std::array<std::uint8_t, 899> records_xpress = {
+    0x4e, 0x3a, 0x00, 0x01, 0x20, 0x00, 0x01, 0x0a, 0x2c, 0x1a, 0x00, 0x02, 0x00, 0x3c, 0x8a, 0xd9,
+    0x01, 0x00, 0x00, 0x34, 0x12, 0xf6, 0x7f, 0x7b, 0x00, 0x01, 0x00, 0xf9, 0x00, 0x30, 0xf8, 0x00,
+    0x26, 0x04, 0xfb, 0x00, 0x40, 0x01, 0xfb, 0x00, 0x40, 0x01, 0xfe, 0x00, 0x34, 0xf3, 0x3c, 0x95,
+    0x95, 0xf8, 0x00, 0xeb, 0x07, 0xfb, 0x00, 0x80, 0xfc, 0x01, 0x02, 0xff, 0x00, 0x51, 0xf9, 0x02,
+    0x11, 0x0c, 0xfb, 0x00, 0xc0, 0xfc, 0x01, 0x03, 0xff, 0x02, 0xd6, 0x0f, 0xfc, 0x03, 0xfc, 0x00,
+    0xff, 0x03, 0x22, 0xf9, 0x02, 0x9b, 0x13, 0xfc, 0x03, 0xfc, 0x02, 0xff, 0x03, 0xf9, 0x02, 0xc1,
+    0x17, 0xfc, 0x03, 0xfc, 0x01, 0x33, 0x33, 0x33, 0xcf, 0xff, 0x03, 0x22, 0xf9, 0x02, 0x86, 0x1b,
+    0xfc, 0x03, 0xfc, 0x01, 0xff, 0x03, 0xf9, 0x02, 0x4b, 0x1f, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02,
+    0x71, 0x23, 0xff, 0x07, 0x01, 0xf9, 0x02, 0x36, 0x27, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02, 0xfb,
+    0x2a, 0xff, 0x07, 0x01, 0xf9, 0x02, 0x21, 0x2f, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02, 0xe6, 0x32,
+    0xff, 0x07, 0x01, 0xf9, 0x02, 0x33, 0x33, 0x33, 0x33, 0x0c, 0x37, 0xff, 0x07, 0xff, 0x01, 0xf9,
+    0x02, 0xd1, 0x3a, 0xff, 0x07, 0x01, 0xf9, 0x02, 0x96, 0x3e, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02,
+    0xbc, 0x42, 0xff, 0x07, 0x01, 0xf9, 0x02, 0x81, 0x46, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02, 0x46,
+    0x4a, 0xff, 0x07, 0x01, 0xf9, 0x02, 0x6c, 0x4e, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02, 0x31, 0x52,
+    0xff, 0x07, 0x01, 0xf9, 0x02, 0x49, 0x92, 0x24, 0x33, 0xf6, 0x55, 0xff, 0x07, 0xff, 0x01, 0xf9,
+    0x02, 0x1c, 0x5a, 0xff, 0x07, 0x01, 0xf9, 0x02, 0xe1, 0x5d, 0xff, 0x17, 0xff, 0x05, 0x07, 0x62,
+    0xff, 0x17, 0x05, 0xcc, 0x65, 0xff, 0x17, 0xff, 0x05, 0x91, 0x69, 0xff, 0x17, 0x05, 0xb7, 0x6d,
+    0xff, 0x17, 0xff, 0x05, 0x7c, 0x71, 0xff, 0x17, 0x05, 0x41, 0x75, 0xff, 0x17, 0xff, 0x05, 0x67,
+    0x79, 0xff, 0x17, 0x05, 0x24, 0x49, 0x92, 0x24, 0x2c, 0x7d, 0xff, 0x17, 0xff, 0x05, 0xf1, 0x80,
+    0xff, 0x17, 0x05, 0x17, 0x85, 0xff, 0x17, 0xff, 0x05, 0xdc, 0x88, 0xff, 0x17, 0x05, 0xa1, 0x8c,
+    0xff, 0x17, 0xff, 0x05, 0xc7, 0x90, 0xff, 0x17, 0x05, 0x8c, 0x94, 0xff, 0x17, 0xff, 0x05, 0xb2,
+    0x98, 0xff, 0x17, 0x05, 0x77, 0x9c, 0xff, 0x17, 0xff, 0x05, 0x3c, 0xa0, 0xff, 0x17, 0x05, 0x62,
+    0xa4, 0x92, 0x24, 0x49, 0x92, 0xff, 0x17, 0xff, 0x05, 0x27, 0xa8, 0xff, 0x17, 0x05, 0xec, 0xab,
+    0xff, 0x17, 0xff, 0x05, 0x12, 0xb0, 0xff, 0x17, 0x05, 0xd7, 0xb3, 0xff, 0x17, 0xff, 0x05, 0x9c,
+    0xb7, 0xff, 0x17, 0x05, 0xc2, 0xbb, 0xff, 0x17, 0xff, 0x05, 0x87, 0xbf, 0xff, 0x17, 0x05, 0xad,
+    0xc3, 0xff, 0x17, 0xff, 0x05, 0x72, 0xc7, 0xff, 0x17, 0x05, 0x37, 0xcb, 0xff, 0x17, 0xff, 0x05,
+    0x5d, 0x49, 0x92, 0x24, 0x49, 0xcf, 0xff, 0x17, 0x05, 0x22, 0xd3, 0xff, 0x17, 0xff, 0x05, 0xe7,
+    0xd6, 0xff, 0x17, 0x05, 0x0d, 0xdb, 0xff, 0x17, 0xff, 0x05, 0xd2, 0xde, 0xff, 0x17, 0x05, 0x97,
+    0xe2, 0xff, 0x17, 0xff, 0x05, 0xbd, 0xe6, 0xff, 0x17, 0x05, 0x82, 0xea, 0xff, 0x17, 0xff, 0x05,
+    0xa8, 0xee, 0xff, 0x17, 0x05, 0x6d, 0xf2, 0xff, 0x17, 0xff, 0x05, 0x32, 0xf6, 0xff, 0x17, 0x05,
+    0xcc, 0xcc, 0x4c, 0x24, 0x58, 0xfa, 0xff, 0x17, 0xff, 0x05, 0x1d, 0xfe, 0xff, 0x17, 0x05, 0xe2,
+    0x01, 0x01, 0xff, 0x17, 0xef, 0x04, 0x08, 0x06, 0xfb, 0x00, 0xff, 0x17, 0xcd, 0x09, 0xfb, 0x00,
+    0xff, 0x17, 0xee, 0x92, 0x0d, 0xfb, 0x00, 0xff, 0x17, 0xb8, 0x11, 0xfc, 0x03, 0xff, 0x17, 0xdd,
+    0x7d, 0x15, 0xfc, 0x03, 0xff, 0x17, 0x42, 0x19, 0xcc, 0xcc, 0xcc, 0xcc, 0xfc, 0x03, 0xff, 0x17,
+    0xdd, 0x68, 0x1d, 0xfc, 0x03, 0xff, 0x17, 0x2d, 0x21, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02, 0x53,
+    0x25, 0xff, 0x07, 0x01, 0xf9, 0x02, 0x18, 0x29, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02, 0xdd, 0x2c,
+    0xff, 0x07, 0x01, 0xf9, 0x02, 0x03, 0x31, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02, 0xc8, 0x34, 0xff,
+    0x07, 0x01, 0xf9, 0x02, 0x8d, 0x38, 0xcc, 0xcc, 0xcc, 0xcc, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02,
+    0xb3, 0x3c, 0xff, 0x07, 0x01, 0xf9, 0x02, 0x78, 0x40, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02, 0x3d,
+    0x44, 0xff, 0x07, 0x01, 0xf9, 0x02, 0x63, 0x48, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02, 0x28, 0x4c,
+    0xff, 0x07, 0x01, 0xf9, 0x02, 0x4e, 0x50, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02, 0x13, 0x54, 0xff,
+    0x07, 0x01, 0xf9, 0x02, 0xd8, 0x57, 0x24, 0x49, 0x92, 0xcc, 0xff, 0x07, 0xff, 0x01, 0xf9, 0x02,
+    0xfe, 0x5b, 0xff, 0x07, 0x01, 0xf9, 0x02, 0xc3, 0x5f, 0xff, 0x17, 0xff, 0x05, 0x88, 0x63, 0xff,
+    0x17, 0x05, 0xae, 0x67, 0xff, 0x17, 0xff, 0x05, 0x73, 0x6b, 0xff, 0x17, 0x05, 0x38, 0x6f, 0xff,
+    0x17, 0xff, 0x05, 0x5e, 0x73, 0xff, 0x17, 0x05, 0x23, 0x77, 0xff, 0x17, 0xff, 0x05, 0xe8, 0x7a,
+    0xff, 0x17, 0x05, 0x0e, 0x7f, 0x92, 0x24, 0x49, 0x92, 0xff, 0x17, 0xff, 0x05, 0xd3, 0x82, 0xff,
+    0x17, 0x05, 0xf9, 0x86, 0xff, 0x17, 0xff, 0x05, 0xbe, 0x8a, 0xff, 0x17, 0x05, 0x83, 0x8e, 0xff,
+    0x17, 0xff, 0x05, 0xa9, 0x92, 0xff, 0x17, 0x05, 0x6e, 0x96, 0xff, 0x17, 0xff, 0x05, 0x33, 0x9a,
+    0xff, 0x17, 0x05, 0x59, 0x9e, 0xff, 0x17, 0xff, 0x05, 0x1e, 0xa2, 0xff, 0x17, 0x05, 0xe3, 0xa5,
+    0xff, 0x17, 0xff, 0x05, 0x09, 0x49, 0x92, 0x24, 0x49, 0xaa, 0xff, 0x17, 0x05, 0xce, 0xad, 0xff,
+    0x17, 0xff, 0x05, 0xf4, 0xb1, 0xff, 0x17, 0x05, 0xb9, 0xb5, 0xff, 0x17, 0xff, 0x05, 0x7e, 0xb9,
+    0xff, 0x17, 0x05, 0xa4, 0xbd, 0xff, 0x17, 0xff, 0x05, 0x69, 0xc1, 0xff, 0x17, 0x05, 0x2e, 0xc5,
+    0xff, 0x17, 0xff, 0x05, 0x54, 0xc9, 0xff, 0x17, 0x05, 0x19, 0xcd, 0xff, 0x17, 0xff, 0x05, 0xde,
+    0xd0, 0xff, 0x17, 0x05, 0xff, 0x49, 0x92, 0x24, 0x04, 0xd5, 0xff, 0x17, 0xff, 0x05, 0xc9, 0xd8,
+    0xff, 0x17, 0x05, 0xef, 0xdc, 0xff, 0x17, 0xff, 0x05, 0xb4, 0xe0, 0xff, 0x17, 0x05, 0x79, 0xe4,
+    0xff, 0x17, 0xff, 0x05, 0x9f, 0xe8, 0xff, 0x17, 0x05, 0x64, 0xec, 0xff, 0x17, 0xcf, 0x05, 0x29,
+    0xf0, 0xff, 0x07};
+
+template<std::size_t N>
+std::string decompress(const std::array<std::uint8_t, N>& compressed_buffer,
+                       std::size_t                        decompressed_size,
+                       common::ms_xca_compression_format  format)
+{
+    std::string decompressed_data;
+    decompressed_data.resize(decompressed_size);
+
+    const auto size = common::ms_xca_decompress(
+        std::as_bytes(std::span(compressed_buffer)),
+        std::as_writable_bytes(std::span(decompressed_data.data(), decompressed_data.size())),
+        format);
+
+    decompressed_data.resize(size);
+    return decompressed_data;
+}
+
+template<std::size_t N>
+double measure_decompression_throughput(const std::array<std::uint8_t, N>& compressed_buffer,
+                                        std::size_t                        decompressed_size,
+                                        common::ms_xca_compression_format  format)
+{
+    std::vector<std::byte> decompressed_buffer(decompressed_size);
+
+    const auto min_duration = std::chrono::milliseconds(500);
+
+    std::size_t total_decompressed_size = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    auto       end   = start;
+    while(end - start < min_duration)
+    {
+        for(int i = 0; i < 16; ++i)
+        {
+            total_decompressed_size += common::ms_xca_decompress(std::as_bytes(std::span(compressed_buffer)), decompressed_buffer, format);
+        }
+        end = std::chrono::steady_clock::now();
+    }
+
+    const auto seconds = std::chrono::duration<double>(end - start).count();
+    return static_cast<double>(total_decompressed_size) / (1024.0 * 1024.0) / seconds;
+}
+
+void report_decompression_throughput(std::string_view format_name, double mb_per_second)
+{
+    std::cout << std::format("{:>12}: {:10.2f} MB/s\n", format_name, mb_per_second);
+    testing::Test::RecordProperty(std::string(format_name), std::format("{:.2f}", mb_per_second));
+}
+
+std::string compress_and_decompress(std::string_view                  input_data,
+                                    common::ms_xca_compression_format format)
+{
+    // Plain LZ77 output is at most 4 bytes of flags per 32 bytes of literals larger than the input.
+    std::vector<std::byte> compressed_data(input_data.size() + input_data.size() / 8 + 8);
+
+    const auto compressed_size = common::ms_xca_compress(std::as_bytes(std::span(input_data)), compressed_data, format);
+    EXPECT_LE(compressed_size, compressed_data.size());
+
+    std::string decompressed_data;
+    decompressed_data.resize(input_data.size());
+
+    const auto decompressed_size = common::ms_xca_decompress(
+        std::span(compressed_data).subspan(0, compressed_size),
+        std::as_writable_bytes(std::span(decompressed_data.data(), decompressed_data.size())),
+        format);
+    decompressed_data.resize(decompressed_size);
+    return decompressed_data;
+}
+
+} // namespace
+
 TEST(MsXcaCompression, DecompressXPress)
 {
     const std::array<std::uint8_t, 59> compressed_buffer = {
@@ -86,25 +412,7 @@ TEST(MsXcaCompression, DecompressXPress)
         0x0e, 0x6d, 0x07, 0x00, 0xff, 0x36, 0x6f, 0x07, 0x00, 0x86, 0x70, 0x07, 0x00, 0xff, 0xff, 0x3c,
         0x01, 0x71, 0x07, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00};
 
-    const auto expected_decompressed = []()
-    {
-        std::string result = "abcdef"
-                             "gg"
-                             "hhh"
-                             "iiii"
-                             "jjjjj"
-                             "kkkkkkkkkk"
-                             "jjjjjjjjjjjjjjjjjjjj"
-                             "llllllllllllllllllllllllllllllllllllllll"
-                             "mmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmmm"
-                             "oooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooo"
-                             "pppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppppp";
-        for(std::size_t i = 0; i < (0xFFFF + 5); ++i)
-        {
-            result.push_back('q');
-        }
-        return result;
-    }();
+    const auto expected_decompressed = make_repetitive_data();
 
     std::string decompressed_data;
     decompressed_data.resize(expected_decompressed.size());
@@ -118,6 +426,12 @@ TEST(MsXcaCompression, DecompressXPress)
     EXPECT_EQ(decompressed_data, expected_decompressed);
 }
 
+TEST(MsXcaCompression, DecompressXPressRecords)
+{
+    const auto expected_records = make_record_data();
+    EXPECT_EQ(decompress(records_xpress, expected_records.size(), common::ms_xca_compression_format::xpress), expected_records);
+}
+
 TEST(MsXcaCompression, DecompressXPressInsufficient)
 {
     const std::array<std::uint8_t, 59> compressed_buffer = {
@@ -183,36 +497,166 @@ TEST(MsXcaCompression, DecompressXPressInvalid)
 
 TEST(MsXcaCompression, DecompressLznt1)
 {
-    const std::array<std::uint8_t, 1> compressed_buffer = {0x00};
+    const auto expected_repetitive = make_repetitive_data();
+    EXPECT_EQ(decompress(repetitive_lznt1, expected_repetitive.size(), common::ms_xca_compression_format::lznt1), expected_repetitive);
 
-    std::array<std::uint8_t, 1> decompressed_buffer;
+    EXPECT_EQ(decompress(text_lznt1, text_data.size(), common::ms_xca_compression_format::lznt1), text_data);
+}
+
+TEST(MsXcaCompression, DecompressLznt1Reference)
+{
+    // Worked example from the MS-XCA specification.
+    const std::array<std::uint8_t, 59> compressed_buffer = {
+        0x38, 0xb0, 0x88, 0x46, 0x23, 0x20, 0x00, 0x20, 0x47, 0x20, 0x41, 0x00, 0x10, 0xa2, 0x47, 0x01,
+        0xa0, 0x45, 0x20, 0x44, 0x00, 0x08, 0x45, 0x01, 0x50, 0x79, 0x00, 0xc0, 0x45, 0x20, 0x05, 0x24,
+        0x13, 0x88, 0x05, 0xb4, 0x02, 0x4a, 0x44, 0xef, 0x03, 0x58, 0x02, 0x8c, 0x09, 0x16, 0x01, 0x48,
+        0x45, 0x00, 0xbe, 0x00, 0x9e, 0x00, 0x04, 0x01, 0x18, 0x90, 0x00};
 
+    const std::string expected_decompressed = std::string("F# F# G A A G F# E D D E F# F# E E F# F# G A A G F# E D D E F# E D D "
+                                                          "E E F# D E F# G F# D E F# G F# E D E A F# F# G A A G F# E D D E F# E D D") +
+                                              '\0';
+
+    EXPECT_EQ(decompress(compressed_buffer, expected_decompressed.size(), common::ms_xca_compression_format::lznt1), expected_decompressed);
+}
+
+TEST(MsXcaCompression, DecompressLznt1Insufficient)
+{
     EXPECT_THAT(
         [&]()
-        {
-            common::ms_xca_decompress(
-                std::as_bytes(std::span(compressed_buffer)),
-                std::as_writable_bytes(std::span(decompressed_buffer)),
-                common::ms_xca_compression_format::lznt1);
-        },
-        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("not yet implemented")));
+        { decompress(repetitive_lznt1, 0, common::ms_xca_compression_format::lznt1); },
+        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("Insufficient output buffer size")));
+
+    EXPECT_THAT(
+        [&]()
+        { decompress(repetitive_lznt1, 5000, common::ms_xca_compression_format::lznt1); },
+        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("Insufficient output buffer size")));
+}
+
+TEST(MsXcaCompression, DecompressLznt1Invalid)
+{
+    // Compressed chunk that claims to be larger than the input.
+    const std::array<std::uint8_t, 4> compressed_truncated_buffer = {0x10, 0xb0, 0x00, 0x61};
+
+    EXPECT_THAT(
+        [&]()
+        { decompress(compressed_truncated_buffer, 1024, common::ms_xca_compression_format::lznt1); },
+        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("Invalid compressed data")));
+
+    // Compressed chunk that starts with a back reference.
+    const std::array<std::uint8_t, 5> compressed_rigged_buffer = {0x02, 0xb0, 0x01, 0x00, 0x00};
+
+    EXPECT_THAT(
+        [&]()
+        { decompress(compressed_rigged_buffer, 1024, common::ms_xca_compression_format::lznt1); },
+        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("Invalid compressed data")));
 }
 
 TEST(MsXcaCompression, DecompressXPressHuff)
 {
-    const std::array<std::uint8_t, 1> compressed_buffer = {0x00};
+    const auto expected_repetitive = make_repetitive_data();
+    EXPECT_EQ(decompress(repetitive_xpress_huff, expected_repetitive.size(), common::ms_xca_compression_format::xpress_huff), expected_repetitive);
 
-    std::array<std::uint8_t, 1> decompressed_buffer;
+    EXPECT_EQ(decompress(text_xpress_huff, text_data.size(), common::ms_xca_compression_format::xpress_huff), text_data);
+}
+
+TEST(MsXcaCompression, DecompressXPressHuffReference)
+{
+    // Worked example from the MS-XCA specification.
+    const std::array<std::uint8_t, 276> compressed_buffer = {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x50, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x45, 0x44, 0x04, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0xd8, 0x52, 0x3e, 0xd7, 0x94, 0x11, 0x5b, 0xe9, 0x19, 0x5f, 0xf9, 0xd6, 0x7c, 0xdf, 0x8d, 0x04,
+        0x00, 0x00, 0x00, 0x00};
+
+    const std::string_view expected_decompressed = "abcdefghijklmnopqrstuvwxyz";
+
+    EXPECT_EQ(decompress(compressed_buffer, expected_decompressed.size(), common::ms_xca_compression_format::xpress_huff), expected_decompressed);
+}
 
+TEST(MsXcaCompression, DecompressXPressHuffInsufficient)
+{
     EXPECT_THAT(
         [&]()
-        {
-            common::ms_xca_decompress(
-                std::as_bytes(std::span(compressed_buffer)),
-                std::as_writable_bytes(std::span(decompressed_buffer)),
-                common::ms_xca_compression_format::xpress_huff);
-        },
-        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("not yet implemented")));
+        { decompress(text_xpress_huff, 0, common::ms_xca_compression_format::xpress_huff); },
+        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("Insufficient output buffer size")));
+
+    EXPECT_THAT(
+        [&]()
+        { decompress(repetitive_xpress_huff, 512, common::ms_xca_compression_format::xpress_huff); },
+        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("Insufficient output buffer size")));
+}
+
+TEST(MsXcaCompression, DecompressXPressHuffInvalid)
+{
+    // Too short to even hold the Huffman table.
+    const std::array<std::uint8_t, 16> compressed_random_buffer = {
+        0x3f, 0xfb, 0x29, 0x26, 0xc8, 0x55, 0xce, 0x49, 0xa0, 0x27, 0x9a, 0x4f, 0xe2, 0x1f, 0xc2, 0xd1};
+
+    EXPECT_THAT(
+        [&]()
+        { decompress(compressed_random_buffer, 1024, common::ms_xca_compression_format::xpress_huff); },
+        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("Invalid compressed data")));
+
+    // All symbols with a code length of 1 do not form a valid prefix code.
+    std::array<std::uint8_t, 260> compressed_oversubscribed_buffer;
+    compressed_oversubscribed_buffer.fill(0x11);
+
+    EXPECT_THAT(
+        [&]()
+        { decompress(compressed_oversubscribed_buffer, 1024, common::ms_xca_compression_format::xpress_huff); },
+        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("Invalid compressed data")));
+
+    // A back reference before the start of the output.
+    auto compressed_rigged_buffer = text_xpress_huff;
+    compressed_rigged_buffer[256] = 0xff;
+    compressed_rigged_buffer[257] = 0xff;
+
+    EXPECT_THAT(
+        [&]()
+        { decompress(compressed_rigged_buffer, 1024, common::ms_xca_compression_format::xpress_huff); },
+        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("Invalid compressed data")));
+}
+
+// The throughput measurements are disabled by default.
+// Run them with `--gtest_also_run_disabled_tests --gtest_filter=MsXcaCompressionThroughput.*`
+
+TEST(MsXcaCompressionThroughput, DISABLED_Repetitive)
+{
+    const auto decompressed_size = make_repetitive_data().size();
+
+    report_decompression_throughput("xpress", measure_decompression_throughput(repetitive_xpress, decompressed_size, common::ms_xca_compression_format::xpress));
+    report_decompression_throughput("xpress_huff", measure_decompression_throughput(repetitive_xpress_huff, decompressed_size, common::ms_xca_compression_format::xpress_huff));
+    report_decompression_throughput("lznt1", measure_decompression_throughput(repetitive_lznt1, decompressed_size, common::ms_xca_compression_format::lznt1));
+}
+
+TEST(MsXcaCompressionThroughput, DISABLED_Text)
+{
+    const auto decompressed_size = text_data.size();
+
+    report_decompression_throughput("xpress", measure_decompression_throughput(text_xpress, decompressed_size, common::ms_xca_compression_format::xpress));
+    report_decompression_throughput("xpress_huff", measure_decompression_throughput(text_xpress_huff, decompressed_size, common::ms_xca_compression_format::xpress_huff));
+    report_decompression_throughput("lznt1", measure_decompression_throughput(text_lznt1, decompressed_size, common::ms_xca_compression_format::lznt1));
+}
+
+TEST(MsXcaCompressionThroughput, DISABLED_Records)
+{
+    const auto decompressed_size = make_record_data().size();
+
+    report_decompression_throughput("xpress", measure_decompression_throughput(records_xpress, decompressed_size, common::ms_xca_compression_format::xpress));
 }
 
 TEST(MsXcaCompression, DecompressInvalid)
@@ -247,3 +691,68 @@ TEST(MsXcaCompression, DecompressNone)
     EXPECT_EQ(decompressed_size, input_data.size());
     EXPECT_EQ(decompressed_data, input_data);
 }
+
+TEST(MsXcaCompression, CompressXPressRoundTrip)
+{
+    const auto repetitive_data = make_repetitive_data();
+    EXPECT_EQ(compress_and_decompress(repetitive_data, common::ms_xca_compression_format::xpress), repetitive_data);
+
+    EXPECT_EQ(compress_and_decompress(text_data, common::ms_xca_compression_format::xpress), text_data);
+
+    const auto record_data = make_record_data();
+    EXPECT_EQ(compress_and_decompress(record_data, common::ms_xca_compression_format::xpress), record_data);
+
+    std::mt19937 random(42);
+    std::string  random_data;
+    for(std::size_t i = 0; i < 10000; ++i)
+    {
+        random_data.push_back(static_cast<char>(random() & 0xFF));
+    }
+    EXPECT_EQ(compress_and_decompress(random_data, common::ms_xca_compression_format::xpress), random_data);
+
+    EXPECT_EQ(compress_and_decompress("", common::ms_xca_compression_format::xpress), "");
+    EXPECT_EQ(compress_and_decompress("a", common::ms_xca_compression_format::xpress), "a");
+}
+
+TEST(MsXcaCompression, CompressXPressRatio)
+{
+    const auto repetitive_data = make_repetitive_data();
+
+    std::vector<std::byte> compressed_data(repetitive_data.size());
+
+    const auto compressed_size = common::ms_xca_compress(std::as_bytes(std::span(repetitive_data)), compressed_data, common::ms_xca_compression_format::xpress);
+    EXPECT_LT(compressed_size, 100);
+}
+
+TEST(MsXcaCompression, CompressXPressInsufficient)
+{
+    const auto text = std::as_bytes(std::span(text_data));
+
+    std::array<std::byte, 16> compressed_data;
+
+    EXPECT_THAT(
+        [&]()
+        {
+            common::ms_xca_compress(text, compressed_data, common::ms_xca_compression_format::xpress);
+        },
+        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("Insufficient output buffer size")));
+}
+
+TEST(MsXcaCompression, CompressNone)
+{
+    EXPECT_EQ(compress_and_decompress(text_data, common::ms_xca_compression_format::none), text_data);
+}
+
+TEST(MsXcaCompression, CompressUnsupported)
+{
+    const auto text = std::as_bytes(std::span(text_data));
+
+    std::vector<std::byte> compressed_data(text.size() * 2);
+
+    EXPECT_THAT(
+        [&]()
+        {
+            common::ms_xca_compress(text, compressed_data, common::ms_xca_compression_format::lznt1);
+        },
+        testing::ThrowsMessage<std::runtime_error>(testing::HasSubstr("Unsupported compression format")));
+}
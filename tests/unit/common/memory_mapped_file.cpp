@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string_view>
+
+#include <snail/common/memory_mapped_file.hpp>
+
+using namespace snail::common;
+
+namespace {
+
+struct temp_file
+{
+    explicit temp_file(std::string_view content) :
+        path(std::filesystem::temp_directory_path() / std::format("snail-test-{}.bin", ::testing::UnitTest::GetInstance()->current_test_info()->name()))
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+    ~temp_file()
+    {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+
+    std::filesystem::path path;
+};
+
+} // namespace
+
+TEST(MemoryMappedFile, Default)
+{
+    memory_mapped_file file;
+    EXPECT_FALSE(file.is_open());
+    EXPECT_TRUE(file.data().empty());
+}
+
+TEST(MemoryMappedFile, Open)
+{
+    const std::string_view content = "Some data in a file that should be mapped.";
+
+    const temp_file temp(content);
+
+    memory_mapped_file file(temp.path);
+    ASSERT_TRUE(file.is_open());
+    EXPECT_TRUE(std::ranges::equal(file.data(), std::as_bytes(std::span(content))));
+
+    memory_mapped_file moved_file(std::move(file));
+    EXPECT_FALSE(file.is_open());
+    ASSERT_TRUE(moved_file.is_open());
+    EXPECT_TRUE(std::ranges::equal(moved_file.data(), std::as_bytes(std::span(content))));
+
+    moved_file.close();
+    EXPECT_FALSE(moved_file.is_open());
+    EXPECT_TRUE(moved_file.data().empty());
+}
+
+TEST(MemoryMappedFile, OpenEmpty)
+{
+    const temp_file temp("");
+
+    memory_mapped_file file;
+    EXPECT_FALSE(file.open(temp.path));
+    EXPECT_FALSE(file.is_open());
+}
+
+TEST(MemoryMappedFile, OpenInvalid)
+{
+    memory_mapped_file file;
+    EXPECT_FALSE(file.open(std::filesystem::temp_directory_path() / "snail-test-does-not-exist.bin"));
+    EXPECT_FALSE(file.open(std::filesystem::temp_directory_path()));
+    EXPECT_FALSE(file.is_open());
+}
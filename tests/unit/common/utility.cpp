@@ -4,9 +4,11 @@
 #include <snail/common/date_time.hpp>
 #include <snail/common/filename.hpp>
 #include <snail/common/guid.hpp>
+#include <snail/common/hash_combine.hpp>
 #include <snail/common/path.hpp>
 #include <snail/common/stream_position.hpp>
 #include <snail/common/string_compare.hpp>
+#include <snail/common/string_interner.hpp>
 #include <snail/common/trim.hpp>
 #include <snail/common/wildcard.hpp>
 
@@ -207,6 +209,20 @@ TEST(Guid, Hash)
     EXPECT_NE(std::hash<guid>{}(guid_a), std::hash<guid>{}(guid_b));
 }
 
+TEST(HashCombine, OrderDependent)
+{
+    EXPECT_NE(hash_combine(1, 2), hash_combine(2, 1));
+    EXPECT_NE(hash_combine(hash_combine(0, 1), 2), hash_combine(hash_combine(0, 2), 1));
+}
+
+TEST(HashCombine, RepeatedValues)
+{
+    // Combining the same value twice must not cancel out.
+    EXPECT_NE(hash_combine(hash_combine(0, 42), 42), 0);
+    EXPECT_NE(hash_combine(hash_combine(0, 42), 42), hash_combine(hash_combine(0, 43), 43));
+    EXPECT_NE(hash_combine(42, 42), hash_combine(43, 43));
+}
+
 TEST(Path, FromUtf8)
 {
     EXPECT_EQ(path_from_utf8("my-file👻"sv), std::filesystem::path(u8"my-file👻"));
@@ -232,6 +248,36 @@ TEST(StreamPositionResetter, Reset)
     EXPECT_EQ(stream.tellg(), 5);
 }
 
+TEST(StringInterner, Intern)
+{
+    string_interner strings;
+
+    const auto id_a     = strings.intern("module_a.so");
+    const auto id_b     = strings.intern("module_b.so");
+    const auto id_empty = strings.intern("");
+
+    EXPECT_NE(id_a, id_b);
+    EXPECT_NE(id_a, id_empty);
+    EXPECT_EQ(strings.size(), 3);
+
+    // Interning equal strings again yields the same ids
+    EXPECT_EQ(strings.intern(std::string("module_a.so")), id_a);
+    EXPECT_EQ(strings.intern("module_b.so"sv), id_b);
+    EXPECT_EQ(strings.intern(""), id_empty);
+    EXPECT_EQ(strings.size(), 3);
+
+    const auto view_a = strings.get(id_a);
+    EXPECT_EQ(view_a, "module_a.so");
+    EXPECT_EQ(strings.get(id_b), "module_b.so");
+    EXPECT_EQ(strings.get(id_empty), "");
+
+    // Views stay valid while the interner grows
+    for(int i = 0; i < 1000; ++i) strings.intern(std::to_string(i));
+    EXPECT_EQ(strings.size(), 1003);
+    EXPECT_EQ(view_a.data(), strings.get(id_a).data());
+    EXPECT_EQ(view_a, "module_a.so");
+}
+
 TEST(Wildcard, ToRegex)
 {
     EXPECT_EQ(wildcard_to_regex("*"), R"(^(?:.*)$)");
@@ -0,0 +1,250 @@
+
+#include <filesystem>
+#include <format>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <snail/etl/dispatching_event_observer.hpp>
+#include <snail/etl/etl_file.hpp>
+#include <snail/etl/etl_writer.hpp>
+
+#include <snail/etl/parser/records/kernel/image.hpp>
+#include <snail/etl/parser/records/kernel/perfinfo.hpp>
+#include <snail/etl/parser/records/kernel/process.hpp>
+#include <snail/etl/parser/records/kernel/stackwalk.hpp>
+#include <snail/etl/parser/records/kernel/thread.hpp>
+
+using namespace snail;
+
+namespace {
+
+struct temp_file_path
+{
+    temp_file_path() :
+        path(std::filesystem::temp_directory_path() / std::format("snail-test-{}.etl", ::testing::UnitTest::GetInstance()->current_test_info()->name()))
+    {}
+    ~temp_file_path()
+    {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+
+    std::filesystem::path path;
+};
+
+struct sample_info
+{
+    std::uint64_t              timestamp;
+    std::uint32_t              thread_id;
+    std::uint64_t              instruction_pointer;
+    std::vector<std::uint64_t> stack;
+};
+
+constexpr std::size_t   sample_count  = 200;
+constexpr std::uint32_t process_id    = 1234;
+constexpr std::uint64_t start_ticks   = 1'000'000;
+constexpr std::uint64_t qpc_frequency = 10'000'000;
+
+const auto start_time = common::nt_sys_time(std::chrono::seconds(1'700'000'000));
+
+std::vector<std::uint64_t> make_stack(std::size_t sample_index)
+{
+    std::vector<std::uint64_t> stack;
+    for(std::size_t i = 0; i < 5 + sample_index % 7; ++i)
+    {
+        stack.push_back(0x7f0000001000 + (sample_index % 3) * 0x100 + i * 0x10);
+    }
+    return stack;
+}
+
+void write_test_file(const std::filesystem::path& path, common::ms_xca_compression_format compression_format)
+{
+    etl::etl_writer writer(path,
+                           etl::etl_writer::options{
+                               .buffer_size          = 1024,
+                               .number_of_processors = 2,
+                               .qpc_frequency        = qpc_frequency,
+                               .start_time_qpc_ticks = start_ticks,
+                               .start_time           = start_time,
+                               .compression_format   = compression_format});
+
+    writer.write_process_start(0, start_ticks + 1, process_id, 4, "test.exe", u"C:\\test.exe --arg");
+    writer.write_thread_start(0, start_ticks + 2, process_id, 10, u"main");
+    writer.write_thread_start(0, start_ticks + 3, process_id, 11, u"");
+    writer.write_image_load(0, start_ticks + 4, process_id, 0x7f0000000000, 0x10000, 0xabcd, u"C:\\test.dll");
+
+    for(std::size_t i = 0; i < sample_count; ++i)
+    {
+        const auto processor_index = static_cast<std::uint16_t>(i % 2);
+        const auto timestamp       = start_ticks + 100 + i * 10;
+        const auto thread_id       = static_cast<std::uint32_t>(10 + i % 2);
+        const auto stack           = make_stack(i);
+
+        writer.write_sampled_profile(processor_index, timestamp, thread_id, stack.front());
+        writer.write_stack(processor_index, timestamp, timestamp, process_id, thread_id, stack);
+    }
+
+    writer.write_thread_end(1, start_ticks + 100'000, process_id, 11);
+
+    writer.finish();
+}
+
+void check_test_file(const std::filesystem::path& path, common::ms_xca_compression_format compression_format)
+{
+    etl::etl_file file(path);
+
+    const auto& header = file.header();
+    EXPECT_EQ(header.start_time, start_time);
+    EXPECT_EQ(header.end_time, start_time + std::chrono::milliseconds(10));
+    EXPECT_EQ(header.start_time_qpc_ticks, start_ticks);
+    EXPECT_EQ(header.qpc_frequency, qpc_frequency);
+    EXPECT_EQ(header.pointer_size, 8);
+    EXPECT_EQ(header.number_of_processors, 2);
+    EXPECT_EQ(header.buffer_size, 1024);
+    EXPECT_GT(header.number_of_buffers, 2);
+    EXPECT_EQ(header.compression_format, compression_format);
+
+    etl::dispatching_event_observer observer;
+
+    std::size_t process_count = 0;
+    observer.register_event<etl::parser::process_v4_type_group1_event_view>(
+        [&process_count](const etl::etl_file::header_data& /*file_header*/,
+                         const etl::common_trace_header&   header,
+                         const etl::parser::process_v4_type_group1_event_view& event)
+        {
+            EXPECT_EQ(header.type, 1);
+            EXPECT_EQ(header.timestamp, start_ticks + 1);
+            EXPECT_EQ(event.process_id(), process_id);
+            EXPECT_EQ(event.parent_id(), 4);
+            EXPECT_FALSE(event.has_sid());
+            EXPECT_EQ(event.image_filename(), "test.exe");
+            EXPECT_EQ(event.command_line(), u"C:\\test.exe --arg");
+            EXPECT_EQ(event.dynamic_size(), event.buffer().size());
+            ++process_count;
+        });
+
+    std::vector<std::tuple<std::uint16_t, std::uint32_t, std::u16string>> threads;
+    observer.register_event<etl::parser::thread_v3_type_group1_event_view>(
+        [&threads](const etl::etl_file::header_data& /*file_header*/,
+                   const etl::common_trace_header&   header,
+                   const etl::parser::thread_v3_type_group1_event_view& event)
+        {
+            EXPECT_EQ(event.process_id(), process_id);
+            const auto name = event.thread_name();
+            threads.emplace_back(header.type, event.thread_id(), name ? std::u16string(*name) : u"<none>");
+        });
+
+    std::size_t image_count = 0;
+    observer.register_event<etl::parser::image_v3_load_event_view>(
+        [&image_count](const etl::etl_file::header_data& /*file_header*/,
+                       const etl::common_trace_header& /*header*/,
+                       const etl::parser::image_v3_load_event_view& event)
+        {
+            EXPECT_EQ(event.process_id(), process_id);
+            EXPECT_EQ(event.image_base(), 0x7f0000000000);
+            EXPECT_EQ(event.image_size(), 0x10000);
+            EXPECT_EQ(event.image_checksum(), 0xabcd);
+            EXPECT_EQ(event.file_name(), u"C:\\test.dll");
+            ++image_count;
+        });
+
+    std::vector<sample_info> samples;
+    observer.register_event<etl::parser::perfinfo_v2_sampled_profile_event_view>(
+        [&samples](const etl::etl_file::header_data& /*file_header*/,
+                   const etl::common_trace_header& header,
+                   const etl::parser::perfinfo_v2_sampled_profile_event_view& event)
+        {
+            samples.push_back(sample_info{
+                .timestamp           = header.timestamp,
+                .thread_id           = event.thread_id(),
+                .instruction_pointer = event.instruction_pointer(),
+                .stack               = {}});
+        });
+    observer.register_event<etl::parser::stackwalk_v2_stack_event_view>(
+        [&samples](const etl::etl_file::header_data& /*file_header*/,
+                   const etl::common_trace_header& /*header*/,
+                   const etl::parser::stackwalk_v2_stack_event_view& event)
+        {
+            ASSERT_FALSE(samples.empty());
+            auto& sample = samples.back();
+            EXPECT_EQ(event.event_timestamp(), sample.timestamp);
+            EXPECT_EQ(event.thread_id(), sample.thread_id);
+            EXPECT_EQ(event.process_id(), process_id);
+            for(std::size_t i = 0; i < event.stack_size(); ++i)
+            {
+                sample.stack.push_back(event.stack_address(i));
+            }
+        });
+
+    file.process(observer);
+
+    EXPECT_EQ(process_count, 1);
+    EXPECT_EQ(image_count, 1);
+    EXPECT_EQ(threads, (std::vector<std::tuple<std::uint16_t, std::uint32_t, std::u16string>>{
+                           {1, 10, u"main"  },
+                           {1, 11, u"<none>"},
+                           {2, 11, u"<none>"}
+    }));
+
+    ASSERT_EQ(samples.size(), sample_count);
+    for(std::size_t i = 0; i < sample_count; ++i)
+    {
+        const auto expected_stack = make_stack(i);
+        EXPECT_EQ(samples[i].timestamp, start_ticks + 100 + i * 10);
+        EXPECT_EQ(samples[i].thread_id, 10 + i % 2);
+        EXPECT_EQ(samples[i].instruction_pointer, expected_stack.front());
+        EXPECT_EQ(samples[i].stack, expected_stack);
+    }
+}
+
+} // namespace
+
+TEST(EtlWriter, WriteAndRead)
+{
+    const temp_file_path temp;
+
+    write_test_file(temp.path, common::ms_xca_compression_format::none);
+    check_test_file(temp.path, common::ms_xca_compression_format::none);
+}
+
+TEST(EtlWriter, WriteAndReadCompressed)
+{
+    const temp_file_path temp;
+
+    write_test_file(temp.path, common::ms_xca_compression_format::xpress);
+    check_test_file(temp.path, common::ms_xca_compression_format::xpress);
+
+    const auto number_of_buffers = etl::etl_file(temp.path).header().number_of_buffers;
+    EXPECT_LT(std::filesystem::file_size(temp.path), number_of_buffers * 1024);
+}
+
+TEST(EtlWriter, ProcessTwiceWithoutMemoryMap)
+{
+    const temp_file_path temp;
+
+    write_test_file(temp.path, common::ms_xca_compression_format::none);
+
+    etl::etl_file file(temp.path, false);
+
+    const auto count_samples = [&file]()
+    {
+        etl::dispatching_event_observer observer;
+
+        std::size_t count = 0;
+        observer.register_event<etl::parser::perfinfo_v2_sampled_profile_event_view>(
+            [&count](const etl::etl_file::header_data& /*file_header*/,
+                     const etl::common_trace_header& /*header*/,
+                     const etl::parser::perfinfo_v2_sampled_profile_event_view& /*event*/)
+            {
+                ++count;
+            });
+
+        file.process(observer);
+        return count;
+    };
+
+    EXPECT_EQ(count_samples(), sample_count);
+    EXPECT_EQ(count_samples(), sample_count);
+}
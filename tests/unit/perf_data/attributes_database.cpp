@@ -1,5 +1,6 @@
 
 #include <array>
+#include <format>
 
 #include <gtest/gtest.h>
 
@@ -420,3 +421,41 @@ TEST(EventAttributesDatabase, GetSampleAllId)
                      std::runtime_error);
     }
 }
+
+TEST(EventAttributesDatabase, AddKeepsAttributes)
+{
+    event_attributes_database database;
+
+    const auto make_attributes = [](std::string name)
+    {
+        return parser::event_attributes{
+            .type               = parser::attribute_type::hardware,
+            .sample_period_freq = {},
+            .sample_format      = parser::sample_format_flags(std::bitset<64>("0000000000000000000000000000000000000000000000010000000100100111")),
+            .read_format        = parser::read_format_flags(std::bitset<64>("0000000000000000000000000000000000000000000000000000000000000100")),
+            .flags              = parser::attribute_flags(std::bitset<64>("0000000000000000000000000000000001100001100101000011011100100011")),
+            .precise_ip         = parser::skid_constraint_type::can_have_arbitrary_skid,
+            .name               = std::move(name)};
+    };
+
+    const std::array<std::uint64_t, 1> ids_1 = {1};
+    database.add(make_attributes("attr-1"), ids_1);
+
+    const std::array<std::uint8_t, 16> buffer = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+    const auto* const attr_1 = &database.get_event_attributes(std::endian::little, parser::event_type::comm, std::as_bytes(std::span(buffer)));
+    EXPECT_EQ(attr_1->name, "attr-1");
+
+    // Adding more attributes (like pipe mode streams do between events) must not move the existing ones.
+    for(std::uint64_t id = 2; id < 100; ++id)
+    {
+        const std::array<std::uint64_t, 1> ids = {id};
+        database.add(make_attributes(std::format("attr-{}", id)), ids);
+    }
+
+    EXPECT_EQ(&database.get_event_attributes(std::endian::little, parser::event_type::comm, std::as_bytes(std::span(buffer))), attr_1);
+    EXPECT_EQ(attr_1->name, "attr-1");
+    EXPECT_EQ(database.id_to_attributes.at(99)->name, "attr-99");
+}
@@ -343,6 +343,63 @@ TEST(PerfDataParser, KernelSampleEvent)
     EXPECT_EQ(event.data, std::nullopt);
 }
 
+TEST(PerfDataParser, KernelSampleEventView)
+{
+    const std::array<std::uint8_t, 72> buffer = {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x93, 0x80, 0x92, 0x49, 0x93, 0x7f, 0x00, 0x00, 0x3f, 0x05, 0x00, 0x00, 0x3f, 0x05, 0x00, 0x00,
+        0x38, 0xb7, 0xf5, 0x37, 0xc3, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfe, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0x93, 0x80, 0x92, 0x49, 0x93, 0x7f, 0x00, 0x00, 0xc0, 0x5f, 0x10, 0x83, 0xae, 0x55, 0x00, 0x00};
+
+    const auto attributes = perf_data::parser::event_attributes{
+        // in the following, only sample_format is used.
+        .type               = {},
+        .sample_period_freq = {},
+        .sample_format      = perf_data::parser::sample_format_flags(295),
+        .read_format        = {},
+        .flags              = {},
+        .precise_ip         = {},
+        .name               = {}};
+
+    const auto event = perf_data::parser::parse_event<perf_data::parser::sample_event_view>(attributes, std::as_bytes(std::span(buffer)), std::endian::little);
+
+    EXPECT_EQ(event.ip, 140270571258003);
+    EXPECT_EQ(event.tid, 1343);
+    EXPECT_EQ(event.time, 1937969100600);
+    EXPECT_EQ(event.period, 1);
+    EXPECT_EQ(event.data, std::nullopt);
+
+    const auto expected_ips = std::vector<std::uint64_t>{18446744073709551104ULL, 140270571258003ULL, 94208011558848ULL};
+
+    ASSERT_TRUE(event.ips);
+    EXPECT_EQ(event.ips->size(), 3);
+    EXPECT_EQ((*event.ips)[1], 140270571258003ULL);
+    EXPECT_EQ(std::vector<std::uint64_t>(event.ips->begin(), event.ips->end()), expected_ips);
+
+    std::vector<std::uint64_t> copied_ips(event.ips->size());
+    event.ips->copy_to(copied_ips);
+    EXPECT_EQ(copied_ips, expected_ips);
+}
+
+TEST(PerfDataParser, CallchainViewBigEndian)
+{
+    const std::array<std::uint8_t, 16> buffer = {
+        0x00, 0x00, 0x7f, 0x93, 0x49, 0x92, 0x80, 0x93,
+        0x00, 0x00, 0x55, 0xae, 0x83, 0x10, 0x5f, 0xc0};
+
+    const auto callchain = perf_data::parser::callchain_view(std::as_bytes(std::span(buffer)), std::endian::big);
+
+    const auto expected_ips = std::vector<std::uint64_t>{140270571258003ULL, 94208011558848ULL};
+
+    EXPECT_EQ(callchain.size(), 2);
+    EXPECT_EQ(std::vector<std::uint64_t>(callchain.begin(), callchain.end()), expected_ips);
+
+    std::vector<std::uint64_t> copied_ips(callchain.size());
+    callchain.copy_to(copied_ips);
+    EXPECT_EQ(copied_ips, expected_ips);
+}
+
 TEST(PerfDataParser, PerfIdIndexEvent)
 {
     const std::array<std::uint8_t, 272> buffer = {
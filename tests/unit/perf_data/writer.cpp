@@ -0,0 +1,451 @@
+
+#include <array>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <snail/perf_data/dispatching_event_observer.hpp>
+#include <snail/perf_data/metadata.hpp>
+#include <snail/perf_data/perf_data_file.hpp>
+#include <snail/perf_data/perf_data_writer.hpp>
+#include <snail/perf_data/parser/records/kernel.hpp>
+#include <snail/perf_data/parser/records/perf.hpp>
+
+using namespace snail;
+
+namespace {
+
+struct temp_file_path
+{
+    temp_file_path() :
+        path(std::filesystem::temp_directory_path() / std::format("snail-test-{}.data", ::testing::UnitTest::GetInstance()->current_test_info()->name()))
+    {}
+    ~temp_file_path()
+    {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+
+    std::filesystem::path path;
+};
+
+struct batch_info
+{
+    std::vector<std::uint64_t> sample_times;
+    bool                       ends_with_finished_round;
+};
+
+class recording_batch : public perf_data::event_batch
+{
+public:
+    explicit recording_batch(std::vector<batch_info>& finished_batches) :
+        finished_batches_(&finished_batches)
+    {}
+
+    void handle(const perf_data::parser::event_header_view& event_header,
+                const perf_data::parser::event_attributes&  attributes,
+                std::span<const std::byte>                  event_data,
+                std::endian                                 byte_order) override
+    {
+        if(event_header.type() == perf_data::parser::event_type::sample)
+        {
+            info_.sample_times.push_back(*perf_data::parser::parse_event<perf_data::parser::sample_event>(attributes, event_data, byte_order).time);
+        }
+        info_.ends_with_finished_round = false;
+    }
+
+    void handle(const perf_data::parser::event_header_view& event_header,
+                std::span<const std::byte> /*event_data*/,
+                std::endian /*byte_order*/) override
+    {
+        info_.ends_with_finished_round = event_header.type() == perf_data::parser::event_type::finished_round;
+    }
+
+    void finish() override
+    {
+        finished_batches_->push_back(std::move(info_));
+    }
+
+private:
+    std::vector<batch_info>* finished_batches_;
+    batch_info               info_ = {};
+};
+
+class recording_batched_observer : public perf_data::batched_event_observer
+{
+public:
+    std::unique_ptr<perf_data::event_batch> create_batch() override
+    {
+        return std::make_unique<recording_batch>(finished_batches);
+    }
+
+    std::vector<batch_info> finished_batches;
+};
+
+} // namespace
+
+TEST(PerfDataWriter, WriteAndRead)
+{
+    const temp_file_path temp;
+
+    const auto callchain = std::array<std::uint64_t, 3>{0x7f0000001010, 0x7f0000002020, 0x7f0000003030};
+
+    {
+        perf_data::perf_data_writer writer(temp.path,
+                                           perf_data::perf_data_writer::options{
+                                               .hostname       = "test-host",
+                                               .os_release     = "6.0.0-test",
+                                               .arch           = "x86_64",
+                                               .number_of_cpus = 4,
+                                               .command_line   = {"perf", "record", "-g"},
+                                               .event_name     = "cpu-clock",
+                                               .sample_period  = 1000});
+
+        writer.write_fork(100, 123, 1, 123, 1);
+        writer.write_comm(100, 123, 123, "my-process");
+        writer.write_mmap2(101, 123, 123, 0x7f0000000000, 0x10000, 0x1000, "/usr/lib/libtest.so");
+        writer.write_fork(102, 123, 123, 124, 123);
+        writer.write_sample(200, 123, 124, callchain.front(), callchain);
+        writer.write_sample(300, 123, 123, 0x7f0000004040, {});
+        writer.finish();
+    }
+
+    perf_data::perf_data_file file(temp.path);
+
+    perf_data::dispatching_event_observer observer;
+
+    std::vector<std::array<std::uint32_t, 4>> forks;
+    observer.register_event<perf_data::parser::fork_event_view>(
+        [&forks](const perf_data::parser::fork_event_view& event)
+        {
+            forks.push_back({event.pid(), event.ppid(), event.tid(), event.ptid()});
+        });
+
+    std::size_t comm_count = 0;
+    observer.register_event<perf_data::parser::comm_event_view>(
+        [&comm_count](const perf_data::parser::comm_event_view& event)
+        {
+            EXPECT_EQ(event.pid(), 123);
+            EXPECT_EQ(event.tid(), 123);
+            EXPECT_EQ(event.comm(), "my-process");
+            EXPECT_EQ(event.sample_id().time, 100);
+            ++comm_count;
+        });
+
+    std::size_t mmap2_count = 0;
+    observer.register_event<perf_data::parser::mmap2_event_view>(
+        [&mmap2_count](const perf_data::parser::mmap2_event_view& event)
+        {
+            EXPECT_EQ(event.pid(), 123);
+            EXPECT_EQ(event.addr(), 0x7f0000000000);
+            EXPECT_EQ(event.len(), 0x10000);
+            EXPECT_EQ(event.pgoff(), 0x1000);
+            EXPECT_EQ(event.filename(), "/usr/lib/libtest.so");
+            EXPECT_EQ(event.sample_id().time, 101);
+            ++mmap2_count;
+        });
+
+    std::vector<perf_data::parser::sample_event> samples;
+    observer.register_event<perf_data::parser::sample_event>(
+        [&samples](const perf_data::parser::sample_event& event)
+        {
+            samples.push_back(event);
+        });
+
+    file.process(observer);
+
+    const auto& metadata = file.metadata();
+    EXPECT_EQ(metadata.hostname, "test-host");
+    EXPECT_EQ(metadata.os_release, "6.0.0-test");
+    EXPECT_EQ(metadata.arch, "x86_64");
+    ASSERT_TRUE(metadata.nr_cpus);
+    EXPECT_EQ(metadata.nr_cpus->nr_cpus_available, 4);
+    EXPECT_EQ(metadata.nr_cpus->nr_cpus_online, 4);
+    EXPECT_EQ(metadata.cmdline, (std::vector<std::string>{"perf", "record", "-g"}));
+    ASSERT_EQ(metadata.event_desc.size(), 1);
+    EXPECT_EQ(metadata.event_desc[0].event_string, "cpu-clock");
+    ASSERT_TRUE(metadata.sample_time);
+    EXPECT_EQ(metadata.sample_time->start, std::chrono::nanoseconds(200));
+    EXPECT_EQ(metadata.sample_time->end, std::chrono::nanoseconds(300));
+
+    EXPECT_EQ(forks, (std::vector<std::array<std::uint32_t, 4>>{
+                         {123, 1,   123, 1  },
+                         {123, 123, 124, 123}
+    }));
+    EXPECT_EQ(comm_count, 1);
+    EXPECT_EQ(mmap2_count, 1);
+
+    ASSERT_EQ(samples.size(), 2);
+    EXPECT_EQ(samples[0].pid, 123);
+    EXPECT_EQ(samples[0].tid, 124);
+    EXPECT_EQ(samples[0].time, 200);
+    EXPECT_EQ(samples[0].period, 1000);
+    EXPECT_EQ(samples[0].ip, callchain.front());
+    EXPECT_EQ(samples[0].ips, std::vector<std::uint64_t>(callchain.begin(), callchain.end()));
+    EXPECT_EQ(samples[1].tid, 123);
+    EXPECT_EQ(samples[1].time, 300);
+    EXPECT_EQ(samples[1].ip, 0x7f0000004040);
+    EXPECT_EQ(samples[1].ips, std::vector<std::uint64_t>{});
+}
+
+TEST(PerfDataWriter, ProcessParallel)
+{
+    const temp_file_path temp;
+
+    // Large enough to be split into multiple batches.
+    constexpr std::size_t sample_count      = 20'000;
+    constexpr std::size_t samples_per_round = 100;
+
+    {
+        perf_data::perf_data_writer writer(temp.path,
+                                           perf_data::perf_data_writer::options{
+                                               .hostname       = "test-host",
+                                               .os_release     = "6.0.0-test",
+                                               .arch           = "x86_64",
+                                               .number_of_cpus = 4,
+                                               .command_line   = {"perf", "record", "-g"},
+                                               .event_name     = "cpu-clock",
+                                               .sample_period  = 1000});
+
+        writer.write_fork(0, 123, 1, 123, 1);
+        writer.write_comm(0, 123, 123, "my-process");
+
+        const auto callchain = std::vector<std::uint64_t>(16, 0x7f0000001010);
+        for(std::size_t i = 0; i < sample_count; ++i)
+        {
+            writer.write_sample(i + 1, 123, 123, callchain.front(), callchain);
+            if((i + 1) % samples_per_round == 0) writer.write_finished_round();
+        }
+        writer.finish();
+    }
+
+    std::vector<std::uint64_t> expected_sample_times(sample_count);
+    std::iota(expected_sample_times.begin(), expected_sample_times.end(), std::uint64_t(1));
+
+    for(const auto use_memory_map : {true, false})
+    {
+        perf_data::perf_data_file file(temp.path, use_memory_map);
+
+        recording_batched_observer observer;
+        file.process_parallel(observer);
+
+        ASSERT_GT(observer.finished_batches.size(), 1);
+
+        std::vector<std::uint64_t> sample_times;
+        for(const auto& batch : observer.finished_batches)
+        {
+            EXPECT_TRUE(batch.ends_with_finished_round);
+            sample_times.insert(sample_times.end(), batch.sample_times.begin(), batch.sample_times.end());
+        }
+        EXPECT_EQ(sample_times, expected_sample_times);
+
+        EXPECT_EQ(file.metadata().hostname, "test-host");
+    }
+}
+
+TEST(PerfDataWriter, WriteAndReadCompressed)
+{
+    const temp_file_path temp;
+
+    // Large enough to require multiple compressed records per round and to be split into
+    // multiple batches.
+    constexpr std::size_t sample_count      = 20'000;
+    constexpr std::size_t samples_per_round = 5'000;
+
+    const auto make_callchain = [](std::size_t sample_index)
+    {
+        return std::vector<std::uint64_t>(1 + sample_index % 32, 0x7f0000001010 + sample_index % 7);
+    };
+
+    std::uint64_t uncompressed_events_size = 0;
+    {
+        perf_data::perf_data_writer writer(temp.path,
+                                           perf_data::perf_data_writer::options{
+                                               .hostname          = "test-host",
+                                               .os_release        = "6.0.0-test",
+                                               .arch              = "x86_64",
+                                               .number_of_cpus    = 4,
+                                               .command_line      = {"perf", "record", "-z", "-g"},
+                                               .event_name        = "cpu-clock",
+                                               .sample_period     = 1000,
+                                               .compression_level = 1});
+
+        writer.write_comm(0, 123, 123, "my-process");
+
+        for(std::size_t i = 0; i < sample_count; ++i)
+        {
+            const auto callchain = make_callchain(i);
+            writer.write_sample(i + 1, 123, 123, callchain.front(), callchain);
+            uncompressed_events_size += 48 + callchain.size() * sizeof(std::uint64_t);
+            if((i + 1) % samples_per_round == 0) writer.write_finished_round();
+        }
+        writer.finish();
+    }
+
+    EXPECT_LT(std::filesystem::file_size(temp.path), uncompressed_events_size / 4);
+
+    for(const auto use_memory_map : {true, false})
+    {
+        perf_data::perf_data_file file(temp.path, use_memory_map);
+
+        perf_data::dispatching_event_observer observer;
+
+        std::size_t comm_count = 0;
+        observer.register_event<perf_data::parser::comm_event_view>(
+            [&comm_count](const perf_data::parser::comm_event_view& event)
+            {
+                EXPECT_EQ(event.comm(), "my-process");
+                ++comm_count;
+            });
+
+        std::size_t sample_index = 0;
+        observer.register_event<perf_data::parser::sample_event>(
+            [&sample_index, &make_callchain](const perf_data::parser::sample_event& event)
+            {
+                EXPECT_EQ(event.time, sample_index + 1);
+                EXPECT_EQ(event.ips, make_callchain(sample_index));
+                ++sample_index;
+            });
+
+        file.process(observer);
+
+        EXPECT_EQ(comm_count, 1);
+        EXPECT_EQ(sample_index, sample_count);
+
+        const auto& metadata = file.metadata();
+        ASSERT_TRUE(metadata.compressed);
+        EXPECT_EQ(metadata.compressed->type, 1);
+        EXPECT_EQ(metadata.compressed->level, 1);
+        EXPECT_GT(metadata.compressed->ratio, 1);
+    }
+
+    std::vector<std::uint64_t> expected_sample_times(sample_count);
+    std::iota(expected_sample_times.begin(), expected_sample_times.end(), std::uint64_t(1));
+
+    for(const auto use_memory_map : {true, false})
+    {
+        perf_data::perf_data_file file(temp.path, use_memory_map);
+
+        recording_batched_observer observer;
+        file.process_parallel(observer);
+
+        ASSERT_GT(observer.finished_batches.size(), 1);
+
+        std::vector<std::uint64_t> sample_times;
+        for(const auto& batch : observer.finished_batches)
+        {
+            EXPECT_TRUE(batch.ends_with_finished_round);
+            sample_times.insert(sample_times.end(), batch.sample_times.begin(), batch.sample_times.end());
+        }
+        EXPECT_EQ(sample_times, expected_sample_times);
+    }
+}
+
+TEST(PerfDataWriter, WriteAndReadPipeMode)
+{
+    const temp_file_path temp;
+
+    constexpr std::size_t sample_count      = 20'000;
+    constexpr std::size_t samples_per_round = 100;
+
+    const auto callchain = std::vector<std::uint64_t>(16, 0x7f0000001010);
+
+    std::vector<std::uint64_t> expected_sample_times(sample_count);
+    std::iota(expected_sample_times.begin(), expected_sample_times.end(), std::uint64_t(1));
+
+    for(const auto compression_level : {std::optional<int>(), std::optional<int>(1)})
+    {
+        {
+            perf_data::perf_data_writer writer(temp.path,
+                                               perf_data::perf_data_writer::options{
+                                                   .hostname          = "test-host",
+                                                   .os_release        = "6.0.0-test",
+                                                   .arch              = "x86_64",
+                                                   .number_of_cpus    = 4,
+                                                   .command_line      = {"perf", "record", "-o", "-"},
+                                                   .event_name        = "cpu-clock",
+                                                   .sample_period     = 1000,
+                                                   .compression_level = compression_level,
+                                                   .pipe_mode         = true});
+
+            writer.write_comm(0, 123, 123, "my-process");
+            for(std::size_t i = 0; i < sample_count; ++i)
+            {
+                writer.write_sample(i + 1, 123, 123, callchain.front(), callchain);
+                if((i + 1) % samples_per_round == 0) writer.write_finished_round();
+            }
+            writer.finish();
+        }
+
+        const auto check_metadata = [](const perf_data::perf_data_metadata& metadata)
+        {
+            EXPECT_EQ(metadata.hostname, "test-host");
+            EXPECT_EQ(metadata.arch, "x86_64");
+            ASSERT_TRUE(metadata.nr_cpus);
+            EXPECT_EQ(metadata.nr_cpus->nr_cpus_online, 4);
+            EXPECT_EQ(metadata.cmdline, (std::vector<std::string>{"perf", "record", "-o", "-"}));
+            ASSERT_EQ(metadata.event_desc.size(), 1);
+            EXPECT_EQ(metadata.event_desc[0].event_string, "cpu-clock");
+            EXPECT_EQ(metadata.event_desc[0].attribute.sample_period_freq, 1000);
+            ASSERT_TRUE(metadata.sample_time);
+            EXPECT_EQ(metadata.sample_time->start, std::chrono::nanoseconds(1));
+            EXPECT_EQ(metadata.sample_time->end, std::chrono::nanoseconds(std::uint64_t(sample_count)));
+        };
+
+        {
+            perf_data::perf_data_file file(temp.path);
+            EXPECT_TRUE(file.is_pipe_mode());
+
+            perf_data::dispatching_event_observer observer;
+
+            std::size_t comm_count = 0;
+            observer.register_event<perf_data::parser::comm_event_view>(
+                [&comm_count](const perf_data::parser::comm_event_view& event)
+                {
+                    EXPECT_EQ(event.comm(), "my-process");
+                    ++comm_count;
+                });
+
+            std::vector<std::uint64_t> sample_times;
+            observer.register_event<perf_data::parser::sample_event>(
+                [&sample_times, &callchain](const perf_data::parser::sample_event& event)
+                {
+                    EXPECT_EQ(event.ips, callchain);
+                    sample_times.push_back(*event.time);
+                });
+
+            file.process(observer);
+
+            EXPECT_EQ(comm_count, 1);
+            EXPECT_EQ(sample_times, expected_sample_times);
+            check_metadata(file.metadata());
+
+            // The stream has been consumed.
+            EXPECT_THROW(file.process(observer), std::runtime_error);
+        }
+
+        {
+            perf_data::perf_data_file file(temp.path);
+
+            recording_batched_observer observer;
+            file.process_parallel(observer);
+
+            ASSERT_GT(observer.finished_batches.size(), 1);
+
+            std::vector<std::uint64_t> sample_times;
+            for(const auto& batch : observer.finished_batches)
+            {
+                sample_times.insert(sample_times.end(), batch.sample_times.begin(), batch.sample_times.end());
+            }
+            EXPECT_EQ(sample_times, expected_sample_times);
+            check_metadata(file.metadata());
+        }
+    }
+}
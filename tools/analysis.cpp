@@ -10,9 +10,17 @@
 
 #include "common/progress_printer.hpp"
 
+// `perf record -o -` writes the perf.data file in pipe mode to the standard output.
+// The files are always opened by their path, hence the standard input is read through the path
+// POSIX systems provide for it. Windows has no such path, so reading from `-` is not supported there.
+#if !defined(_WIN32)
+constexpr std::string_view standard_input_path = "/dev/stdin";
+#endif
+
 struct command_line_args
 {
     std::filesystem::path file_path;
+    bool                  is_standard_input = false;
 
     snail::analysis::options  options;
     snail::analysis::path_map module_path_mapper;
@@ -34,7 +42,8 @@ void print_usage(std::string_view application_path)
               << "\n"
               << "File:\n"
               << "  Path to the file to read. Should be a *.diagsession, *.etl or *perf.data\n"
-              << "  file.\n"
+              << "  file. Use `-` to read a perf.data stream from the standard input,\n"
+              << "  e.g. `perf record -o - | analysis -` (not supported on Windows).\n"
               << "Options:\n"
               << "  --module-path-map <source> <target>\n"
               << "                   Module file path map. Can be added multiple times.\n"
@@ -55,6 +64,15 @@ void print_usage(std::string_view application_path)
     print_usage_and_exit(application_path, EXIT_FAILURE);
 }
 
+std::filesystem::path get_standard_input_path([[maybe_unused]] std::string_view application_path)
+{
+#if defined(_WIN32)
+    print_error_and_exit(application_path, "Reading from the standard input is only supported on POSIX systems.");
+#else
+    return std::filesystem::path(standard_input_path);
+#endif
+}
+
 command_line_args parse_command_line(int argc, char* argv[]) // NOLINT(modernize-avoid-c-arrays,cppcoreguidelines-avoid-c-arrays)
 {
     const auto application_path = argc > 0 ? std::string_view(argv[0]) : "";
@@ -84,8 +102,9 @@ command_line_args parse_command_line(int argc, char* argv[]) // NOLINT(modernize
         else
         {
             if(has_path) print_error_and_exit(application_path, "More than one path given.");
-            result.file_path = current_arg;
-            has_path         = true;
+            result.is_standard_input = current_arg == "-";
+            result.file_path         = result.is_standard_input ? get_standard_input_path(application_path) : std::filesystem::path(current_arg);
+            has_path                 = true;
         }
     }
 
@@ -103,7 +122,10 @@ int main(int argc, char* argv[])
 
     progress_printer progress;
 
-    auto provider = snail::analysis::make_data_provider(args.file_path.extension(), std::move(args.options), std::move(args.module_path_mapper));
+    // The standard input can only deliver a perf.data stream.
+    const auto extension = args.is_standard_input ? std::filesystem::path(".data") : args.file_path.extension();
+
+    auto provider = snail::analysis::make_data_provider(extension, std::move(args.options), std::move(args.module_path_mapper));
     provider->process(args.file_path, args.no_progress ? nullptr : &progress);
 
     const auto& session_info = provider->session_info();
@@ -0,0 +1,426 @@
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <charconv>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <snail/common/date_time.hpp>
+#include <snail/common/ms_xca_compression_format.hpp>
+
+#include <snail/etl/etl_writer.hpp>
+
+#include <snail/perf_data/perf_data_writer.hpp>
+
+enum class trace_format
+{
+    perf_data,
+    etl
+};
+
+// The shape of the generated trace.
+struct trace_shape
+{
+    std::size_t   number_of_processes  = 1;
+    std::size_t   threads_per_process  = 4;
+    std::size_t   samples_per_thread   = 1000;
+    std::size_t   number_of_stacks     = 1000;
+    std::size_t   min_stack_depth      = 8;
+    std::size_t   max_stack_depth      = 32;
+    std::size_t   number_of_modules    = 8;
+    std::size_t   functions_per_module = 256;
+    std::size_t   sample_interval_us   = 1000;
+    std::size_t   number_of_processors = 8;
+    std::uint64_t seed                 = 0;
+};
+
+struct command_line_args
+{
+    std::filesystem::path file_path;
+
+    std::optional<trace_format> format;
+
+    trace_shape shape;
+
+    bool          compress           = false;
+    bool          pipe_mode          = false;
+    std::uint32_t etl_buffer_size_kb = 64;
+};
+
+std::string extract_application_name(std::string_view application_path)
+{
+    if(application_path.empty()) return "generate";
+    return std::filesystem::path(application_path).filename().string();
+}
+
+void print_usage(std::string_view application_path)
+{
+    std::cout << std::format("Usage: {} <Options> <File>", extract_application_name(application_path)) << "\n"
+              << "\n"
+              << "File:\n"
+              << "  Path of the file to write.\n"
+              << "Options:\n"
+              << "  --format <perf|etl>  Format of the file to write. Defaults to `etl` for\n"
+              << "                       *.etl files and to `perf` otherwise.\n"
+              << "  --processes <N>      Number of sampled processes. Default: 1\n"
+              << "  --threads <N>        Number of threads per process. Default: 4\n"
+              << "  --samples <N>        Number of samples per thread. Default: 1000\n"
+              << "  --stacks <N>         Number of distinct stacks. Default: 1000\n"
+              << "  --min-depth <N>      Minimal stack depth. Default: 8\n"
+              << "  --max-depth <N>      Maximal stack depth. Default: 32\n"
+              << "  --modules <N>        Number of modules per process. Default: 8\n"
+              << "  --functions <N>      Number of functions per module. Default: 256\n"
+              << "  --interval <N>       Sampling interval in microseconds. Default: 1000\n"
+              << "  --processors <N>     Number of processors. Default: 8\n"
+              << "  --seed <N>           Seed for the random stacks. Default: 0\n"
+              << "  --compress           Compress the buffers (ETL) or the events (perf.data).\n"
+              << "  --pipe               Write the file in pipe mode, as `perf record -o -` does.\n"
+              << "                       The file can be a named pipe (perf.data only).\n"
+              << "  --buffer-size <N>    Size of the buffers in KiB (ETL only). Default: 64\n";
+}
+
+[[noreturn]] void print_usage_and_exit(std::string_view application_path, int exit_code)
+{
+    print_usage(application_path);
+    std::quick_exit(exit_code);
+}
+
+[[noreturn]] void print_error_and_exit(std::string_view application_path, std::string_view error)
+{
+    std::cout << "Error:\n"
+              << "  " << error << "\n\n";
+    print_usage_and_exit(application_path, EXIT_FAILURE);
+}
+
+template<typename T>
+T parse_number(std::string_view application_path, int argc, char* argv[], int& arg_i) // NOLINT(modernize-avoid-c-arrays,cppcoreguidelines-avoid-c-arrays)
+{
+    const auto option = std::string_view(argv[arg_i]);
+    if(arg_i + 1 >= argc) print_error_and_exit(application_path, std::format("Missing value for {}.", option));
+    const auto value_arg = std::string_view(argv[++arg_i]);
+
+    T value;
+    const auto result = std::from_chars(value_arg.data(), value_arg.data() + value_arg.size(), value);
+    if(result.ec != std::errc{} || result.ptr != value_arg.data() + value_arg.size())
+    {
+        print_error_and_exit(application_path, std::format("Invalid value for {}: {}", option, value_arg));
+    }
+    return value;
+}
+
+command_line_args parse_command_line(int argc, char* argv[]) // NOLINT(modernize-avoid-c-arrays,cppcoreguidelines-avoid-c-arrays)
+{
+    const auto application_path = argc > 0 ? std::string_view(argv[0]) : "";
+
+    command_line_args result;
+    bool              has_path = false;
+    for(int arg_i = 1; arg_i < argc; ++arg_i)
+    {
+        const auto current_arg = std::string_view(argv[arg_i]);
+        if(current_arg == "--format")
+        {
+            if(arg_i + 1 >= argc) print_error_and_exit(application_path, "Missing value for --format.");
+            const auto format_arg = std::string_view(argv[++arg_i]);
+            if(format_arg == "perf") result.format = trace_format::perf_data;
+            else if(format_arg == "etl") result.format = trace_format::etl;
+            else print_error_and_exit(application_path, std::format("Invalid format: {}", format_arg));
+        }
+        else if(current_arg == "--processes") result.shape.number_of_processes = parse_number<std::size_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--threads") result.shape.threads_per_process = parse_number<std::size_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--samples") result.shape.samples_per_thread = parse_number<std::size_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--stacks") result.shape.number_of_stacks = parse_number<std::size_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--min-depth") result.shape.min_stack_depth = parse_number<std::size_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--max-depth") result.shape.max_stack_depth = parse_number<std::size_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--modules") result.shape.number_of_modules = parse_number<std::size_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--functions") result.shape.functions_per_module = parse_number<std::size_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--interval") result.shape.sample_interval_us = parse_number<std::size_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--processors") result.shape.number_of_processors = parse_number<std::size_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--seed") result.shape.seed = parse_number<std::uint64_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--buffer-size") result.etl_buffer_size_kb = parse_number<std::uint32_t>(application_path, argc, argv, arg_i);
+        else if(current_arg == "--compress")
+        {
+            result.compress = true;
+        }
+        else if(current_arg == "--pipe")
+        {
+            result.pipe_mode = true;
+        }
+        else
+        {
+            if(has_path) print_error_and_exit(application_path, "More than one path given.");
+            result.file_path = current_arg;
+            has_path         = true;
+        }
+    }
+
+    if(!has_path)
+    {
+        print_error_and_exit(application_path, "Missing path argument.");
+    }
+
+    const auto& shape = result.shape;
+    if(shape.number_of_processes == 0 || shape.threads_per_process == 0 || shape.number_of_stacks == 0 ||
+       shape.number_of_modules == 0 || shape.functions_per_module == 0 || shape.number_of_processors == 0)
+    {
+        print_error_and_exit(application_path, "The number of processes, threads, stacks, modules, functions and processors must not be zero.");
+    }
+    if(shape.min_stack_depth == 0 || shape.min_stack_depth > shape.max_stack_depth)
+    {
+        print_error_and_exit(application_path, "Invalid stack depth range.");
+    }
+    if(shape.functions_per_module > 0x10000)
+    {
+        print_error_and_exit(application_path, "Too many functions per module.");
+    }
+
+    if(!result.format)
+    {
+        result.format = result.file_path.extension() == ".etl" ? trace_format::etl : trace_format::perf_data;
+    }
+    if(result.pipe_mode && result.format != trace_format::perf_data)
+    {
+        print_error_and_exit(application_path, "Pipe mode is only supported for perf.data files.");
+    }
+    return result;
+}
+
+// Every module occupies 16 MiB of address space and every function 256 bytes within it.
+constexpr std::uint64_t module_base_address = 0x7f00'0000'0000;
+constexpr std::uint64_t module_size         = 0x100'0000;
+constexpr std::uint64_t function_size       = 0x100;
+
+constexpr std::uint32_t first_process_id = 1000;
+constexpr std::uint32_t first_thread_id  = 100000;
+
+// The random numbers are mapped to the ranges manually, since the standard distributions
+// are implementation defined and we want the same traces on every platform.
+std::vector<std::vector<std::uint64_t>> make_stacks(const trace_shape& shape)
+{
+    std::mt19937_64 random(shape.seed);
+
+    const auto number_of_functions = shape.number_of_modules * shape.functions_per_module;
+
+    std::vector<std::vector<std::uint64_t>> stacks;
+    stacks.reserve(shape.number_of_stacks);
+    for(std::size_t stack_index = 0; stack_index < shape.number_of_stacks; ++stack_index)
+    {
+        const auto depth = shape.min_stack_depth + random() % (shape.max_stack_depth - shape.min_stack_depth + 1);
+
+        // Innermost frame first
+        auto& stack = stacks.emplace_back(depth);
+        for(auto& address : stack)
+        {
+            const auto function_index = random() % number_of_functions;
+            const auto module_index   = function_index / shape.functions_per_module;
+            address                   = module_base_address + module_index * module_size +
+                          (function_index % shape.functions_per_module) * function_size +
+                          random() % function_size;
+        }
+    }
+    return stacks;
+}
+
+std::uint32_t get_process_id(std::size_t process_index)
+{
+    return first_process_id + static_cast<std::uint32_t>(process_index);
+}
+
+std::uint32_t get_thread_id(const trace_shape& shape, std::size_t process_index, std::size_t thread_index)
+{
+    return first_thread_id + static_cast<std::uint32_t>(process_index * shape.threads_per_process + thread_index);
+}
+
+// Calls `sample(process_index, thread_index, time, stack)` for all samples in the order of
+// their timestamps. Within one sampling interval, the samples of the threads are evenly spread.
+template<typename SampleCallback>
+void for_each_sample(const trace_shape& shape, const std::vector<std::vector<std::uint64_t>>& stacks,
+                     std::chrono::nanoseconds start_time, SampleCallback&& sample)
+{
+    std::mt19937_64 random(shape.seed + 1);
+
+    const auto interval      = std::chrono::nanoseconds(std::chrono::microseconds(shape.sample_interval_us));
+    const auto total_threads = shape.number_of_processes * shape.threads_per_process;
+
+    for(std::size_t sample_index = 0; sample_index < shape.samples_per_thread; ++sample_index)
+    {
+        const auto interval_start = start_time + interval * (sample_index + 1);
+        for(std::size_t process_index = 0; process_index < shape.number_of_processes; ++process_index)
+        {
+            for(std::size_t thread_index = 0; thread_index < shape.threads_per_process; ++thread_index)
+            {
+                const auto global_thread_index = process_index * shape.threads_per_process + thread_index;
+                const auto time                = interval_start + interval * global_thread_index / total_threads;
+                sample(process_index, thread_index, time, stacks[random() % stacks.size()]);
+            }
+        }
+    }
+}
+
+void generate_perf_data(const command_line_args& args, const std::vector<std::vector<std::uint64_t>>& stacks)
+{
+    const auto& shape = args.shape;
+
+    snail::perf_data::perf_data_writer writer(args.file_path,
+                                              snail::perf_data::perf_data_writer::options{
+                                                  .hostname          = "synthetic",
+                                                  .os_release        = "6.0.0-synthetic",
+                                                  .arch              = "x86_64",
+                                                  .number_of_cpus    = static_cast<std::uint32_t>(shape.number_of_processors),
+                                                  .command_line      = {"perf", "record", "-g", "synthetic"},
+                                                  .event_name        = "cpu-clock",
+                                                  .sample_period     = shape.sample_interval_us * 1000,
+                                                  .compression_level = args.compress ? std::optional<int>(1) : std::nullopt,
+                                                  .pipe_mode         = args.pipe_mode});
+
+    constexpr auto start_time = std::chrono::nanoseconds(std::chrono::seconds(1));
+
+    // On Linux, the main thread has the same id as its process.
+    const auto get_tid = [&shape](std::size_t process_index, std::size_t thread_index)
+    {
+        return thread_index == 0 ? get_process_id(process_index) : get_thread_id(shape, process_index, thread_index);
+    };
+
+    std::uint64_t setup_time = start_time.count();
+    for(std::size_t process_index = 0; process_index < shape.number_of_processes; ++process_index)
+    {
+        const auto pid = get_process_id(process_index);
+
+        writer.write_fork(setup_time, pid, 1, pid, 1);
+        writer.write_comm(setup_time, pid, pid, std::format("process_{}", process_index));
+        for(std::size_t module_index = 0; module_index < shape.number_of_modules; ++module_index)
+        {
+            writer.write_mmap2(setup_time, pid, pid, module_base_address + module_index * module_size, module_size, 0,
+                               std::format("/usr/lib/synthetic/libmodule_{}.so", module_index));
+        }
+        for(std::size_t thread_index = 1; thread_index < shape.threads_per_process; ++thread_index)
+        {
+            const auto tid = get_tid(process_index, thread_index);
+            writer.write_fork(setup_time, pid, pid, tid, pid);
+            writer.write_comm(setup_time, pid, tid, std::format("thread_{}", thread_index));
+        }
+        ++setup_time;
+    }
+
+    // perf finishes a round whenever it has flushed the buffers of all CPUs.
+    // We simply emit one after a fixed number of samples.
+    constexpr std::size_t samples_per_round = 1000;
+
+    writer.write_finished_round();
+
+    std::size_t sample_count = 0;
+    for_each_sample(shape, stacks, start_time,
+                    [&](std::size_t process_index, std::size_t thread_index, std::chrono::nanoseconds time, const std::vector<std::uint64_t>& stack)
+                    {
+                        writer.write_sample(static_cast<std::uint64_t>(time.count()), get_process_id(process_index), get_tid(process_index, thread_index), stack.front(), stack);
+                        if(++sample_count % samples_per_round == 0) writer.write_finished_round();
+                    });
+
+    writer.finish();
+}
+
+std::u16string to_u16string(std::string_view ascii)
+{
+    return std::u16string(ascii.begin(), ascii.end());
+}
+
+void generate_etl(const command_line_args& args, const std::vector<std::vector<std::uint64_t>>& stacks)
+{
+    const auto& shape = args.shape;
+
+    // 100ns QPC ticks
+    constexpr std::uint64_t qpc_frequency        = 10'000'000;
+    constexpr std::uint64_t start_time_qpc_ticks = 10'000'000;
+
+    const auto to_qpc_ticks = [](std::chrono::nanoseconds time)
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<snail::common::nt_duration>(time).count());
+    };
+
+    snail::etl::etl_writer writer(args.file_path,
+                                  snail::etl::etl_writer::options{
+                                      .buffer_size          = args.etl_buffer_size_kb * 1024,
+                                      .number_of_processors = static_cast<std::uint32_t>(shape.number_of_processors),
+                                      .qpc_frequency        = qpc_frequency,
+                                      .start_time_qpc_ticks = start_time_qpc_ticks,
+                                      .start_time           = snail::common::nt_sys_time(std::chrono::seconds(1'700'000'000)),
+                                      .compression_format   = args.compress ? snail::common::ms_xca_compression_format::xpress : snail::common::ms_xca_compression_format::none});
+
+    const auto start_time = std::chrono::nanoseconds(start_time_qpc_ticks * 100);
+
+    std::uint64_t setup_time = start_time_qpc_ticks;
+    for(std::size_t process_index = 0; process_index < shape.number_of_processes; ++process_index)
+    {
+        const auto pid = get_process_id(process_index);
+
+        writer.write_process_start(0, setup_time, pid, 4, std::format("process_{}.exe", process_index),
+                                   to_u16string(std::format("C:\\synthetic\\process_{}.exe --synthetic", process_index)));
+        for(std::size_t module_index = 0; module_index < shape.number_of_modules; ++module_index)
+        {
+            writer.write_image_load(0, setup_time, pid, module_base_address + module_index * module_size, module_size, 0,
+                                    to_u16string(std::format("C:\\synthetic\\module_{}.dll", module_index)));
+        }
+        for(std::size_t thread_index = 0; thread_index < shape.threads_per_process; ++thread_index)
+        {
+            writer.write_thread_start(0, setup_time, pid, get_thread_id(shape, process_index, thread_index),
+                                      to_u16string(std::format("thread_{}", thread_index)));
+        }
+        ++setup_time;
+    }
+
+    for_each_sample(shape, stacks, start_time,
+                    [&](std::size_t process_index, std::size_t thread_index, std::chrono::nanoseconds time, const std::vector<std::uint64_t>& stack)
+                    {
+                        const auto global_thread_index = process_index * shape.threads_per_process + thread_index;
+                        const auto processor_index     = static_cast<std::uint16_t>(global_thread_index % shape.number_of_processors);
+
+                        const auto pid       = get_process_id(process_index);
+                        const auto tid       = get_thread_id(shape, process_index, thread_index);
+                        const auto timestamp = to_qpc_ticks(time);
+
+                        writer.write_sampled_profile(processor_index, timestamp, tid, stack.front());
+                        writer.write_stack(processor_index, timestamp, timestamp, pid, tid, stack);
+                    });
+
+    writer.finish();
+}
+
+int main(int argc, char* argv[])
+{
+    const auto args = parse_command_line(argc, argv);
+
+    const auto stacks = make_stacks(args.shape);
+
+    try
+    {
+        if(args.format == trace_format::etl) generate_etl(args, stacks);
+        else generate_perf_data(args, stacks);
+    }
+    catch(const std::exception& e)
+    {
+        std::cout << "Error:\n"
+                  << "  " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    const auto number_of_samples = args.shape.number_of_processes * args.shape.threads_per_process * args.shape.samples_per_thread;
+    if(std::filesystem::is_regular_file(args.file_path))
+    {
+        std::cout << std::format("Wrote {} samples to {} ({} bytes)\n", number_of_samples, args.file_path.string(), std::filesystem::file_size(args.file_path));
+    }
+    else
+    {
+        // The file might be the standard output.
+        std::cerr << std::format("Wrote {} samples to {}\n", number_of_samples, args.file_path.string());
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -22,6 +22,13 @@ using namespace snail;
 
 namespace {
 
+// `perf record -o -` writes the perf.data file in pipe mode to the standard output.
+// The files are always opened by their path, hence the standard input is read through the path
+// POSIX systems provide for it. Windows has no such path, so reading from `-` is not supported there.
+#if !defined(_WIN32)
+constexpr std::string_view standard_input_path = "/dev/stdin";
+#endif
+
 std::string extract_application_name(std::string_view application_path)
 {
     if(application_path.empty()) return "perf_data_file";
@@ -33,7 +40,8 @@ void print_usage(std::string_view application_path)
     std::cout << std::format("Usage: {} <Options> <File>", extract_application_name(application_path)) << "\n"
               << "\n"
               << "File:\n"
-              << "  Path to the perf.data file to be read.\n"
+              << "  Path to the perf.data file to be read. Use `-` to read from the standard input,\n"
+              << "  e.g. `perf record -o - | perf_data_file -` (not supported on Windows).\n"
               << "Options:\n"
               << "  --help, -h       Show this help text.\n"
               << "  --no-progress    Do not print a progress bar.\n";
@@ -52,6 +60,15 @@ void print_usage(std::string_view application_path)
     print_usage_and_exit(application_path, EXIT_FAILURE);
 }
 
+std::filesystem::path get_standard_input_path([[maybe_unused]] std::string_view application_path)
+{
+#if defined(_WIN32)
+    print_error_and_exit(application_path, "Reading from the standard input is only supported on POSIX systems.");
+#else
+    return std::filesystem::path(standard_input_path);
+#endif
+}
+
 struct options
 {
     std::filesystem::path file_path;
@@ -77,7 +94,7 @@ options parse_command_line(int argc, char* argv[]) // NOLINT(modernize-avoid-c-a
         {
             result.no_progress = true;
         }
-        else if(current_arg.starts_with("-"))
+        else if(current_arg.starts_with("-") && current_arg != "-")
         {
             print_error_and_exit(application_path, std::format("Unknown command line argument: {}", current_arg));
         }
@@ -100,7 +117,7 @@ options parse_command_line(int argc, char* argv[]) // NOLINT(modernize-avoid-c-a
     {
         print_error_and_exit(application_path, "Missing perf.data file.");
     }
-    result.file_path = *file_path;
+    result.file_path = *file_path == "-" ? get_standard_input_path(application_path) : *file_path;
 
     return result;
 }